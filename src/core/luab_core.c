@@ -24,6 +24,7 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <pthread.h>
 #include <unistd.h>
 
 #include <lua.h>
@@ -39,7 +40,7 @@ static const char *luab_copyright =
     " All rights reserved.\n"
     "\n";
 
-LUAMOD_API int  luaopen_bsd(lua_State *);
+static pthread_once_t luab_core_once_ctl = PTHREAD_ONCE_INIT;
 
 static void
 luab_core_initparam(lua_State *L __unused, luab_sysconf_vec_t *vec)
@@ -96,22 +97,36 @@ luab_core_initlib(lua_State *L, int narg, luab_libdata_t *vec)
 }
 
 /*
- * Main entry point for loadlib(3).
+ * Initialization of process wide state.
  */
 
-LUAMOD_API int
-luaopen_bsd(lua_State *L)
+static void
+luab_core_once(void)
 {
     (void)printf("%s", luab_copyright);
 
     /* initialize constraints */
-    luab_core_initparam(L, luab_env_param);
+    luab_core_initparam(NULL, luab_env_param);
+
+    /* initialize threading pool */
+    luab_thread_initpool(NULL);
+}
+
+/*
+ * Main entry point for loadlib(3).
+ *
+ * Process wide state is initialized once, since each worker of a
+ * (LUA_TUSERDATA(POOL)) loads the library into a lua_State of its own.
+ */
+
+LUAMOD_API int
+luaopen_bsd(lua_State *L)
+{
+    if (pthread_once(&luab_core_once_ctl, luab_core_once) != 0)
+        luab_core_err(EX_OSERR, __func__, errno);
 
     /* register modules */
     luab_core_initlib(L, -2, luab_env_libdata_vec);
 
-    /* initialize threading pool */
-    luab_thread_initpool(L);
-
     return (1);
 }
@@ -0,0 +1,385 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+
+/*
+ * Size-class allocator.
+ *
+ * Each block is prefixed by a header denoting its size-class. Blocks up
+ * to LUAB_ALLOC_MAXSZ bytes are rounded up to a power of two and cached
+ * on a per-thread free-list when released, larger blocks are passed to
+ * malloc(3) and free(3) directly.
+ *
+ * Thus luab_core_free{,x}(3) and luab_core_realloc(3) accept only memory
+ * obtained by luab_core_alloc{,x}(3), luab_core_realloc(3) or by
+ * luab_core_allocstring(3). Memory returned by libc, e. g. by strdup(3)
+ * or fflagstostr(3), is released by free(3) at its call site. The magic
+ * in the header of a block is not used to recognize its origin, but to
+ * catch blocks, which were released twice.
+ */
+
+#define LUAB_ALLOC_MAGIC        0x6c756162U
+#define LUAB_ALLOC_FREED        0x66726565U
+
+#define LUAB_ALLOC_MINSHIFT     5
+#define LUAB_ALLOC_NCLASS       8
+#define LUAB_ALLOC_MAXSZ        (1UL << (LUAB_ALLOC_MINSHIFT + LUAB_ALLOC_NCLASS - 1))
+#define LUAB_ALLOC_NCACHE       64
+
+typedef struct luab_alloc_hdr {
+    uint32_t    ah_magic;
+    uint32_t    ah_class;
+    size_t      ah_len;
+} __aligned(16) luab_alloc_hdr_t;
+
+typedef struct luab_alloc_cache {
+    luab_alloc_hdr_t    *ac_head[LUAB_ALLOC_NCLASS];
+    u_int               ac_count[LUAB_ALLOC_NCLASS];
+    int                 ac_init;
+} luab_alloc_cache_t;
+
+#define luab_alloc_hdr(v) \
+    ((luab_alloc_hdr_t *)(v) - 1)
+#define luab_alloc_data(h) \
+    ((caddr_t)((luab_alloc_hdr_t *)(h) + 1))
+#define luab_alloc_next(h) \
+    (*(luab_alloc_hdr_t **)luab_alloc_data(h))
+
+static __thread luab_alloc_cache_t luab_alloc_cache;
+
+static pthread_once_t luab_alloc_once = PTHREAD_ONCE_INIT;
+static pthread_key_t luab_alloc_key;
+
+static atomic_ulong luab_alloc_nalloc;
+static atomic_ulong luab_alloc_nfree;
+static atomic_ulong luab_alloc_nhit;
+static atomic_ulong luab_alloc_nmiss;
+static atomic_ulong luab_alloc_nscrub;
+static atomic_ulong luab_alloc_nbytes;
+
+#define luab_alloc_count(x, n) \
+    ((void)atomic_fetch_add_explicit(&(x), (n), memory_order_relaxed))
+#define luab_alloc_uncount(x, n) \
+    ((void)atomic_fetch_sub_explicit(&(x), (n), memory_order_relaxed))
+#define luab_alloc_load(x) \
+    (atomic_load_explicit(&(x), memory_order_relaxed))
+
+/*
+ * Subr.
+ */
+
+static void
+alloc_cache_drain(void *arg)
+{
+    luab_alloc_cache_t *ac;
+    luab_alloc_hdr_t *h;
+    u_int c;
+
+    if ((ac = (luab_alloc_cache_t *)arg) != NULL) {
+
+        for (c = 0; c < LUAB_ALLOC_NCLASS; c++) {
+
+            while ((h = ac->ac_head[c]) != NULL) {
+                ac->ac_head[c] = luab_alloc_next(h);
+                free(h);
+            }
+            ac->ac_count[c] = 0;
+        }
+        ac->ac_init = 0;
+    }
+}
+
+static void
+alloc_key_init(void)
+{
+    if (pthread_key_create(&luab_alloc_key, alloc_cache_drain) != 0)
+        luab_core_err(EX_OSERR, __func__, errno);
+}
+
+static luab_alloc_cache_t *
+alloc_cache(void)
+{
+    luab_alloc_cache_t *ac;
+
+    ac = &luab_alloc_cache;
+
+    if (ac->ac_init == 0) {
+        (void)pthread_once(&luab_alloc_once, alloc_key_init);
+        (void)pthread_setspecific(luab_alloc_key, ac);
+        ac->ac_init = 1;
+    }
+    return (ac);
+}
+
+static u_int
+alloc_class(size_t len)
+{
+    u_int c;
+
+    if (len > LUAB_ALLOC_MAXSZ)
+        c = LUAB_ALLOC_NCLASS;
+    else if (len <= (1UL << LUAB_ALLOC_MINSHIFT))
+        c = 0;
+    else
+        c = fls((int)(len - 1)) - LUAB_ALLOC_MINSHIFT;
+
+    return (c);
+}
+
+static void *
+alloc_get(size_t len, u_int flags)
+{
+    luab_alloc_cache_t *ac;
+    luab_alloc_hdr_t *h;
+    size_t size;
+    u_int c;
+
+    if ((c = alloc_class(len)) < LUAB_ALLOC_NCLASS) {
+        size = 1UL << (c + LUAB_ALLOC_MINSHIFT);
+        ac = alloc_cache();
+
+        if ((h = ac->ac_head[c]) != NULL) {
+            ac->ac_head[c] = luab_alloc_next(h);
+            ac->ac_count[c]--;
+
+            luab_alloc_count(luab_alloc_nhit, 1);
+        } else {
+            if ((h = malloc(sizeof(*h) + size)) == NULL)
+                return (NULL);
+
+            luab_alloc_count(luab_alloc_nmiss, 1);
+        }
+    } else {
+        size = len;
+
+        if (size > (SIZE_MAX - sizeof(*h))) {
+            errno = ENOMEM;
+            return (NULL);
+        }
+
+        if ((h = malloc(sizeof(*h) + size)) == NULL)
+            return (NULL);
+
+        luab_alloc_count(luab_alloc_nmiss, 1);
+    }
+    h->ah_magic = LUAB_ALLOC_MAGIC;
+    h->ah_class = c;
+    h->ah_len = size;
+
+    if ((flags & LUAB_ALLOC_NOZERO) == 0)
+        (void)memset(luab_alloc_data(h), 0, len);
+
+    luab_alloc_count(luab_alloc_nalloc, 1);
+    luab_alloc_count(luab_alloc_nbytes, size);
+
+    return (luab_alloc_data(h));
+}
+
+static void
+alloc_put(luab_alloc_hdr_t *h, u_int flags)
+{
+    luab_alloc_cache_t *ac;
+    u_int c;
+
+    if (flags & LUAB_ALLOC_SCRUB) {
+        (void)memset_s(luab_alloc_data(h), h->ah_len, 0, h->ah_len);
+        luab_alloc_count(luab_alloc_nscrub, 1);
+    }
+    h->ah_magic = LUAB_ALLOC_FREED;
+
+    luab_alloc_count(luab_alloc_nfree, 1);
+    luab_alloc_uncount(luab_alloc_nbytes, h->ah_len);
+
+    if ((c = h->ah_class) < LUAB_ALLOC_NCLASS) {
+        ac = alloc_cache();
+
+        if (ac->ac_count[c] < LUAB_ALLOC_NCACHE) {
+            luab_alloc_next(h) = ac->ac_head[c];
+            ac->ac_head[c] = h;
+            ac->ac_count[c]++;
+            return;
+        }
+    }
+    free(h);
+}
+
+/*
+ * Generic operations.
+ */
+
+void
+luab_core_freex(void *v, size_t sz __unused, u_int flags)
+{
+    luab_alloc_hdr_t *h;
+
+    if (v != NULL) {
+        h = luab_alloc_hdr(v);
+
+        if (h->ah_magic != LUAB_ALLOC_MAGIC)
+            luab_core_errx(EX_SOFTWARE, "%s: %p freed twice", __func__, v);
+
+        alloc_put(h, flags);
+    } else
+        errno = ENOENT;
+}
+
+void
+luab_core_free(void *v, size_t sz)
+{
+    luab_core_freex(v, sz, 0);
+}
+
+void
+luab_core_freestrx(caddr_t dp, u_int flags)
+{
+    size_t n;
+
+    if (dp != NULL) {
+        n = strnlen(dp, luab_env_buf_max);
+        luab_core_freex(dp, n, flags);
+    } else
+        errno = ENOENT;
+}
+
+void
+luab_core_freestr(caddr_t dp)
+{
+    luab_core_freestrx(dp, 0);
+}
+
+void *
+luab_core_allocx(size_t n, size_t sz, u_int flags)
+{
+    size_t nbytes;
+    caddr_t dp;
+
+    if ((nbytes = (n * sz)) > 0) {
+
+        if ((nbytes / sz) == n && nbytes <= (SIZE_MAX - sz))
+            dp = alloc_get(nbytes + sz, flags);
+        else {
+            errno = ENOMEM;
+            dp = NULL;
+        }
+    } else {
+        errno = ERANGE;
+        dp = NULL;
+    }
+    return (dp);
+}
+
+void *
+luab_core_alloc(size_t n, size_t sz)
+{
+    return (luab_core_allocx(n, sz, 0));
+}
+
+void *
+luab_core_realloc(void *v, size_t len, u_int flags)
+{
+    luab_alloc_hdr_t *h;
+    caddr_t dp;
+
+    if (v == NULL)
+        return (luab_core_allocx(len, sizeof(char), flags));
+
+    if (len == 0) {
+        errno = ERANGE;
+        return (NULL);
+    }
+    h = luab_alloc_hdr(v);
+
+    if (h->ah_magic != LUAB_ALLOC_MAGIC)
+        luab_core_errx(EX_SOFTWARE, "%s: %p already freed", __func__, v);
+
+    if (len <= h->ah_len)
+        return (v);
+
+    if ((dp = alloc_get(len, flags | LUAB_ALLOC_NOZERO)) != NULL) {
+        (void)memmove(dp, v, h->ah_len);
+
+        if ((flags & LUAB_ALLOC_NOZERO) == 0)
+            (void)memset(dp + h->ah_len, 0, len - h->ah_len);
+
+        alloc_put(h, flags);
+    }
+    return (dp);
+}
+
+char *
+luab_core_allocstring(const char *dp, size_t *np)
+{
+    size_t len;
+    caddr_t bp;
+
+    if (dp != NULL) {
+        len = strnlen(dp, luab_env_buf_max);
+
+        if ((bp = luab_core_allocx(len, sizeof(char),
+            LUAB_ALLOC_NOZERO)) != NULL) {
+            (void)memmove(bp, dp, len);
+            bp[len] = '\0';
+        } else
+            len = 0;
+    } else {
+        errno = ENOENT;
+        bp = NULL;
+        len = 0;
+    }
+
+    if (np != NULL)
+        *np = len;
+
+    return (bp);
+}
+
+void
+luab_core_allocstat(luab_alloc_stat_t *as)
+{
+    if (as != NULL) {
+        as->as_nalloc = luab_alloc_load(luab_alloc_nalloc);
+        as->as_nfree = luab_alloc_load(luab_alloc_nfree);
+        as->as_nhit = luab_alloc_load(luab_alloc_nhit);
+        as->as_nmiss = luab_alloc_load(luab_alloc_nmiss);
+        as->as_nscrub = luab_alloc_load(luab_alloc_nscrub);
+        as->as_nbytes = luab_alloc_load(luab_alloc_nbytes);
+    } else
+        errno = EINVAL;
+}
@@ -0,0 +1,429 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/mman.h>
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+
+/*
+ * Subr.
+ */
+
+static void
+channel_msg_free(luab_iovec_param_t *msg)
+{
+    if (msg->iop_flags & IOV_MMAP)
+        (void)munmap(msg->iop_iov.iov_base, msg->iop_iov.iov_len);
+    else
+        (void)luab_iov_free(&msg->iop_iov);
+}
+
+static int
+channel_enqueue(luab_channel_t *ch, luab_iovec_param_t *msg)
+{
+    luab_channel_cell_t *cell;
+    size_t pos, seq;
+    intptr_t diff;
+
+    pos = atomic_load_explicit(&ch->ch_head, memory_order_relaxed);
+
+    for (;;) {
+        cell = &ch->ch_vec[pos & (ch->ch_card - 1)];
+        seq = atomic_load_explicit(&cell->cc_seq, memory_order_acquire);
+        diff = (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ch->ch_head, &pos,
+                pos + 1, memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0)
+            return (luab_env_error);
+        else
+            pos = atomic_load_explicit(&ch->ch_head, memory_order_relaxed);
+    }
+    cell->cc_msg = *msg;
+    atomic_store_explicit(&cell->cc_seq, pos + 1, memory_order_release);
+
+    return (0);
+}
+
+static int
+channel_dequeue(luab_channel_t *ch, luab_iovec_param_t *msg)
+{
+    luab_channel_cell_t *cell;
+    size_t pos, seq;
+    intptr_t diff;
+
+    pos = atomic_load_explicit(&ch->ch_tail, memory_order_relaxed);
+
+    for (;;) {
+        cell = &ch->ch_vec[pos & (ch->ch_card - 1)];
+        seq = atomic_load_explicit(&cell->cc_seq, memory_order_acquire);
+        diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ch->ch_tail, &pos,
+                pos + 1, memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0)
+            return (luab_env_error);
+        else
+            pos = atomic_load_explicit(&ch->ch_tail, memory_order_relaxed);
+    }
+    *msg = cell->cc_msg;
+    atomic_store_explicit(&cell->cc_seq, pos + ch->ch_card,
+        memory_order_release);
+
+    return (0);
+}
+
+/*
+ * Wakes up peers sleeping on the opposite side, the lock is taken only
+ * if there are any.
+ */
+static void
+channel_wakeup(luab_channel_t *ch, atomic_int *nwait)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+
+    if (atomic_load(nwait) > 0) {
+        (void)pthread_mutex_lock(&ch->ch_mtx);
+        (void)pthread_cond_broadcast(&ch->ch_cv);
+        (void)pthread_mutex_unlock(&ch->ch_mtx);
+    }
+}
+
+/*
+ * Sleeps until the condition tested by the caller may have changed, the
+ * state is re-checked under ch_mtx, after nwait was incremented.
+ */
+static int
+channel_sleep(luab_channel_t *ch, atomic_int *nwait, int rx,
+    const struct timespec *abstime)
+{
+    size_t head, tail;
+    int status;
+
+    (void)pthread_mutex_lock(&ch->ch_mtx);
+    atomic_fetch_add(nwait, 1);
+
+    head = atomic_load(&ch->ch_head);
+    tail = atomic_load(&ch->ch_tail);
+
+    if (atomic_load(&ch->ch_closed) == 0 &&
+        ((rx != 0 && head == tail) ||
+        (rx == 0 && (head - tail) >= ch->ch_card))) {
+
+        if (abstime != NULL)
+            status = pthread_cond_timedwait(&ch->ch_cv, &ch->ch_mtx, abstime);
+        else
+            status = pthread_cond_wait(&ch->ch_cv, &ch->ch_mtx);
+    } else
+        status = 0;
+
+    atomic_fetch_sub(nwait, 1);
+    (void)pthread_mutex_unlock(&ch->ch_mtx);
+
+    return (status);
+}
+
+static struct timespec *
+channel_abstime(const struct timespec *timeout, struct timespec *abstime)
+{
+    if (timeout != NULL) {
+        (void)clock_gettime(CLOCK_REALTIME, abstime);
+
+        abstime->tv_sec += timeout->tv_sec;
+        abstime->tv_nsec += timeout->tv_nsec;
+
+        if (abstime->tv_nsec >= 1000000000L) {
+            abstime->tv_sec++;
+            abstime->tv_nsec -= 1000000000L;
+        }
+        return (abstime);
+    }
+    return (NULL);
+}
+
+/*
+ * Generator functions.
+ */
+
+luab_channel_t *
+luab_channel_alloc(size_t card)
+{
+    luab_channel_t *ch;
+    size_t n, i;
+
+    for (n = 1; n < card && n > 0; n <<= 1)
+        ;
+
+    if (card == 0 || n == 0) {
+        errno = ERANGE;
+        return (NULL);
+    }
+
+    if ((errno = posix_memalign((void **)&ch, CACHE_LINE_SIZE,
+        sizeof(luab_channel_t))) != 0)
+        return (NULL);
+
+    (void)memset_s(ch, sizeof(luab_channel_t), 0, sizeof(luab_channel_t));
+
+    if ((ch->ch_vec = luab_core_alloc(n, sizeof(luab_channel_cell_t))) != NULL) {
+        ch->ch_card = n;
+
+        for (i = 0; i < n; i++)
+            atomic_init(&ch->ch_vec[i].cc_seq, i);
+
+        atomic_init(&ch->ch_head, 0);
+        atomic_init(&ch->ch_tail, 0);
+        atomic_init(&ch->ch_refcnt, 1);
+        atomic_init(&ch->ch_nrx, 0);
+        atomic_init(&ch->ch_ntx, 0);
+        atomic_init(&ch->ch_closed, 0);
+
+        (void)pthread_mutex_init(&ch->ch_mtx, NULL);
+        (void)pthread_cond_init(&ch->ch_cv, NULL);
+
+        return (ch);
+    }
+    free(ch);
+
+    return (NULL);
+}
+
+void
+luab_channel_hold(luab_channel_t *ch)
+{
+    if (ch != NULL)
+        atomic_fetch_add(&ch->ch_refcnt, 1);
+    else
+        errno = ENOENT;
+}
+
+void
+luab_channel_rele(luab_channel_t *ch)
+{
+    luab_iovec_param_t msg;
+
+    if (ch != NULL) {
+
+        if (atomic_fetch_sub(&ch->ch_refcnt, 1) == 1) {
+
+            while (channel_dequeue(ch, &msg) == 0)
+                channel_msg_free(&msg);
+
+            (void)pthread_cond_destroy(&ch->ch_cv);
+            (void)pthread_mutex_destroy(&ch->ch_mtx);
+
+            luab_core_free(ch->ch_vec, ch->ch_card * sizeof(luab_channel_cell_t));
+            free(ch);
+        }
+    } else
+        errno = ENOENT;
+}
+
+/*
+ * Access functions.
+ */
+
+void
+luab_channel_close(luab_channel_t *ch)
+{
+    atomic_store(&ch->ch_closed, 1);
+
+    (void)pthread_mutex_lock(&ch->ch_mtx);
+    (void)pthread_cond_broadcast(&ch->ch_cv);
+    (void)pthread_mutex_unlock(&ch->ch_mtx);
+}
+
+size_t
+luab_channel_len(luab_channel_t *ch)
+{
+    size_t head, tail;
+
+    tail = atomic_load(&ch->ch_tail);
+    head = atomic_load(&ch->ch_head);
+
+    return ((head > tail) ? (head - tail) : 0);
+}
+
+/*
+ * Service primitives.
+ *
+ * Unless wait is set, EAGAIN is returned, if the operation would block.
+ * The timeout is relative, by (LUA_TNIL) the caller sleeps until the
+ * operation is completed or the channel was closed.
+ */
+
+int
+luab_channel_send(luab_channel_t *ch, luab_iovec_param_t *msg, int wait,
+    const struct timespec *timeout)
+{
+    struct timespec ts, *abstime;
+    int status;
+
+    abstime = channel_abstime(timeout, &ts);
+
+    for (;;) {
+
+        if (atomic_load(&ch->ch_closed) != 0) {
+            errno = EPIPE;
+            return (luab_env_error);
+        }
+
+        if (channel_enqueue(ch, msg) == 0) {
+            channel_wakeup(ch, &ch->ch_nrx);
+            return (0);
+        }
+
+        if (wait == 0) {
+            errno = EAGAIN;
+            return (luab_env_error);
+        }
+
+        if ((status = channel_sleep(ch, &ch->ch_ntx, 0, abstime)) != 0) {
+            errno = status;
+            return (luab_env_error);
+        }
+    }
+}
+
+int
+luab_channel_recv(luab_channel_t *ch, luab_iovec_param_t *msg, int wait,
+    const struct timespec *timeout)
+{
+    struct timespec ts, *abstime;
+    int status;
+
+    abstime = channel_abstime(timeout, &ts);
+
+    for (;;) {
+
+        if (channel_dequeue(ch, msg) == 0) {
+            channel_wakeup(ch, &ch->ch_ntx);
+            return (0);
+        }
+
+        if (atomic_load(&ch->ch_closed) != 0) {
+            errno = EPIPE;
+            return (luab_env_error);
+        }
+
+        if (wait == 0) {
+            errno = EAGAIN;
+            return (luab_env_error);
+        }
+
+        if ((status = channel_sleep(ch, &ch->ch_nrx, 1, abstime)) != 0) {
+            errno = status;
+            return (luab_env_error);
+        }
+    }
+}
+
+/*
+ * Moves the memory region bound to buf into the channel, buf is empty
+ * afterwards.
+ *
+ * The handoff itself is lock-free, but buf is pinned by luab_iovec_hold,
+ * thus luab_thread_mtx is taken for testing and setting IOV_LOCK only.
+ * Other accessors update iov_flags by plain read-modify-write under this
+ * mutex, an atomic compare-and-swap in this path alone would race them.
+ */
+int
+luab_channel_sendiovec(lua_State *L, luab_channel_t *ch, luab_iovec_t *buf,
+    int wait, const struct timespec *timeout)
+{
+    luab_iovec_param_t msg;
+    int status;
+
+    if ((buf->iov_flags & IOV_BUFF) &&
+        (buf->iov.iov_base != NULL)) {
+
+        if ((status = luab_iovec_hold(L, buf, __func__)) == 0) {
+            (void)memset_s(&msg, sizeof(msg), 0, sizeof(msg));
+
+            msg.iop_iov.iov_base = buf->iov.iov_base;
+            msg.iop_iov.iov_len = buf->iov_max_len;
+            msg.iop_data.iov_len = buf->iov.iov_len;
+            msg.iop_flags = buf->iov_flags & (IOV_BUFF|IOV_MMAP|IOV_RDONLY);
+
+            if ((status = luab_channel_send(ch, &msg, wait, timeout)) == 0) {
+                buf->iov.iov_base = NULL;
+                buf->iov.iov_len = 0;
+                buf->iov_max_len = 0;
+                buf->iov_flags &= ~(IOV_BUFF|IOV_MMAP|IOV_RDONLY);
+            }
+            luab_iovec_rele(L, buf, __func__);
+        }
+    } else {
+        errno = EINVAL;
+        status = luab_env_error;
+    }
+    return (status);
+}
+
+/*
+ * Pushes the received memory region by an instance of (LUA_TUSERDATA(IOVEC)).
+ */
+int
+luab_channel_pushiovec(lua_State *L, luab_channel_t *ch, int wait,
+    const struct timespec *timeout)
+{
+    luab_module_t *m;
+    luab_iovec_param_t msg, tmp;
+    int up_call;
+
+    m = luab_xmod(IOVEC, TYPE, __func__);
+
+    if (luab_channel_recv(ch, &msg, wait, timeout) != 0)
+        return (luab_pushnil(L));
+
+    tmp = msg;
+
+    /* the dequeued region is owned by us, until adopted */
+    if ((*m->m_create)(L, &tmp) == NULL) {
+        up_call = errno;
+        channel_msg_free(&msg);
+        errno = up_call;
+        return (luab_pushnil(L));
+    }
+    return (1);
+}
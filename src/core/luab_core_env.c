@@ -800,6 +800,9 @@ luab_env_newmetatable(lua_State *L, int narg, luab_module_t *m)
         lua_setfield(L, narg, "__index");
         luab_env_populate(L, narg, m);
 
+        lua_pushlightuserdata(L, m);
+        lua_rawsetp(L, narg, LUAB_XMOD_KEY);
+
         lua_pop(L, 1);
     } else
         luab_core_err(EX_DATAERR, __func__, ENOEXEC);
@@ -24,6 +24,7 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <sys/mman.h>
 #include <sys/uio.h>
 
 #include <unistd.h>
@@ -134,7 +135,8 @@ luab_iov_realloc(struct iovec *iov, size_t len)
 
     if (iov != NULL && len > 1) {
 
-        if ((bp = realloc(iov->iov_base, len)) != NULL) {
+        if ((bp = luab_core_realloc(iov->iov_base, len,
+            LUAB_ALLOC_SCRUB)) != NULL) {
             iov->iov_base = bp;
             iov->iov_len = len;
             status = luab_env_success;
@@ -202,7 +204,8 @@ luab_iov_free(struct iovec *iov)
 
     if (iov != NULL) {
         if (iov->iov_base != NULL) {
-            free(iov->iov_base);
+            luab_core_freex(iov->iov_base, iov->iov_len,
+                LUAB_ALLOC_SCRUB);
             iov->iov_base = NULL;
         }
         iov->iov_len = 0;
@@ -490,7 +493,7 @@ luab_iovec_toldata(lua_State *L, int narg, size_t len)
     m = luab_xmod(IOVEC, TYPE, __func__);
     buf = luab_udata(L, narg, m, luab_iovec_t *);
 
-    if ((buf->iov_max_len <= luab_env_buf_max) &&
+    if (luab_iovec_istxbuf(buf) &&
         (buf->iov.iov_len <= buf->iov_max_len) &&
         (len <= buf->iov_max_len))
         bp = buf->iov.iov_base;
@@ -539,6 +542,34 @@ luab_iovec_pushxdata(lua_State *L, void *v, size_t len, size_t max_len)
     return (luab_pushxdata(L, m, &mpi));
 }
 
+/*
+ * Maps region v, returned by mmap(2), into (LUA_TUSERDATA(IOVEC)) without
+ * copying. The region is released by munmap(2), when its instance is
+ * collected. The parameter flags may be set to IOV_RDONLY, if the region
+ * was mapped without PROT_WRITE.
+ */
+int
+luab_iovec_pushmdata(lua_State *L, void *v, size_t len, u_int flags)
+{
+    luab_iovec_param_t mpi;
+    luab_module_t *m;
+
+    m = luab_xmod(IOVEC, TYPE, __func__);
+
+    if (v != NULL && v != MAP_FAILED && len > 0) {
+        (void)memset_s(&mpi, sizeof(mpi), 0, sizeof(mpi));
+
+        mpi.iop_iov.iov_base = v;
+        mpi.iop_iov.iov_len = len;
+        mpi.iop_data.iov_len = len;
+        mpi.iop_flags = IOV_MMAP | (flags & IOV_RDONLY);
+    } else {
+        errno = EINVAL;
+        return (luab_pushnil(L));
+    }
+    return (luab_pushxdata(L, m, &mpi));
+}
+
 /*
  * Table operations.
  */
@@ -625,6 +656,75 @@ luab_iovec_pushtable(lua_State *L, int narg, luab_table_t *tbl, int new, int clr
         errno = ERANGE;
 }
 
+/*
+ * Pinning.
+ *
+ * The global mutex is held only for the duration of testing and setting
+ * IOV_LOCK on the buffer, the blocking system call itself is performed
+ * by its holder without any lock. Thus an operation in progress on one
+ * instance of (LUA_TUSERDATA(IOVEC)) does not stall I/O on any other
+ * instance, but concurrent access to the same instance fails with EBUSY.
+ *
+ * If the instance was collected while held, its region is released by
+ * the holder, when it drops IOV_LOCK.
+ */
+
+int
+luab_iovec_hold(lua_State *L, luab_iovec_t *buf, const char *fname)
+{
+    int status;
+
+    if (buf != NULL) {
+        luab_thread_mtx_lock(L, fname);
+
+        if ((buf->iov_flags & IOV_LOCK) == 0) {
+            buf->iov_flags |= IOV_LOCK;
+            status = luab_env_success;
+        } else {
+            errno = EBUSY;
+            status = luab_env_error;
+        }
+        luab_thread_mtx_unlock(L, fname);
+    } else {
+        errno = EINVAL;
+        status = luab_env_error;
+    }
+    return (status);
+}
+
+void
+luab_iovec_rele(lua_State *L, luab_iovec_t *buf, const char *fname)
+{
+    caddr_t dp;
+    size_t len;
+    u_int flags;
+
+    if (buf != NULL) {
+        luab_thread_mtx_lock(L, fname);
+
+        buf->iov_flags &= ~IOV_LOCK;
+
+        if ((flags = buf->iov_flags) & IOV_ORPHAN) {
+            dp = buf->iov.iov_base;
+            len = buf->iov_max_len;
+
+            (void)memset(buf, 0, sizeof(*buf));
+        } else
+            dp = NULL;
+
+        luab_thread_mtx_unlock(L, fname);
+
+        if (dp != NULL && (flags & IOV_BUFF)) {
+
+            if ((flags & IOV_MMAP) == 0)
+                luab_core_freex(dp, len, LUAB_ALLOC_SCRUB);
+            else
+                (void)munmap(dp, len);
+        }
+    } else
+        errno = EINVAL;
+}
+
 /*
  * Generic accessor.
  */
@@ -639,20 +739,19 @@ luab_iovec_copyin(luab_iovec_t *buf, const void *dp, size_t len)
 
     if (buf != NULL) {
 
-        if ((buf->iov_max_len <= luab_env_buf_max) &&
-            (len <= buf->iov_max_len) &&
-            ((buf->iov_flags & IOV_BUFF) != 0)) {
+        if (luab_iovec_isrxbuf(buf) &&
+            (len <= buf->iov_max_len)) {
 
-            luab_thread_mtx_lock(NULL, __func__);
+            if ((status = luab_iovec_hold(NULL, buf, __func__)) == 0) {
+                iov = &(buf->iov);
+                olen = iov->iov_len;
+                iov->iov_len = len;
 
-            iov = &(buf->iov);
-            olen = iov->iov_len;
-            iov->iov_len = len;
+                if ((status = luab_iov_copyin(iov, dp, len)) != 0)
+                    iov->iov_len = olen;
 
-            if ((status = luab_iov_copyin(iov, dp, len)) != 0)
-                iov->iov_len = olen;
-
-            luab_thread_mtx_unlock(NULL, __func__);
+                luab_iovec_rele(NULL, buf, __func__);
+            }
         } else {
             errno = ERANGE;
             status = -1;
@@ -673,16 +772,14 @@ luab_iovec_copyout(luab_iovec_t *buf, void *dp, size_t len)
 
     if (buf != NULL) {
 
-        if ((buf->iov_max_len <= luab_env_buf_max) &&
-            (len <= buf->iov_max_len) &&
-            ((buf->iov_flags & IOV_BUFF) != 0)) {
-
-            luab_thread_mtx_lock(NULL, __func__);
-
-            iov = &(buf->iov);
-            status = luab_iov_copyout(iov, dp, len);
+        if (luab_iovec_istxbuf(buf) &&
+            (len <= buf->iov_max_len)) {
 
-            luab_thread_mtx_unlock(NULL, __func__);
+            if ((status = luab_iovec_hold(NULL, buf, __func__)) == 0) {
+                iov = &(buf->iov);
+                status = luab_iov_copyout(iov, dp, len);
+                luab_iovec_rele(NULL, buf, __func__);
+            }
         } else {
             errno = ERANGE;
             status = -1;
@@ -707,23 +804,24 @@ luab_iovec_read(lua_State *L, int fd, luab_iovec_t *buf, size_t *n)
 
     if (buf != NULL) {
 
-        if ((buf->iov_max_len <= luab_env_buf_max) &&
-            ((buf->iov_flags & IOV_BUFF) != 0)) {
+        if (luab_iovec_isrxbuf(buf)) {
 
-            luab_thread_mtx_lock(L, __func__);
+            if (luab_iovec_hold(L, buf, __func__) == 0) {
 
-            len = (n == NULL) ? buf->iov_max_len : *n;
+                len = (n == NULL) ? buf->iov_max_len : *n;
 
-            if (((bp = buf->iov.iov_base) != NULL) &&
-                (len <= buf->iov_max_len)) {
+                if (((bp = buf->iov.iov_base) != NULL) &&
+                    (len <= buf->iov_max_len)) {
 
-                if ((count = read(fd, bp, len)) > 0)
-                    buf->iov.iov_len = count;
-            } else {
-                errno = ERANGE;
+                    if ((count = read(fd, bp, len)) > 0)
+                        buf->iov.iov_len = count;
+                } else {
+                    errno = ERANGE;
+                    count = luab_env_error;
+                }
+                luab_iovec_rele(L, buf, __func__);
+            } else
                 count = luab_env_error;
-            }
-            luab_thread_mtx_unlock(L, __func__);
         } else {
             errno = ERANGE;
             count = luab_env_error;
@@ -743,15 +841,15 @@ luab_iovec_readv(lua_State *L, int fd, luab_iovec_t *buf, size_t n)
 
     if (buf != NULL) {
 
-        if ((buf->iov_max_len <= luab_env_buf_max) &&
-            ((buf->iov_flags & IOV_BUFF) != 0)) {
-
-            luab_thread_mtx_lock(L, __func__);
+        if (luab_iovec_isrxbuf(buf)) {
 
-            iov = &(buf->iov);
-            count = luab_iov_readv(iov, fd, n);
+            if (luab_iovec_hold(L, buf, __func__) == 0) {
 
-            luab_thread_mtx_unlock(L, __func__);
+                iov = &(buf->iov);
+                count = luab_iov_readv(iov, fd, n);
+                luab_iovec_rele(L, buf, __func__);
+            } else
+                count = luab_env_error;
         } else {
             errno = ERANGE;
             count = luab_env_error;
@@ -772,21 +870,22 @@ luab_iovec_write(lua_State *L, int fd, luab_iovec_t *buf, size_t *n)
 
     if (buf != NULL) {
 
-        if ((buf->iov_max_len <= luab_env_buf_max) &&
-            ((buf->iov_flags & IOV_BUFF) != 0)) {
+        if (luab_iovec_istxbuf(buf)) {
 
-            luab_thread_mtx_lock(L, __func__);
+            if (luab_iovec_hold(L, buf, __func__) == 0) {
 
-            len = (n == NULL) ? buf->iov.iov_len : *n;
+                len = (n == NULL) ? buf->iov.iov_len : *n;
 
-            if (((bp = buf->iov.iov_base) != NULL) &&
-                (len <= buf->iov_max_len))
-                count = write(fd, bp, len);
-            else {
-                errno = ERANGE;
+                if (((bp = buf->iov.iov_base) != NULL) &&
+                    (len <= buf->iov_max_len))
+                    count = write(fd, bp, len);
+                else {
+                    errno = ERANGE;
+                    count = luab_env_error;
+                }
+                luab_iovec_rele(L, buf, __func__);
+            } else
                 count = luab_env_error;
-            }
-            luab_thread_mtx_unlock(L, __func__);
         } else {
             errno = ERANGE;
             count = luab_env_error;
@@ -806,15 +905,15 @@ luab_iovec_writev(lua_State *L, int fd, luab_iovec_t *buf, size_t n)
 
     if (buf != NULL) {
 
-        if ((buf->iov_max_len <= luab_env_buf_max) &&
-            ((buf->iov_flags & IOV_BUFF) != 0)) {
+        if (luab_iovec_istxbuf(buf)) {
 
-            luab_thread_mtx_lock(L, __func__);
+            if (luab_iovec_hold(L, buf, __func__) == 0) {
 
-            iov = &(buf->iov);
-            count = luab_iov_writev(iov, fd, n);
-
-            luab_thread_mtx_unlock(L, __func__);
+                iov = &(buf->iov);
+                count = luab_iov_writev(iov, fd, n);
+                luab_iovec_rele(L, buf, __func__);
+            } else
+                count = luab_env_error;
         } else {
             errno = ERANGE;
             count = luab_env_error;
@@ -837,23 +936,24 @@ luab_iovec_readlink(lua_State *L, const char *path, luab_iovec_t *buf, size_t *n
 
     if (path != NULL && buf != NULL) {
 
-        if ((buf->iov_max_len <= luab_env_buf_max) &&
-            ((buf->iov_flags & IOV_BUFF) != 0)) {
+        if (luab_iovec_isrxbuf(buf)) {
 
-            luab_thread_mtx_lock(L, __func__);
+            if (luab_iovec_hold(L, buf, __func__) == 0) {
 
-            len = (n == NULL) ? buf->iov_max_len : *n;
+                len = (n == NULL) ? buf->iov_max_len : *n;
 
-            if (((bp = buf->iov.iov_base) != NULL) &&
-                (len <= buf->iov_max_len)) {
+                if (((bp = buf->iov.iov_base) != NULL) &&
+                    (len <= buf->iov_max_len)) {
 
-                if ((count = readlink(path, bp, len)) > 0)
-                    buf->iov.iov_len = count;
-            } else {
-                errno = ERANGE;
+                    if ((count = readlink(path, bp, len)) > 0)
+                        buf->iov.iov_len = count;
+                } else {
+                    errno = ERANGE;
+                    count = luab_env_error;
+                }
+                luab_iovec_rele(L, buf, __func__);
+            } else
                 count = luab_env_error;
-            }
-            luab_thread_mtx_unlock(L, __func__);
         } else {
             errno = ERANGE;
             count = luab_env_error;
@@ -877,23 +977,24 @@ luab_iovec_pread(lua_State *L, int fd, luab_iovec_t *buf, size_t *n, off_t off)
 
     if (buf != NULL) {
 
-        if ((buf->iov_max_len <= luab_env_buf_max) &&
-            ((buf->iov_flags & IOV_BUFF) != 0)) {
+        if (luab_iovec_isrxbuf(buf)) {
 
-            luab_thread_mtx_lock(L, __func__);
+            if (luab_iovec_hold(L, buf, __func__) == 0) {
 
-            len = (n == NULL) ? buf->iov_max_len : *n;
+                len = (n == NULL) ? buf->iov_max_len : *n;
 
-            if (((bp = buf->iov.iov_base) != NULL) &&
-                (len <= buf->iov_max_len)) {
+                if (((bp = buf->iov.iov_base) != NULL) &&
+                    (len <= buf->iov_max_len)) {
 
-                if ((count = pread(fd, bp, len, off)) > 0)
-                    buf->iov.iov_len = count;
-            } else {
-                errno = ERANGE;
+                    if ((count = pread(fd, bp, len, off)) > 0)
+                        buf->iov.iov_len = count;
+                } else {
+                    errno = ERANGE;
+                    count = luab_env_error;
+                }
+                luab_iovec_rele(L, buf, __func__);
+            } else
                 count = luab_env_error;
-            }
-            luab_thread_mtx_unlock(L, __func__);
         } else {
             errno = ERANGE;
             count = luab_env_error;
@@ -914,21 +1015,22 @@ luab_iovec_pwrite(lua_State *L, int fd, luab_iovec_t *buf, size_t *n, off_t off)
 
     if (buf != NULL) {
 
-        if ((buf->iov_max_len <= luab_env_buf_max) &&
-            ((buf->iov_flags & IOV_BUFF) != 0)) {
+        if (luab_iovec_istxbuf(buf)) {
 
-            luab_thread_mtx_lock(L, __func__);
+            if (luab_iovec_hold(L, buf, __func__) == 0) {
 
-            len = (n == NULL) ? buf->iov.iov_len : *n;
+                len = (n == NULL) ? buf->iov.iov_len : *n;
 
-            if (((bp = buf->iov.iov_base) != NULL) &&
-                (len <= buf->iov_max_len))
-                count = pwrite(fd, bp, len, off);
-            else {
-                errno = ERANGE;
+                if (((bp = buf->iov.iov_base) != NULL) &&
+                    (len <= buf->iov_max_len))
+                    count = pwrite(fd, bp, len, off);
+                else {
+                    errno = ERANGE;
+                    count = luab_env_error;
+                }
+                luab_iovec_rele(L, buf, __func__);
+            } else
                 count = luab_env_error;
-            }
-            luab_thread_mtx_unlock(L, __func__);
         } else {
             errno = ERANGE;
             count = luab_env_error;
@@ -952,24 +1054,25 @@ luab_iovec_readlinkat(lua_State *L, int fd, const char *path,
 
     if (path != NULL && buf != NULL) {
 
-        if ((buf->iov_max_len <= luab_env_buf_max) &&
-            ((buf->iov_flags & IOV_BUFF) != 0)) {
+        if (luab_iovec_isrxbuf(buf)) {
 
-            luab_thread_mtx_lock(L, __func__);
+            if (luab_iovec_hold(L, buf, __func__) == 0) {
 
-            len = (n == NULL) ? buf->iov_max_len : *n;
+                len = (n == NULL) ? buf->iov_max_len : *n;
 
-            if (((bp = buf->iov.iov_base) != NULL) &&
-                (len <= buf->iov_max_len)) {
+                if (((bp = buf->iov.iov_base) != NULL) &&
+                    (len <= buf->iov_max_len)) {
 
-                if ((count = readlinkat(fd, path, bp, len)) > 0)
-                    buf->iov.iov_len = count;
+                    if ((count = readlinkat(fd, path, bp, len)) > 0)
+                        buf->iov.iov_len = count;
 
-            } else {
-                errno = ERANGE;
+                } else {
+                    errno = ERANGE;
+                    count = luab_env_error;
+                }
+                luab_iovec_rele(L, buf, __func__);
+            } else
                 count = luab_env_error;
-            }
-            luab_thread_mtx_unlock(L, __func__);
         } else {
             errno = ERANGE;
             count = luab_env_error;
@@ -991,15 +1094,15 @@ luab_iovec_preadv(lua_State *L, int fd, luab_iovec_t *buf, size_t n, off_t off)
 
     if (buf != NULL) {
 
-        if ((buf->iov_max_len <= luab_env_buf_max) &&
-            ((buf->iov_flags & IOV_BUFF) != 0)) {
+        if (luab_iovec_isrxbuf(buf)) {
 
-            luab_thread_mtx_lock(L, __func__);
+            if (luab_iovec_hold(L, buf, __func__) == 0) {
 
-            iov = &(buf->iov);
-            count = luab_iov_preadv(iov, fd, n, off);
-
-            luab_thread_mtx_unlock(L, __func__);
+                iov = &(buf->iov);
+                count = luab_iov_preadv(iov, fd, n, off);
+                luab_iovec_rele(L, buf, __func__);
+            } else
+                count = luab_env_error;
         } else {
             errno = ERANGE;
             count = luab_env_error;
@@ -1019,15 +1122,15 @@ luab_iovec_pwritev(lua_State *L, int fd, luab_iovec_t *buf, size_t n, off_t off)
 
     if (buf != NULL) {
 
-        if ((buf->iov_max_len <= luab_env_buf_max) &&
-            ((buf->iov_flags & IOV_BUFF) != 0)) {
-
-            luab_thread_mtx_lock(L, __func__);
+        if (luab_iovec_istxbuf(buf)) {
 
-            iov = &(buf->iov);
-            count = luab_iov_pwritev(iov, fd, n, off);
+            if (luab_iovec_hold(L, buf, __func__) == 0) {
 
-            luab_thread_mtx_unlock(L, __func__);
+                iov = &(buf->iov);
+                count = luab_iov_pwritev(iov, fd, n, off);
+                luab_iovec_rele(L, buf, __func__);
+            } else
+                count = luab_env_error;
         } else {
             errno = ERANGE;
             count = luab_env_error;
@@ -1053,26 +1156,27 @@ luab_iovec_recv(lua_State *L, int s, luab_iovec_t *buf, size_t *n, int flags)
 
     if (buf != NULL) {
 
-        if ((buf->iov_max_len <= luab_env_buf_max) &&
-            ((buf->iov_flags & IOV_BUFF) != 0)) {
+        if (luab_iovec_isrxbuf(buf)) {
 
-            luab_thread_mtx_lock(L, __func__);
+            if (luab_iovec_hold(L, buf, __func__) == 0) {
 
-            if (n == NULL)
-                len = buf->iov_max_len;
-            else
-                len = *n;
+                if (n == NULL)
+                    len = buf->iov_max_len;
+                else
+                    len = *n;
 
-            if (((bp = buf->iov.iov_base) != NULL) &&
-                (len <= buf->iov_max_len)) {
+                if (((bp = buf->iov.iov_base) != NULL) &&
+                    (len <= buf->iov_max_len)) {
 
-                if ((count = recv(s, bp, len, flags)) > 0)
-                    buf->iov.iov_len = count;
-            } else {
-                errno = ERANGE;
+                    if ((count = recv(s, bp, len, flags)) > 0)
+                        buf->iov.iov_len = count;
+                } else {
+                    errno = ERANGE;
+                    count = luab_env_error;
+                }
+                luab_iovec_rele(L, buf, __func__);
+            } else
                 count = luab_env_error;
-            }
-            luab_thread_mtx_unlock(L, __func__);
         } else {
             errno = ERANGE;
             count = luab_env_error;
@@ -1094,27 +1198,28 @@ luab_iovec_recvfrom(lua_State *L, int s, luab_iovec_t *buf, size_t *n,
 
     if (buf != NULL) {
 
-        if ((buf->iov_max_len <= luab_env_buf_max) &&
-            ((buf->iov_flags & IOV_BUFF) != 0)) {
+        if (luab_iovec_isrxbuf(buf)) {
 
-            luab_thread_mtx_lock(L, __func__);
+            if (luab_iovec_hold(L, buf, __func__) == 0) {
 
-            if (n == NULL)
-                len = buf->iov_max_len;
-            else
-                len = *n;
+                if (n == NULL)
+                    len = buf->iov_max_len;
+                else
+                    len = *n;
 
-            if (((bp = buf->iov.iov_base) != NULL) &&
-                (len <= buf->iov_max_len)) {
+                if (((bp = buf->iov.iov_base) != NULL) &&
+                    (len <= buf->iov_max_len)) {
 
-                if ((count = recvfrom(s, bp, len, flags, from, fromlen)) > 0)
-                    buf->iov.iov_len = count;
+                    if ((count = recvfrom(s, bp, len, flags, from, fromlen)) > 0)
+                        buf->iov.iov_len = count;
 
-            } else {
-                errno = ERANGE;
+                } else {
+                    errno = ERANGE;
+                    count = luab_env_error;
+                }
+                luab_iovec_rele(L, buf, __func__);
+            } else
                 count = luab_env_error;
-            }
-            luab_thread_mtx_unlock(L, __func__);
         } else {
             errno = ERANGE;
             count = luab_env_error;
@@ -1135,24 +1240,25 @@ luab_iovec_send(lua_State *L, int s, luab_iovec_t *buf, size_t *n, int flags)
 
     if (buf != NULL) {
 
-        if ((buf->iov_max_len <= luab_env_buf_max) &&
-            ((buf->iov_flags & IOV_BUFF) != 0)) {
+        if (luab_iovec_istxbuf(buf)) {
 
-            luab_thread_mtx_lock(L, __func__);
+            if (luab_iovec_hold(L, buf, __func__) == 0) {
 
-            if (n == NULL)
-                len = buf->iov.iov_len;
-            else
-                len = *n;
+                if (n == NULL)
+                    len = buf->iov.iov_len;
+                else
+                    len = *n;
 
-            if (((bp = buf->iov.iov_base) != NULL) &&
-                (len <= buf->iov_max_len))
-                count = send(s, bp, len, flags);
-            else {
-                errno = ERANGE;
+                if (((bp = buf->iov.iov_base) != NULL) &&
+                    (len <= buf->iov_max_len))
+                    count = send(s, bp, len, flags);
+                else {
+                    errno = ERANGE;
+                    count = luab_env_error;
+                }
+                luab_iovec_rele(L, buf, __func__);
+            } else
                 count = luab_env_error;
-            }
-            luab_thread_mtx_unlock(L, __func__);
         } else {
             errno = ERANGE;
             count = luab_env_error;
@@ -1174,24 +1280,25 @@ luab_iovec_sendto(lua_State *L, int s, luab_iovec_t *buf, size_t *n,
 
     if (buf != NULL) {
 
-        if ((buf->iov_max_len <= luab_env_buf_max) &&
-            ((buf->iov_flags & IOV_BUFF) != 0)) {
+        if (luab_iovec_istxbuf(buf)) {
 
-            luab_thread_mtx_lock(L, __func__);
+            if (luab_iovec_hold(L, buf, __func__) == 0) {
 
-            if (n == NULL)
-                len = buf->iov.iov_len;
-            else
-                len = *n;
+                if (n == NULL)
+                    len = buf->iov.iov_len;
+                else
+                    len = *n;
 
-            if (((bp = buf->iov.iov_base) != NULL) &&
-                (len <= buf->iov_max_len))
-                count = sendto(s, bp, len, flags, to, tolen);
-            else {
-                errno = ERANGE;
+                if (((bp = buf->iov.iov_base) != NULL) &&
+                    (len <= buf->iov_max_len))
+                    count = sendto(s, bp, len, flags, to, tolen);
+                else {
+                    errno = ERANGE;
+                    count = luab_env_error;
+                }
+                luab_iovec_rele(L, buf, __func__);
+            } else
                 count = luab_env_error;
-            }
-            luab_thread_mtx_unlock(L, __func__);
         } else {
             errno = ERANGE;
             count = luab_env_error;
@@ -44,73 +44,6 @@
  * Generic operations.
  */
 
-void
-luab_core_free(void *v, size_t sz)
-{
-    if (v != NULL) {
-        if (sz > 0)
-            (void)memset_s(v, sz, 0, sz);
-
-        free(v);
-    } else
-        errno = ENOENT;
-}
-
-void
-luab_core_freestr(caddr_t dp)
-{
-    size_t n;
-
-    if (dp != NULL) {
-        n = strnlen(dp, luab_env_buf_max);
-        luab_core_free(dp, n);
-    } else
-        errno = ENOENT;
-}
-
-void *
-luab_core_alloc(size_t n, size_t sz)
-{
-    size_t nbytes, len;
-    caddr_t dp;
-
-    if ((nbytes = (n * sz)) > 0) {
-        len = nbytes + sz;
-
-        if ((dp = malloc(len)) != NULL)
-            (void)memset_s(dp, len, 0, len);
-    } else {
-        errno = ERANGE;
-        dp = NULL;
-    }
-    return (dp);
-}
-
-char *
-luab_core_allocstring(const char *dp, size_t *np)
-{
-    size_t len;
-    caddr_t bp;
-
-    if (dp != NULL) {
-        len = strnlen(dp, luab_env_buf_max);
-
-        if ((bp = luab_core_alloc(len, sizeof(char))) != NULL)
-            (void)memmove(bp, dp, len);
-        else
-            len = 0;
-    } else {
-        errno = ENOENT;
-        bp = NULL;
-        len = 0;
-    }
-
-    if (np != NULL)
-        *np = len;
-
-    return (bp);
-}
-
 void
 luab_core_errx(int eval, const char *fmt, ...)
 {
@@ -222,6 +155,28 @@ luab_core_gc(lua_State *L, int narg, luab_module_t *m)
     return (0);
 }
 
+/*
+ * Same as luab_core_gc, but luab_thread_mtx is held by the caller, thus
+ * nothing is raised.
+ */
+int
+luab_core_xgc(lua_State *L, int narg, luab_module_t *m)
+{
+    luab_udata_t *self, *ud, *ud_tmp;
+
+    if ((self = luab_isdata(L, narg, m, luab_udata_t *)) != NULL) {
+
+        LIST_FOREACH_SAFE(ud, &self->ud_list, ud_next, ud_tmp)
+            luab_udata_xremove(ud);
+
+        if (self->ud_xhd != NULL)
+            luab_udata_xremove(self);
+
+        (void)memset_s(self, m->m_len, 0, m->m_len);
+    }
+    return (0);
+}
+
 int
 luab_core_len(lua_State *L, int narg, luab_module_t *m)
 {
@@ -248,7 +203,12 @@ luab_core_tostring(lua_State *L, int narg, luab_module_t *m)
     (void)luab_core_checkmaxargs(L, narg);
 
     if ((ud = luab_todata(L, narg, m, luab_udata_t *)) != NULL)
-        status = luab_pushfstring(L, "%s (%p,%d)", m->m_name, ud, ud->ud_ts);
+#ifdef LUAB_UDATA_TS
+        status = luab_pushfstring(L, "%s (%p,%d)", m->m_name, ud,
+            (int)ud->ud_ts);
+#else
+        status = luab_pushfstring(L, "%s (%p)", m->m_name, ud);
+#endif
     else
         status = luab_pushfstring(L, "%s (%p,%d)", "nil", NULL, 0);   /* XXX */
 
@@ -323,7 +283,7 @@ luab_toxinteger(lua_State *L, int narg, luab_module_t *m, lua_Integer b_msk)
         if (lua_isnumber(L, narg) != 0)
             return (luab_tointeger(L, narg, b_msk));
 
-        if ((xp = luab_udataisnil(L, 1, m, lua_Integer *)) != NULL)
+        if ((xp = luab_udataisnil(L, narg, m, lua_Integer *)) != NULL)
             return (*xp & b_msk);
     } else
         errno = ENOSYS;
@@ -341,7 +301,7 @@ luab_tolxinteger(lua_State *L, int narg, luab_module_t *m, int s)
         if (lua_isnumber(L, narg) != 0)
             return (luab_tolinteger(L, narg, s));
 
-        if ((xp = luab_udataisnil(L, 1, m, lua_Integer *)) != NULL) {
+        if ((xp = luab_udataisnil(L, narg, m, lua_Integer *)) != NULL) {
             b_msk = luab_core_Integer_promotion_msk(s);
             return (*xp & b_msk);
         }
@@ -376,7 +336,7 @@ luab_checkxinteger(lua_State *L, int narg, luab_module_t *m, lua_Integer b_msk)
         if (lua_isnumber(L, narg) != 0)
             return (luab_checkinteger(L, narg, b_msk));
 
-        if ((xp = luab_udataisnil(L, 1, m, lua_Integer *)) != NULL)
+        if ((xp = luab_udataisnil(L, narg, m, lua_Integer *)) != NULL)
             return (*xp & b_msk);
     } else
         luab_core_argerror(L, narg, NULL, 0, 0, ENOSYS);
@@ -394,7 +354,7 @@ luab_checklxinteger(lua_State *L, int narg, luab_module_t *m, int s)
         if (lua_isnumber(L, narg) != 0)
             return (luab_checklinteger(L, narg, s));
 
-        if ((xp = luab_udataisnil(L, 1, m, lua_Integer *)) != NULL) {
+        if ((xp = luab_udataisnil(L, narg, m, lua_Integer *)) != NULL) {
             b_msk = luab_core_Integer_promotion_msk(s);
             return (*xp & b_msk);
         }
@@ -414,7 +374,7 @@ luab_toxnumber(lua_State *L, int narg, luab_module_t *m)
         if (lua_isnumber(L, narg) != 0)
             return (lua_tonumber(L, narg));
 
-        if ((xp = luab_udataisnil(L, 1, m, lua_Number *)) != NULL)
+        if ((xp = luab_udataisnil(L, narg, m, lua_Number *)) != NULL)
             return (*xp);
     } else
         errno = ENOSYS;
@@ -432,7 +392,7 @@ luab_checkxnumber(lua_State *L, int narg, luab_module_t *m)
         if (lua_isnumber(L, narg) != 0)
             return (luaL_checknumber(L, narg));
 
-        if ((xp = luab_udataisnil(L, 1, m, lua_Number *)) != NULL)
+        if ((xp = luab_udataisnil(L, narg, m, lua_Number *)) != NULL)
             return (*xp);
     } else
         luab_core_argerror(L, narg, NULL, 0, 0, ENOSYS);
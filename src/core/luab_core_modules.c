@@ -666,6 +666,82 @@ luab_module_vec_t luab_env_type_vec[] = {
         .mv_mod = &luab_sigvec_type,
         .mv_init = luab_env_newmetatable,
         .mv_idx = LUAB_SIGVEC_IDX,
+    },{
+        .mv_mod = &luab_kqueue_type,
+        .mv_init = luab_env_newmetatable,
+        .mv_idx = LUAB_KQUEUE_IDX,
+    },{
+        .mv_mod = &luab_pool_type,
+        .mv_init = luab_env_newmetatable,
+        .mv_idx = LUAB_POOL_IDX,
+    },{
+        .mv_mod = &luab_future_type,
+        .mv_init = luab_env_newmetatable,
+        .mv_idx = LUAB_FUTURE_IDX,
+    },{
+        .mv_mod = &luab_channel_type,
+        .mv_init = luab_env_newmetatable,
+        .mv_idx = LUAB_CHANNEL_IDX,
+    },{
+        .mv_mod = &luab_mmsgbatch_type,
+        .mv_init = luab_env_newmetatable,
+        .mv_idx = LUAB_MMSGBATCH_IDX,
+    },{
+        .mv_mod = &luab_dbcursor_type,
+        .mv_init = luab_env_newmetatable,
+        .mv_idx = LUAB_DBCURSOR_IDX,
+    },{
+        .mv_mod = &luab_slice_type,
+        .mv_init = luab_env_newmetatable,
+        .mv_idx = LUAB_SLICE_IDX,
+    },{
+        .mv_mod = &luab_ringbuf_type,
+        .mv_init = luab_env_newmetatable,
+        .mv_idx = LUAB_RINGBUF_IDX,
+    },{
+        .mv_mod = &luab_iovec_array_type,
+        .mv_init = luab_env_newmetatable,
+        .mv_idx = LUAB_IOVEC_ARRAY_IDX,
+    },{
+        .mv_mod = &luab_aioq_type,
+        .mv_init = luab_env_newmetatable,
+        .mv_idx = LUAB_AIOQ_IDX,
+    },{
+        .mv_mod = &luab_dirwalk_type,
+        .mv_init = luab_env_newmetatable,
+        .mv_idx = LUAB_DIRWALK_IDX,
+    },{
+        .mv_mod = &luab_dirbuf_type,
+        .mv_init = luab_env_newmetatable,
+        .mv_idx = LUAB_DIRBUF_IDX,
+    },{
+        .mv_mod = &luab_btreeinfo_type,
+        .mv_init = luab_env_newmetatable,
+        .mv_idx = LUAB_BTREEINFO_IDX,
+    },{
+        .mv_mod = &luab_hashinfo_type,
+        .mv_init = luab_env_newmetatable,
+        .mv_idx = LUAB_HASHINFO_IDX,
+    },{
+        .mv_mod = &luab_recnoinfo_type,
+        .mv_init = luab_env_newmetatable,
+        .mv_idx = LUAB_RECNOINFO_IDX,
+    },{
+        .mv_mod = &luab_dbcache_type,
+        .mv_init = luab_env_newmetatable,
+        .mv_idx = LUAB_DBCACHE_IDX,
+    },{
+        .mv_mod = &luab_dbloader_type,
+        .mv_init = luab_env_newmetatable,
+        .mv_idx = LUAB_DBLOADER_IDX,
+    },{
+        .mv_mod = &luab_sstable_type,
+        .mv_init = luab_env_newmetatable,
+        .mv_idx = LUAB_SSTABLE_IDX,
+    },{
+        .mv_mod = &luab_bloom_type,
+        .mv_init = luab_env_newmetatable,
+        .mv_idx = LUAB_BLOOM_IDX,
     },
 #endif  /* __BSD_VISIBLE */
     LUAB_MOD_VEC_SENTINEL
@@ -701,6 +777,9 @@ static luab_module_vec_t luab_env_sys_vec[] = {
     {
         .mv_mod = &luab_sys_dirent_lib,
         .mv_init = luab_env_newtable,
+    },{
+        .mv_mod = &luab_sys_event_lib,
+        .mv_init = luab_env_newtable,
     },{
         .mv_mod = &luab_sys_file_lib,
         .mv_init = luab_env_newtable,
@@ -710,6 +789,9 @@ static luab_module_vec_t luab_env_sys_vec[] = {
     },{
         .mv_mod = &luab_sys_jail_lib,
         .mv_init = luab_env_newtable,
+    },{
+        .mv_mod = &luab_sys_mman_lib,
+        .mv_init = luab_env_newtable,
     },{
         .mv_mod = &luab_sys_mount_lib,
         .mv_init = luab_env_newtable,
@@ -786,6 +868,9 @@ static luab_module_vec_t luab_env_core_vec[] = {
 /* Interface against <xxx.h> */
 static luab_module_vec_t luab_env_vec[] = {
     {
+        .mv_mod = &luab_aio_lib,
+        .mv_init = luab_env_newtable,
+    },{
         .mv_mod = &luab_cpio_lib,
         .mv_init = luab_env_newtable,
     },{
@@ -815,6 +900,9 @@ static luab_module_vec_t luab_env_vec[] = {
     },{
         .mv_mod = &luab_pwd_lib,
         .mv_init = luab_env_newtable,
+    },{
+        .mv_mod = &luab_pool_lib,
+        .mv_init = luab_env_newtable,
     },{
         .mv_mod = &luab_pthread_lib,
         .mv_init = luab_env_newtable,
@@ -0,0 +1,731 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/queue.h>
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+
+/*
+ * Tags, encoded values are prefixed by.
+ */
+
+#define LUAB_POOL_NIL           0x00
+#define LUAB_POOL_BOOLEAN       0x01
+#define LUAB_POOL_NUMBER        0x02
+#define LUAB_POOL_STRING        0x03
+#define LUAB_POOL_TABLE         0x04
+#define LUAB_POOL_TABLE_END     0x05
+#define LUAB_POOL_CHANNEL       0x06
+
+#define LUAB_POOL_DEPTH_MAX     16
+
+/*
+ * Subr.
+ */
+
+static int
+pool_buf_append(luab_pool_buf_t *pb, const void *v, size_t len)
+{
+    size_t max_len;
+    caddr_t bp;
+
+    if ((pb->pb_len + len) > pb->pb_max_len) {
+
+        if ((max_len = pb->pb_max_len) == 0)
+            max_len = luab_env_buf_max;
+
+        while (max_len < (pb->pb_len + len))
+            max_len <<= 1;
+
+        if ((bp = luab_core_realloc(pb->pb_base, max_len,
+            LUAB_ALLOC_NOZERO)) == NULL)
+            return (luab_env_error);
+
+        pb->pb_base = bp;
+        pb->pb_max_len = max_len;
+    }
+    (void)memmove(pb->pb_base + pb->pb_len, v, len);
+    pb->pb_len += len;
+
+    return (0);
+}
+
+static int
+pool_buf_read(luab_pool_buf_t *pb, size_t *off, void *v, size_t len)
+{
+    if ((*off + len) <= pb->pb_len) {
+        (void)memmove(v, pb->pb_base + *off, len);
+        *off += len;
+        return (0);
+    }
+    errno = ERANGE;
+    return (luab_env_error);
+}
+
+/*
+ * Releases references on (LUA_TUSERDATA(CHANNEL)), held by encoded values.
+ */
+static void
+pool_buf_rele(luab_pool_buf_t *pb)
+{
+    luab_channel_t *ch;
+    lua_Number x;
+    size_t off, len;
+    u_char tag;
+
+    for (off = 0; pool_buf_read(pb, &off, &tag, sizeof(tag)) == 0; ) {
+
+        switch (tag) {
+        case LUAB_POOL_BOOLEAN:
+            off += sizeof(tag);
+            break;
+        case LUAB_POOL_NUMBER:
+            off += sizeof(x);
+            break;
+        case LUAB_POOL_STRING:
+            if (pool_buf_read(pb, &off, &len, sizeof(len)) == 0)
+                off += len;
+            break;
+        case LUAB_POOL_CHANNEL:
+            if (pool_buf_read(pb, &off, &ch, sizeof(ch)) == 0)
+                luab_channel_rele(ch);
+            break;
+        default:
+            break;
+        }
+    }
+    pb->pb_len = 0;
+}
+
+/*
+ * Releases the buffer only, encoded values must be released before by
+ * pool_buf_rele, since pj_chunk holds code, which is not tagged.
+ */
+static void
+pool_buf_free(luab_pool_buf_t *pb)
+{
+    if (pb->pb_base != NULL)
+        luab_core_free(pb->pb_base, pb->pb_max_len);
+
+    pb->pb_base = NULL;
+    pb->pb_len = 0;
+    pb->pb_max_len = 0;
+}
+
+static int
+pool_writer(lua_State *L __unused, const void *v, size_t len, void *arg)
+{
+    return (pool_buf_append((luab_pool_buf_t *)arg, v, len) != 0);
+}
+
+/*
+ * Serialization, [stack -> buffer] and vice versa.
+ */
+
+static int
+pool_encode(lua_State *L, int narg, luab_pool_buf_t *pb, int depth)
+{
+    luab_module_t *m;
+    luab_channel_udata_t *ud;
+    lua_Number x;
+    const char *dp;
+    size_t len;
+    u_char tag;
+    int status;
+
+    narg = lua_absindex(L, narg);
+
+    switch (lua_type(L, narg)) {
+    case LUA_TNIL:
+        tag = LUAB_POOL_NIL;
+        status = pool_buf_append(pb, &tag, sizeof(tag));
+        break;
+    case LUA_TBOOLEAN:
+        tag = LUAB_POOL_BOOLEAN;
+
+        if ((status = pool_buf_append(pb, &tag, sizeof(tag))) == 0) {
+            tag = (u_char)lua_toboolean(L, narg);
+            status = pool_buf_append(pb, &tag, sizeof(tag));
+        }
+        break;
+    case LUA_TNUMBER:
+        tag = LUAB_POOL_NUMBER;
+        x = lua_tonumber(L, narg);
+
+        if ((status = pool_buf_append(pb, &tag, sizeof(tag))) == 0)
+            status = pool_buf_append(pb, &x, sizeof(x));
+        break;
+    case LUA_TSTRING:
+        tag = LUAB_POOL_STRING;
+        dp = lua_tolstring(L, narg, &len);
+
+        if ((status = pool_buf_append(pb, &tag, sizeof(tag))) == 0) {
+
+            if ((status = pool_buf_append(pb, &len, sizeof(len))) == 0)
+                status = pool_buf_append(pb, dp, len);
+        }
+        break;
+    case LUA_TTABLE:
+
+        if (depth < LUAB_POOL_DEPTH_MAX && lua_checkstack(L, 2) != 0) {
+            tag = LUAB_POOL_TABLE;
+
+            if ((status = pool_buf_append(pb, &tag, sizeof(tag))) == 0) {
+                lua_pushnil(L);
+
+                while (lua_next(L, narg) != 0) {
+
+                    if ((status = pool_encode(L, -2, pb, depth + 1)) == 0)
+                        status = pool_encode(L, -1, pb, depth + 1);
+
+                    lua_pop(L, 1);
+
+                    if (status != 0) {
+                        lua_pop(L, 1);
+                        break;
+                    }
+                }
+            }
+
+            if (status == 0) {
+                tag = LUAB_POOL_TABLE_END;
+                status = pool_buf_append(pb, &tag, sizeof(tag));
+            }
+        } else {
+            errno = ELOOP;
+            status = luab_env_error;
+        }
+        break;
+    case LUA_TUSERDATA:
+        m = luab_xmod(CHANNEL, TYPE, __func__);
+
+        if ((ud = luab_isdata(L, narg, m, luab_channel_udata_t *)) != NULL) {
+            tag = LUAB_POOL_CHANNEL;
+
+            if ((status = pool_buf_append(pb, &tag, sizeof(tag))) == 0) {
+
+                if ((status = pool_buf_append(pb, &ud->ud_ch,
+                    sizeof(ud->ud_ch))) == 0)
+                    luab_channel_hold(ud->ud_ch);
+                else
+                    pb->pb_len -= sizeof(tag);
+            }
+        } else {
+            errno = EINVAL;
+            status = luab_env_error;
+        }
+        break;
+    default:
+        errno = EINVAL;
+        status = luab_env_error;
+        break;
+    }
+    return (status);
+}
+
+static int
+pool_decode(lua_State *L, luab_pool_buf_t *pb, size_t *off)
+{
+    luab_module_t *m;
+    luab_channel_t *ch;
+    lua_Number x;
+    size_t len;
+    u_char tag;
+    int status;
+
+    if (lua_checkstack(L, 3) == 0) {
+        errno = ENOMEM;
+        return (luab_env_error);
+    }
+
+    if ((status = pool_buf_read(pb, off, &tag, sizeof(tag))) != 0)
+        return (status);
+
+    switch (tag) {
+    case LUAB_POOL_NIL:
+        lua_pushnil(L);
+        break;
+    case LUAB_POOL_BOOLEAN:
+
+        if ((status = pool_buf_read(pb, off, &tag, sizeof(tag))) == 0)
+            lua_pushboolean(L, tag);
+        break;
+    case LUAB_POOL_NUMBER:
+
+        if ((status = pool_buf_read(pb, off, &x, sizeof(x))) == 0)
+            lua_pushnumber(L, x);
+        break;
+    case LUAB_POOL_STRING:
+
+        if ((status = pool_buf_read(pb, off, &len, sizeof(len))) == 0) {
+
+            if ((*off + len) <= pb->pb_len) {
+                lua_pushlstring(L, pb->pb_base + *off, len);
+                *off += len;
+            } else {
+                errno = ERANGE;
+                status = luab_env_error;
+            }
+        }
+        break;
+    case LUAB_POOL_TABLE:
+        lua_newtable(L);
+
+        while (status == 0) {
+
+            if (*off < pb->pb_len &&
+                pb->pb_base[*off] == LUAB_POOL_TABLE_END) {
+                *off += 1;
+                break;
+            }
+
+            if ((status = pool_decode(L, pb, off)) == 0) {
+
+                if ((status = pool_decode(L, pb, off)) == 0)
+                    lua_rawset(L, -3);
+                else
+                    lua_pop(L, 1);
+            }
+        }
+
+        if (status != 0)
+            lua_pop(L, 1);
+        break;
+    case LUAB_POOL_CHANNEL:
+        m = luab_xmod(CHANNEL, TYPE, __func__);
+
+        if ((status = pool_buf_read(pb, off, &ch, sizeof(ch))) == 0) {
+
+            if ((*m->m_create)(L, ch) == NULL)
+                status = luab_env_error;
+        }
+        break;
+    default:
+        errno = EINVAL;
+        status = luab_env_error;
+        break;
+    }
+    return (status);
+}
+
+static int
+pool_decodev(lua_State *L, luab_pool_buf_t *pb, int n)
+{
+    size_t off;
+    int base, i, status;
+
+    base = lua_gettop(L);
+
+    for (off = 0, i = 0, status = 0; i < n && status == 0; i++)
+        status = pool_decode(L, pb, &off);
+
+    if (status != 0)
+        lua_settop(L, base);
+
+    return (status);
+}
+
+/*
+ * Jobs.
+ */
+
+static luab_pool_job_t *
+pool_job_alloc(void)
+{
+    luab_pool_job_t *job;
+
+    if ((job = luab_core_alloc(1, sizeof(luab_pool_job_t))) != NULL) {
+
+        if (pthread_mutex_init(&job->pj_mtx, NULL) == 0) {
+
+            if (pthread_cond_init(&job->pj_cv, NULL) == 0) {
+                job->pj_refcnt = 2;     /* held by worker and future */
+                job->pj_state = PJ_PENDING;
+                return (job);
+            }
+            (void)pthread_mutex_destroy(&job->pj_mtx);
+        }
+        luab_core_free(job, sizeof(luab_pool_job_t));
+    }
+    return (NULL);
+}
+
+static void
+pool_job_free(luab_pool_job_t *job)
+{
+    pool_buf_free(&job->pj_chunk);
+
+    pool_buf_rele(&job->pj_args);
+    pool_buf_free(&job->pj_args);
+
+    pool_buf_rele(&job->pj_res);
+    pool_buf_free(&job->pj_res);
+
+    (void)pthread_cond_destroy(&job->pj_cv);
+    (void)pthread_mutex_destroy(&job->pj_mtx);
+
+    luab_core_free(job, sizeof(luab_pool_job_t));
+}
+
+static int
+pool_job_fail(lua_State *L, luab_pool_job_t *job, int narg)
+{
+    const char *msg;
+    size_t len;
+    u_char tag;
+
+    if (L == NULL || (msg = lua_tolstring(L, narg, &len)) == NULL) {
+        msg = strerror(errno);
+        len = strlen(msg);
+    }
+    pool_buf_rele(&job->pj_res);
+
+    tag = LUAB_POOL_STRING;
+
+    if (pool_buf_append(&job->pj_res, &tag, sizeof(tag)) == 0 &&
+        pool_buf_append(&job->pj_res, &len, sizeof(len)) == 0 &&
+        pool_buf_append(&job->pj_res, msg, len) == 0)
+        job->pj_nres = 1;
+    else
+        job->pj_nres = 0;
+
+    return (PJ_FAILED);
+}
+
+static int
+pool_job_exec(lua_State *L, luab_pool_job_t *job)
+{
+    const char *chunk;
+    int base, i, nres, status, state;
+
+    if (L != NULL) {
+        base = lua_gettop(L);
+        chunk = job->pj_chunk.pb_base;
+
+        status = luaL_loadbuffer(L, chunk, job->pj_chunk.pb_len, "=pool");
+
+        if (status == LUA_OK) {
+
+            if (pool_decodev(L, &job->pj_args, job->pj_nargs) == 0)
+                status = lua_pcall(L, job->pj_nargs, LUA_MULTRET, 0);
+            else {
+                lua_pushstring(L, strerror(errno));
+                status = LUA_ERRRUN;
+            }
+        }
+
+        if (status == LUA_OK) {
+            nres = lua_gettop(L) - base;
+
+            for (i = 1; i <= nres && status == 0; i++)
+                status = pool_encode(L, base + i, &job->pj_res, 0);
+
+            if (status == 0) {
+                job->pj_nres = nres;
+                state = PJ_DONE;
+            } else
+                state = pool_job_fail(NULL, job, 0);
+        } else
+            state = pool_job_fail(L, job, -1);
+
+        lua_settop(L, base);
+    } else {
+        errno = ENOMEM;
+        state = pool_job_fail(NULL, job, 0);
+    }
+    return (state);
+}
+
+/*
+ * Workers.
+ */
+
+static luab_pool_job_t *
+pool_dequeue(luab_pool_t *pool)
+{
+    luab_pool_job_t *job;
+
+    (void)pthread_mutex_lock(&pool->pl_mtx);
+
+    while (TAILQ_EMPTY(&pool->pl_queue) && pool->pl_shutdown == 0)
+        (void)pthread_cond_wait(&pool->pl_cv, &pool->pl_mtx);
+
+    if ((job = TAILQ_FIRST(&pool->pl_queue)) != NULL) {
+        TAILQ_REMOVE(&pool->pl_queue, job, pj_next);
+        pool->pl_npending--;
+    }
+    (void)pthread_mutex_unlock(&pool->pl_mtx);
+
+    return (job);
+}
+
+static void *
+pool_worker(void *arg)
+{
+    luab_pool_t *pool;
+    luab_pool_job_t *job;
+    lua_State *L;
+    int state;
+
+    if ((pool = (luab_pool_t *)arg) != NULL) {
+
+        if ((L = luaL_newstate()) != NULL) {
+            luaL_openlibs(L);
+            luaL_requiref(L, "bsd", luaopen_bsd, 1);
+            lua_pop(L, 1);
+        } else
+            luab_core_warn("%s: %s", __func__, strerror(ENOMEM));
+
+        while ((job = pool_dequeue(pool)) != NULL) {
+            state = pool_job_exec(L, job);
+
+            (void)pthread_mutex_lock(&job->pj_mtx);
+            job->pj_state = state;
+            (void)pthread_cond_broadcast(&job->pj_cv);
+            (void)pthread_mutex_unlock(&job->pj_mtx);
+
+            luab_pool_rele(job);
+        }
+
+        if (L != NULL)
+            lua_close(L);
+    }
+    return (NULL);
+}
+
+/*
+ * Generator functions.
+ */
+
+luab_pool_t *
+luab_pool_alloc(int card)
+{
+    luab_pool_t *pool;
+    sigset_t nset, oset;
+    int i;
+
+    if (card < 1) {
+        errno = EINVAL;
+        return (NULL);
+    }
+
+    if ((pool = luab_core_alloc(1, sizeof(luab_pool_t))) != NULL) {
+        TAILQ_INIT(&pool->pl_queue);
+
+        if ((pool->pl_thr = luab_core_alloc(card, sizeof(pthread_t))) != NULL) {
+            pool->pl_card = card;
+
+            (void)pthread_mutex_init(&pool->pl_mtx, NULL);
+            (void)pthread_cond_init(&pool->pl_cv, NULL);
+
+            /* signals are delivered to the main thread or luab_thread_sigwait */
+            (void)sigfillset(&nset);
+            (void)pthread_sigmask(SIG_BLOCK, &nset, &oset);
+
+            for (i = 0; i < card; i++) {
+
+                if (pthread_create(&pool->pl_thr[i], NULL,
+                    pool_worker, pool) != 0)
+                    break;
+
+                pool->pl_nthr++;
+            }
+            (void)pthread_sigmask(SIG_SETMASK, &oset, NULL);
+
+            if (pool->pl_nthr > 0)
+                return (pool);
+
+            luab_pool_free(pool);
+        } else
+            luab_core_free(pool, sizeof(luab_pool_t));
+    }
+    return (NULL);
+}
+
+void
+luab_pool_free(luab_pool_t *pool)
+{
+    int i;
+
+    if (pool != NULL) {
+        (void)pthread_mutex_lock(&pool->pl_mtx);
+        pool->pl_shutdown = 1;
+        (void)pthread_cond_broadcast(&pool->pl_cv);
+        (void)pthread_mutex_unlock(&pool->pl_mtx);
+
+        /* workers drain the queue, before they terminate */
+        for (i = 0; i < pool->pl_nthr; i++)
+            (void)pthread_join(pool->pl_thr[i], NULL);
+
+        (void)pthread_cond_destroy(&pool->pl_cv);
+        (void)pthread_mutex_destroy(&pool->pl_mtx);
+
+        luab_core_free(pool->pl_thr, pool->pl_card * sizeof(pthread_t));
+        luab_core_free(pool, sizeof(luab_pool_t));
+    } else
+        errno = ENOENT;
+}
+
+/*
+ * Access functions.
+ */
+
+luab_pool_job_t *
+luab_pool_submit(lua_State *L, luab_pool_t *pool, int narg)
+{
+    luab_pool_job_t *job;
+    const char *dp;
+    size_t len;
+    int n, status;
+
+    if (pool == NULL) {
+        errno = ENXIO;
+        return (NULL);
+    }
+
+    if ((job = pool_job_alloc()) == NULL)
+        return (NULL);
+
+    switch (lua_type(L, narg)) {
+    case LUA_TFUNCTION:
+
+        if (lua_iscfunction(L, narg) == 0) {
+            lua_pushvalue(L, narg);
+            status = lua_dump(L, pool_writer, &job->pj_chunk);
+            lua_pop(L, 1);
+        } else
+            status = 1;
+
+        if (status != 0) {
+            errno = EINVAL;
+            status = luab_env_error;
+        }
+        break;
+    case LUA_TSTRING:
+        dp = lua_tolstring(L, narg, &len);
+        status = pool_buf_append(&job->pj_chunk, dp, len);
+        break;
+    default:
+        errno = EINVAL;
+        status = luab_env_error;
+        break;
+    }
+
+    for (n = narg + 1; n <= lua_gettop(L) && status == 0; n++) {
+
+        if ((status = pool_encode(L, n, &job->pj_args, 0)) == 0)
+            job->pj_nargs++;
+    }
+
+    if (status == 0) {
+        (void)pthread_mutex_lock(&pool->pl_mtx);
+
+        if (pool->pl_shutdown == 0) {
+            TAILQ_INSERT_TAIL(&pool->pl_queue, job, pj_next);
+            pool->pl_npending++;
+            (void)pthread_cond_signal(&pool->pl_cv);
+        } else {
+            errno = ESHUTDOWN;
+            status = luab_env_error;
+        }
+        (void)pthread_mutex_unlock(&pool->pl_mtx);
+    }
+
+    if (status != 0) {
+        pool_job_free(job);
+        job = NULL;
+    }
+    return (job);
+}
+
+int
+luab_pool_isdone(luab_pool_job_t *job)
+{
+    int state;
+
+    (void)pthread_mutex_lock(&job->pj_mtx);
+    state = job->pj_state;
+    (void)pthread_mutex_unlock(&job->pj_mtx);
+
+    return (state != PJ_PENDING);
+}
+
+/*
+ * Pushes (LUA_TBOOLEAN) and the results or the error message of the job,
+ * similar to pcall. Unless wait is set, EAGAIN is returned by (LUA_TNIL),
+ * if the job is still pending.
+ */
+int
+luab_pool_pushresult(lua_State *L, luab_pool_job_t *job, int wait)
+{
+    int state;
+
+    (void)pthread_mutex_lock(&job->pj_mtx);
+
+    while ((state = job->pj_state) == PJ_PENDING && wait != 0)
+        (void)pthread_cond_wait(&job->pj_cv, &job->pj_mtx);
+
+    (void)pthread_mutex_unlock(&job->pj_mtx);
+
+    if (state != PJ_PENDING) {
+        lua_pushboolean(L, (state == PJ_DONE));
+
+        if (pool_decodev(L, &job->pj_res, job->pj_nres) == 0)
+            return (job->pj_nres + 1);
+
+        lua_pop(L, 1);
+    } else
+        errno = EAGAIN;
+
+    return (luab_pushnil(L));
+}
+
+void
+luab_pool_rele(luab_pool_job_t *job)
+{
+    int refcnt;
+
+    if (job != NULL) {
+        (void)pthread_mutex_lock(&job->pj_mtx);
+        refcnt = --job->pj_refcnt;
+        (void)pthread_mutex_unlock(&job->pj_mtx);
+
+        if (refcnt == 0)
+            pool_job_free(job);
+    } else
+        errno = ENOENT;
+}
@@ -119,10 +119,20 @@ void
 luab_table_free(luab_table_t *tbl)
 {
     size_t nbytes;
+    u_int flags;
 
     if (tbl != NULL) {
         nbytes = (tbl->tbl_card * tbl->tbl_sz);
-        luab_core_free(tbl->tbl_vec, nbytes);
+
+        /* vectors over crypt_data{} hold keying material */
+        if (tbl->tbl_id == LUAB_CRYPT_DATA_TYPE_ID)
+            flags = LUAB_ALLOC_SCRUB;
+        else
+            flags = 0;
+
+        if (tbl->tbl_vec != NULL)
+            luab_core_freex(tbl->tbl_vec, nbytes, flags);
+
         luab_core_free(tbl, sizeof(*tbl));
     } else
         errno = ERANGE;
@@ -34,6 +34,7 @@
 
 #include "luabsd.h"
 #include "luab_modules.h"
+#include "luab_table.h"
 #include "luab_udata.h"
 
 #define LUAB_CORE_ATOMIC_LIB_ID    1607258006
@@ -638,6 +639,22 @@ luab_module_t luab_core_atomic_lib = {
 #define LUAB_CORE_LIB_ID    1595987973
 #define LUAB_CORE_LIB_KEY   "core"
 
+static void
+core_fillxtable_allocstat(lua_State *L, int narg, void *arg)
+{
+    luab_alloc_stat_t *as;
+
+    if ((as = (luab_alloc_stat_t *)arg) != NULL) {
+        luab_setinteger(L, narg, "nalloc",  as->as_nalloc);
+        luab_setinteger(L, narg, "nfree",   as->as_nfree);
+        luab_setinteger(L, narg, "nhit",    as->as_nhit);
+        luab_setinteger(L, narg, "nmiss",   as->as_nmiss);
+        luab_setinteger(L, narg, "nscrub",  as->as_nscrub);
+        luab_setinteger(L, narg, "nbytes",  as->as_nbytes);
+    } else
+        luab_core_err(EX_DATAERR, __func__, EINVAL);
+}
+
 /***
  * Interface against uuidgen(2), derived from implementation of uuidgen(1).
  *
@@ -675,6 +692,46 @@ luab_uuid(lua_State *L)
     return (status);
 }
 
+/***
+ * Counters maintained by the allocator behind luab_core_alloc(3).
+ *
+ * @function allocstat
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              nalloc      = (LUA_TNUMBER),
+ *              nfree       = (LUA_TNUMBER),
+ *              nhit        = (LUA_TNUMBER),
+ *              nmiss       = (LUA_TNUMBER),
+ *              nscrub      = (LUA_TNUMBER),
+ *              nbytes      = (LUA_TNUMBER),
+ *          }
+ *
+ *          whereby nhit denotes allocations served by a per-thread
+ *          cache, nmiss those passed to malloc(3) and nbytes the
+ *          amount of memory currently in use.
+ *
+ * @usage t [, err, msg ] = bsd.core.allocstat()
+ */
+static int
+luab_allocstat(lua_State *L)
+{
+    luab_alloc_stat_t as;
+    luab_xtable_param_t xtp;
+
+    (void)luab_core_checkmaxargs(L, 0);
+
+    luab_core_allocstat(&as);
+
+    xtp.xtp_fill = core_fillxtable_allocstat;
+    xtp.xtp_arg = &as;
+    xtp.xtp_new = 1;
+    xtp.xtp_k = NULL;
+
+    return (luab_table_pushxtable(L, -2, &xtp));
+}
+
 /* composite data types */
 /***
  * Generator function - create an instance of (LUA_TUSERDATA(INTEGER)).
@@ -697,6 +754,7 @@ luab_integer_create(lua_State *L)
 
 static luab_module_table_t luab_core_vec[] = {
     LUAB_FUNC("uuid",               luab_uuid),
+    LUAB_FUNC("allocstat",          luab_allocstat),
 
     /* composite data types */
     LUAB_FUNC("integer_create",     luab_integer_create),
@@ -33,11 +33,6 @@
 #include <lauxlib.h>
 #include <lualib.h>
 
-/*
- * XXX
- *  luab_isxdata(3).
- */
-
 #include "luabsd.h"
 #include "luab_udata.h"
 
@@ -53,13 +48,13 @@ luab_newuserdata(lua_State *L, luab_module_t *m, void *arg)
     if (m != NULL) {
 
         if ((ud = lua_newuserdata(L, m->m_len)) != NULL) {
-            (void)memset_s(ud, m->m_len, 0, m->m_len);
+            (void)memset(ud, 0, m->m_len);
 
             if (m->m_init != NULL && arg != NULL)
                 (*m->m_init)(ud, arg);  /* XXX upcall */
-
-            ud->ud_m = m;
+#ifdef LUAB_UDATA_TS
             ud->ud_ts = time(NULL);
+#endif
             LIST_INIT(&ud->ud_list);
 
             luaL_setmetatable(L, m->m_name);
@@ -91,14 +86,26 @@ luab_udata_remove(luab_udata_t *ud)
 {
     if (ud != NULL) {
         luab_thread_mtx_lock(NULL, __func__);
-    
+        luab_udata_xremove(ud);
+        luab_thread_mtx_unlock(NULL, __func__);
+    } else
+        errno = ENOENT;
+}
+
+/*
+ * Same as luab_udata_remove, but luab_thread_mtx is held by the caller.
+ */
+void
+luab_udata_xremove(luab_udata_t *ud)
+{
+    if (ud != NULL) {
+
         if (ud->ud_x != NULL) {
             *(ud->ud_x) = NULL;
             ud->ud_x = NULL;
             ud->ud_xhd = NULL;
         }
         LIST_REMOVE(ud, ud_next);
-        luab_thread_mtx_unlock(NULL, __func__);
     } else
         errno = ENOENT;
 }
@@ -225,38 +232,39 @@ luab_checkxdataisnil(lua_State *L, int narg, luab_module_t *m)
     return (luab_todata(L, narg, m, luab_udata_t *));
 }
 
+/*
+ * Constant time selector, the metatable of (LUA_TUSERDATA(XXX)) refers its
+ * luab_module_t{} by LUAB_XMOD_KEY, see luab_env_newmetatable(3). Those are
+ * immutable after package.loadlib() returns, thus no lock is required.
+ */
 void *
 luab_isxdata(lua_State *L, int narg, luab_xarg_t *xarg)
 {
+    luab_module_t *m = NULL;
     luab_udata_t *ud = NULL;
-    luab_module_vec_t *vec;
 
-    if ((vec = luab_env_type_vec) != NULL) {
-        luab_thread_mtx_lock(L, __func__);
+    narg = lua_absindex(L, narg);
 
-        while (vec->mv_mod != NULL) {
+    if ((lua_type(L, narg) == LUA_TUSERDATA) &&
+        (lua_getmetatable(L, narg) != 0)) {
+        lua_rawgetp(L, -1, LUAB_XMOD_KEY);
 
-            if ((ud = luab_isudata(L, narg, vec->mv_mod)) != NULL) {
-                ud = luab_todata(L, narg, vec->mv_mod, luab_udata_t *);
-                break;
-            }
-            vec++;
-        }
+        if ((m = (luab_module_t *)lua_touserdata(L, -1)) != NULL)
+            ud = (luab_udata_t *)lua_touserdata(L, narg);
 
-        if (xarg != NULL) {
+        lua_pop(L, 2);
+    }
 
-            if (ud != NULL) {
-                xarg->xarg_mod = vec->mv_mod;
-                xarg->xarg_len = vec->mv_mod->m_sz;
-            } else {
-                xarg->xarg_mod = NULL;
-                xarg->xarg_len = 0;
-            }
-        }
-        luab_thread_mtx_unlock(L, __func__);
-    } else
-        luab_core_argerror(L, narg, NULL, 0, 0, ENXIO);
+    if (xarg != NULL) {
 
+        if (ud != NULL) {
+            xarg->xarg_mod = m;
+            xarg->xarg_len = m->m_sz;
+        } else {
+            xarg->xarg_mod = NULL;
+            xarg->xarg_len = 0;
+        }
+    }
     return (ud);
 }
 
@@ -34,7 +34,66 @@ typedef struct luab_db_param {
     int             dbp_flags;
     int             dbp_mode;
     int             dbp_type;
+    int             dbp_dup;    /* DB_BTREE, opened by R_DUP */
     DB              *dbp_db;
 } luab_db_param_t;
 
+typedef struct luab_dbcursor_param {
+    int             dcp_narg;
+    DBTYPE          dcp_type;
+    DBT             dcp_lower;
+    DBT             dcp_upper;
+    int             dcp_prefix;
+    int             dcp_reverse;
+    size_t          dcp_card;
+} luab_dbcursor_param_t;
+
+typedef struct luab_dbcache_param {
+    int             dbcp_narg;
+    DBTYPE          dbcp_type;
+    int             dbcp_dup;
+    size_t          dbcp_budget;
+} luab_dbcache_param_t;
+
+/*
+ * Records are sorted in memory up to dlp_budget bytes, exceeding runs
+ * are spilled into temporary files and merged, see luab_dbloader_type.c.
+ */
+
+#define LUAB_DBLOADER_BUDGET    (64 * 1024 * 1024)
+
+typedef struct luab_dbloader_param {
+    int             dlp_narg;
+    size_t          dlp_budget;
+} luab_dbloader_param_t;
+
+/*
+ * Immutable sorted tables, written by db:export(), see luab_sstable_type.c.
+ */
+
+#define LUAB_SSTABLE_PREFIX     0x0001
+#define LUAB_SSTABLE_INTERVAL   16
+
+/*
+ * A Bloom filter over keys of a DB is either built by traversal, sized
+ * by blp_nelem (counted, if 0) and blp_bits per element, or loaded from
+ * blp_path, see luab_bloom_type.c.
+ */
+
+#define LUAB_BLOOM_BITS         10
+#define LUAB_BLOOM_MAXBITS      64
+
+typedef struct luab_bloom_param {
+    int             blp_narg;
+    DB              *blp_db;
+    const char      *blp_path;
+    size_t          blp_nelem;
+    u_int           blp_bits;
+} luab_bloom_param_t;
+
+DBT  *luab_db_checkbatch(lua_State *, int, size_t *);
+
+ssize_t  luab_sstable_export(DB *, const char *, u_int, u_int);
+int  luab_sstable_pushfile(lua_State *, const char *);
+
 #endif /* _LUAB_DB_H_ */
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _LUAB_DIRENT_H_
+#define _LUAB_DIRENT_H_
+
+#if __BSD_VISIBLE
+/*
+ * Recursive traversal of a directory tree by getdents(2), see
+ * luab_dirwalk_type.c. By LUAB_DIRWALK_STAT, each entry is
+ * evaluated by fstatat(2) relative to its directory.
+ */
+
+#define LUAB_DIRWALK_STAT       0x0001
+
+#define LUAB_DIRWALK_BUFSIZE    (64 * 1024)
+
+typedef struct luab_dirwalk_param {
+    const char      *dwp_path;
+    size_t          dwp_maxdepth;   /* 0 denotes no limit */
+    size_t          dwp_bufsize;
+    u_int           dwp_flags;
+} luab_dirwalk_param_t;
+
+/*
+ * Raw buffer filled by getdents(2) or getdirentries(2), entries in
+ * [ud_off, ud_len) are decoded on demand, see luab_dirbuf_type.c.
+ */
+
+#define LUAB_DIRBUF_SIZE        (64 * 1024)
+
+typedef struct luab_dirbuf {
+    luab_udata_t    ud_softc;
+    caddr_t         ud_buf;
+    size_t          ud_size;
+    size_t          ud_len;
+    size_t          ud_off;
+    off_t           ud_base;
+} luab_dirbuf_t;
+
+ssize_t  luab_dirbuf_fill(luab_dirbuf_t *, int, size_t, off_t *);
+#endif /* __BSD_VISIBLE */
+#endif /* _LUAB_DIRENT_H_ */
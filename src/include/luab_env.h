@@ -970,6 +970,63 @@ extern u_long luab_env_phys_pages;
 #if __BSD_VISIBLE
 #define LUAB_SIGVEC_TYPE_ID                     1611262452
 #define LUAB_SIGVEC_TYPE                        "SIGVEC*"
+
+#define LUAB_KQUEUE_TYPE_ID                     1615221342
+#define LUAB_KQUEUE_TYPE                        "KQUEUE*"
+
+#define LUAB_POOL_TYPE_ID                       1615392211
+#define LUAB_POOL_TYPE                          "POOL*"
+
+#define LUAB_FUTURE_TYPE_ID                     1615392617
+#define LUAB_FUTURE_TYPE                        "FUTURE*"
+
+#define LUAB_CHANNEL_TYPE_ID                    1615478530
+#define LUAB_CHANNEL_TYPE                       "CHANNEL*"
+
+#define LUAB_MMSGBATCH_TYPE_ID                  1615563180
+#define LUAB_MMSGBATCH_TYPE                     "MMSGBATCH*"
+
+#define LUAB_DBCURSOR_TYPE_ID                   1615649732
+#define LUAB_DBCURSOR_TYPE                      "DBCURSOR*"
+
+#define LUAB_SLICE_TYPE_ID                      1615740918
+#define LUAB_SLICE_TYPE                         "SLICE*"
+
+#define LUAB_RINGBUF_TYPE_ID                    1615827365
+#define LUAB_RINGBUF_TYPE                       "RINGBUF*"
+
+#define LUAB_IOVEC_ARRAY_TYPE_ID                1615913847
+#define LUAB_IOVEC_ARRAY_TYPE                   "IOVEC_ARRAY*"
+
+#define LUAB_AIOQ_TYPE_ID                       1616001135
+#define LUAB_AIOQ_TYPE                          "AIOQ*"
+
+#define LUAB_DIRWALK_TYPE_ID                    1616087520
+#define LUAB_DIRWALK_TYPE                       "DIRWALK*"
+
+#define LUAB_DIRBUF_TYPE_ID                     1616174033
+#define LUAB_DIRBUF_TYPE                        "DIRBUF*"
+
+#define LUAB_BTREEINFO_TYPE_ID                  1616260487
+#define LUAB_BTREEINFO_TYPE                     "BTREEINFO*"
+
+#define LUAB_HASHINFO_TYPE_ID                   1616260913
+#define LUAB_HASHINFO_TYPE                      "HASHINFO*"
+
+#define LUAB_RECNOINFO_TYPE_ID                  1616261338
+#define LUAB_RECNOINFO_TYPE                     "RECNOINFO*"
+
+#define LUAB_DBCACHE_TYPE_ID                    1616347263
+#define LUAB_DBCACHE_TYPE                       "DBCACHE*"
+
+#define LUAB_DBLOADER_TYPE_ID                   1616433618
+#define LUAB_DBLOADER_TYPE                      "DBLOADER*"
+
+#define LUAB_SSTABLE_TYPE_ID                    1616520034
+#define LUAB_SSTABLE_TYPE                       "SSTABLE*"
+
+#define LUAB_BLOOM_TYPE_ID                      1616606451
+#define LUAB_BLOOM_TYPE                         "BLOOM*"
 #endif
 
 /*
@@ -1285,6 +1342,25 @@ typedef enum luab_type {
     LUAB_CMSGCRED_IDX,
     LUAB_SF_HDTR_IDX,
     LUAB_SIGVEC_IDX,
+    LUAB_KQUEUE_IDX,
+    LUAB_POOL_IDX,
+    LUAB_FUTURE_IDX,
+    LUAB_CHANNEL_IDX,
+    LUAB_MMSGBATCH_IDX,
+    LUAB_DBCURSOR_IDX,
+    LUAB_SLICE_IDX,
+    LUAB_RINGBUF_IDX,
+    LUAB_IOVEC_ARRAY_IDX,
+    LUAB_AIOQ_IDX,
+    LUAB_DIRWALK_IDX,
+    LUAB_DIRBUF_IDX,
+    LUAB_BTREEINFO_IDX,
+    LUAB_HASHINFO_IDX,
+    LUAB_RECNOINFO_IDX,
+    LUAB_DBCACHE_IDX,
+    LUAB_DBLOADER_IDX,
+    LUAB_SSTABLE_IDX,
+    LUAB_BLOOM_IDX,
 #endif /* __BSD_VISIBLE */
     LUAB_TYPE_SENTINEL
 } luab_type_t;
@@ -1307,6 +1383,13 @@ typedef struct luab_module_vec {
 
 extern luab_module_vec_t luab_env_type_vec[];
 
+/*
+ * Each metatable maps by (LUA_TLIGHTUSERDATA) key to its luab_module_t{},
+ * whereby the address of luab_env_type_vec[] is unique, see luab_isxdata(3).
+ */
+#define LUAB_XMOD_KEY \
+    ((const void *)luab_env_type_vec)
+
 /*
  * Primitives for module-vector operations.
  */
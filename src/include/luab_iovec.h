@@ -45,12 +45,58 @@ typedef struct luab_iovec {
 #define IOV_PROXY   0x00000001
 #define IOV_BUFF    0x00000002
 #define IOV_DUMP    0x00000004
+#define IOV_LOCK    0x00000008
+#define IOV_MMAP    0x00000010
+#define IOV_RDONLY  0x00000020
+#define IOV_ORPHAN  0x00000040
 #else
 #define IOV_PROXY   0x0001
 #define IOV_BUFF    0x0002
 #define IOV_DUMP    0x0004
+#define IOV_LOCK    0x0008
+#define IOV_MMAP    0x0010
+#define IOV_RDONLY  0x0020
+#define IOV_ORPHAN  0x0040
 #endif
 
+/*
+ * IOV_ORPHAN denotes a buffer collected while held by IOV_LOCK, e. g. by
+ * an aio(4) request in flight. Its release is deferred to luab_iovec_rele.
+ */
+
+/*
+ * Maps-to a region of (LUA_TUSERDATA(IOVEC)), see luab_slice_type.c.
+ */
+
+typedef struct luab_slice_param {
+    int             slp_narg;   /* refers (LUA_TUSERDATA(IOVEC)) on stack */
+    luab_iovec_t    *slp_buf;
+    size_t          slp_off;
+    size_t          slp_len;
+} luab_slice_param_t;
+
+/*
+ * Initial and maximum capacity of (LUA_TUSERDATA(RINGBUF)).
+ */
+
+typedef struct luab_ringbuf_param {
+    size_t          rbp_size;
+    size_t          rbp_max_len;
+} luab_ringbuf_param_t;
+
+/*
+ * Buffer may be read or written, respectively. The capacity of regions
+ * mapped by mmap(2) is not constrained by the value of (luab_env_buf_max).
+ */
+
+#define luab_iovec_istxbuf(buf)                                     \
+    ((((buf)->iov_flags & IOV_BUFF) != 0) &&                        \
+    (((buf)->iov_max_len <= luab_env_buf_max) ||                    \
+    (((buf)->iov_flags & IOV_MMAP) != 0)))
+#define luab_iovec_isrxbuf(buf)                                     \
+    (luab_iovec_istxbuf(buf) &&                                     \
+    (((buf)->iov_flags & IOV_RDONLY) == 0))
+
 /*
  * Generic service primitives.
  */
@@ -111,6 +157,7 @@ luab_table_t     *luab_iovec_checktable(lua_State *, int);
  */
 
 int  luab_iovec_pushxdata(lua_State *, void *, size_t, size_t);
+int  luab_iovec_pushmdata(lua_State *, void *, size_t, u_int);
 
 void     luab_iovec_rawsetldata(lua_State *, int, lua_Integer, void *, size_t);
 void     luab_iovec_setldata(lua_State *, int, const char *, void *, size_t);
@@ -121,6 +168,9 @@ void     luab_iovec_pushtable(lua_State *, int, luab_table_t *, int new, int);
  * Service primitives.
  */
 
+int  luab_iovec_hold(lua_State *, luab_iovec_t *, const char *);
+void     luab_iovec_rele(lua_State *, luab_iovec_t *, const char *);
+
 int  luab_iovec_copyin(luab_iovec_t *, const void *, size_t);
 int  luab_iovec_copyout(luab_iovec_t *, void *, size_t);
 
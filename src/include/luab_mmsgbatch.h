@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _LUAB_MMSGBATCH_H_
+#define _LUAB_MMSGBATCH_H_
+
+#if __BSD_VISIBLE
+/*
+ * Preallocated vector over mmsghdr{}, each slot maps-to a region of
+ * ud_buflen bytes in ud_buf and an address in ud_addr. The vector is
+ * built once and handed to recvmmsg(2) or sendmmsg(2) repeatedly.
+ */
+
+typedef struct luab_mmsgbatch_param {
+    size_t  mbp_card;
+    size_t  mbp_buflen;
+} luab_mmsgbatch_param_t;
+
+typedef struct luab_mmsgbatch {
+    luab_udata_t            ud_softc;
+    size_t                  ud_card;
+    size_t                  ud_buflen;
+    struct mmsghdr          *ud_vec;
+    struct iovec            *ud_iov;
+    struct sockaddr_storage *ud_addr;
+    caddr_t                 ud_buf;
+} luab_mmsgbatch_t;
+
+/*
+ * Prepares the first vlen slots for receiving, i. e. each slot
+ * accepts ud_buflen bytes and the address of its peer.
+ */
+static __inline struct mmsghdr *
+luab_mmsgbatch_rxvec(luab_mmsgbatch_t *self, size_t vlen)
+{
+    struct msghdr *msg;
+    size_t i;
+
+    if (vlen <= self->ud_card) {
+
+        for (i = 0; i < vlen; i++) {
+            msg = &(self->ud_vec[i].msg_hdr);
+
+            msg->msg_name = &(self->ud_addr[i]);
+            msg->msg_namelen = sizeof(struct sockaddr_storage);
+            msg->msg_flags = 0;
+
+            self->ud_iov[i].iov_len = self->ud_buflen;
+            self->ud_vec[i].msg_len = 0;
+        }
+        return (self->ud_vec);
+    }
+    errno = ERANGE;
+    return (NULL);
+}
+
+static __inline struct mmsghdr *
+luab_mmsgbatch_txvec(luab_mmsgbatch_t *self, size_t vlen)
+{
+    if (vlen <= self->ud_card)
+        return (self->ud_vec);
+
+    errno = ERANGE;
+    return (NULL);
+}
+#endif /* __BSD_VISIBLE */
+#endif /* _LUAB_MMSGBATCH_H_ */
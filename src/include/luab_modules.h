@@ -232,6 +232,20 @@ extern luab_module_t luab_sigstack_type;
 #if __BSD_VISIBLE
 extern luab_module_t luab_dbt_type;
 extern luab_module_t luab_db_type;
+extern luab_module_t luab_dbcursor_type;
+extern luab_module_t luab_slice_type;
+extern luab_module_t luab_ringbuf_type;
+extern luab_module_t luab_iovec_array_type;
+extern luab_module_t luab_aioq_type;
+extern luab_module_t luab_dirwalk_type;
+extern luab_module_t luab_dirbuf_type;
+extern luab_module_t luab_btreeinfo_type;
+extern luab_module_t luab_hashinfo_type;
+extern luab_module_t luab_recnoinfo_type;
+extern luab_module_t luab_dbcache_type;
+extern luab_module_t luab_dbloader_type;
+extern luab_module_t luab_sstable_type;
+extern luab_module_t luab_bloom_type;
 extern luab_module_t luab_bintime_type;
 extern luab_module_t luab_crypt_data_type;
 extern luab_module_t luab_cap_rbuf_type;
@@ -240,6 +254,11 @@ extern luab_module_t luab_sockproto_type;
 extern luab_module_t luab_cmsgcred_type;
 extern luab_module_t luab_sf_hdtr_type;
 extern luab_module_t luab_sigvec_type;
+extern luab_module_t luab_kqueue_type;
+extern luab_module_t luab_pool_type;
+extern luab_module_t luab_future_type;
+extern luab_module_t luab_channel_type;
+extern luab_module_t luab_mmsgbatch_type;
 #endif /* __BSD_VISIBLE */
 
 /*
@@ -255,9 +274,11 @@ extern luab_module_t luab_net_if_lib;
 extern luab_module_t luab_net_if_dl_lib;
 
 extern luab_module_t luab_sys_dirent_lib;
+extern luab_module_t luab_sys_event_lib;
 extern luab_module_t luab_sys_file_lib;
 extern luab_module_t luab_sys_ipc_lib;
 extern luab_module_t luab_sys_jail_lib;
+extern luab_module_t luab_sys_mman_lib;
 extern luab_module_t luab_sys_mount_lib;
 extern luab_module_t luab_sys_stat_lib;
 extern luab_module_t luab_sys_time_lib;
@@ -276,6 +297,7 @@ extern luab_module_t luab_xlocale_langinfo_lib;
 extern luab_module_t luab_xlocale_locale_lib;
 extern luab_module_t luab_xlocale_time_lib;
 
+extern luab_module_t luab_aio_lib;
 extern luab_module_t luab_cpio_lib;
 extern luab_module_t luab_ctype_lib;
 extern luab_module_t luab_db_lib;
@@ -286,6 +308,7 @@ extern luab_module_t luab_grp_lib;
 extern luab_module_t luab_langinfo_lib;
 extern luab_module_t luab_locale_lib;
 extern luab_module_t luab_pwd_lib;
+extern luab_module_t luab_pool_lib;
 extern luab_module_t luab_pthread_lib;
 extern luab_module_t luab_regex_lib;
 extern luab_module_t luab_signal_lib;
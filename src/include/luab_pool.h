@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _LUAB_POOL_H_
+#define _LUAB_POOL_H_
+
+#include <sys/queue.h>
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+/*
+ * Workers of a pool are OS threads, each owns a lua_State of its own
+ * with the bsd library preloaded. A job is a chunk, dumped by lua_dump(3)
+ * or supplied as source code, and its arguments, both are serialized
+ * into flat buffers, thus no Lua value is shared between states.
+ *
+ * Only values of type nil, boolean, number, string, (LUA_TUSERDATA(CHANNEL))
+ * and tables over these are transferable.
+ */
+
+typedef struct luab_pool_buf {
+    caddr_t     pb_base;
+    size_t      pb_len;
+    size_t      pb_max_len;
+} luab_pool_buf_t;
+
+#define PJ_PENDING  0x0000
+#define PJ_DONE     0x0001
+#define PJ_FAILED   0x0002
+
+typedef struct luab_pool_job {
+    TAILQ_ENTRY(luab_pool_job)  pj_next;
+    pthread_mutex_t     pj_mtx;
+    pthread_cond_t      pj_cv;
+    int                 pj_refcnt;
+    int                 pj_state;
+    luab_pool_buf_t     pj_chunk;
+    luab_pool_buf_t     pj_args;
+    int                 pj_nargs;
+    luab_pool_buf_t     pj_res;     /* results or error message */
+    int                 pj_nres;
+} luab_pool_job_t;
+
+typedef struct luab_pool {
+    TAILQ_HEAD(, luab_pool_job) pl_queue;
+    pthread_mutex_t     pl_mtx;
+    pthread_cond_t      pl_cv;
+    pthread_t           *pl_thr;
+    int                 pl_card;
+    int                 pl_nthr;
+    int                 pl_npending;
+    int                 pl_shutdown;
+} luab_pool_t;
+
+/*
+ * Bounded MPMC queue, by sequence numbers over a ring of cells. Messages
+ * are memory regions, taken from (LUA_TUSERDATA(IOVEC)) and handed over
+ * to the receiver without copying. Producer and consumer sleep on ch_cv
+ * only, if the ring is full or empty respectively.
+ */
+
+typedef struct luab_channel_cell {
+    atomic_size_t       cc_seq;
+    luab_iovec_param_t  cc_msg;
+} luab_channel_cell_t;
+
+typedef struct luab_channel {
+    atomic_size_t       ch_head __aligned(CACHE_LINE_SIZE);
+    atomic_size_t       ch_tail __aligned(CACHE_LINE_SIZE);
+    luab_channel_cell_t *ch_vec __aligned(CACHE_LINE_SIZE);
+    size_t              ch_card;
+    atomic_int          ch_refcnt;
+    atomic_int          ch_nrx;     /* sleeping receivers */
+    atomic_int          ch_ntx;     /* sleeping senders */
+    atomic_int          ch_closed;
+    pthread_mutex_t     ch_mtx;
+    pthread_cond_t      ch_cv;
+} luab_channel_t;
+
+typedef struct luab_channel_udata {
+    luab_udata_t    ud_softc;
+    luab_channel_t  *ud_ch;
+} luab_channel_udata_t;
+
+luab_channel_t   *luab_channel_alloc(size_t);
+void     luab_channel_hold(luab_channel_t *);
+void     luab_channel_rele(luab_channel_t *);
+void     luab_channel_close(luab_channel_t *);
+size_t   luab_channel_len(luab_channel_t *);
+
+int  luab_channel_send(luab_channel_t *, luab_iovec_param_t *, int,
+    const struct timespec *);
+int  luab_channel_recv(luab_channel_t *, luab_iovec_param_t *, int,
+    const struct timespec *);
+
+int  luab_channel_sendiovec(lua_State *, luab_channel_t *, luab_iovec_t *,
+    int, const struct timespec *);
+int  luab_channel_pushiovec(lua_State *, luab_channel_t *, int,
+    const struct timespec *);
+
+luab_pool_t  *luab_pool_alloc(int);
+void     luab_pool_free(luab_pool_t *);
+
+luab_pool_job_t  *luab_pool_submit(lua_State *, luab_pool_t *, int);
+int  luab_pool_pushresult(lua_State *, luab_pool_job_t *, int);
+int  luab_pool_isdone(luab_pool_job_t *);
+void     luab_pool_rele(luab_pool_job_t *);
+
+#endif /* _LUAB_POOL_H_ */
@@ -31,13 +31,20 @@
  * Interface Control Information (ICI).
  */
 
+/*
+ * Prefixes each (LUA_TUSERDATA(XXX)), thus kept as small as possible. The
+ * time of creation is recorded, if built with -DLUAB_UDATA_TS only, since
+ * time(3) on each allocation dominates the cost of creating scalar boxes.
+ */
+
 typedef struct luab_udata {
     LIST_ENTRY(luab_udata)  ud_next;
     LIST_HEAD(, luab_udata) ud_list;
-    luab_module_t           *ud_m;
-    time_t                  ud_ts;
     void                    **ud_x;
     void                    *ud_xhd;
+#ifdef LUAB_UDATA_TS
+    time_t                  ud_ts;
+#endif
 } luab_udata_t;
 
 /*
@@ -56,6 +63,7 @@ typedef struct luab_xarg {
 void     *luab_newuserdata(lua_State *, luab_module_t *, void *);
 void     luab_udata_init(luab_module_t *, luab_udata_t *, void *);
 void     luab_udata_remove(luab_udata_t *);
+void     luab_udata_xremove(luab_udata_t *);
 luab_udata_t     *luab_udata_find(luab_udata_t *, void **);
 void     *luab_udata_insert(luab_udata_t *, luab_udata_t *, void **);
 
@@ -105,7 +113,10 @@ void     luab_setxdata(lua_State *, int, luab_module_t *, const char *, void *);
 
 #include "luab_iovec.h"
 #include "luab_db.h"
+#include "luab_dirent.h"
 #include "luab_locale.h"
+#include "luab_mmsgbatch.h"
+#include "luab_pool.h"
 #include "luab_time.h"
 
 #endif /* _LUAB_UDATA_H_ */
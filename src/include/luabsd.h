@@ -32,15 +32,38 @@
 #include <sys/socket.h>
 
 #include <errno.h>
+#include <limits.h>
+#include <stdint.h>
 #include <sysexits.h>
 
 #include "luab_env.h"
 
+/*
+ * Flags for luab_core_{alloc,free}x(3).
+ */
+
+#define LUAB_ALLOC_NOZERO   0x0001  /* don't zero on allocation */
+#define LUAB_ALLOC_SCRUB    0x0002  /* scrub on release, e. g. passwords */
+
+typedef struct luab_alloc_stat {
+    u_long  as_nalloc;
+    u_long  as_nfree;
+    u_long  as_nhit;
+    u_long  as_nmiss;
+    u_long  as_nscrub;
+    u_long  as_nbytes;
+} luab_alloc_stat_t;
+
 void     luab_core_free(void *, size_t);
+void     luab_core_freex(void *, size_t, u_int);
 void     luab_core_freestr(caddr_t);
+void     luab_core_freestrx(caddr_t, u_int);
 
 void     *luab_core_alloc(size_t, size_t);
+void     *luab_core_allocx(size_t, size_t, u_int);
+void     *luab_core_realloc(void *, size_t, u_int);
 char     *luab_core_allocstring(const char *, size_t *);
+void     luab_core_allocstat(luab_alloc_stat_t *);
 
 void     luab_core_err(int, const char *, int);
 void     luab_core_errx(int, const char *, ...);
@@ -85,6 +108,7 @@ void  luab_thread_mtx_unlock(lua_State *, const char *);
 int  luab_core_create(lua_State *, int, luab_module_t *, luab_module_t *);
 int  luab_core_dump(lua_State *, int, luab_module_t *, size_t);
 int  luab_core_gc(lua_State *, int, luab_module_t *);
+int  luab_core_xgc(lua_State *, int, luab_module_t *);
 int  luab_core_len(lua_State *, int, luab_module_t *);
 int  luab_core_tostring(lua_State *, int, luab_module_t *);
 
@@ -110,6 +134,94 @@ lua_Integer  luab_checklinteger(lua_State *, int, int);
 lua_Integer  luab_checkxinteger(lua_State *, int, luab_module_t *, lua_Integer);
 lua_Integer  luab_checklxinteger(lua_State *, int, luab_module_t *, int);
 
+/*
+ * Scalar arguments, specialized by C type.
+ *
+ * A (LUA_TNUMBER) is converted without any lookup of a luab_module_t{},
+ * whereby its value must be integral and fit into the width of the C
+ * type, otherwise ERANGE is raised. The range is tested before the
+ * conversion, since converting an out of range lua_Number is undefined. Unsigned types accept the negative range of their
+ * signed counterpart too, e. g. (uid_t)-1. Any other argument is passed
+ * to luab_checkxinteger(3) as instance of (LUA_TUSERDATA(XXX)).
+ */
+
+#define LUAB_XINTEGER_MAX(max)                                      \
+    ((((uintmax_t)(max)) < ((uintmax_t)PTRDIFF_MAX)) ?              \
+        ((lua_Integer)(max)) : ((lua_Integer)PTRDIFF_MAX))
+#define LUAB_XINTEGER_MIN(min)                                      \
+    ((((intmax_t)(min)) > ((intmax_t)PTRDIFF_MIN)) ?                \
+        ((lua_Integer)(min)) : ((lua_Integer)PTRDIFF_MIN))
+#define LUAB_XINTEGER_UMIN(max)                                     \
+    (-LUAB_XINTEGER_MAX((max) >> 1) - 1)
+
+static __inline lua_Integer
+luab_checkrinteger(lua_State *L, int narg, lua_Integer lo, lua_Integer hi)
+{
+    lua_Number n;
+    lua_Integer x;
+
+    n = lua_tonumber(L, narg);
+
+    if (!((n >= (lua_Number)lo) && (n < ((lua_Number)hi + 1))))
+        luab_core_argerror(L, narg, NULL, 0, 0, ERANGE);
+
+    x = (lua_Integer)n;
+
+    if (((lua_Number)x != n) || (x < lo) || (x > hi))
+        luab_core_argerror(L, narg, NULL, 0, 0, ERANGE);
+
+    return (x);
+}
+
+#define luab_checkxscalar(L, narg, name, type, lo, hi, b_msk)       \
+    ((lua_type((L), (narg)) == LUA_TNUMBER) ?                       \
+        ((type)luab_checkrinteger((L), (narg), (lo), (hi))) :       \
+        ((type)luab_checkxinteger((L), (narg),                      \
+            luab_xmod(name, TYPE, __func__), (b_msk))))
+#define luab_checkxsscalar(L, narg, name, type, min, max, b_msk)    \
+    luab_checkxscalar((L), (narg), name, type,                      \
+        LUAB_XINTEGER_MIN(min), LUAB_XINTEGER_MAX(max), (b_msk))
+#define luab_checkxuscalar(L, narg, name, type, max, b_msk)         \
+    luab_checkxscalar((L), (narg), name, type,                      \
+        LUAB_XINTEGER_UMIN(max), LUAB_XINTEGER_MAX(max), (b_msk))
+
+#define luab_checkint(L, narg)                                      \
+    luab_checkxsscalar((L), (narg), INT, int,                       \
+        INT_MIN, INT_MAX, luab_env_int_max)
+#define luab_checkuint(L, narg)                                     \
+    luab_checkxuscalar((L), (narg), UINT, u_int,                    \
+        UINT_MAX, luab_env_uint_max)
+#define luab_checklong(L, narg)                                     \
+    luab_checkxsscalar((L), (narg), LONG, long,                     \
+        LONG_MIN, LONG_MAX, luab_env_long_max)
+#define luab_checkulong(L, narg)                                    \
+    luab_checkxuscalar((L), (narg), ULONG, u_long,                  \
+        ULONG_MAX, luab_env_ulong_max)
+#define luab_checkushrt(L, narg)                                    \
+    luab_checkxuscalar((L), (narg), USHRT, u_short,                 \
+        USHRT_MAX, luab_env_ushrt_max)
+#define luab_checksize(L, narg)                                     \
+    luab_checkxuscalar((L), (narg), SIZE, size_t,                   \
+        SIZE_MAX, luab_core_Integer_promotion_msk(0))
+#define luab_checkssize(L, narg)                                    \
+    luab_checkxsscalar((L), (narg), SSIZE, ssize_t,                 \
+        -SSIZE_MAX - 1, SSIZE_MAX, luab_env_ssize_max)
+#define luab_checkoff(L, narg)                                      \
+    luab_checkxsscalar((L), (narg), OFF, off_t,                     \
+        -OFF_MAX - 1, OFF_MAX, luab_env_off_max)
+#define luab_checksocklen(L, narg)                                  \
+    luab_checkxuscalar((L), (narg), SOCKLEN, socklen_t,             \
+        UINT_MAX, luab_env_uint_max)
+#define luab_checkpid(L, narg)                                      \
+    luab_checkxsscalar((L), (narg), PID, pid_t,                     \
+        INT_MIN, INT_MAX, luab_env_int_max)
+#define luab_checkuid(L, narg)                                      \
+    luab_checkxuscalar((L), (narg), UID, uid_t,                     \
+        UID_MAX, luab_env_uid_max)
+#define luab_checkgid(L, narg)                                      \
+    luab_checkxuscalar((L), (narg), GID, gid_t,                     \
+        GID_MAX, luab_env_gid_max)
+
 lua_Number   luab_toxnumber(lua_State *, int, luab_module_t *);
 lua_Number   luab_checkxnumber(lua_State *, int, luab_module_t *);
 
@@ -157,4 +269,10 @@ int  luab_pushstring(lua_State *, const char *);
 int  luab_pushfstring(lua_State *, const char *, ...);
 
 int  luab_pushldata(lua_State *, void *, size_t);
+
+/*
+ * Main entry point for loadlib(3).
+ */
+
+LUAMOD_API int  luaopen_bsd(lua_State *);
 #endif /* _LUABSD_H_ */
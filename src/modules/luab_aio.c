@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+
+#include <aio.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+
+#define LUAB_AIO_LIB_ID    1616000412
+#define LUAB_AIO_LIB_KEY   "aio"
+
+extern luab_module_t luab_aio_lib;
+
+/*
+ * Generator functions.
+ */
+
+/***
+ * Generator function - create an instance of (LUA_TUSERDATA(AIOQ)).
+ *
+ * @function create_aioq
+ *
+ * @param card              Maximum number of requests, either pending
+ *                          or in flight.
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage aioq [, err, msg ] = bsd.aio.create_aioq(card)
+ */
+static int
+luab_type_create_aioq(lua_State *L)
+{
+    luab_module_t *m;
+    size_t card;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(AIOQ, TYPE, __func__);
+    card = luab_checksize(L, 1);
+
+    return (luab_pushxdata(L, m, &card));
+}
+
+/*
+ * Interface against <aio.h>.
+ */
+
+static luab_module_table_t luab_aio_vec[] = {
+    LUAB_INT("AIO_CANCELED",        AIO_CANCELED),
+    LUAB_INT("AIO_NOTCANCELED",     AIO_NOTCANCELED),
+    LUAB_INT("AIO_ALLDONE",         AIO_ALLDONE),
+    LUAB_INT("LIO_NOP",             LIO_NOP),
+    LUAB_INT("LIO_WRITE",           LIO_WRITE),
+    LUAB_INT("LIO_READ",            LIO_READ),
+    LUAB_INT("LIO_NOWAIT",          LIO_NOWAIT),
+    LUAB_INT("LIO_WAIT",            LIO_WAIT),
+    LUAB_FUNC("create_aioq",        luab_type_create_aioq),
+    LUAB_MOD_TBL_SENTINEL
+};
+
+luab_module_t luab_aio_lib = {
+    .m_id       = LUAB_AIO_LIB_ID,
+    .m_name     = LUAB_AIO_LIB_KEY,
+    .m_vec      = luab_aio_vec,
+};
@@ -27,6 +27,8 @@
 
 #include <sys/file.h>
 
+#include <string.h>
+
 #include <lua.h>
 #include <lauxlib.h>
 #include <lualib.h>
@@ -54,29 +56,70 @@ extern luab_module_t luab_db_lib;
  * @param flags                     Same as specified for open(2).
  * @param mode                      Same as specified for open(2).
  * @param type                      Specifies DBTYPE as defined in <db.h>.
+ * @param openinfo                  Access method specific tuning, either
+ *                                  an instance of
+ *
+ *                                      (LUA_TUSERDATA(BTREEINFO)),
+ *                                      (LUA_TUSERDATA(HASHINFO)) or
+ *                                      (LUA_TUSERDATA(RECNOINFO)),
+ *
+ *                                  as required by type, optional.
+ *                                  Passing openinfo by an unknown type
+ *                                  raises an error.
  *
  * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
  *
- * @usage iovec [, err, msg ] = bsd.db.dbopen(file, flags, mode, type)
+ * @usage db [, err, msg ] = bsd.db.dbopen(file, flags, mode, type [, openinfo ])
  */
 static int
 luab_dbopen(lua_State *L)
 {
-    luab_module_t *m0, *m1;
+    luab_module_t *m0, *m1, *m2;
     luab_db_param_t dbp;
+    const void *openinfo;
 
-    (void)luab_core_checkmaxargs(L, 4);
+    (void)luab_core_checkmaxargs(L, 5);
 
     m0 = luab_xmod(INT, TYPE, __func__);
     m1 = luab_xmod(DB, TYPE, __func__);
 
+    (void)memset(&dbp, 0, sizeof(dbp));
+
     dbp.dbp_file = luab_islstring(L, 1, luab_env_path_max);
     dbp.dbp_flags = luab_checkxinteger(L, 2, m0, luab_env_int_max);
     dbp.dbp_mode = luab_checkxinteger(L, 3, m0, luab_env_int_max);
     dbp.dbp_type = luab_checkxinteger(L, 4, m0, luab_env_int_max);
 
+    switch (dbp.dbp_type) {
+    case DB_BTREE:
+        m2 = luab_xmod(BTREEINFO, TYPE, __func__);
+        break;
+    case DB_HASH:
+        m2 = luab_xmod(HASHINFO, TYPE, __func__);
+        break;
+    case DB_RECNO:
+        m2 = luab_xmod(RECNOINFO, TYPE, __func__);
+        break;
+    default:
+        m2 = NULL;
+        break;
+    }
+
+    if (lua_isnoneornil(L, 5) == 0) {
+
+        if (m2 == NULL)
+            luab_core_argerror(L, 5, NULL, 0, 0, EINVAL);
+
+        openinfo = luab_udata(L, 5, m2, const void *);
+
+        if (dbp.dbp_type == DB_BTREE)
+            dbp.dbp_dup = ((((const BTREEINFO *)openinfo)->flags &
+                R_DUP) != 0);
+    } else
+        openinfo = NULL;
+
     dbp.dbp_db = dbopen(dbp.dbp_file, dbp.dbp_flags, dbp.dbp_mode,
-        dbp.dbp_type, NULL);
+        dbp.dbp_type, openinfo);
 
     return (luab_pushxdata(L, m1, &dbp));
 }
@@ -106,6 +149,87 @@ luab_type_create_dbt(lua_State *L)
 
     return (luab_core_create(L, 1, m0, m1));
 }
+
+/***
+ * Generator function - create an instance of (LUA_TUSERDATA(BTREEINFO)).
+ *
+ * @function create_btreeinfo
+ *
+ * @param arg           Instance of (LUA_TUSERDATA(BTREEINFO)), optional.
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage btreeinfo [, err, msg ] = bsd.db.create_btreeinfo([ arg ])
+ */
+static int
+luab_type_create_btreeinfo(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(BTREEINFO, TYPE, __func__);
+    return (luab_core_create(L, 1, m, NULL));
+}
+
+/***
+ * Generator function - create an instance of (LUA_TUSERDATA(HASHINFO)).
+ *
+ * @function create_hashinfo
+ *
+ * @param arg           Instance of (LUA_TUSERDATA(HASHINFO)), optional.
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage hashinfo [, err, msg ] = bsd.db.create_hashinfo([ arg ])
+ */
+static int
+luab_type_create_hashinfo(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(HASHINFO, TYPE, __func__);
+    return (luab_core_create(L, 1, m, NULL));
+}
+
+/***
+ * Generator function - create an instance of (LUA_TUSERDATA(RECNOINFO)).
+ *
+ * @function create_recnoinfo
+ *
+ * @param arg           Instance of (LUA_TUSERDATA(RECNOINFO)), optional.
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage recnoinfo [, err, msg ] = bsd.db.create_recnoinfo([ arg ])
+ */
+static int
+luab_type_create_recnoinfo(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(RECNOINFO, TYPE, __func__);
+    return (luab_core_create(L, 1, m, NULL));
+}
+
+/***
+ * Generator function - create an instance of (LUA_TUSERDATA(SSTABLE))
+ * over a file, written by db:export(), mapped by mmap(2).
+ *
+ * @function create_sstable
+ *
+ * @param path          Path of file.
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage sstable [, err, msg ] = bsd.db.create_sstable(path)
+ */
+static int
+luab_type_create_sstable(lua_State *L)
+{
+    const char *path;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    path = luab_checklstring(L, 1, luab_env_path_max, NULL);
+
+    return (luab_sstable_pushfile(L, path));
+}
 #endif /* __BSD_VISIBLE */
 
 /*
@@ -130,12 +254,21 @@ static luab_module_table_t luab_db_vec[] = {
     LUAB_INT("R_PREV",        R_PREV),
     LUAB_INT("R_SETCURSOR",   R_SETCURSOR),
     LUAB_INT("R_RECNOSYNC",   R_RECNOSYNC),
+    LUAB_INT("R_DUP",         R_DUP),
+    LUAB_INT("R_FIXEDLEN",    R_FIXEDLEN),
+    LUAB_INT("R_NOKEY",       R_NOKEY),
+    LUAB_INT("R_SNAPSHOT",    R_SNAPSHOT),
     LUAB_INT("DB_BTREE",      DB_BTREE),
     LUAB_INT("DB_HASH",       DB_HASH),
     LUAB_INT("DB_RECNO",      DB_RECNO),
 #if __BSD_VISIBLE
+    LUAB_INT("SSTABLE_PREFIX", LUAB_SSTABLE_PREFIX),
     LUAB_FUNC("dbopen",       luab_dbopen),
     LUAB_FUNC("create_dbt",   luab_type_create_dbt),
+    LUAB_FUNC("create_btreeinfo", luab_type_create_btreeinfo),
+    LUAB_FUNC("create_hashinfo",  luab_type_create_hashinfo),
+    LUAB_FUNC("create_recnoinfo", luab_type_create_recnoinfo),
+    LUAB_FUNC("create_sstable",   luab_type_create_sstable),
 #endif
     LUAB_MOD_TBL_SENTINEL
 };
@@ -153,9 +153,11 @@ luab_opendir2(lua_State *L)
  *                                  direntN
  *                              }
  *
- *                          over (LUA_TUSERDATA(DIRENT)).
+ *                          over (LUA_TUSERDATA(DIRENT)), or an instance
+ *                          of (LUA_TUSERDATA(DIRBUF)), filled in place.
  *
- * @param nbytes            Reflects the cardinality of (LUA_TTABLE).
+ * @param nbytes            Reflects the cardinality of (LUA_TTABLE), or
+ *                          amount of bytes by (LUA_TUSERDATA(DIRBUF)).
  *
  * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
  *
@@ -164,7 +166,7 @@ luab_opendir2(lua_State *L)
 static int
 luab_getdents(lua_State *L)
 {
-    luab_module_t *m0, *m1, *m2;
+    luab_module_t *m0, *m1, *m2, *m3;
     int fd;
     luab_table_t *tbl;
     size_t nbytes;
@@ -175,8 +177,16 @@ luab_getdents(lua_State *L)
     m0 = luab_xmod(INT, TYPE, __func__);
     m1 = luab_xmod(DIRENT, TYPE, __func__);
     m2 = luab_xmod(SIZE, TYPE, __func__);
+    m3 = luab_xmod(DIRBUF, TYPE, __func__);
 
     fd = (int)luab_checkxinteger(L, 1, m0, luab_env_int_max);
+
+    if (luab_isdata(L, 2, m3, void *) != NULL) {
+        nbytes = (size_t)luab_checklxinteger(L, 3, m2, 0);
+        count = luab_dirbuf_fill(luab_udata(L, 2, m3, luab_dirbuf_t *),
+            fd, nbytes, NULL);
+        return (luab_pushxinteger(L, count));
+    }
     tbl = luab_table_checkxdata(L, 2, m1);
     nbytes = (size_t)luab_checklxinteger(L, 3, m2, 0);
 
@@ -214,9 +224,11 @@ luab_getdents(lua_State *L)
  *                                  direntN
  *                              }
  *
- *                          over (LUA_TUSERDATA(DIRENT)).
+ *                          over (LUA_TUSERDATA(DIRENT)), or an instance
+ *                          of (LUA_TUSERDATA(DIRBUF)), filled in place.
  *
- * @param nbytes            Reflects the cardinality of (LUA_TTABLE).
+ * @param nbytes            Reflects the cardinality of (LUA_TTABLE), or
+ *                          amount of bytes by (LUA_TUSERDATA(DIRBUF)).
  * @param basep             Specifies location for position block read.
  *
  * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
@@ -226,11 +238,12 @@ luab_getdents(lua_State *L)
 static int
 luab_getdirentries(lua_State *L)
 {
-    luab_module_t *m0, *m1, *m2, *m3;
+    luab_module_t *m0, *m1, *m2, *m3, *m4;
     int fd;
     luab_table_t *tbl;
     size_t nbytes;
     off_t *basep;
+    luab_dirbuf_t *buf;
     ssize_t count;
 
     (void)luab_core_checkmaxargs(L, 4);
@@ -239,8 +252,18 @@ luab_getdirentries(lua_State *L)
     m1 = luab_xmod(DIRENT, TYPE, __func__);
     m2 = luab_xmod(SIZE, TYPE, __func__);
     m3 = luab_xmod(OFF, TYPE, __func__);
+    m4 = luab_xmod(DIRBUF, TYPE, __func__);
 
     fd = (int)luab_checkxinteger(L, 1, m0, luab_env_int_max);
+
+    if (luab_isdata(L, 2, m4, void *) != NULL) {
+        buf = luab_udata(L, 2, m4, luab_dirbuf_t *);
+        nbytes = (size_t)luab_checklxinteger(L, 3, m2, 0);
+        basep = luab_udataisnil(L, 4, m3, off_t *);
+        count = luab_dirbuf_fill(buf, fd, nbytes,
+            (basep != NULL) ? basep : &(buf->ud_base));
+        return (luab_pushxinteger(L, count));
+    }
     tbl = luab_table_checkxdata(L, 2, m1);
     nbytes = (size_t)luab_checklxinteger(L, 3, m2, 0);
     basep = luab_udataisnil(L, 4, m3, off_t *);
@@ -561,6 +584,72 @@ luab_type_create_dir(lua_State *L)
     return (luab_core_create(L, 1, m, NULL));
 }
 
+#if __BSD_VISIBLE
+/***
+ * Generator function - create an instance of (LUA_TUSERDATA(DIRWALK)).
+ *
+ * @function create_dirwalk
+ *
+ * @param path              Root of directory tree.
+ * @param maxdepth          Limits descent, optional, 0 denotes no limit.
+ * @param flags             Flags argument, optional, over
+ *
+ *                              bsd.dirent.DIRWALK_STAT
+ *
+ *                          evaluates size and mtime of each entry.
+ *
+ * @param bufsize           Size of buffer for getdents(2), optional, at
+ *                          least DIRBLKSIZ.
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage dirwalk [, err, msg ] = bsd.dirent.create_dirwalk(path [, maxdepth [, flags [, bufsize ]]])
+ */
+static int
+luab_type_create_dirwalk(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dirwalk_param_t dwp;
+
+    (void)luab_core_checkmaxargs(L, 4);
+
+    m = luab_xmod(DIRWALK, TYPE, __func__);
+
+    dwp.dwp_path = luab_checklstring(L, 1, luab_env_path_max, NULL);
+    dwp.dwp_maxdepth = lua_isnoneornil(L, 2) ? 0 : luab_checksize(L, 2);
+    dwp.dwp_flags = lua_isnoneornil(L, 3) ? 0 : luab_checkuint(L, 3);
+    dwp.dwp_bufsize = lua_isnoneornil(L, 4) ?
+        LUAB_DIRWALK_BUFSIZE : luab_checksize(L, 4);
+
+    return (luab_pushxdata(L, m, &dwp));
+}
+
+/***
+ * Generator function - create an instance of (LUA_TUSERDATA(DIRBUF)).
+ *
+ * @function create_dirbuf
+ *
+ * @param size              Capacity in bytes, optional, at least DIRBLKSIZ.
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage dirbuf [, err, msg ] = bsd.dirent.create_dirbuf([ size ])
+ */
+static int
+luab_type_create_dirbuf(lua_State *L)
+{
+    luab_module_t *m;
+    size_t size;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DIRBUF, TYPE, __func__);
+    size = lua_isnoneornil(L, 1) ? LUAB_DIRBUF_SIZE : luab_checksize(L, 1);
+
+    return (luab_pushxdata(L, m, &size));
+}
+#endif /* __BSD_VISIBLE */
+
 /*
  * Interface against <dirent.h>.
  */
@@ -573,6 +662,7 @@ static luab_module_table_t luab_dirent_vec[] = { /* dirent.h */
     LUAB_INT("DTF_REWIND",              DTF_REWIND),
     LUAB_INT("__DTF_READALL",           __DTF_READALL),
     LUAB_INT("__DTF_SKIPREAD",          __DTF_SKIPREAD),
+    LUAB_INT("DIRWALK_STAT",            LUAB_DIRWALK_STAT),
 #endif /* __BSD_VISIBLE */
 #if __POSIX_VISIBLE >= 200809 || __XSI_VISIBLE >= 700
     LUAB_FUNC("dirfd",                  luab_dirfd),
@@ -596,6 +686,10 @@ static luab_module_table_t luab_dirent_vec[] = { /* dirent.h */
 #endif
     LUAB_FUNC("closedir",               luab_closedir),
     LUAB_FUNC("create_dir",             luab_type_create_dir),
+#if __BSD_VISIBLE
+    LUAB_FUNC("create_dirbuf",          luab_type_create_dirbuf),
+    LUAB_FUNC("create_dirwalk",         luab_type_create_dirwalk),
+#endif
     LUAB_MOD_TBL_SENTINEL
 };
 
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <unistd.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+
+#define LUAB_POOL_LIB_ID    1615391874
+#define LUAB_POOL_LIB_KEY   "pool"
+
+extern luab_module_t luab_pool_lib;
+
+/*
+ * Generator functions.
+ */
+
+/***
+ * Generator function - create an instance of (LUA_TUSERDATA(POOL)).
+ *
+ * @function create_pool
+ *
+ * @param card              Number of worker threads, each executes jobs
+ *                          within a lua_State of its own, where the bsd
+ *                          library is preloaded. If set to 0, the number
+ *                          of online processors is taken.
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage pool [, err, msg ] = bsd.pool.create_pool(card)
+ */
+static int
+luab_type_create_pool(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    int card;
+    long ncpu;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m0 = luab_xmod(POOL, TYPE, __func__);
+    m1 = luab_xmod(INT, TYPE, __func__);
+
+    card = (int)luab_checkxinteger(L, 1, m1, luab_env_int_max);
+
+    if (card == 0) {
+
+        if ((ncpu = sysconf(_SC_NPROCESSORS_ONLN)) > 0)
+            card = (int)ncpu;
+        else
+            card = 1;
+    }
+
+    if (card > 0)
+        return (luab_pushxdata(L, m0, &card));
+
+    errno = ERANGE;
+    return (luab_pushnil(L));
+}
+
+/***
+ * Generator function - create an instance of (LUA_TUSERDATA(CHANNEL)).
+ *
+ * @function create_channel
+ *
+ * @param card              Capacity, rounded up to the next power of 2.
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage channel [, err, msg ] = bsd.pool.create_channel(card)
+ */
+static int
+luab_type_create_channel(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    luab_channel_t *ch;
+    size_t card;
+    int status;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m0 = luab_xmod(CHANNEL, TYPE, __func__);
+    m1 = luab_xmod(SIZE, TYPE, __func__);
+
+    card = (size_t)luab_checklxinteger(L, 1, m1, 0);
+
+    if ((ch = luab_channel_alloc(card)) != NULL) {
+        status = luab_pushxdata(L, m0, ch);
+        luab_channel_rele(ch);
+    } else
+        status = luab_pushnil(L);
+
+    return (status);
+}
+
+/*
+ * Interface against isolated lua_State worker pools.
+ */
+
+static luab_module_table_t luab_pool_vec[] = {
+    LUAB_FUNC("create_pool",            luab_type_create_pool),
+    LUAB_FUNC("create_channel",         luab_type_create_channel),
+    LUAB_MOD_TBL_SENTINEL
+};
+
+luab_module_t luab_pool_lib = {
+    .m_id       = LUAB_POOL_LIB_ID,
+    .m_name     = LUAB_POOL_LIB_KEY,
+    .m_vec      = luab_pool_vec,
+};
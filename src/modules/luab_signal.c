@@ -106,18 +106,14 @@ luab_raise(lua_State *L)
 static int
 luab_kill(lua_State *L)
 {
-    luab_module_t *m0, *m1;
     pid_t pid;
     int sig;
     int status;
 
     (void)luab_core_checkmaxargs(L, 2);
 
-    m0 = luab_xmod(PID, TYPE, __func__);
-    m1 = luab_xmod(INT, TYPE, __func__);
-
-    pid = (pid_t)luab_checkxinteger(L, 1, m0, luab_env_uint_max);
-    sig = (int)luab_checkxinteger(L, 2, m1, luab_env_uint_max);
+    pid = luab_checkpid(L, 1);
+    sig = luab_checkint(L, 2);
 
     status = kill(pid, sig);
     return (luab_pushxinteger(L, status));
@@ -197,13 +197,11 @@ luab_chown(lua_State *L)
 static int
 luab_close(lua_State *L)
 {
-    luab_module_t *m;
     int fd, status;
 
     (void)luab_core_checkmaxargs(L, 1);
 
-    m = luab_xmod(INT, TYPE, __func__);
-    fd = (int)luab_checkxinteger(L, 1, m, luab_env_int_max);
+    fd = luab_checkint(L, 1);
     status = close(fd);
 
     return (luab_pushxinteger(L, status));
@@ -251,13 +249,11 @@ luab_closefrom(lua_State *L)
 static int
 luab_dup(lua_State *L)
 {
-    luab_module_t *m;
     int oldd, fd;
 
     (void)luab_core_checkmaxargs(L, 1);
 
-    m = luab_xmod(INT, TYPE, __func__);
-    oldd = (int)luab_checkxinteger(L, 1, m, luab_env_int_max);
+    oldd = luab_checkint(L, 1);
     fd = dup(oldd);
 
     return (luab_pushxinteger(L, fd));
@@ -279,15 +275,12 @@ luab_dup(lua_State *L)
 static int
 luab_dup2(lua_State *L)
 {
-    luab_module_t *m;
     int oldd, newd, fd;
 
     (void)luab_core_checkmaxargs(L, 2);
 
-    m = luab_xmod(INT, TYPE, __func__);
-
-    oldd = (int)luab_checkxinteger(L, 1, m, luab_env_int_max);
-    newd = (int)luab_checkxinteger(L, 2, m, luab_env_int_max);
+    oldd = luab_checkint(L, 1);
+    newd = luab_checkint(L, 2);
 
     fd = dup2(oldd, newd);
 
@@ -770,13 +763,11 @@ luab_getuid(lua_State *L)
 static int
 luab_isatty(lua_State *L)
 {
-    luab_module_t *m;
     int fd, status;
 
     (void)luab_core_checkmaxargs(L, 1);
 
-    m = luab_xmod(INT, TYPE, __func__);
-    fd = (int)luab_checkxinteger(L, 1, m, luab_env_int_max);
+    fd = luab_checkint(L, 1);
     status = isatty(fd);
 
     return (luab_pushxinteger(L, status));
@@ -830,7 +821,6 @@ luab_link(lua_State *L)
 static int
 luab_lseek(lua_State *L)
 {
-    luab_module_t *m0, *m1;
     int filedes;
     off_t offset;
     int whence;
@@ -838,12 +828,9 @@ luab_lseek(lua_State *L)
 
     (void)luab_core_checkmaxargs(L, 3);
 
-    m0 = luab_xmod(INT, TYPE, __func__);
-    m1 = luab_xmod(OFF, TYPE, __func__);
-
-    filedes = (int)luab_checkxinteger(L, 1, m0, luab_env_int_max);
-    offset = (off_t)luab_checkxinteger(L, 2, m1, luab_env_ulong_max);
-    whence = (int)luab_checkxinteger(L, 3, m0, luab_env_int_max);
+    filedes = luab_checkint(L, 1);
+    offset = luab_checkoff(L, 2);
+    whence = luab_checkint(L, 3);
 
     location = lseek(filedes, offset, whence);
 
@@ -962,20 +949,18 @@ luab_pipe(lua_State *L)
 static int
 luab_read(lua_State *L)
 {
-    luab_module_t *m0, *m1, *m2;
+    luab_module_t *m;
     int fd;
     luab_iovec_t *buf;
     size_t nbytes;
 
     (void)luab_core_checkmaxargs(L, 3);
 
-    m0 = luab_xmod(INT, TYPE, __func__);
-    m1 = luab_xmod(IOVEC, TYPE, __func__);
-    m2 = luab_xmod(SIZE, TYPE, __func__);
+    m = luab_xmod(IOVEC, TYPE, __func__);
 
-    fd = (int)luab_checkxinteger(L, 1, m0, luab_env_int_max);
-    buf = luab_udata(L, 2, m1, luab_iovec_t *);
-    nbytes = (size_t)luab_checklxinteger(L, 3, m2, 0);
+    fd = luab_checkint(L, 1);
+    buf = luab_udata(L, 2, m, luab_iovec_t *);
+    nbytes = luab_checksize(L, 3);
 
     return (luab_iovec_read(L, fd, buf, &nbytes));
 }
@@ -1232,9 +1217,8 @@ luab_ttyname(lua_State *L)
     m = luab_xmod(INT, TYPE, __func__);
     fd = (int)luab_checkxinteger(L, 1, m, luab_env_int_max);
 
-    buf = ttyname(fd);
+    buf = ttyname(fd);     /* static, owned by libc */
     status = luab_pushstring(L, buf);
-    luab_core_freestr(buf);
 
     return (status);
 }
@@ -1333,20 +1317,18 @@ luab_unlink(lua_State *L)
 static int
 luab_write(lua_State *L)
 {
-    luab_module_t *m0, *m1, *m2;
+    luab_module_t *m;
     int fd;
     luab_iovec_t *buf;
     size_t nbytes;
 
     (void)luab_core_checkmaxargs(L, 3);
 
-    m0 = luab_xmod(INT, TYPE, __func__);
-    m1 = luab_xmod(IOVEC, TYPE, __func__);
-    m2 = luab_xmod(SIZE, TYPE, __func__);
+    m = luab_xmod(IOVEC, TYPE, __func__);
 
-    fd = (int)luab_checkxinteger(L, 1, m0, luab_env_int_max);
-    buf = luab_udata(L, 2, m1, luab_iovec_t *);
-    nbytes = (size_t)luab_checklxinteger(L, 3, m2, 0);
+    fd = luab_checkint(L, 1);
+    buf = luab_udata(L, 2, m, luab_iovec_t *);
+    nbytes = luab_checksize(L, 3);
 
     return (luab_iovec_write(L, fd, buf, &nbytes));
 }
@@ -1367,13 +1349,11 @@ luab_write(lua_State *L)
 static int
 luab_fsync(lua_State *L)
 {
-    luab_module_t *m;
     int fd, status;
 
     (void)luab_core_checkmaxargs(L, 1);
 
-    m = luab_xmod(INT, TYPE, __func__);
-    fd = (int)luab_checkinteger(L, 1, luab_env_int_max);
+    fd = luab_checkint(L, 1);
 
     status = fsync(fd);
 
@@ -1425,18 +1405,14 @@ luab_fdatasync(lua_State *L)
 static int
 luab_ftruncate(lua_State *L)
 {
-    luab_module_t *m0, *m1;
     int fd;
     off_t length;
     int status;
 
-    luab_core_checkmaxargs(L, 2);
-
-    m0 = luab_xmod(INT, TYPE, __func__);
-    m1 = luab_xmod(OFF, TYPE, __func__);
+    (void)luab_core_checkmaxargs(L, 2);
 
-    fd = (int)luab_checkxinteger(L, 1, m0, luab_env_path_max);
-    length = (off_t)luab_checkxinteger(L, 2, m1, luab_env_long_max);
+    fd = luab_checkint(L, 1);
+    length = luab_checkoff(L, 2);
 
     status = ftruncate(fd, length);
 
@@ -1512,7 +1488,6 @@ luab_getlogin_r(lua_State *L)
 static int
 luab_fchown(lua_State *L)
 {
-    luab_module_t *m0, *m1, *m2;
     int fd;
     uid_t owner;
     gid_t group;
@@ -1520,13 +1495,9 @@ luab_fchown(lua_State *L)
 
     (void)luab_core_checkmaxargs(L, 3);
 
-    m0 = luab_xmod(INT, TYPE, __func__);
-    m1 = luab_xmod(UID, TYPE, __func__);
-    m2 = luab_xmod(GID, TYPE, __func__);
-
-    fd = (int)luab_checkxinteger(L, 1, m0, luab_env_int_max);
-    owner = (uid_t)luab_checkxinteger(L, 2, m1, luab_env_int_max);
-    group = (gid_t)luab_checkxinteger(L, 3, m2, luab_env_int_max);
+    fd = luab_checkint(L, 1);
+    owner = luab_checkuid(L, 2);
+    group = luab_checkgid(L, 3);
 
     status = fchown(fd, owner, group);
 
@@ -1809,23 +1780,20 @@ luab_lchown(lua_State *L)
 static int
 luab_pread(lua_State *L)
 {
-    luab_module_t *m0, *m1, *m2, *m3;
+    luab_module_t *m;
     int fd;
     luab_iovec_t *buf;
     size_t nbytes;
     off_t offset;
 
-    (void)luab_core_checkmaxargs(L, 3);
+    (void)luab_core_checkmaxargs(L, 4);
 
-    m0 = luab_xmod(INT, TYPE, __func__);
-    m1 = luab_xmod(IOVEC, TYPE, __func__);
-    m2 = luab_xmod(SIZE, TYPE, __func__);
-    m3 = luab_xmod(OFF, TYPE, __func__);
+    m = luab_xmod(IOVEC, TYPE, __func__);
 
-    fd = (int)luab_checkxinteger(L, 1, m0, luab_env_int_max);
-    buf = luab_udata(L, 2, m1, luab_iovec_t *);
-    nbytes = (size_t)luab_checklxinteger(L, 3, m2, 0);
-    offset = (off_t)luab_checkxinteger(L, 4, m3, luab_env_long_max);
+    fd = luab_checkint(L, 1);
+    buf = luab_udata(L, 2, m, luab_iovec_t *);
+    nbytes = luab_checksize(L, 3);
+    offset = luab_checkoff(L, 4);
 
     return (luab_iovec_pread(L, fd, buf, &nbytes, offset));
 }
@@ -1847,23 +1815,20 @@ luab_pread(lua_State *L)
 static int
 luab_pwrite(lua_State *L)
 {
-    luab_module_t *m0, *m1, *m2, *m3;
+    luab_module_t *m;
     int fd;
     luab_iovec_t *buf;
     size_t nbytes;
     off_t offset;
 
-    (void)luab_core_checkmaxargs(L, 3);
+    (void)luab_core_checkmaxargs(L, 4);
 
-    m0 = luab_xmod(INT, TYPE, __func__);
-    m1 = luab_xmod(IOVEC, TYPE, __func__);
-    m2 = luab_xmod(SIZE, TYPE, __func__);
-    m3 = luab_xmod(OFF, TYPE, __func__);
+    m = luab_xmod(IOVEC, TYPE, __func__);
 
-    fd = (int)luab_checkxinteger(L, 1, m0, luab_env_int_max);
-    buf = luab_udata(L, 2, m1, luab_iovec_t *);
-    nbytes = (size_t)luab_checklxinteger(L, 3, m2, 0);
-    offset = (off_t)luab_checkxinteger(L, 4, m3, luab_env_long_max);
+    fd = luab_checkint(L, 1);
+    buf = luab_udata(L, 2, m, luab_iovec_t *);
+    nbytes = luab_checksize(L, 3);
+    offset = luab_checkoff(L, 4);
 
     return (luab_iovec_pwrite(L, fd, buf, &nbytes, offset));
 }
@@ -3077,7 +3042,7 @@ luab_fflagstostr(lua_State *L)
 
     str = fflagstostr(flags);
     status = luab_pushstring(L, str);
-    luab_core_freestr(str);
+    free(str);
 
     return (status);
 }
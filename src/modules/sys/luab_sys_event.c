@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/event.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+
+#define LUAB_SYS_EVENT_LIB_ID    1615221102
+#define LUAB_SYS_EVENT_LIB_KEY    "event"
+
+extern luab_module_t luab_sys_event_lib;
+
+/*
+ * Service primitives.
+ */
+
+#if __BSD_VISIBLE
+/***
+ * kqueue(2) - kernel event notification mechanism
+ *
+ * @function kqueue
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage fd [, err, msg ] = bsd.sys.event.kqueue()
+ */
+static int
+luab_kqueue(lua_State *L)
+{
+    int fd;
+
+    (void)luab_core_checkmaxargs(L, 0);
+
+    fd = kqueue();
+
+    return (luab_pushxinteger(L, fd));
+}
+
+/*
+ * Generator functions.
+ */
+
+/***
+ * Generator function - create an instance of (LUA_TUSERDATA(KQUEUE)).
+ *
+ * @function create_kqueue
+ *
+ * @param card              Capacity of changelist and eventlist, that is
+ *                          the maximum number of events returned by a
+ *                          single call of kqueue:wait().
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage kqueue [, err, msg ] = bsd.sys.event.create_kqueue(card)
+ */
+static int
+luab_type_create_kqueue(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    int card;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m0 = luab_xmod(KQUEUE, TYPE, __func__);
+    m1 = luab_xmod(INT, TYPE, __func__);
+
+    card = (int)luab_checkxinteger(L, 1, m1, luab_env_int_max);
+
+    if (card > 0)
+        return (luab_pushxdata(L, m0, &card));
+
+    errno = ERANGE;
+    return (luab_pushnil(L));
+}
+#endif /* __BSD_VISIBLE */
+
+/*
+ * Interface against <sys/event.h>.
+ */
+
+static luab_module_table_t luab_sys_event_vec[] = { /* sys/event.h */
+#if __BSD_VISIBLE
+    LUAB_INT("EVFILT_READ",             EVFILT_READ),
+    LUAB_INT("EVFILT_WRITE",            EVFILT_WRITE),
+    LUAB_INT("EVFILT_AIO",              EVFILT_AIO),
+    LUAB_INT("EVFILT_VNODE",            EVFILT_VNODE),
+    LUAB_INT("EVFILT_PROC",             EVFILT_PROC),
+    LUAB_INT("EVFILT_SIGNAL",           EVFILT_SIGNAL),
+    LUAB_INT("EVFILT_TIMER",            EVFILT_TIMER),
+    LUAB_INT("EVFILT_PROCDESC",         EVFILT_PROCDESC),
+    LUAB_INT("EVFILT_FS",               EVFILT_FS),
+    LUAB_INT("EVFILT_LIO",              EVFILT_LIO),
+    LUAB_INT("EVFILT_USER",             EVFILT_USER),
+    LUAB_INT("EVFILT_SENDFILE",         EVFILT_SENDFILE),
+    LUAB_INT("EVFILT_EMPTY",            EVFILT_EMPTY),
+    LUAB_INT("EVFILT_SYSCOUNT",         EVFILT_SYSCOUNT),
+    LUAB_INT("EV_ADD",                  EV_ADD),
+    LUAB_INT("EV_DELETE",               EV_DELETE),
+    LUAB_INT("EV_ENABLE",               EV_ENABLE),
+    LUAB_INT("EV_DISABLE",              EV_DISABLE),
+    LUAB_INT("EV_FORCEONESHOT",         EV_FORCEONESHOT),
+    LUAB_INT("EV_ONESHOT",              EV_ONESHOT),
+    LUAB_INT("EV_CLEAR",                EV_CLEAR),
+    LUAB_INT("EV_RECEIPT",              EV_RECEIPT),
+    LUAB_INT("EV_DISPATCH",             EV_DISPATCH),
+    LUAB_INT("EV_SYSFLAGS",             EV_SYSFLAGS),
+    LUAB_INT("EV_DROP",                 EV_DROP),
+    LUAB_INT("EV_FLAG1",                EV_FLAG1),
+    LUAB_INT("EV_FLAG2",                EV_FLAG2),
+    LUAB_INT("EV_EOF",                  EV_EOF),
+    LUAB_INT("EV_ERROR",                EV_ERROR),
+    LUAB_INT("NOTE_FFNOP",              NOTE_FFNOP),
+    LUAB_INT("NOTE_FFAND",              NOTE_FFAND),
+    LUAB_INT("NOTE_FFOR",               NOTE_FFOR),
+    LUAB_INT("NOTE_FFCOPY",             NOTE_FFCOPY),
+    LUAB_INT("NOTE_FFCTRLMASK",         NOTE_FFCTRLMASK),
+    LUAB_INT("NOTE_FFLAGSMASK",         NOTE_FFLAGSMASK),
+    LUAB_INT("NOTE_TRIGGER",            NOTE_TRIGGER),
+    LUAB_INT("NOTE_LOWAT",              NOTE_LOWAT),
+    LUAB_INT("NOTE_FILE_POLL",          NOTE_FILE_POLL),
+    LUAB_INT("NOTE_DELETE",             NOTE_DELETE),
+    LUAB_INT("NOTE_WRITE",              NOTE_WRITE),
+    LUAB_INT("NOTE_EXTEND",             NOTE_EXTEND),
+    LUAB_INT("NOTE_ATTRIB",             NOTE_ATTRIB),
+    LUAB_INT("NOTE_LINK",               NOTE_LINK),
+    LUAB_INT("NOTE_RENAME",             NOTE_RENAME),
+    LUAB_INT("NOTE_REVOKE",             NOTE_REVOKE),
+    LUAB_INT("NOTE_OPEN",               NOTE_OPEN),
+    LUAB_INT("NOTE_CLOSE",              NOTE_CLOSE),
+    LUAB_INT("NOTE_CLOSE_WRITE",        NOTE_CLOSE_WRITE),
+    LUAB_INT("NOTE_READ",               NOTE_READ),
+    LUAB_INT("NOTE_EXIT",               NOTE_EXIT),
+    LUAB_INT("NOTE_FORK",               NOTE_FORK),
+    LUAB_INT("NOTE_EXEC",               NOTE_EXEC),
+    LUAB_INT("NOTE_PCTRLMASK",          NOTE_PCTRLMASK),
+    LUAB_INT("NOTE_PDATAMASK",          NOTE_PDATAMASK),
+    LUAB_INT("NOTE_TRACK",              NOTE_TRACK),
+    LUAB_INT("NOTE_TRACKERR",           NOTE_TRACKERR),
+    LUAB_INT("NOTE_CHILD",              NOTE_CHILD),
+    LUAB_INT("NOTE_SECONDS",            NOTE_SECONDS),
+    LUAB_INT("NOTE_MSECONDS",           NOTE_MSECONDS),
+    LUAB_INT("NOTE_USECONDS",           NOTE_USECONDS),
+    LUAB_INT("NOTE_NSECONDS",           NOTE_NSECONDS),
+    LUAB_INT("NOTE_ABSTIME",            NOTE_ABSTIME),
+    LUAB_FUNC("kqueue",                 luab_kqueue),
+    LUAB_FUNC("create_kqueue",          luab_type_create_kqueue),
+#endif /* __BSD_VISIBLE */
+    LUAB_MOD_TBL_SENTINEL
+};
+
+luab_module_t luab_sys_event_lib = {
+    .m_id       = LUAB_SYS_EVENT_LIB_ID,
+    .m_name     = LUAB_SYS_EVENT_LIB_KEY,
+    .m_vec      = luab_sys_event_vec,
+};
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/mman.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+
+#define LUAB_SYS_MMAN_LIB_ID    1615308224
+#define LUAB_SYS_MMAN_LIB_KEY    "mman"
+
+extern luab_module_t luab_sys_mman_lib;
+
+/*
+ * Service primitives.
+ */
+
+/***
+ * mmap(2) - allocate memory, or map files or devices into memory
+ *
+ * @function mmap
+ *
+ * @param addr              Hint, (LUA_TNIL), the kernel selects the address.
+ * @param len               Length of the mapped region.
+ * @param prot              Protection, by values from
+ *
+ *                              bsd.sys.mman.PROT_{
+ *                                  NONE,
+ *                                  READ,
+ *                                  WRITE,
+ *                                  EXEC
+ *                              }
+ *
+ *                          may combined by inclusive OR.
+ * @param flags             Specifies the type of the mapped object, by
+ *                          values from bsd.sys.mman.MAP_*.
+ * @param fd                File descriptor or -1 for MAP_ANON.
+ * @param offset            Offset into the mapped object.
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          The mapped region is returned by an instance of
+ *          (LUA_TUSERDATA(IOVEC)) without copying, it is unmapped
+ *          when its instance is collected. Regions mapped without
+ *          PROT_WRITE are rejected as buffer for read(2) et al.
+ *
+ * @usage iovec [, err, msg ] = bsd.sys.mman.mmap(nil, len, prot, flags, fd, offset)
+ */
+static int
+luab_mmap(lua_State *L)
+{
+    luab_module_t *m0, *m1, *m2;
+    size_t len;
+    int prot, flags, fd;
+    off_t offset;
+    void *addr;
+
+    (void)luab_core_checkmaxargs(L, 6);
+
+    m0 = luab_xmod(SIZE, TYPE, __func__);
+    m1 = luab_xmod(INT, TYPE, __func__);
+    m2 = luab_xmod(OFF, TYPE, __func__);
+
+    (void)luab_checknil(L, 1);
+    len = (size_t)luab_checklxinteger(L, 2, m0, 0);
+    prot = (int)luab_checkxinteger(L, 3, m1, luab_env_int_max);
+    flags = (int)luab_checkxinteger(L, 4, m1, luab_env_int_max);
+    fd = (int)luab_checkxinteger(L, 5, m1, luab_env_uint_max);
+    offset = (off_t)luab_checkxinteger(L, 6, m2, luab_env_long_max);
+
+    if (len > 0) {
+        addr = mmap(NULL, len, prot, flags, fd, offset);
+
+        if (addr != MAP_FAILED)
+            return (luab_iovec_pushmdata(L, addr, len,
+                (prot & PROT_WRITE) ? 0 : IOV_RDONLY));
+    } else
+        errno = EINVAL;
+
+    return (luab_pushnil(L));
+}
+
+/***
+ * munmap(2) - remove a mapping
+ *
+ * @function munmap
+ *
+ * @param iovec             Instance of (LUA_TUSERDATA(IOVEC)), returned
+ *                          by bsd.sys.mman.mmap.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage ret [, err, msg ] = bsd.sys.mman.munmap(iovec)
+ */
+static int
+luab_munmap(lua_State *L)
+{
+    luab_module_t *m;
+    luab_iovec_t *buf;
+    int status;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(IOVEC, TYPE, __func__);
+    buf = luab_udata(L, 1, m, luab_iovec_t *);
+
+    if ((buf->iov_flags & IOV_MMAP) &&
+        (buf->iov.iov_base != NULL)) {
+
+        if ((status = luab_iovec_hold(L, buf, __func__)) == 0) {
+
+            if ((status = munmap(buf->iov.iov_base,
+                buf->iov_max_len)) == 0) {
+                buf->iov.iov_base = NULL;
+                buf->iov.iov_len = 0;
+                buf->iov_max_len = 0;
+                buf->iov_flags &= ~(IOV_BUFF|IOV_MMAP|IOV_RDONLY);
+            }
+            luab_iovec_rele(L, buf, __func__);
+        }
+    } else {
+        errno = EINVAL;
+        status = luab_env_error;
+    }
+    return (luab_pushxinteger(L, status));
+}
+
+/***
+ * msync(2) - synchronize a mapped region
+ *
+ * @function msync
+ *
+ * @param iovec             Instance of (LUA_TUSERDATA(IOVEC)), returned
+ *                          by bsd.sys.mman.mmap.
+ * @param flags             Values from bsd.sys.mman.MS_{ASYNC,SYNC,INVALIDATE}.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage ret [, err, msg ] = bsd.sys.mman.msync(iovec, flags)
+ */
+static int
+luab_msync(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    luab_iovec_t *buf;
+    int flags, status;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(IOVEC, TYPE, __func__);
+    m1 = luab_xmod(INT, TYPE, __func__);
+
+    buf = luab_udata(L, 1, m0, luab_iovec_t *);
+    flags = (int)luab_checkxinteger(L, 2, m1, luab_env_int_max);
+
+    if ((buf->iov_flags & IOV_MMAP) &&
+        (buf->iov.iov_base != NULL))
+        status = msync(buf->iov.iov_base, buf->iov_max_len, flags);
+    else {
+        errno = EINVAL;
+        status = luab_env_error;
+    }
+    return (luab_pushxinteger(L, status));
+}
+
+/***
+ * madvise(2) - give advice about use of memory
+ *
+ * @function madvise
+ *
+ * @param iovec             Instance of (LUA_TUSERDATA(IOVEC)), returned
+ *                          by bsd.sys.mman.mmap.
+ * @param behav             Values from bsd.sys.mman.MADV_*.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage ret [, err, msg ] = bsd.sys.mman.madvise(iovec, behav)
+ */
+static int
+luab_madvise(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    luab_iovec_t *buf;
+    int behav, status;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(IOVEC, TYPE, __func__);
+    m1 = luab_xmod(INT, TYPE, __func__);
+
+    buf = luab_udata(L, 1, m0, luab_iovec_t *);
+    behav = (int)luab_checkxinteger(L, 2, m1, luab_env_int_max);
+
+    if ((buf->iov_flags & IOV_MMAP) &&
+        (buf->iov.iov_base != NULL))
+        status = madvise(buf->iov.iov_base, buf->iov_max_len, behav);
+    else {
+        errno = EINVAL;
+        status = luab_env_error;
+    }
+    return (luab_pushxinteger(L, status));
+}
+
+/*
+ * Interface against <sys/mman.h>.
+ */
+
+static luab_module_table_t luab_sys_mman_vec[] = { /* sys/mman.h */
+    LUAB_INT("PROT_NONE",               PROT_NONE),
+    LUAB_INT("PROT_READ",               PROT_READ),
+    LUAB_INT("PROT_WRITE",              PROT_WRITE),
+    LUAB_INT("PROT_EXEC",               PROT_EXEC),
+    LUAB_INT("MAP_SHARED",              MAP_SHARED),
+    LUAB_INT("MAP_PRIVATE",             MAP_PRIVATE),
+    LUAB_INT("MAP_FIXED",               MAP_FIXED),
+#if __BSD_VISIBLE
+    LUAB_INT("MAP_ANON",                MAP_ANON),
+    LUAB_INT("MAP_ANONYMOUS",           MAP_ANONYMOUS),
+    LUAB_INT("MAP_FILE",                MAP_FILE),
+    LUAB_INT("MAP_HASSEMAPHORE",        MAP_HASSEMAPHORE),
+    LUAB_INT("MAP_STACK",               MAP_STACK),
+    LUAB_INT("MAP_NOSYNC",              MAP_NOSYNC),
+    LUAB_INT("MAP_EXCL",                MAP_EXCL),
+    LUAB_INT("MAP_NOCORE",              MAP_NOCORE),
+    LUAB_INT("MAP_PREFAULT_READ",       MAP_PREFAULT_READ),
+#endif /* __BSD_VISIBLE */
+    LUAB_INT("MS_SYNC",                 MS_SYNC),
+    LUAB_INT("MS_ASYNC",                MS_ASYNC),
+    LUAB_INT("MS_INVALIDATE",           MS_INVALIDATE),
+#if __BSD_VISIBLE
+    LUAB_INT("MADV_NORMAL",             MADV_NORMAL),
+    LUAB_INT("MADV_RANDOM",             MADV_RANDOM),
+    LUAB_INT("MADV_SEQUENTIAL",         MADV_SEQUENTIAL),
+    LUAB_INT("MADV_WILLNEED",           MADV_WILLNEED),
+    LUAB_INT("MADV_DONTNEED",           MADV_DONTNEED),
+    LUAB_INT("MADV_FREE",               MADV_FREE),
+    LUAB_INT("MADV_NOSYNC",             MADV_NOSYNC),
+    LUAB_INT("MADV_AUTOSYNC",           MADV_AUTOSYNC),
+    LUAB_INT("MADV_NOCORE",             MADV_NOCORE),
+    LUAB_INT("MADV_CORE",               MADV_CORE),
+    LUAB_INT("MADV_PROTECT",            MADV_PROTECT),
+#endif /* __BSD_VISIBLE */
+    LUAB_INT("POSIX_MADV_NORMAL",       POSIX_MADV_NORMAL),
+    LUAB_INT("POSIX_MADV_RANDOM",       POSIX_MADV_RANDOM),
+    LUAB_INT("POSIX_MADV_SEQUENTIAL",   POSIX_MADV_SEQUENTIAL),
+    LUAB_INT("POSIX_MADV_WILLNEED",     POSIX_MADV_WILLNEED),
+    LUAB_INT("POSIX_MADV_DONTNEED",     POSIX_MADV_DONTNEED),
+    LUAB_FUNC("mmap",                   luab_mmap),
+    LUAB_FUNC("munmap",                 luab_munmap),
+    LUAB_FUNC("msync",                  luab_msync),
+    LUAB_FUNC("madvise",                luab_madvise),
+    LUAB_MOD_TBL_SENTINEL
+};
+
+luab_module_t luab_sys_mman_lib = {
+    .m_id       = LUAB_SYS_MMAN_LIB_ID,
+    .m_name     = LUAB_SYS_MMAN_LIB_KEY,
+    .m_vec      = luab_sys_mman_vec,
+};
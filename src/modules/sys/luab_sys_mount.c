@@ -517,13 +517,12 @@ luab_getmntinfo(lua_State *L)
 
     mode = (int)luab_checkxinteger(L, 2, m0, luab_env_int_max);
 
+    /* vec is owned by getmntinfo(3) and reused by subsequent calls */
     if ((nmts = getmntinfo(&vec, mode)) > 0) {
         if ((tbl = (*m1->m_alloc_tbl)(vec, nmts)) != NULL)
             luab_table_pushxdata(L, 1, m1, tbl, 0, 1);
         else
             nmts = luab_env_success;
-
-        luab_core_free(vec, nmts * m1->m_sz);
     }
     return (luab_pushxinteger(L, nmts));
 }
@@ -506,16 +506,13 @@ luab_getsockopt(lua_State *L)
 static int
 luab_listen(lua_State *L)
 {
-    luab_module_t *m;
     int s, backlog;
     int status;
 
     (void)luab_core_checkmaxargs(L, 2);
 
-    m = luab_xmod(INT, TYPE, __func__);
-
-    s = (int)luab_checkxinteger(L, 1, m, luab_env_int_max);
-    backlog = (int)luab_checkxinteger(L, 2, m, luab_env_int_max);
+    s = luab_checkint(L, 1);
+    backlog = luab_checkint(L, 2);
 
     status = listen(s, backlog);
 
@@ -549,22 +546,20 @@ luab_listen(lua_State *L)
 static int
 luab_recv(lua_State *L)
 {
-    luab_module_t *m0, *m1, *m2;
+    luab_module_t *m;
     int s;
     luab_iovec_t *buf;
     size_t len;
     int flags;
 
-    (void)luab_core_checkmaxargs(L, 3);
+    (void)luab_core_checkmaxargs(L, 4);
 
-    m0 = luab_xmod(INT, TYPE, __func__);
-    m1 = luab_xmod(IOVEC, TYPE, __func__);
-    m2 = luab_xmod(SIZE, TYPE, __func__);
+    m = luab_xmod(IOVEC, TYPE, __func__);
 
-    s = (int)luab_checkxinteger(L, 1, m0, luab_env_int_max);
-    buf = luab_udata(L, 2, m1, luab_iovec_t *);
-    len = (size_t)luab_checklxinteger(L, 3, m2, 0);
-    flags = (int)luab_checkxinteger(L, 4, m0, luab_env_int_max);
+    s = luab_checkint(L, 1);
+    buf = luab_udata(L, 2, m, luab_iovec_t *);
+    len = luab_checksize(L, 3);
+    flags = luab_checkint(L, 4);
 
     return (luab_iovec_recv(L, s, buf, &len, flags));
 }
@@ -598,7 +593,7 @@ luab_recv(lua_State *L)
 static int
 luab_recvfrom(lua_State *L)
 {
-    luab_module_t *m0, *m1, *m2, *m3, *m4;
+    luab_module_t *m0, *m1, *m2;
     int s;
     luab_iovec_t *buf;
     size_t len;
@@ -608,18 +603,16 @@ luab_recvfrom(lua_State *L)
 
     (void)luab_core_checkmaxargs(L, 6);
 
-    m0 = luab_xmod(INT, TYPE, __func__);
-    m1 = luab_xmod(IOVEC, TYPE, __func__);
-    m2 = luab_xmod(SIZE, TYPE, __func__);
-    m3 = luab_xmod(SOCKADDR, TYPE, __func__);
-    m4 = luab_xmod(SOCKLEN, TYPE, __func__);
+    m0 = luab_xmod(IOVEC, TYPE, __func__);
+    m1 = luab_xmod(SOCKADDR, TYPE, __func__);
+    m2 = luab_xmod(SOCKLEN, TYPE, __func__);
 
-    s = (int)luab_checkxinteger(L, 1, m0, luab_env_int_max);
-    buf = luab_udata(L, 2, m1, luab_iovec_t *);
-    len = (size_t)luab_checklxinteger(L, 3, m2, 0);
-    flags = (int)luab_checkxinteger(L, 4, m3, luab_env_int_max);
-    from = luab_udataisnil(L, 5, m3, struct sockaddr *);
-    fromlen = luab_udata(L, 6, m4, socklen_t *);
+    s = luab_checkint(L, 1);
+    buf = luab_udata(L, 2, m0, luab_iovec_t *);
+    len = luab_checksize(L, 3);
+    flags = luab_checkint(L, 4);
+    from = luab_udataisnil(L, 5, m1, struct sockaddr *);
+    fromlen = luab_udata(L, 6, m2, socklen_t *);
 
     return (luab_iovec_recvfrom(L, s, buf, &len, flags, from, fromlen));
 }
@@ -705,9 +698,10 @@ luab_recvmsg(lua_State *L)
 static int
 luab_recvmmsg(lua_State *L)
 {
-    luab_module_t *m0, *m1, *m2;
+    luab_module_t *m0, *m1, *m2, *m3;
     int s;
     luab_table_t *tbl;
+    luab_mmsgbatch_t *mb;
     size_t vlen;
     int flags;
     struct timespec *timeout;
@@ -719,14 +713,26 @@ luab_recvmmsg(lua_State *L)
     m0 = luab_xmod(INT, TYPE, __func__);
     m1 = luab_xmod(SIZE, TYPE, __func__);
     m2 = luab_xmod(TIMESPEC, TYPE, __func__);
+    m3 = luab_xmod(MMSGBATCH, TYPE, __func__);
 
     s = (int)luab_checkxinteger(L, 1, m0, luab_env_int_max);
-    tbl = luab_table_checkmmsghdr(L, 2);
+
+    if ((mb = luab_isdata(L, 2, m3, luab_mmsgbatch_t *)) != NULL)
+        tbl = NULL;
+    else
+        tbl = luab_table_checkmmsghdr(L, 2);
+
     vlen = (size_t)luab_checklxinteger(L, 3, m1, 0);
     flags = (int)luab_checkxinteger(L, 4, m0, luab_env_int_max);
     timeout = luab_udataisnil(L, 5, m2, struct timespec *);
 
-    if (tbl != NULL) {
+    if (mb != NULL) {
+
+        if ((msgvec = luab_mmsgbatch_rxvec(mb, vlen)) != NULL)
+            count = recvmmsg(s, msgvec, vlen, flags, timeout);
+        else
+            count = luab_env_error;
+    } else if (tbl != NULL) {
         msgvec = (struct mmsghdr *)(tbl->tbl_vec);
         count = recvmmsg(s, msgvec, vlen, flags, timeout);
         luab_table_free(tbl);
@@ -765,22 +771,20 @@ luab_recvmmsg(lua_State *L)
 static int
 luab_send(lua_State *L)
 {
-    luab_module_t *m0, *m1, *m2;
+    luab_module_t *m;
     int s;
     luab_iovec_t *msg;
     size_t len;
     int flags;
 
-    (void)luab_core_checkmaxargs(L, 3);
+    (void)luab_core_checkmaxargs(L, 4);
 
-    m0 = luab_xmod(INT, TYPE, __func__);
-    m1 = luab_xmod(IOVEC, TYPE, __func__);
-    m2 = luab_xmod(SIZE, TYPE, __func__);
+    m = luab_xmod(IOVEC, TYPE, __func__);
 
-    s = (int)luab_checkxinteger(L, 1, m0, luab_env_int_max);
-    msg = luab_udata(L, 2, m1, luab_iovec_t *);
-    len = (size_t)luab_checklxinteger(L, 3, m2, 0);
-    flags = (int)luab_checkxinteger(L, 4, m0, luab_env_int_max);
+    s = luab_checkint(L, 1);
+    msg = luab_udata(L, 2, m, luab_iovec_t *);
+    len = luab_checksize(L, 3);
+    flags = luab_checkint(L, 4);
 
     return (luab_iovec_send(L, s, msg, &len, flags));
 }
@@ -815,7 +819,7 @@ luab_send(lua_State *L)
 static int
 luab_sendto(lua_State *L)
 {
-    luab_module_t *m0, *m1, *m2, *m3, *m4;
+    luab_module_t *m0, *m1;
     int s;
     luab_iovec_t *buf;
     size_t len;
@@ -825,18 +829,15 @@ luab_sendto(lua_State *L)
 
     (void)luab_core_checkmaxargs(L, 6);
 
-    m0 = luab_xmod(INT, TYPE, __func__);
-    m1 = luab_xmod(IOVEC, TYPE, __func__);
-    m2 = luab_xmod(SIZE, TYPE, __func__);
-    m3 = luab_xmod(SOCKADDR, TYPE, __func__);
-    m4 = luab_xmod(SOCKLEN, TYPE, __func__);
+    m0 = luab_xmod(IOVEC, TYPE, __func__);
+    m1 = luab_xmod(SOCKADDR, TYPE, __func__);
 
-    s = (int)luab_checkxinteger(L, 1, m0, luab_env_int_max);
-    buf = luab_udata(L, 2, m1, luab_iovec_t *);
-    len = (size_t)luab_checklxinteger(L, 3, m2, 0);
-    flags = (int)luab_checkxinteger(L, 4, m0, luab_env_int_max);
-    to = luab_udataisnil(L, 5, m3, struct sockaddr *);
-    tolen = (socklen_t)luab_checkxinteger(L, 4, m4, luab_env_int_max);
+    s = luab_checkint(L, 1);
+    buf = luab_udata(L, 2, m0, luab_iovec_t *);
+    len = luab_checksize(L, 3);
+    flags = luab_checkint(L, 4);
+    to = luab_udataisnil(L, 5, m1, struct sockaddr *);
+    tolen = luab_checksocklen(L, 6);
 
     return (luab_iovec_sendto(L, s, buf, &len, flags, to, tolen));
 }
@@ -955,6 +956,125 @@ luab_sendfile(lua_State *L)
     return (luab_pushxinteger(L, status));
 }
 
+/***
+ * Transmit a file to a socket(9) by sendfile(2), without passing the
+ * data through userspace.
+ *
+ * @function transmit_file
+ *
+ * @param fd                Specifies either regular file or shared memory object.
+ * @param s                 File descriptor for open socket(9), may be
+ *                          non-blocking, e. g. as returned by accept4(2).
+ * @param offset            Specifies where transmission starts, either by
+ *                          (LUA_TNUMBER) or by an instance of
+ *                          (LUA_TUSERDATA(OFF)), latter is advanced by the
+ *                          amount of transmitted bytes.
+ * @param nbytes            Specifies either how many bytes will be
+ *                          transmitted by (LUA_TNUMBER), whereby 0 denotes
+ *                          end of file, or the offset where transmission
+ *                          ends, exclusive, by an instance of
+ *                          (LUA_TUSERDATA(OFF)).
+ * @param flags             Flags argument over
+ *
+ *                              bsd.sys.socket.SF_{
+ *                                  NODISKIO,
+ *                                  NOCACHE,
+ *                                  SYNC,
+ *                                  USER_READAHEAD
+ *                              }
+ *
+ *                          may combined by inclusive or, optional.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          Amount of transmitted bytes. Interrupted calls are restarted.
+ *          If s would block or an error occurs after some data was
+ *          transmitted, the partial count is returned along with that
+ *          error, e. g. EAGAIN. If no data was transmitted, -1 is
+ *          returned along with the error.
+ *
+ *          If both offset and end of the range are passed by instances
+ *          of (LUA_TUSERDATA(OFF)), the call may be repeated by the same
+ *          arguments, until 0 is returned, since offset is advanced.
+ *
+ * @usage count [, err, msg ] = bsd.sys.socket.transmit_file(fd, s, offset, nbytes [, flags ])
+ *
+ *          or
+ *
+ *      count [, err, msg ] = bsd.sys.socket.transmit_file(fd, s, offset, end [, flags ])
+ */
+static int
+luab_transmit_file(lua_State *L)
+{
+    luab_module_t *m;
+    int fd, s;
+    off_t offset, *offp, *endp;
+    size_t nbytes, len;
+    int flags;
+    off_t sbytes;
+    ssize_t count;
+    int up_call;
+
+    (void)luab_core_checkmaxargs(L, 5);
+
+    m = luab_xmod(OFF, TYPE, __func__);
+
+    fd = luab_checkint(L, 1);
+    s = luab_checkint(L, 2);
+
+    if (luab_isdata(L, 3, m, void *) != NULL) {
+        offp = luab_udata(L, 3, m, off_t *);
+        offset = *offp;
+    } else {
+        offp = NULL;
+        offset = luab_checkoff(L, 3);
+    }
+    if (luab_isdata(L, 4, m, void *) != NULL) {
+        endp = luab_udata(L, 4, m, off_t *);
+
+        if (*endp < offset)
+            luab_core_argerror(L, 4, NULL, 0, 0, ERANGE);
+
+        /* range completed, but 0 would denote end of file */
+        if ((nbytes = (size_t)(*endp - offset)) == 0)
+            return (luab_pushxinteger(L, 0));
+    } else
+        nbytes = luab_checksize(L, 4);
+
+    flags = lua_isnoneornil(L, 5) ? 0 : luab_checkint(L, 5);
+
+    for (count = 0, up_call = 0;;) {
+        len = (nbytes > 0) ? (nbytes - (size_t)count) : 0;
+        sbytes = 0;
+
+        if (sendfile(fd, s, offset + count, len, NULL, &sbytes, flags) == 0) {
+            count += sbytes;
+
+            if (sbytes == 0 || nbytes == 0 || (size_t)count >= nbytes)
+                break;
+        } else {
+            count += sbytes;
+
+            if (errno == EINTR)
+                continue;
+
+            up_call = errno;
+            break;
+        }
+    }
+
+    if (offp != NULL && count > 0)
+        *offp += count;
+
+    if (up_call != 0 && count == 0) {
+        errno = up_call;
+        return (luab_pushxinteger(L, luab_env_error));
+    }
+    lua_pushinteger(L, (lua_Integer)count);
+
+    return (luab_pusherr(L, up_call, 1));
+}
+
 /***
  * sendmmsg(2) - send multiple message(s) at a call from a socket(9)
  *
@@ -983,9 +1103,10 @@ luab_sendfile(lua_State *L)
 static int
 luab_sendmmsg(lua_State *L)
 {
-    luab_module_t *m0, *m1;
+    luab_module_t *m0, *m1, *m2;
     int s;
     luab_table_t *tbl;
+    luab_mmsgbatch_t *mb;
     size_t vlen;
     int flags;
     struct mmsghdr *msgvec;
@@ -995,13 +1116,25 @@ luab_sendmmsg(lua_State *L)
 
     m0 = luab_xmod(INT, TYPE, __func__);
     m1 = luab_xmod(SIZE, TYPE, __func__);
+    m2 = luab_xmod(MMSGBATCH, TYPE, __func__);
 
     s = (int)luab_checkxinteger(L, 1, m0, luab_env_int_max);
-    tbl = luab_table_checkmmsghdr(L, 2);
+
+    if ((mb = luab_isdata(L, 2, m2, luab_mmsgbatch_t *)) != NULL)
+        tbl = NULL;
+    else
+        tbl = luab_table_checkmmsghdr(L, 2);
+
     vlen = (size_t)luab_checklxinteger(L, 3, m1, 0);
     flags = (int)luab_checkxinteger(L, 4, m0, luab_env_int_max);
 
-    if (tbl != NULL) {
+    if (mb != NULL) {
+
+        if ((msgvec = luab_mmsgbatch_txvec(mb, vlen)) != NULL)
+            count = sendmmsg(s, msgvec, vlen, flags);
+        else
+            count = luab_env_error;
+    } else if (tbl != NULL) {
         msgvec = (struct mmsghdr *)(tbl->tbl_vec);
         count = sendmmsg(s, msgvec, vlen, flags);
         luab_table_free(tbl);
@@ -1093,16 +1226,13 @@ luab_setsockopt(lua_State *L)
 static int
 luab_shutdown(lua_State *L)
 {
-    luab_module_t *m;
     int s, how;
     int status;
 
     (void)luab_core_checkmaxargs(L, 2);
 
-    m = luab_xmod(INT, TYPE, __func__);
-
-    s = (int)luab_checkxinteger(L, 1, m, luab_env_int_max);
-    how = (int)luab_checkxinteger(L, 2, m, luab_env_int_max);
+    s = luab_checkint(L, 1);
+    how = luab_checkint(L, 2);
     status = shutdown(s, how);
 
     return (luab_pushxinteger(L, status));
@@ -1152,7 +1282,6 @@ luab_sockatmark(lua_State *L)
 static int
 luab_socket(lua_State *L)
 {
-    luab_module_t *m;
     int domain;
     int type;
     int protocol;
@@ -1160,11 +1289,9 @@ luab_socket(lua_State *L)
 
     (void)luab_core_checkmaxargs(L, 3);
 
-    m = luab_xmod(INT, TYPE, __func__);
-
-    domain = (int)luab_checkxinteger(L, 1, m, luab_env_int_max);
-    type = (int)luab_checkxinteger(L, 2, m, luab_env_int_max);
-    protocol = (int)luab_checkxinteger(L, 3, m, luab_env_int_max);
+    domain = luab_checkint(L, 1);
+    type = luab_checkint(L, 2);
+    protocol = luab_checkint(L, 3);
 
     s = socket(domain, type, protocol);
 
@@ -1350,6 +1477,39 @@ luab_type_create_sf_hdtr(lua_State *L)
     m = luab_xmod(SF_HDTR, TYPE, __func__);
     return (luab_core_create(L, 0, m, NULL));
 }
+
+/***
+ * Generator function - create an instance of (LUA_TUSERDATA(MMSGBATCH)).
+ *
+ * @function create_mmsgbatch
+ *
+ * @param card              Number of slots.
+ * @param buflen            Capacity of each slot.
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage mmsgbatch [, err, msg ] = bsd.sys.socket.create_mmsgbatch(card, buflen)
+ */
+static int
+luab_type_create_mmsgbatch(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    luab_mmsgbatch_param_t mbp;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(MMSGBATCH, TYPE, __func__);
+    m1 = luab_xmod(SIZE, TYPE, __func__);
+
+    mbp.mbp_card = (size_t)luab_checklxinteger(L, 1, m1, 0);
+    mbp.mbp_buflen = (size_t)luab_checklxinteger(L, 2, m1, 0);
+
+    if (mbp.mbp_card > 0 && mbp.mbp_buflen > 0)
+        return (luab_pushxdata(L, m0, &mbp));
+
+    errno = ERANGE;
+    return (luab_pushnil(L));
+}
 #endif
 
 /*
@@ -1638,6 +1798,7 @@ static luab_module_table_t luab_sys_socket_vec[] = {
     LUAB_FUNC("sendmsg",                    luab_sendmsg),
 #if __BSD_VISIBLE
     LUAB_FUNC("sendfile",                   luab_sendfile),
+    LUAB_FUNC("transmit_file",              luab_transmit_file),
     LUAB_FUNC("sendmmesg",                  luab_sendmmsg),
     LUAB_FUNC("setfib",                     luab_setfib),
 #endif
@@ -1655,6 +1816,7 @@ static luab_module_table_t luab_sys_socket_vec[] = {
     LUAB_FUNC("create_cmsgcred",            luab_type_create_cmsgcred),
     LUAB_FUNC("create_sockproto",           luab_type_create_sockproto),
     LUAB_FUNC("create_sf_hdtr",             luab_type_create_sf_hdtr),
+    LUAB_FUNC("create_mmsgbatch",           luab_type_create_mmsgbatch),
 #endif
     LUAB_MOD_TBL_SENTINEL
 };
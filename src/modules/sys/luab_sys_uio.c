@@ -58,20 +58,18 @@ extern luab_module_t luab_sys_uio_lib;
 static int
 luab_readv(lua_State *L)
 {
-    luab_module_t *m0, *m1, *m2;
+    luab_module_t *m;
     int fd;
     luab_iovec_t *buf;
     size_t iovcnt;
 
     (void)luab_core_checkmaxargs(L, 3);
 
-    m0 = luab_xmod(INT, TYPE, __func__);
-    m1 = luab_xmod(IOVEC, TYPE, __func__);
-    m2 = luab_xmod(SIZE, TYPE, __func__);
+    m = luab_xmod(IOVEC, TYPE, __func__);
 
-    fd = (int)luab_checkxinteger(L, 1, m0, luab_env_int_max);
-    buf = luab_udata(L, 2, m1, luab_iovec_t *);
-    iovcnt = (size_t)luab_checklxinteger(L, 3, m2, 0);
+    fd = luab_checkint(L, 1);
+    buf = luab_udata(L, 2, m, luab_iovec_t *);
+    iovcnt = luab_checksize(L, 3);
 
     return (luab_iovec_readv(L, fd, buf, iovcnt));
 }
@@ -92,20 +90,18 @@ luab_readv(lua_State *L)
 static int
 luab_writev(lua_State *L)
 {
-    luab_module_t *m0, *m1, *m2;
+    luab_module_t *m;
     int fd;
     luab_iovec_t *buf;
     size_t iovcnt;
 
     (void)luab_core_checkmaxargs(L, 3);
 
-    m0 = luab_xmod(INT, TYPE, __func__);
-    m1 = luab_xmod(IOVEC, TYPE, __func__);
-    m2 = luab_xmod(SIZE, TYPE, __func__);
+    m = luab_xmod(IOVEC, TYPE, __func__);
 
-    fd = (int)luab_checkxinteger(L, 1, m0, luab_env_int_max);
-    buf = luab_udata(L, 2, m1, luab_iovec_t *);
-    iovcnt = (size_t)luab_checklxinteger(L, 3, m2, 0);
+    fd = luab_checkint(L, 1);
+    buf = luab_udata(L, 2, m, luab_iovec_t *);
+    iovcnt = luab_checksize(L, 3);
 
     return (luab_iovec_writev(L, fd, buf, iovcnt));
 }
@@ -128,7 +124,7 @@ luab_writev(lua_State *L)
 static int
 luab_preadv(lua_State *L)
 {
-    luab_module_t *m0, *m1, *m2, *m3;
+    luab_module_t *m;
     int fd;
     luab_iovec_t *buf;
     size_t iovcnt;
@@ -136,15 +132,12 @@ luab_preadv(lua_State *L)
 
     (void)luab_core_checkmaxargs(L, 4);
 
-    m0 = luab_xmod(INT, TYPE, __func__);
-    m1 = luab_xmod(IOVEC, TYPE, __func__);
-    m2 = luab_xmod(SIZE, TYPE, __func__);
-    m3 = luab_xmod(OFF, TYPE, __func__);
+    m = luab_xmod(IOVEC, TYPE, __func__);
 
-    fd = (int)luab_checkxinteger(L, 1, m0, luab_env_int_max);
-    buf = luab_udata(L, 2, m1, luab_iovec_t *);
-    iovcnt = (size_t)luab_checklxinteger(L, 3, m2, 0);
-    offset = (off_t)luab_checkxinteger(L, 4, m3, luab_env_long_max);
+    fd = luab_checkint(L, 1);
+    buf = luab_udata(L, 2, m, luab_iovec_t *);
+    iovcnt = luab_checksize(L, 3);
+    offset = luab_checkoff(L, 4);
 
     return (luab_iovec_preadv(L, fd, buf, iovcnt, offset));
 }
@@ -166,7 +159,7 @@ luab_preadv(lua_State *L)
 static int
 luab_pwritev(lua_State *L)
 {
-    luab_module_t *m0, *m1, *m2, *m3;
+    luab_module_t *m;
     int fd;
     luab_iovec_t *buf;
     size_t iovcnt;
@@ -174,17 +167,14 @@ luab_pwritev(lua_State *L)
 
     (void)luab_core_checkmaxargs(L, 4);
 
-    m0 = luab_xmod(INT, TYPE, __func__);
-    m1 = luab_xmod(IOVEC, TYPE, __func__);
-    m2 = luab_xmod(SIZE, TYPE, __func__);
-    m3 = luab_xmod(OFF, TYPE, __func__);
+    m = luab_xmod(IOVEC, TYPE, __func__);
 
-    fd = (int)luab_checkxinteger(L, 1, m0, luab_env_int_max);
-    buf = luab_udata(L, 2, m1, luab_iovec_t *);
-    iovcnt = (size_t)luab_checklxinteger(L, 3, m2, 0);
-    offset = (off_t)luab_checkxinteger(L, 4, m3, luab_env_long_max);
+    fd = luab_checkint(L, 1);
+    buf = luab_udata(L, 2, m, luab_iovec_t *);
+    iovcnt = luab_checksize(L, 3);
+    offset = luab_checkoff(L, 4);
 
-    return (luab_iovec_preadv(L, fd, buf, iovcnt, offset));
+    return (luab_iovec_pwritev(L, fd, buf, iovcnt, offset));
 }
 #endif /* __BSD_VISIBLE */
 
@@ -217,6 +207,64 @@ luab_type_create_iovec(lua_State *L)
     return (luab_iovec_pushxdata(L, NULL, 0, max_len));
 }
 
+#if __BSD_VISIBLE
+/***
+ * Generator function, creates an instance of (LUA_TUSERDATA(RINGBUF)).
+ *
+ * @function create_ringbuf
+ *
+ * @param size              Initial capacity in bytes, (LUA_TNUMBER).
+ * @param max_len           Upper bound of capacity, optional, defaults
+ *                          to size.
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage ringbuf [, err, msg ] = bsd.sys.uio.create_ringbuf(size [, max_len ])
+ */
+static int
+luab_type_create_ringbuf(lua_State *L)
+{
+    luab_module_t *m;
+    luab_ringbuf_param_t rbp;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(RINGBUF, TYPE, __func__);
+
+    rbp.rbp_size = luab_checksize(L, 1);
+    rbp.rbp_max_len = lua_isnoneornil(L, 2) ?
+        rbp.rbp_size : luab_checksize(L, 2);
+
+    return (luab_pushxdata(L, m, &rbp));
+}
+
+/***
+ * Generator function, creates an instance of (LUA_TUSERDATA(IOVEC_ARRAY)).
+ *
+ * @function create_iovec_array
+ *
+ * @param card              Maximum number of referred buffers, bound
+ *                          by IOV_MAX, (LUA_TNUMBER).
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage iovec_array [, err, msg ] = bsd.sys.uio.create_iovec_array(card)
+ */
+static int
+luab_type_create_iovec_array(lua_State *L)
+{
+    luab_module_t *m;
+    size_t card;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(IOVEC_ARRAY, TYPE, __func__);
+    card = luab_checksize(L, 1);
+
+    return (luab_pushxdata(L, m, &card));
+}
+#endif /* __BSD_VISIBLE */
+
 /*
  * Interface against <sys/uio.h>.
  */
@@ -236,6 +284,10 @@ static luab_module_table_t luab_sys_uio_vec[] = {
     LUAB_FUNC("pwritev",      luab_pwritev),
 #endif
     LUAB_FUNC("create_iovec", luab_type_create_iovec),
+#if __BSD_VISIBLE
+    LUAB_FUNC("create_ringbuf", luab_type_create_ringbuf),
+    LUAB_FUNC("create_iovec_array", luab_type_create_iovec_array),
+#endif
     LUAB_MOD_TBL_SENTINEL
 };
 
@@ -0,0 +1,771 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+
+#include <aio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+#include "luab_table.h"
+
+extern luab_module_t luab_aioq_type;
+
+/*
+ * Interface against
+ *
+ *  typedef struct luab_aioq {
+ *      luab_udata_t        ud_softc;
+ *      luab_aioq_req_t     *ud_req;
+ *      struct aiocb        **ud_list;
+ *      size_t              ud_card;
+ *      size_t              ud_npending;
+ *      size_t              ud_ninflight;
+ *  } luab_aioq_t;
+ *
+ * whereby each request refers a (LUA_TUSERDATA(IOVEC)), kept by the
+ * uservalue at index of its slot and held by IOV_LOCK until reaped. If
+ * both become unreachable, the region of a buffer finalized first is
+ * released by aioq_unref after the request completed, see IOV_ORPHAN.
+ * Pending requests are submitted by lio_listio(2), completions are
+ * reaped in bulk after aio_suspend(2).
+ */
+
+typedef struct luab_aioq_req {
+    struct aiocb    ar_cb;
+    luab_iovec_t    *ar_buf;
+    u_int           ar_state;
+} luab_aioq_req_t;
+
+#define AIOQ_FREE       0x00
+#define AIOQ_PENDING    0x01
+#define AIOQ_INFLIGHT   0x02
+
+typedef struct luab_aioq {
+    luab_udata_t        ud_softc;
+    luab_aioq_req_t     *ud_req;
+    struct aiocb        **ud_list;
+    size_t              ud_card;
+    size_t              ud_npending;
+    size_t              ud_ninflight;
+} luab_aioq_t;
+
+/*
+ * Subr.
+ */
+
+static void
+aioq_unref(lua_State *L, int narg, luab_aioq_t *self, size_t i)
+{
+    luab_aioq_req_t *ar;
+
+    ar = &(self->ud_req[i]);
+
+    if (ar->ar_buf != NULL)
+        luab_iovec_rele(L, ar->ar_buf, __func__);
+
+    if (narg != 0) {
+        lua_getuservalue(L, narg);
+        lua_pushnil(L);
+        lua_rawseti(L, -2, (int)(i + 1));
+        lua_pop(L, 1);
+    }
+    (void)memset(ar, 0, sizeof(*ar));
+}
+
+/*
+ * Cancels requests in flight and waits for their completion.
+ */
+static void
+aioq_drain(lua_State *L, luab_aioq_t *self)
+{
+    luab_aioq_req_t *ar;
+    const struct aiocb *cb;
+    size_t i;
+
+    if (self->ud_req == NULL)
+        return;
+
+    for (i = 0; i < self->ud_card; i++) {
+        ar = &(self->ud_req[i]);
+
+        if (ar->ar_state == AIOQ_INFLIGHT) {
+            cb = &(ar->ar_cb);
+
+            (void)aio_cancel(ar->ar_cb.aio_fildes, &(ar->ar_cb));
+
+            while (aio_error(cb) == EINPROGRESS)
+                (void)aio_suspend(&cb, 1, NULL);
+
+            (void)aio_return(&(ar->ar_cb));
+        }
+
+        if (ar->ar_state != AIOQ_FREE)
+            aioq_unref(L, 0, self, i);
+    }
+    self->ud_npending = 0;
+    self->ud_ninflight = 0;
+}
+
+static void
+aioq_free(luab_aioq_t *self)
+{
+    if (self->ud_req != NULL)
+        luab_core_free(self->ud_req, self->ud_card * sizeof(luab_aioq_req_t));
+
+    if (self->ud_list != NULL)
+        luab_core_free(self->ud_list, self->ud_card * sizeof(struct aiocb *));
+
+    self->ud_req = NULL;
+    self->ud_list = NULL;
+}
+
+/*
+ * Queues a request, returns its slot by index starting at 1.
+ */
+static int
+aioq_enqueue(lua_State *L, int opcode)
+{
+    luab_module_t *m0, *m1;
+    luab_aioq_t *self;
+    luab_iovec_t *buf;
+    luab_aioq_req_t *ar;
+    int fd;
+    off_t offset;
+    size_t i, nbytes, len;
+
+    (void)luab_core_checkmaxargs(L, 5);
+
+    m0 = luab_xmod(AIOQ, TYPE, __func__);
+    m1 = luab_xmod(IOVEC, TYPE, __func__);
+
+    self = luab_udata(L, 1, m0, luab_aioq_t *);
+    fd = luab_checkint(L, 2);
+    buf = luab_udata(L, 3, m1, luab_iovec_t *);
+    offset = luab_checkoff(L, 4);
+    nbytes = lua_isnoneornil(L, 5) ? 0 : luab_checksize(L, 5);
+
+    for (i = 0; i < self->ud_card; i++) {
+        if (self->ud_req[i].ar_state == AIOQ_FREE)
+            break;
+    }
+
+    if (i == self->ud_card) {
+        errno = EAGAIN;
+        return (luab_pushxinteger(L, luab_env_error));
+    }
+
+    if (((opcode == LIO_READ) ? luab_iovec_isrxbuf(buf) :
+        luab_iovec_istxbuf(buf)) == 0) {
+        errno = ERANGE;
+        return (luab_pushxinteger(L, luab_env_error));
+    }
+    len = (opcode == LIO_READ) ? buf->iov_max_len : buf->iov.iov_len;
+
+    if (nbytes == 0)
+        nbytes = len;
+    else if (nbytes > len) {
+        errno = ERANGE;
+        return (luab_pushxinteger(L, luab_env_error));
+    }
+
+    if (luab_iovec_hold(L, buf, __func__) != 0)
+        return (luab_pushxinteger(L, luab_env_error));
+
+    ar = &(self->ud_req[i]);
+    (void)memset(ar, 0, sizeof(*ar));
+
+    ar->ar_cb.aio_fildes = fd;
+    ar->ar_cb.aio_offset = offset;
+    ar->ar_cb.aio_buf = buf->iov.iov_base;
+    ar->ar_cb.aio_nbytes = nbytes;
+    ar->ar_cb.aio_lio_opcode = opcode;
+    ar->ar_cb.aio_sigevent.sigev_notify = SIGEV_NONE;
+    ar->ar_buf = buf;
+    ar->ar_state = AIOQ_PENDING;
+
+    lua_getuservalue(L, 1);
+    lua_pushvalue(L, 3);
+    lua_rawseti(L, -2, (int)(i + 1));
+    lua_pop(L, 1);
+
+    self->ud_npending++;
+
+    return (luab_pushxinteger(L, i + 1));
+}
+
+static void
+aioq_fillxtable(lua_State *L, int narg, void *arg)
+{
+    luab_aioq_t *self;
+
+    if ((self = (luab_aioq_t *)arg) != NULL) {
+
+        luab_setinteger(L, narg, "card",        self->ud_card);
+        luab_setinteger(L, narg, "npending",    self->ud_npending);
+        luab_setinteger(L, narg, "ninflight",   self->ud_ninflight);
+    } else
+        luab_core_err(EX_DATAERR, __func__, EINVAL);
+}
+
+/*
+ * Generator functions.
+ */
+
+/***
+ * Generator function - translate (LUA_TUSERDATA(AIOQ)) into (LUA_TTABLE).
+ *
+ * @function get_table
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              card        = (LUA_TNUMBER),
+ *              npending    = (LUA_TNUMBER),
+ *              ninflight   = (LUA_TNUMBER),
+ *          }
+ *
+ * @usage t [, err, msg ] = aioq:get_table()
+ */
+static int
+AIOQ_get_table(lua_State *L)
+{
+    luab_module_t *m;
+    luab_xtable_param_t xtp;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(AIOQ, TYPE, __func__);
+
+    xtp.xtp_fill = aioq_fillxtable;
+    xtp.xtp_arg = luab_todata(L, 1, m, void *);
+    xtp.xtp_new = 1;
+    xtp.xtp_k = NULL;
+
+    return (luab_table_pushxtable(L, -2, &xtp));
+}
+
+/***
+ * Generator function - returns (LUA_TNIL).
+ *
+ * @function dump
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage iovec [, err, msg ] = aioq:dump()
+ */
+static int
+AIOQ_dump(lua_State *L)
+{
+    return (luab_core_dump(L, 1, NULL, 0));
+}
+
+/*
+ * Access functions, immutable properties.
+ */
+
+/***
+ * Get maximum number of requests.
+ *
+ * @function card
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage card [, err, msg ] = aioq:card()
+ */
+static int
+AIOQ_card(lua_State *L)
+{
+    luab_module_t *m;
+    luab_aioq_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(AIOQ, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_aioq_t *);
+
+    return (luab_pushxinteger(L, self->ud_card));
+}
+
+/*
+ * Access functions.
+ */
+
+/***
+ * Get number of requests not yet submitted.
+ *
+ * @function get_pending
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage n [, err, msg ] = aioq:get_pending()
+ */
+static int
+AIOQ_get_pending(lua_State *L)
+{
+    luab_module_t *m;
+    luab_aioq_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(AIOQ, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_aioq_t *);
+
+    return (luab_pushxinteger(L, self->ud_npending));
+}
+
+/***
+ * Get number of requests in flight.
+ *
+ * @function get_inflight
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage n [, err, msg ] = aioq:get_inflight()
+ */
+static int
+AIOQ_get_inflight(lua_State *L)
+{
+    luab_module_t *m;
+    luab_aioq_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(AIOQ, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_aioq_t *);
+
+    return (luab_pushxinteger(L, self->ud_ninflight));
+}
+
+/***
+ * Queue a read request.
+ *
+ * @function read
+ *
+ * @param fd                Open file descriptor.
+ * @param buf               Instance of (LUA_TUSERDATA(IOVEC)), held until
+ *                          the request is reaped.
+ * @param offset            Offset.
+ * @param nbytes            Amount of bytes, optional, capacity by default.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          Identifier of the request, EAGAIN if no slot is free.
+ *
+ * @usage id [, err, msg ] = aioq:read(fd, buf, offset [, nbytes ])
+ */
+static int
+AIOQ_read(lua_State *L)
+{
+    return (aioq_enqueue(L, LIO_READ));
+}
+
+/***
+ * Queue a write request.
+ *
+ * @function write
+ *
+ * @param fd                Open file descriptor.
+ * @param buf               Instance of (LUA_TUSERDATA(IOVEC)), held until
+ *                          the request is reaped.
+ * @param offset            Offset.
+ * @param nbytes            Amount of bytes, optional, length by default.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          Identifier of the request, EAGAIN if no slot is free.
+ *
+ * @usage id [, err, msg ] = aioq:write(fd, buf, offset [, nbytes ])
+ */
+static int
+AIOQ_write(lua_State *L)
+{
+    return (aioq_enqueue(L, LIO_WRITE));
+}
+
+/***
+ * Submit pending requests by lio_listio(2), in batches bound by
+ * AIO_LISTIO_MAX.
+ *
+ * @function submit
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          Number of requests accepted by the kernel, those are reported
+ *          by reap. If lio_listio(2) fails, each request is checked by
+ *          aio_error(2), those not queued, e. g. by EAGAIN or EINVAL, stay
+ *          pending and are submitted again by a later call. The error is
+ *          returned, if no request was accepted.
+ *
+ * @usage n [, err, msg ] = aioq:submit()
+ */
+static int
+AIOQ_submit(lua_State *L)
+{
+    luab_module_t *m;
+    luab_aioq_t *self;
+    luab_aioq_req_t *ar;
+    size_t i, k, n, max, nqueued;
+    ssize_t count;
+    int error, up_call;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(AIOQ, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_aioq_t *);
+
+    max = (luab_env_aio_listio_max > 0) ?
+        luab_env_aio_listio_max : self->ud_card;
+
+    for (count = 0, i = 0; i < self->ud_card; ) {
+
+        for (n = 0; i < self->ud_card && n < max; i++) {
+            ar = &(self->ud_req[i]);
+
+            if (ar->ar_state == AIOQ_PENDING)
+                self->ud_list[n++] = &(ar->ar_cb);
+        }
+
+        if (n == 0)
+            break;
+
+        if (lio_listio(LIO_NOWAIT, self->ud_list, (int)n, NULL) != 0)
+            up_call = errno;
+        else
+            up_call = 0;
+
+        for (nqueued = 0, k = 0; k < n; k++) {
+            ar = (luab_aioq_req_t *)self->ud_list[k];   /* ar_cb leads */
+
+            if (up_call != 0) {
+                error = aio_error(&(ar->ar_cb));
+
+                /* not queued, thus still pending */
+                if (error == -1 || error == EINVAL || error == EAGAIN)
+                    continue;
+            }
+            ar->ar_state = AIOQ_INFLIGHT;
+            nqueued++;
+        }
+        self->ud_npending -= nqueued;
+        self->ud_ninflight += nqueued;
+        count += nqueued;
+
+        if (up_call != 0) {
+
+            if (count == 0) {
+                errno = up_call;
+                count = luab_env_error;
+            }
+            break;
+        }
+    }
+    return (luab_pushxinteger(L, count));
+}
+
+/***
+ * Reap completed requests in bulk.
+ *
+ * @function reap
+ *
+ * @param timeout           Instance of (LUA_TUSERDATA(TIMESPEC)) or
+ *                          (LUA_TNIL) for blocking infinitely.
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              {
+ *                  id      = (LUA_TNUMBER),
+ *                  ret     = (LUA_TNUMBER),
+ *                  errno   = (LUA_TNUMBER),
+ *              },
+ *              ...
+ *          }
+ *
+ *          whereby ret denotes the amount of transferred bytes or -1.
+ *          The length of each received buffer is updated. The table is
+ *          empty, if none completed before timeout expired.
+ *
+ * @usage t [, err, msg ] = aioq:reap([ timeout ])
+ */
+static int
+AIOQ_reap(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    luab_aioq_t *self;
+    luab_aioq_req_t *ar;
+    struct timespec *timeout;
+    ssize_t ret;
+    size_t i, n;
+    int error, k;
+
+    m0 = luab_xmod(AIOQ, TYPE, __func__);
+    m1 = luab_xmod(TIMESPEC, TYPE, __func__);
+
+    if (luab_core_checkmaxargs(L, 2) > 1)
+        timeout = luab_udataisnil(L, 2, m1, struct timespec *);
+    else
+        timeout = NULL;
+
+    self = luab_udata(L, 1, m0, luab_aioq_t *);
+
+    for (n = 0, i = 0; i < self->ud_card; i++) {
+        ar = &(self->ud_req[i]);
+
+        if (ar->ar_state == AIOQ_INFLIGHT)
+            self->ud_list[n++] = &(ar->ar_cb);
+    }
+
+    if (n > 0 && aio_suspend((const struct aiocb * const *)self->ud_list,
+        (int)n, timeout) != 0) {
+
+        if (errno != EAGAIN)
+            return (luab_pushnil(L));
+    }
+    lua_newtable(L);
+
+    for (k = 0, i = 0; i < self->ud_card; i++) {
+        ar = &(self->ud_req[i]);
+
+        if (ar->ar_state != AIOQ_INFLIGHT)
+            continue;
+
+        if ((error = aio_error(&(ar->ar_cb))) == EINPROGRESS)
+            continue;
+
+        ret = aio_return(&(ar->ar_cb));
+
+        if (error == -1)
+            error = errno;
+
+        if (ar->ar_cb.aio_lio_opcode == LIO_READ && ret >= 0) {
+            luab_thread_mtx_lock(L, __func__);
+            ar->ar_buf->iov.iov_len = (size_t)ret;
+            luab_thread_mtx_unlock(L, __func__);
+        }
+        lua_createtable(L, 0, 3);
+
+        luab_setinteger(L, -2, "id",        i + 1);
+        luab_setinteger(L, -2, "ret",       ret);
+        luab_setinteger(L, -2, "errno",     error);
+
+        lua_rawseti(L, -2, ++k);
+
+        aioq_unref(L, 1, self, i);
+        self->ud_ninflight--;
+    }
+    return (1);
+}
+
+/***
+ * Cancel requests in flight by aio_cancel(2).
+ *
+ * @function cancel
+ *
+ * @param id                Identifier of request, optional, all by default.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          Number of requests not yet completed, those are still reaped.
+ *
+ * @usage n [, err, msg ] = aioq:cancel([ id ])
+ */
+static int
+AIOQ_cancel(lua_State *L)
+{
+    luab_module_t *m;
+    luab_aioq_t *self;
+    luab_aioq_req_t *ar;
+    size_t i, lo, hi;
+    ssize_t count;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(AIOQ, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_aioq_t *);
+
+    if (lua_isnoneornil(L, 2)) {
+        lo = 0;
+        hi = self->ud_card;
+    } else {
+        lo = luab_checksize(L, 2);
+
+        if (lo < 1 || lo > self->ud_card) {
+            errno = ERANGE;
+            return (luab_pushxinteger(L, luab_env_error));
+        }
+        hi = lo--;
+    }
+
+    for (count = 0, i = lo; i < hi; i++) {
+        ar = &(self->ud_req[i]);
+
+        if (ar->ar_state != AIOQ_INFLIGHT)
+            continue;
+
+        switch (aio_cancel(ar->ar_cb.aio_fildes, &(ar->ar_cb))) {
+        case AIO_NOTCANCELED:
+            count++;
+            break;
+        case -1:
+            return (luab_pushxinteger(L, luab_env_error));
+        default:
+            break;
+        }
+    }
+    return (luab_pushxinteger(L, count));
+}
+
+/*
+ * Metamethods.
+ */
+
+static int
+AIOQ_gc(lua_State *L)
+{
+    luab_module_t *m;
+    luab_aioq_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(AIOQ, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_aioq_t *);
+
+    aioq_drain(L, self);
+    aioq_free(self);
+
+    return (luab_core_gc(L, 1, m));
+}
+
+static int
+AIOQ_len(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(AIOQ, TYPE, __func__);
+    return (luab_core_len(L, 2, m));
+}
+
+static int
+AIOQ_tostring(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(AIOQ, TYPE, __func__);
+    return (luab_core_tostring(L, 1, m));
+}
+
+/*
+ * Internal interface.
+ */
+
+static luab_module_table_t aioq_methods[] = {
+    LUAB_FUNC("card",           AIOQ_card),
+    LUAB_FUNC("get_pending",    AIOQ_get_pending),
+    LUAB_FUNC("get_inflight",   AIOQ_get_inflight),
+    LUAB_FUNC("read",           AIOQ_read),
+    LUAB_FUNC("write",          AIOQ_write),
+    LUAB_FUNC("submit",         AIOQ_submit),
+    LUAB_FUNC("reap",           AIOQ_reap),
+    LUAB_FUNC("cancel",         AIOQ_cancel),
+    LUAB_FUNC("get_table",      AIOQ_get_table),
+    LUAB_FUNC("dump",           AIOQ_dump),
+    LUAB_FUNC("__gc",           AIOQ_gc),
+    LUAB_FUNC("__len",          AIOQ_len),
+    LUAB_FUNC("__tostring",     AIOQ_tostring),
+    LUAB_MOD_TBL_SENTINEL
+};
+
+static void *
+aioq_create(lua_State *L, void *arg)
+{
+    luab_module_t *m;
+    luab_aioq_t aq, *self;
+    size_t card;
+
+    m = luab_xmod(AIOQ, TYPE, __func__);
+
+    if ((arg == NULL) ||
+        ((card = *(size_t *)arg) < 1) ||
+        (card > luab_env_int_max)) {
+        errno = EINVAL;
+        return (NULL);
+    }
+    (void)memset(&aq, 0, sizeof(aq));
+
+    aq.ud_card = card;
+
+    if (((aq.ud_req = luab_core_alloc(card,
+        sizeof(luab_aioq_req_t))) == NULL) ||
+        ((aq.ud_list = luab_core_alloc(card,
+        sizeof(struct aiocb *))) == NULL))
+        goto bad;
+
+    if ((self = luab_newuserdata(L, m, &aq)) != NULL) {
+        lua_createtable(L, (int)card, 0);
+        lua_setuservalue(L, -2);
+        return (self);
+    }
+bad:
+    aioq_free(&aq);
+    return (NULL);
+}
+
+static void
+aioq_init(void *ud, void *arg)
+{
+    luab_aioq_t *self, *aq;
+
+    if (((self = (luab_aioq_t *)ud) != NULL) &&
+        ((aq = (luab_aioq_t *)arg) != NULL)) {
+        self->ud_req = aq->ud_req;
+        self->ud_list = aq->ud_list;
+        self->ud_card = aq->ud_card;
+    }
+}
+
+static void *
+aioq_udata(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    m = luab_xmod(AIOQ, TYPE, __func__);
+    return (luab_todata(L, narg, m, luab_aioq_t *));
+}
+
+luab_module_t luab_aioq_type = {
+    .m_id           = LUAB_AIOQ_TYPE_ID,
+    .m_name         = LUAB_AIOQ_TYPE,
+    .m_vec          = aioq_methods,
+    .m_create       = aioq_create,
+    .m_init         = aioq_init,
+    .m_get          = aioq_udata,
+    .m_len          = sizeof(luab_aioq_t),
+    .m_sz           = sizeof(size_t),
+};
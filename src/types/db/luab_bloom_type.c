@@ -0,0 +1,899 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+
+#include <db.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+#include "luab_table.h"
+
+#if __BSD_VISIBLE
+extern luab_module_t luab_bloom_type;
+
+/*
+ * Interface against
+ *
+ *  typedef struct luab_bloom {
+ *      luab_udata_t    ud_softc;
+ *      u_char          *ud_vec;
+ *      size_t          ud_nbits;
+ *      u_int           ud_nhash;
+ *      size_t          ud_nadd;
+ *      u_long          ud_lookups;
+ *      u_long          ud_negatives;
+ *  } luab_bloom_t;
+ *
+ * whereby ud_vec holds a Bloom filter over the keys of a DB, which is
+ * referenced by the uservalue of the filter. Keys are mapped onto
+ * ud_nhash bits by double hashing over a single 64 bit hash.
+ *
+ * The filter is either built by traversal of the DB or loaded from a
+ * file, written by bloom:save(). Keys stored by bloom:put() are added,
+ * but any key stored on the DB itself, which bypasses its filter, is
+ * not seen and may be reported as absent. Removed keys are retained,
+ * which yields false positives only. Since records of DB_RECNO are
+ * renumbered, that access method is not supported.
+ */
+
+#define LUAB_BLOOM_MAGIC        0x4c42464cU
+#define LUAB_BLOOM_VERSION      1
+#define LUAB_BLOOM_MAXHASH      16
+#define LUAB_BLOOM_MINBITS      64
+
+typedef struct bloom_hdr {
+    uint32_t        bh_magic;
+    uint16_t        bh_version;
+    uint16_t        bh_nhash;
+    uint64_t        bh_nbits;
+    uint64_t        bh_nadd;
+} bloom_hdr_t;
+
+typedef struct luab_bloom {
+    luab_udata_t    ud_softc;
+    u_char          *ud_vec;
+    size_t          ud_nbits;
+    u_int           ud_nhash;
+    size_t          ud_nadd;
+    u_long          ud_lookups;
+    u_long          ud_negatives;
+} luab_bloom_t;
+
+#define bloom_veclen(nbits) \
+    (howmany((nbits), NBBY))
+
+/*
+ * Subr.
+ */
+
+static void
+bloom_hash(const void *v, size_t len, uint64_t *h1, uint64_t *h2)
+{
+    const u_char *bp;
+    uint64_t hv;
+    size_t i;
+
+    for (bp = v, hv = 14695981039346656037ULL, i = 0; i < len; i++) {
+        hv ^= bp[i];
+        hv *= 1099511628211ULL;
+    }
+    *h1 = hv;
+
+    hv ^= hv >> 33;
+    hv *= 0xff51afd7ed558ccdULL;
+    hv ^= hv >> 33;
+    hv *= 0xc4ceb9fe1a85ec53ULL;
+    hv ^= hv >> 33;
+
+    *h2 = hv | 1;
+}
+
+static void
+bloom_add(luab_bloom_t *self, const DBT *k)
+{
+    uint64_t h1, h2, bit;
+    u_int i;
+
+    bloom_hash(k->data, k->size, &h1, &h2);
+
+    for (i = 0; i < self->ud_nhash; i++) {
+        bit = (h1 + i * h2) % self->ud_nbits;
+        setbit(self->ud_vec, bit);
+    }
+    self->ud_nadd++;
+}
+
+static int
+bloom_test(luab_bloom_t *self, const DBT *k)
+{
+    uint64_t h1, h2, bit;
+    u_int i;
+
+    bloom_hash(k->data, k->size, &h1, &h2);
+
+    self->ud_lookups++;
+
+    for (i = 0; i < self->ud_nhash; i++) {
+        bit = (h1 + i * h2) % self->ud_nbits;
+
+        if (isclr(self->ud_vec, bit)) {
+            self->ud_negatives++;
+            return (0);
+        }
+    }
+    return (1);
+}
+
+/*
+ * Sizes the filter by bits per element, whereby ln(2) bits per element
+ * are spent for each hash function.
+ */
+static int
+bloom_alloc(luab_bloom_t *self, size_t nelem, u_int bits)
+{
+    size_t nbits;
+
+    if ((bits == 0) || (bits > LUAB_BLOOM_MAXBITS) ||
+        (nelem > (SIZE_MAX / NBBY / bits))) {
+        errno = ERANGE;
+        return (luab_env_error);
+    }
+
+    if ((nbits = nelem * bits) < LUAB_BLOOM_MINBITS)
+        nbits = LUAB_BLOOM_MINBITS;
+
+    if ((self->ud_vec = luab_core_alloc(bloom_veclen(nbits),
+        sizeof(u_char))) == NULL)
+        return (luab_env_error);
+
+    self->ud_nbits = nbits;
+    self->ud_nhash = MIN(MAX((bits * 693 + 500) / 1000, 1),
+        LUAB_BLOOM_MAXHASH);
+
+    return (luab_env_success);
+}
+
+static int
+bloom_build(luab_bloom_t *self, DB *db, size_t nelem, u_int bits)
+{
+    DBT k, v;
+    int status, up_call;
+
+    if (nelem == 0) {
+
+        for (status = (*db->seq)(db, &k, &v, R_FIRST); status == 0;
+            status = (*db->seq)(db, &k, &v, R_NEXT))
+            nelem++;
+
+        if (status < 0)
+            return (luab_env_error);
+    }
+
+    if (bloom_alloc(self, nelem, bits) != 0)
+        return (luab_env_error);
+
+    for (status = (*db->seq)(db, &k, &v, R_FIRST); status == 0;
+        status = (*db->seq)(db, &k, &v, R_NEXT))
+        bloom_add(self, &k);
+
+    if (status < 0) {
+        up_call = errno;
+        luab_core_free(self->ud_vec, bloom_veclen(self->ud_nbits));
+        self->ud_vec = NULL;
+        errno = up_call;
+        return (luab_env_error);
+    }
+    return (luab_env_success);
+}
+
+static int
+bloom_read(int fd, void *v, size_t len)
+{
+    ssize_t n;
+
+    for (; len > 0; v = (caddr_t)v + n, len -= (size_t)n) {
+
+        if ((n = read(fd, v, len)) <= 0) {
+
+            if (n == 0)
+                errno = EFTYPE;
+
+            return (luab_env_error);
+        }
+    }
+    return (luab_env_success);
+}
+
+static int
+bloom_load(luab_bloom_t *self, const char *path)
+{
+    bloom_hdr_t hdr;
+    struct stat sb;
+    size_t len;
+    int fd, up_call;
+
+    if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+        return (luab_env_error);
+
+    if ((fstat(fd, &sb) != 0) ||
+        (bloom_read(fd, &hdr, sizeof(hdr)) != 0))
+        goto bad;
+
+    if ((hdr.bh_magic != LUAB_BLOOM_MAGIC) ||
+        (hdr.bh_version != LUAB_BLOOM_VERSION) ||
+        (hdr.bh_nhash == 0) ||
+        (hdr.bh_nhash > LUAB_BLOOM_MAXHASH) ||
+        (hdr.bh_nbits == 0) ||
+        (hdr.bh_nbits > ((uint64_t)SIZE_MAX - NBBY)) ||
+        ((uintmax_t)sb.st_size !=
+            sizeof(hdr) + (uintmax_t)bloom_veclen(hdr.bh_nbits))) {
+        errno = EFTYPE;
+        goto bad;
+    }
+    len = bloom_veclen((size_t)hdr.bh_nbits);
+
+    if ((self->ud_vec = luab_core_alloc(len, sizeof(u_char))) == NULL)
+        goto bad;
+
+    if (bloom_read(fd, self->ud_vec, len) != 0) {
+        up_call = errno;
+        luab_core_free(self->ud_vec, len);
+        self->ud_vec = NULL;
+        errno = up_call;
+        goto bad;
+    }
+    (void)close(fd);
+
+    self->ud_nbits = (size_t)hdr.bh_nbits;
+    self->ud_nhash = hdr.bh_nhash;
+    self->ud_nadd = (size_t)hdr.bh_nadd;
+
+    return (luab_env_success);
+bad:
+    up_call = errno;
+    (void)close(fd);
+    errno = up_call;
+    return (luab_env_error);
+}
+
+static int
+bloom_write(int fd, const void *v, size_t len)
+{
+    ssize_t n;
+
+    for (; len > 0; v = (const char *)v + n, len -= (size_t)n) {
+
+        if ((n = write(fd, v, len)) < 0)
+            return (luab_env_error);
+    }
+    return (luab_env_success);
+}
+
+static DB *
+bloom_db(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    DB *db;
+
+    m = luab_xmod(DB, TYPE, __func__);
+
+    lua_getuservalue(L, narg);
+    lua_rawgeti(L, -1, 1);
+
+    db = luab_udata(L, -1, m, DB *);
+
+    lua_pop(L, 2);
+
+    return (db);
+}
+
+static void
+bloom_checkkey(lua_State *L, int narg, DBT *k)
+{
+    size_t len;
+
+    k->data = (void *)(uintptr_t)luab_checklstring(L, narg,
+        luab_env_buf_max, &len);
+    k->size = len;
+}
+
+static void
+bloom_fillxtable(lua_State *L, int narg, void *arg)
+{
+    luab_bloom_t *self;
+
+    if ((self = (luab_bloom_t *)arg) != NULL) {
+
+        luab_setinteger(L, narg, "nbits",       self->ud_nbits);
+        luab_setinteger(L, narg, "nhash",       self->ud_nhash);
+        luab_setinteger(L, narg, "nadd",        self->ud_nadd);
+        luab_setinteger(L, narg, "lookups",     self->ud_lookups);
+        luab_setinteger(L, narg, "negatives",   self->ud_negatives);
+    } else
+        luab_core_err(EX_DATAERR, __func__, EINVAL);
+}
+
+/*
+ * Generator functions.
+ */
+
+/***
+ * Generator function - translate (LUA_TUSERDATA(BLOOM)) into (LUA_TTABLE).
+ *
+ * @function get_table
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              nbits       = (LUA_TNUMBER),
+ *              nhash       = (LUA_TNUMBER),
+ *              nadd        = (LUA_TNUMBER),
+ *              lookups     = (LUA_TNUMBER),
+ *              negatives   = (LUA_TNUMBER),
+ *          }
+ *
+ * @usage t [, err, msg ] = bloom:get_table()
+ */
+static int
+BLOOM_get_table(lua_State *L)
+{
+    luab_module_t *m;
+    luab_xtable_param_t xtp;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(BLOOM, TYPE, __func__);
+
+    xtp.xtp_fill = bloom_fillxtable;
+    xtp.xtp_arg = luab_todata(L, 1, m, void *);
+    xtp.xtp_new = 1;
+    xtp.xtp_k = NULL;
+
+    return (luab_table_pushxtable(L, -2, &xtp));
+}
+
+/***
+ * Generator function - returns (LUA_TNIL).
+ *
+ * @function dump
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage iovec [, err, msg ] = bloom:dump()
+ */
+static int
+BLOOM_dump(lua_State *L)
+{
+    return (luab_core_dump(L, 1, NULL, 0));
+}
+
+/*
+ * Access functions.
+ */
+
+/***
+ * Get counters.
+ *
+ * @function get_stats
+ *
+ * @return (LUA_TNUMBER, LUA_TNUMBER)
+ *
+ *          Number of lookups and number of lookups, which were answered
+ *          without accessing the db(3).
+ *
+ * @usage lookups, negatives = bloom:get_stats()
+ */
+static int
+BLOOM_get_stats(lua_State *L)
+{
+    luab_module_t *m;
+    luab_bloom_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(BLOOM, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_bloom_t *);
+
+    lua_pushinteger(L, (lua_Integer)self->ud_lookups);
+    lua_pushinteger(L, (lua_Integer)self->ud_negatives);
+
+    return (2);
+}
+
+/*
+ * Service primitives.
+ */
+
+/***
+ * Add key to the filter.
+ *
+ * @function add
+ *
+ * @param key               Key, (LUA_TSTRING).
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage ret [, err, msg ] = bloom:add(key)
+ */
+static int
+BLOOM_add(lua_State *L)
+{
+    luab_module_t *m;
+    luab_bloom_t *self;
+    DBT k;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(BLOOM, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_bloom_t *);
+
+    bloom_checkkey(L, 2, &k);
+    bloom_add(self, &k);
+
+    return (luab_pushxinteger(L, 0));
+}
+
+/***
+ * Membership test.
+ *
+ * @function test
+ *
+ * @param key               Key, (LUA_TSTRING).
+ *
+ * @return (LUA_TBOOLEAN)
+ *
+ *          False, if key is not stored in the db(3), true, if it may be.
+ *
+ * @usage bool = bloom:test(key)
+ */
+static int
+BLOOM_test(lua_State *L)
+{
+    luab_module_t *m;
+    luab_bloom_t *self;
+    DBT k;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(BLOOM, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_bloom_t *);
+
+    bloom_checkkey(L, 2, &k);
+
+    lua_pushboolean(L, bloom_test(self, &k));
+
+    return (1);
+}
+
+/***
+ * Batched membership test.
+ *
+ * @function test_many
+ *
+ * @param keys              Either an array of (LUA_TSTRING) or an instance
+ *                          of (LUA_TUSERDATA(IOVEC)) holding records,
+ *                          each prefixed by its length as uint32_t.
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          The table holds the result of bloom:test() for each key.
+ *
+ * @usage t [, err, msg ] = bloom:test_many(keys)
+ */
+static int
+BLOOM_test_many(lua_State *L)
+{
+    luab_module_t *m;
+    luab_bloom_t *self;
+    DBT *k;
+    size_t nk, i;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(BLOOM, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_bloom_t *);
+
+    if ((k = luab_db_checkbatch(L, 2, &nk)) == NULL)
+        luab_core_argerror(L, 2, NULL, 0, 0, errno);
+
+    lua_createtable(L, (int)nk, 0);
+
+    for (i = 0; i < nk; i++) {
+        lua_pushboolean(L, bloom_test(self, &k[i]));
+        lua_rawseti(L, -2, (int)(i + 1));
+    }
+    return (1);
+}
+
+/***
+ * Write the filter into a file, which replaces path on completion. Its
+ * mode is set as by open(2), thus restricted by umask(2).
+ *
+ * @function save
+ *
+ * @param path              Path of file.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage ret [, err, msg ] = bloom:save(path)
+ */
+static int
+BLOOM_save(lua_State *L)
+{
+    luab_module_t *m;
+    luab_bloom_t *self;
+    bloom_hdr_t hdr;
+    const char *path;
+    char tmp[MAXPATHLEN];
+    mode_t mask;
+    int fd, up_call;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(BLOOM, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_bloom_t *);
+    path = luab_checklstring(L, 2, luab_env_path_max, NULL);
+
+    if (snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path) >=
+        (int)sizeof(tmp)) {
+        errno = ENAMETOOLONG;
+        return (luab_pushxinteger(L, luab_env_error));
+    }
+
+    if ((fd = mkstemp(tmp)) < 0)
+        return (luab_pushxinteger(L, luab_env_error));
+
+    mask = umask(0);
+    (void)umask(mask);
+
+    (void)memset(&hdr, 0, sizeof(hdr));
+
+    hdr.bh_magic = LUAB_BLOOM_MAGIC;
+    hdr.bh_version = LUAB_BLOOM_VERSION;
+    hdr.bh_nhash = (uint16_t)self->ud_nhash;
+    hdr.bh_nbits = (uint64_t)self->ud_nbits;
+    hdr.bh_nadd = (uint64_t)self->ud_nadd;
+
+    if ((fchmod(fd, DEFFILEMODE & ~mask) != 0) ||
+        (bloom_write(fd, &hdr, sizeof(hdr)) != 0) ||
+        (bloom_write(fd, self->ud_vec, bloom_veclen(self->ud_nbits)) != 0) ||
+        (fsync(fd) != 0)) {
+        up_call = errno;
+        (void)close(fd);
+        goto bad;
+    }
+
+    if ((close(fd) != 0) || (rename(tmp, path) != 0)) {
+        up_call = errno;
+        goto bad;
+    }
+    return (luab_pushxinteger(L, luab_env_success));
+bad:
+    (void)unlink(tmp);
+    errno = up_call;
+    return (luab_pushxinteger(L, luab_env_error));
+}
+
+/*
+ * Database access methods.
+ */
+
+/***
+ * Keyed retrieval, the db(3) is accessed only, if the filter does not
+ * exclude the key.
+ *
+ * @function get
+ *
+ * @param key               Key, (LUA_TSTRING).
+ *
+ * @return (LUA_T{NIL,STRING} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          Data, or (LUA_TNIL), if key was not found.
+ *
+ * @usage data [, err, msg ] = bloom:get(key)
+ */
+static int
+BLOOM_get(lua_State *L)
+{
+    luab_module_t *m;
+    luab_bloom_t *self;
+    DB *db;
+    DBT k, v;
+    int status;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(BLOOM, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_bloom_t *);
+
+    bloom_checkkey(L, 2, &k);
+
+    if (bloom_test(self, &k) == 0) {
+        lua_pushnil(L);
+        return (1);
+    }
+
+    if ((db = bloom_db(L, 1)) == NULL)
+        return (luab_pushnil(L));
+
+    if ((status = (*db->get)(db, &k, &v, 0)) != 0) {
+
+        if (status > 0) {
+            lua_pushnil(L);
+            return (1);
+        }
+        return (luab_pushnil(L));
+    }
+    lua_pushlstring(L, v.data, v.size);
+
+    return (1);
+}
+
+/***
+ * Batched keyed retrieval, see bloom:get().
+ *
+ * @function get_many
+ *
+ * @param keys              Either an array of (LUA_TSTRING) or an instance
+ *                          of (LUA_TUSERDATA(IOVEC)) holding records,
+ *                          each prefixed by its length as uint32_t.
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          The table holds data or false for each key, as db:get_many().
+ *
+ * @usage t [, err, msg ] = bloom:get_many(keys)
+ */
+static int
+BLOOM_get_many(lua_State *L)
+{
+    luab_module_t *m;
+    luab_bloom_t *self;
+    DB *db;
+    DBT *k, v;
+    size_t nk, i;
+    int status, up_call;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(BLOOM, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_bloom_t *);
+
+    if ((db = bloom_db(L, 1)) == NULL)
+        return (luab_pushnil(L));
+
+    if ((k = luab_db_checkbatch(L, 2, &nk)) == NULL)
+        luab_core_argerror(L, 2, NULL, 0, 0, errno);
+
+    lua_createtable(L, (int)nk, 0);
+
+    for (i = 0, up_call = 0; i < nk; i++) {
+
+        if (bloom_test(self, &k[i]) == 0)
+            lua_pushboolean(L, 0);
+        else if ((status = (*db->get)(db, &k[i], &v, 0)) == 0)
+            lua_pushlstring(L, v.data, v.size);
+        else if (status > 0)
+            lua_pushboolean(L, 0);
+        else {
+            up_call = errno;
+            break;
+        }
+        lua_rawseti(L, -2, (int)(i + 1));
+    }
+    return (luab_pusherr(L, up_call, 1));
+}
+
+/***
+ * Store key/data pair in the db(3), then add key to the filter.
+ *
+ * @function put
+ *
+ * @param key               Key, (LUA_TSTRING).
+ * @param data              Data, (LUA_TSTRING).
+ * @param flags             May be set from
+ *
+ *                              bsd.db.R_{CURSOR,NOOVERWRITE}
+ *
+ *                          as possible value, optional.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage ret [, err, msg ] = bloom:put(key, data [, flags ])
+ */
+static int
+BLOOM_put(lua_State *L)
+{
+    luab_module_t *m;
+    luab_bloom_t *self;
+    DB *db;
+    DBT k, v;
+    u_int flags;
+    int status;
+
+    (void)luab_core_checkmaxargs(L, 4);
+
+    m = luab_xmod(BLOOM, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_bloom_t *);
+
+    bloom_checkkey(L, 2, &k);
+    bloom_checkkey(L, 3, &v);
+    flags = lua_isnoneornil(L, 4) ? 0 : luab_checkuint(L, 4);
+
+    if ((db = bloom_db(L, 1)) != NULL) {
+
+        /* R_NOOVERWRITE yields 1, if key exists */
+        if ((status = (*db->put)(db, &k, &v, flags)) >= 0)
+            bloom_add(self, &k);
+    } else
+        status = luab_env_error;
+
+    return (luab_pushxinteger(L, status));
+}
+
+/*
+ * Metamethods.
+ */
+
+static int
+BLOOM_gc(lua_State *L)
+{
+    luab_module_t *m;
+    luab_bloom_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(BLOOM, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_bloom_t *);
+
+    if (self->ud_vec != NULL) {
+        luab_core_free(self->ud_vec, bloom_veclen(self->ud_nbits));
+        self->ud_vec = NULL;
+    }
+    return (luab_core_gc(L, 1, m));
+}
+
+static int
+BLOOM_len(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(BLOOM, TYPE, __func__);
+    return (luab_core_len(L, 2, m));
+}
+
+static int
+BLOOM_tostring(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(BLOOM, TYPE, __func__);
+    return (luab_core_tostring(L, 1, m));
+}
+
+/*
+ * Internal interface.
+ */
+
+static luab_module_table_t bloom_methods[] = {
+    LUAB_FUNC("add",            BLOOM_add),
+    LUAB_FUNC("test",           BLOOM_test),
+    LUAB_FUNC("test_many",      BLOOM_test_many),
+    LUAB_FUNC("get",            BLOOM_get),
+    LUAB_FUNC("get_many",       BLOOM_get_many),
+    LUAB_FUNC("put",            BLOOM_put),
+    LUAB_FUNC("save",           BLOOM_save),
+    LUAB_FUNC("get_stats",      BLOOM_get_stats),
+    LUAB_FUNC("get_table",      BLOOM_get_table),
+    LUAB_FUNC("dump",           BLOOM_dump),
+    LUAB_FUNC("__gc",           BLOOM_gc),
+    LUAB_FUNC("__len",          BLOOM_len),
+    LUAB_FUNC("__tostring",     BLOOM_tostring),
+    LUAB_MOD_TBL_SENTINEL
+};
+
+static void *
+bloom_create(lua_State *L, void *arg)
+{
+    luab_module_t *m;
+    luab_bloom_param_t *blp;
+    luab_bloom_t bf, *self;
+    int status;
+
+    m = luab_xmod(BLOOM, TYPE, __func__);
+
+    if (((blp = (luab_bloom_param_t *)arg) == NULL) ||
+        (blp->blp_db == NULL) ||
+        (blp->blp_db->type == DB_RECNO)) {
+        errno = EINVAL;
+        return (NULL);
+    }
+    (void)memset(&bf, 0, sizeof(bf));
+
+    if (blp->blp_path != NULL)
+        status = bloom_load(&bf, blp->blp_path);
+    else
+        status = bloom_build(&bf, blp->blp_db, blp->blp_nelem,
+            blp->blp_bits);
+
+    if (status != 0)
+        return (NULL);
+
+    if ((self = luab_newuserdata(L, m, &bf)) != NULL) {
+        lua_createtable(L, 1, 0);
+        lua_pushvalue(L, blp->blp_narg);
+        lua_rawseti(L, -2, 1);
+        lua_setuservalue(L, -2);
+    } else
+        luab_core_free(bf.ud_vec, bloom_veclen(bf.ud_nbits));
+
+    return (self);
+}
+
+static void
+bloom_init(void *ud, void *arg)
+{
+    luab_bloom_t *self, *bf;
+
+    if (((self = (luab_bloom_t *)ud) != NULL) &&
+        ((bf = (luab_bloom_t *)arg) != NULL)) {
+        self->ud_vec = bf->ud_vec;
+        self->ud_nbits = bf->ud_nbits;
+        self->ud_nhash = bf->ud_nhash;
+        self->ud_nadd = bf->ud_nadd;
+    }
+}
+
+static void *
+bloom_udata(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    m = luab_xmod(BLOOM, TYPE, __func__);
+    return (luab_todata(L, narg, m, luab_bloom_t *));
+}
+
+luab_module_t luab_bloom_type = {
+    .m_id           = LUAB_BLOOM_TYPE_ID,
+    .m_name         = LUAB_BLOOM_TYPE,
+    .m_vec          = bloom_methods,
+    .m_create       = bloom_create,
+    .m_init         = bloom_init,
+    .m_get          = bloom_udata,
+    .m_len          = sizeof(luab_bloom_t),
+    .m_sz           = sizeof(luab_bloom_param_t),
+};
+#endif /* __BSD_VISIBLE */
@@ -0,0 +1,649 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <db.h>
+#include <string.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+#include "luab_table.h"
+
+#if __BSD_VISIBLE
+extern luab_module_t luab_btreeinfo_type;
+
+/*
+ * Interface against
+ *
+ *  typedef struct {
+ *      u_long  flags;
+ *      u_int   cachesize;
+ *      int     maxkeypage;
+ *      int     minkeypage;
+ *      u_int   psize;
+ *      int     (*compare)(const DBT *key1, const DBT *key2);
+ *      size_t  (*prefix)(const DBT *key1, const DBT *key2);
+ *      int     lorder;
+ *  } BTREEINFO;
+ */
+
+typedef struct luab_btreeinfo {
+    luab_udata_t    ud_softc;
+    BTREEINFO       ud_info;
+} luab_btreeinfo_t;
+
+/*
+ * The callouts compare and prefix are not mapped, because they are not
+ * called with any context, where a lua_State might be retrieved from. Both
+ * are NULL, thus the defaults of btree(3) are used.
+ */
+
+/*
+ * Subr.
+ */
+
+static void
+btreeinfo_fillxtable(lua_State *L, int narg, void *arg)
+{
+    BTREEINFO *info;
+
+    if ((info = (BTREEINFO *)arg) != NULL) {
+
+        luab_setinteger(L, narg, "flags",       info->flags);
+        luab_setinteger(L, narg, "cachesize",   info->cachesize);
+        luab_setinteger(L, narg, "maxkeypage",  info->maxkeypage);
+        luab_setinteger(L, narg, "minkeypage",  info->minkeypage);
+        luab_setinteger(L, narg, "psize",       info->psize);
+        luab_setinteger(L, narg, "lorder",      info->lorder);
+    } else
+        luab_core_err(EX_DATAERR, __func__, EINVAL);
+}
+
+/*
+ * Generator functions.
+ */
+
+/***
+ * Generator function - translate (LUA_TUSERDATA(BTREEINFO)) into (LUA_TTABLE).
+ *
+ * @function get_table
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              flags         = (LUA_TNUMBER),
+ *              cachesize     = (LUA_TNUMBER),
+ *              maxkeypage    = (LUA_TNUMBER),
+ *              minkeypage    = (LUA_TNUMBER),
+ *              psize         = (LUA_TNUMBER),
+ *              lorder        = (LUA_TNUMBER),
+ *          }
+ *
+ * @usage t [, err, msg ] = btreeinfo:get_table()
+ */
+static int
+BTREEINFO_get_table(lua_State *L)
+{
+    luab_module_t *m;
+    luab_xtable_param_t xtp;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(BTREEINFO, TYPE, __func__);
+
+    xtp.xtp_fill = btreeinfo_fillxtable;
+    xtp.xtp_arg = luab_xdata(L, 1, m);
+    xtp.xtp_new = 1;
+    xtp.xtp_k = NULL;
+
+    return (luab_table_pushxtable(L, -2, &xtp));
+}
+
+/***
+ * Generator function - translate btreeinfo{} into (LUA_TUSERDATA(IOVEC)).
+ *
+ * @function dump
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage iovec [, err, msg ] = btreeinfo:dump()
+ */
+static int
+BTREEINFO_dump(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(BTREEINFO, TYPE, __func__);
+    return (luab_core_dump(L, 1, m, m->m_sz));
+}
+
+/*
+ * Access functions.
+ */
+
+/***
+ * Set flags, e. g. bsd.db.R_DUP.
+ *
+ * @function set_flags
+ *
+ * @param arg               Specifies flags.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = btreeinfo:set_flags(arg)
+ */
+static int
+BTREEINFO_set_flags(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    BTREEINFO *info;
+    u_long x;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(BTREEINFO, TYPE, __func__);
+    m1 = luab_xmod(ULONG, TYPE, __func__);
+
+    info = luab_udata(L, 1, m0, BTREEINFO *);
+    x = (u_long)luab_checkxinteger(L, 2, m1, luab_env_ulong_max);
+
+    info->flags = x;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Get flags, e. g. bsd.db.R_DUP.
+ *
+ * @function get_flags
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = btreeinfo:get_flags()
+ */
+static int
+BTREEINFO_get_flags(lua_State *L)
+{
+    luab_module_t *m;
+    BTREEINFO *info;
+    u_long x;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(BTREEINFO, TYPE, __func__);
+    info = luab_udata(L, 1, m, BTREEINFO *);
+    x = info->flags;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Set maximum size of memory cache in bytes.
+ *
+ * @function set_cachesize
+ *
+ * @param arg               Specifies cachesize.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = btreeinfo:set_cachesize(arg)
+ */
+static int
+BTREEINFO_set_cachesize(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    BTREEINFO *info;
+    u_int x;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(BTREEINFO, TYPE, __func__);
+    m1 = luab_xmod(UINT, TYPE, __func__);
+
+    info = luab_udata(L, 1, m0, BTREEINFO *);
+    x = (u_int)luab_checkxinteger(L, 2, m1, luab_env_uint_max);
+
+    info->cachesize = x;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Get maximum size of memory cache in bytes.
+ *
+ * @function get_cachesize
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = btreeinfo:get_cachesize()
+ */
+static int
+BTREEINFO_get_cachesize(lua_State *L)
+{
+    luab_module_t *m;
+    BTREEINFO *info;
+    u_int x;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(BTREEINFO, TYPE, __func__);
+    info = luab_udata(L, 1, m, BTREEINFO *);
+    x = info->cachesize;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Set maximum number of keys per page.
+ *
+ * @function set_maxkeypage
+ *
+ * @param arg               Specifies maxkeypage.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = btreeinfo:set_maxkeypage(arg)
+ */
+static int
+BTREEINFO_set_maxkeypage(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    BTREEINFO *info;
+    int x;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(BTREEINFO, TYPE, __func__);
+    m1 = luab_xmod(INT, TYPE, __func__);
+
+    info = luab_udata(L, 1, m0, BTREEINFO *);
+    x = (int)luab_checkxinteger(L, 2, m1, luab_env_int_max);
+
+    info->maxkeypage = x;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Get maximum number of keys per page.
+ *
+ * @function get_maxkeypage
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = btreeinfo:get_maxkeypage()
+ */
+static int
+BTREEINFO_get_maxkeypage(lua_State *L)
+{
+    luab_module_t *m;
+    BTREEINFO *info;
+    int x;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(BTREEINFO, TYPE, __func__);
+    info = luab_udata(L, 1, m, BTREEINFO *);
+    x = info->maxkeypage;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Set minimum number of keys per page.
+ *
+ * @function set_minkeypage
+ *
+ * @param arg               Specifies minkeypage.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = btreeinfo:set_minkeypage(arg)
+ */
+static int
+BTREEINFO_set_minkeypage(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    BTREEINFO *info;
+    int x;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(BTREEINFO, TYPE, __func__);
+    m1 = luab_xmod(INT, TYPE, __func__);
+
+    info = luab_udata(L, 1, m0, BTREEINFO *);
+    x = (int)luab_checkxinteger(L, 2, m1, luab_env_int_max);
+
+    info->minkeypage = x;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Get minimum number of keys per page.
+ *
+ * @function get_minkeypage
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = btreeinfo:get_minkeypage()
+ */
+static int
+BTREEINFO_get_minkeypage(lua_State *L)
+{
+    luab_module_t *m;
+    BTREEINFO *info;
+    int x;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(BTREEINFO, TYPE, __func__);
+    info = luab_udata(L, 1, m, BTREEINFO *);
+    x = info->minkeypage;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Set page size in bytes.
+ *
+ * @function set_psize
+ *
+ * @param arg               Specifies psize.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = btreeinfo:set_psize(arg)
+ */
+static int
+BTREEINFO_set_psize(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    BTREEINFO *info;
+    u_int x;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(BTREEINFO, TYPE, __func__);
+    m1 = luab_xmod(UINT, TYPE, __func__);
+
+    info = luab_udata(L, 1, m0, BTREEINFO *);
+    x = (u_int)luab_checkxinteger(L, 2, m1, luab_env_uint_max);
+
+    info->psize = x;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Get page size in bytes.
+ *
+ * @function get_psize
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = btreeinfo:get_psize()
+ */
+static int
+BTREEINFO_get_psize(lua_State *L)
+{
+    luab_module_t *m;
+    BTREEINFO *info;
+    u_int x;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(BTREEINFO, TYPE, __func__);
+    info = luab_udata(L, 1, m, BTREEINFO *);
+    x = info->psize;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Set byte order.
+ *
+ * @function set_lorder
+ *
+ * @param arg               Specifies lorder.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = btreeinfo:set_lorder(arg)
+ */
+static int
+BTREEINFO_set_lorder(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    BTREEINFO *info;
+    int x;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(BTREEINFO, TYPE, __func__);
+    m1 = luab_xmod(INT, TYPE, __func__);
+
+    info = luab_udata(L, 1, m0, BTREEINFO *);
+    x = (int)luab_checkxinteger(L, 2, m1, luab_env_int_max);
+
+    info->lorder = x;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Get byte order.
+ *
+ * @function get_lorder
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = btreeinfo:get_lorder()
+ */
+static int
+BTREEINFO_get_lorder(lua_State *L)
+{
+    luab_module_t *m;
+    BTREEINFO *info;
+    int x;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(BTREEINFO, TYPE, __func__);
+    info = luab_udata(L, 1, m, BTREEINFO *);
+    x = info->lorder;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/*
+ * Metamethods.
+ */
+
+static int
+BTREEINFO_gc(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(BTREEINFO, TYPE, __func__);
+    return (luab_core_gc(L, 1, m));
+}
+
+static int
+BTREEINFO_len(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(BTREEINFO, TYPE, __func__);
+    return (luab_core_len(L, 2, m));
+}
+
+static int
+BTREEINFO_tostring(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(BTREEINFO, TYPE, __func__);
+    return (luab_core_tostring(L, 1, m));
+}
+
+/*
+ * Internal interface.
+ */
+
+static luab_module_table_t btreeinfo_methods[] = {
+    LUAB_FUNC("set_flags",        BTREEINFO_set_flags),
+    LUAB_FUNC("set_cachesize",    BTREEINFO_set_cachesize),
+    LUAB_FUNC("set_maxkeypage",   BTREEINFO_set_maxkeypage),
+    LUAB_FUNC("set_minkeypage",   BTREEINFO_set_minkeypage),
+    LUAB_FUNC("set_psize",        BTREEINFO_set_psize),
+    LUAB_FUNC("set_lorder",       BTREEINFO_set_lorder),
+    LUAB_FUNC("get_table",        BTREEINFO_get_table),
+    LUAB_FUNC("get_flags",        BTREEINFO_get_flags),
+    LUAB_FUNC("get_cachesize",    BTREEINFO_get_cachesize),
+    LUAB_FUNC("get_maxkeypage",   BTREEINFO_get_maxkeypage),
+    LUAB_FUNC("get_minkeypage",   BTREEINFO_get_minkeypage),
+    LUAB_FUNC("get_psize",        BTREEINFO_get_psize),
+    LUAB_FUNC("get_lorder",       BTREEINFO_get_lorder),
+    LUAB_FUNC("dump",             BTREEINFO_dump),
+    LUAB_FUNC("__gc",             BTREEINFO_gc),
+    LUAB_FUNC("__len",            BTREEINFO_len),
+    LUAB_FUNC("__tostring",       BTREEINFO_tostring),
+    LUAB_MOD_TBL_SENTINEL
+};
+
+static void *
+btreeinfo_create(lua_State *L, void *arg)
+{
+    luab_module_t *m;
+    m = luab_xmod(BTREEINFO, TYPE, __func__);
+    return (luab_newuserdata(L, m, arg));
+}
+
+static void
+btreeinfo_init(void *ud, void *arg)
+{
+    luab_module_t *m;
+    m = luab_xmod(BTREEINFO, TYPE, __func__);
+    luab_udata_init(m, ud, arg);
+}
+
+static void *
+btreeinfo_udata(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    m = luab_xmod(BTREEINFO, TYPE, __func__);
+    return (luab_checkludata(L, narg, m, m->m_sz));
+}
+
+static luab_table_t *
+btreeinfo_checktable(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    luab_table_t *tbl;
+    BTREEINFO *x, *y;
+    size_t i, j;
+
+    m = luab_xmod(BTREEINFO, TYPE, __func__);
+
+    if ((tbl = luab_table_newvectornil(L, narg, m)) != NULL) {
+
+        if (((x = (BTREEINFO *)tbl->tbl_vec) != NULL) &&
+            (tbl->tbl_card > 0)) {
+            luab_table_init(L, 0);
+
+            for (i = 0, j = tbl->tbl_card; i < j; i++) {
+
+                if (lua_next(L, narg) != 0) {
+
+                    if ((lua_isnumber(L, -2) != 0) &&
+                        (lua_isuserdata(L, -1) != 0)) {
+                        y = luab_udata(L, -1, m, BTREEINFO *);
+                        (void)memmove(&(x[i]), y, m->m_sz);
+                    } else
+                        luab_core_err(EX_DATAERR, __func__, EINVAL);
+                } else {
+                    errno = ENOENT;
+                    break;
+                }
+                lua_pop(L, 1);
+            }
+        } else
+            errno = ERANGE;
+    }
+    return (tbl);
+}
+
+static void
+btreeinfo_pushtable(lua_State *L, int narg, luab_table_t *tbl, int new, int clr)
+{
+    luab_module_t *m;
+    BTREEINFO *x;
+    size_t i, j, k;
+
+    m = luab_xmod(BTREEINFO, TYPE, __func__);
+
+    if (tbl != NULL) {
+
+        if (((x = (BTREEINFO *)tbl->tbl_vec) != NULL) &&
+            (tbl->tbl_card > 0)) {
+            luab_table_init(L, new);
+
+            for (i = 0, j = tbl->tbl_card, k = 1; i < j; i++, k++)
+                luab_rawsetxdata(L, narg, m, k, &(x[i]));
+
+            errno = ENOENT;
+        } else
+            errno = ERANGE;
+
+        if (clr != 0)
+            luab_table_free(tbl);
+    } else
+        errno = ERANGE;
+}
+
+static luab_table_t *
+btreeinfo_alloctable(void *vec, size_t card)
+{
+    luab_module_t *m;
+    m = luab_xmod(BTREEINFO, TYPE, __func__);
+    return (luab_table_create(m, vec, card));
+}
+
+luab_module_t luab_btreeinfo_type = {
+    .m_id           = LUAB_BTREEINFO_TYPE_ID,
+    .m_name         = LUAB_BTREEINFO_TYPE,
+    .m_vec          = btreeinfo_methods,
+    .m_create       = btreeinfo_create,
+    .m_init         = btreeinfo_init,
+    .m_get          = btreeinfo_udata,
+    .m_get_tbl      = btreeinfo_checktable,
+    .m_set_tbl      = btreeinfo_pushtable,
+    .m_alloc_tbl    = btreeinfo_alloctable,
+    .m_len          = sizeof(luab_btreeinfo_t),
+    .m_sz           = sizeof(BTREEINFO),
+};
+#endif /* __BSD_VISIBLE */
@@ -58,6 +58,7 @@ extern luab_module_t luab_db_type;
 typedef struct luab_db {
     luab_udata_t    ud_softc;
     DB              *ud_db;
+    int             ud_dup;
 } luab_db_t;
 
 /*
@@ -101,6 +102,90 @@ db_fillxtable(lua_State *L, int narg, void *arg)
         luab_core_err(EX_DATAERR, __func__, EINVAL);
 }
 
+/*
+ * Keys and values of batched operations are passed either by an array
+ * of (LUA_TSTRING) or by an instance of (LUA_TUSERDATA(IOVEC)) holding
+ * a sequence of records, each prefixed by its length as uint32_t in
+ * host byte order. The returned vector of DBT refers those strings or
+ * the buffer, thus it is valid as long as the argument is on stack.
+ *
+ * The vector is pushed onto the stack by (LUA_TUSERDATA), thus it is
+ * released by the collector, even if an error is raised afterwards. An
+ * empty batch yields an empty vector.
+ */
+
+DBT *
+luab_db_checkbatch(lua_State *L, int narg, size_t *card)
+{
+    luab_iovec_t *buf;
+    DBT *vec;
+    caddr_t bp;
+    size_t i, n, off, len;
+    uint32_t rlen;
+
+    if ((buf = luab_isiovec(L, narg)) != NULL) {
+
+        bp = buf->iov.iov_base;
+        len = buf->iov.iov_len;
+
+        if (bp == NULL && len != 0) {
+            errno = ENXIO;
+            return (NULL);
+        }
+
+        for (n = 0, off = 0; off < len; n++) {
+
+            if ((len - off) < sizeof(rlen)) {
+                errno = EINVAL;
+                return (NULL);
+            }
+            (void)memmove(&rlen, bp + off, sizeof(rlen));
+            off += sizeof(rlen);
+
+            if (rlen > (len - off)) {
+                errno = EINVAL;
+                return (NULL);
+            }
+            off += rlen;
+        }
+    } else if (lua_istable(L, narg) != 0) {
+        bp = NULL;
+        n = lua_rawlen(L, narg);
+    } else {
+        errno = EINVAL;
+        return (NULL);
+    }
+
+    vec = lua_newuserdata(L, n * sizeof(DBT));
+
+    for (i = 0, off = 0; i < n; i++) {
+
+        if (bp != NULL) {
+            (void)memmove(&rlen, bp + off, sizeof(rlen));
+            off += sizeof(rlen);
+
+            vec[i].data = bp + off;
+            vec[i].size = rlen;
+
+            off += rlen;
+        } else {
+            lua_rawgeti(L, narg, (int)(i + 1));
+
+            if (lua_type(L, -1) != LUA_TSTRING) {
+                lua_pop(L, 2);
+                errno = EINVAL;
+                return (NULL);
+            }
+            vec[i].data = (void *)(uintptr_t)lua_tolstring(L, -1, &len);
+            vec[i].size = len;
+
+            lua_pop(L, 1);
+        }
+    }
+    *card = n;
+    return (vec);
+}
+
 /*
  * Generator functions.
  */
@@ -159,6 +244,246 @@ DB_dump(lua_State *L)
     return (luab_core_dump(L, 1, NULL, 0));
 }
 
+/***
+ * Generator function - create an instance of (LUA_TUSERDATA(DBCURSOR)).
+ *
+ * @function cursor
+ *
+ * @param lower             Lower bound, inclusive, (LUA_T{NIL,STRING}).
+ * @param upper             Upper bound, exclusive, (LUA_T{NIL,STRING}).
+ * @param reverse           Scan in descending order, (LUA_T{NIL,BOOLEAN}).
+ * @param card              Number of records fetched ahead, (LUA_T{NIL,NUMBER}).
+ *
+ *                          Bounds are applicable on DB_BTREE only.
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage for k, v in db:cursor([ lower [, upper [, reverse [, card ]]]]) do
+ *          ...
+ *      end
+ */
+static int
+DB_cursor(lua_State *L)
+{
+    luab_module_t *m0, *m1, *m2;
+    luab_dbcursor_param_t dcp;
+    DB *db;
+    size_t len;
+
+    (void)luab_core_checkmaxargs(L, 5);
+
+    m0 = luab_xmod(DB, TYPE, __func__);
+    m1 = luab_xmod(SIZE, TYPE, __func__);
+    m2 = luab_xmod(DBCURSOR, TYPE, __func__);
+
+    if ((db = luab_udata(L, 1, m0, DB *)) == NULL)
+        return (luab_pushnil(L));
+
+    (void)memset(&dcp, 0, sizeof(dcp));
+
+    dcp.dcp_narg = 1;
+    dcp.dcp_type = db->type;
+
+    if (lua_isnoneornil(L, 2) == 0) {
+        dcp.dcp_lower.data = (void *)(uintptr_t)luab_checklstring(L, 2,
+            luab_env_buf_max, &len);
+        dcp.dcp_lower.size = len;
+    }
+
+    if (lua_isnoneornil(L, 3) == 0) {
+        dcp.dcp_upper.data = (void *)(uintptr_t)luab_checklstring(L, 3,
+            luab_env_buf_max, &len);
+        dcp.dcp_upper.size = len;
+    }
+
+    dcp.dcp_reverse = lua_toboolean(L, 4);
+
+    if (lua_isnoneornil(L, 5) == 0)
+        dcp.dcp_card = (size_t)luab_checklxinteger(L, 5, m1, 0);
+
+    return (luab_pushxdata(L, m2, &dcp));
+}
+
+/***
+ * Generator function - create an instance of (LUA_TUSERDATA(DBCURSOR))
+ * scanning all keys with given prefix on DB_BTREE.
+ *
+ * @function prefix
+ *
+ * @param prefix            Prefix, (LUA_TSTRING).
+ * @param reverse           Scan in descending order, (LUA_T{NIL,BOOLEAN}).
+ * @param card              Number of records fetched ahead, (LUA_T{NIL,NUMBER}).
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage for k, v in db:prefix(prefix [, reverse [, card ]]) do
+ *          ...
+ *      end
+ */
+static int
+DB_prefix(lua_State *L)
+{
+    luab_module_t *m0, *m1, *m2;
+    luab_dbcursor_param_t dcp;
+    DB *db;
+    size_t len;
+
+    (void)luab_core_checkmaxargs(L, 4);
+
+    m0 = luab_xmod(DB, TYPE, __func__);
+    m1 = luab_xmod(SIZE, TYPE, __func__);
+    m2 = luab_xmod(DBCURSOR, TYPE, __func__);
+
+    if ((db = luab_udata(L, 1, m0, DB *)) == NULL)
+        return (luab_pushnil(L));
+
+    (void)memset(&dcp, 0, sizeof(dcp));
+
+    dcp.dcp_narg = 1;
+    dcp.dcp_type = db->type;
+
+    dcp.dcp_lower.data = (void *)(uintptr_t)luab_checklstring(L, 2,
+        luab_env_buf_max, &len);
+    dcp.dcp_lower.size = len;
+    dcp.dcp_prefix = 1;
+
+    dcp.dcp_reverse = lua_toboolean(L, 3);
+
+    if (lua_isnoneornil(L, 4) == 0)
+        dcp.dcp_card = (size_t)luab_checklxinteger(L, 4, m1, 0);
+
+    return (luab_pushxdata(L, m2, &dcp));
+}
+
+/***
+ * Generator function - create an instance of (LUA_TUSERDATA(DBCACHE)),
+ * a read-through cache of key/data pairs in least recently used order.
+ *
+ * @function cache
+ *
+ * @param budget            Upper bound for bytes held by cache.
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage cache [, err, msg ] = db:cache(budget)
+ */
+static int
+DB_cache(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    luab_dbcache_param_t dbcp;
+    luab_db_t *self;
+    DB *db;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(DB, TYPE, __func__);
+    m1 = luab_xmod(DBCACHE, TYPE, __func__);
+
+    if ((db = luab_udata(L, 1, m0, DB *)) == NULL)
+        return (luab_pushnil(L));
+
+    self = luab_todata(L, 1, m0, luab_db_t *);
+
+    dbcp.dbcp_narg = 1;
+    dbcp.dbcp_type = db->type;
+    dbcp.dbcp_dup = self->ud_dup;
+    dbcp.dbcp_budget = luab_checksize(L, 2);
+
+    return (luab_pushxdata(L, m1, &dbcp));
+}
+
+/***
+ * Generator function - create an instance of (LUA_TUSERDATA(DBLOADER)),
+ * which stores key/data pairs sorted by their keys into a DB_BTREE.
+ *
+ * @function loader
+ *
+ * @param budget            Upper bound for bytes sorted in memory, before
+ *                          records are spilled into temporary files,
+ *                          (LUA_T{NIL,NUMBER}).
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage loader [, err, msg ] = db:loader([ budget ])
+ */
+static int
+DB_loader(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    luab_dbloader_param_t dlp;
+    DB *db;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(DB, TYPE, __func__);
+    m1 = luab_xmod(DBLOADER, TYPE, __func__);
+
+    if ((db = luab_udata(L, 1, m0, DB *)) == NULL)
+        return (luab_pushnil(L));
+
+    dlp.dlp_narg = 1;
+    dlp.dlp_budget = lua_isnoneornil(L, 2) ?
+        LUAB_DBLOADER_BUDGET : luab_checksize(L, 2);
+
+    if (db->type != DB_BTREE) {
+        errno = EINVAL;
+        return (luab_pushnil(L));
+    }
+    return (luab_pushxdata(L, m1, &dlp));
+}
+
+/***
+ * Generator function - create an instance of (LUA_TUSERDATA(BLOOM)),
+ * a Bloom filter over the keys of a DB_{BTREE,HASH}, which is consulted
+ * before the db(3) is accessed.
+ *
+ * @function bloom
+ *
+ * @param nelem             Expected number of keys, counted by traversal
+ *                          if (LUA_TNIL), or path of file written by
+ *                          bloom:save(), (LUA_T{NIL,NUMBER,STRING}).
+ * @param bits              Bits per key, up to 64, (LUA_T{NIL,NUMBER}).
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage bloom [, err, msg ] = db:bloom([ nelem [, bits ]])
+ *
+ *          or
+ *
+ *      bloom [, err, msg ] = db:bloom(path)
+ */
+static int
+DB_bloom(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    luab_bloom_param_t blp;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m0 = luab_xmod(DB, TYPE, __func__);
+    m1 = luab_xmod(BLOOM, TYPE, __func__);
+
+    if ((blp.blp_db = luab_udata(L, 1, m0, DB *)) == NULL)
+        return (luab_pushnil(L));
+
+    blp.blp_narg = 1;
+    blp.blp_path = NULL;
+    blp.blp_nelem = 0;
+    blp.blp_bits = LUAB_BLOOM_BITS;
+
+    if (lua_type(L, 2) == LUA_TSTRING)
+        blp.blp_path = luab_checklstring(L, 2, luab_env_path_max, NULL);
+    else {
+        if (lua_isnoneornil(L, 2) == 0)
+            blp.blp_nelem = luab_checksize(L, 2);
+
+        if (lua_isnoneornil(L, 3) == 0)
+            blp.blp_bits = luab_checkuint(L, 3);
+    }
+    return (luab_pushxdata(L, m1, &blp));
+}
+
 /*
  * Database access methods.
  */
@@ -427,6 +752,238 @@ DB_sync(lua_State *L)
     return (luab_pushxinteger(L, status));
 }
 
+/***
+ * Export key/data pairs of a DB_BTREE into an immutable sorted table,
+ * which may be mapped by bsd.db.create_sstable(3).
+ *
+ * @function export
+ *
+ * @param path              Path of file, replaced on completion.
+ * @param interval          Number of records between entries of the
+ *                          index, (LUA_T{NIL,NUMBER}).
+ * @param flags             May be set
+ *
+ *                              bsd.db.SSTABLE_PREFIX or 0
+ *
+ *                          as possible value, (LUA_T{NIL,NUMBER}).
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          Number of records written, or -1.
+ *
+ * @usage count [, err, msg ] = db:export(path [, interval [, flags ]])
+ */
+static int
+DB_export(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    DB *db;
+    const char *path;
+    u_int interval, flags;
+    ssize_t count;
+
+    (void)luab_core_checkmaxargs(L, 4);
+
+    m0 = luab_xmod(DB, TYPE, __func__);
+    m1 = luab_xmod(UINT, TYPE, __func__);
+
+    if ((db = luab_udata(L, 1, m0, DB *)) != NULL) {
+        path = luab_checklstring(L, 2, luab_env_path_max, NULL);
+
+        interval = lua_isnoneornil(L, 3) ? LUAB_SSTABLE_INTERVAL :
+            (u_int)luab_checkxinteger(L, 3, m1, luab_env_uint_max);
+        flags = lua_isnoneornil(L, 4) ? 0 :
+            (u_int)luab_checkxinteger(L, 4, m1, luab_env_uint_max);
+
+        count = luab_sstable_export(db, path, interval, flags);
+    } else
+        count = luab_env_error;
+
+    return (luab_pushxinteger(L, count));
+}
+
+/*
+ * Batched access methods.
+ */
+
+/***
+ * Store a batch of key/data pairs in the db(3).
+ *
+ * @function put_many
+ *
+ * @param keys              Either an array of (LUA_TSTRING) or an instance
+ *                          of (LUA_TUSERDATA(IOVEC)) holding records,
+ *                          each prefixed by its length as uint32_t.
+ * @param values            Values, passed as keys and with same cardinality.
+ * @param flags             Applied to each put, see db:put().
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          The table holds the status of each put. Processing stops at
+ *          the first failing put, whose status is -1, and the error is
+ *          returned along with the table.
+ *
+ * @usage ret [, err, msg ] = db:put_many(keys, values, flags)
+ */
+static int
+DB_put_many(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    DB *db;
+    DBT *k, *v;
+    size_t nk, nv, i;
+    u_int flags;
+    int status, up_call;
+
+    (void)luab_core_checkmaxargs(L, 4);
+
+    m0 = luab_xmod(DB, TYPE, __func__);
+    m1 = luab_xmod(UINT, TYPE, __func__);
+
+    flags = (u_int)luab_checkxinteger(L, 4, m1, luab_env_uint_max);
+
+    if ((db = luab_udata(L, 1, m0, DB *)) == NULL)
+        return (luab_pushnil(L));
+
+    if ((k = luab_db_checkbatch(L, 2, &nk)) == NULL)
+        luab_core_argerror(L, 2, NULL, 0, 0, errno);
+
+    if ((v = luab_db_checkbatch(L, 3, &nv)) == NULL || nv != nk)
+        luab_core_argerror(L, 3, NULL, 0, 0, (v == NULL) ? errno : ERANGE);
+
+    lua_createtable(L, (int)nk, 0);
+
+    for (i = 0, up_call = 0; i < nk; i++) {
+        status = (*db->put)(db, &k[i], &v[i], flags);
+
+        lua_pushinteger(L, status);
+        lua_rawseti(L, -2, (int)(i + 1));
+
+        if (status < 0) {
+            up_call = errno;
+            break;
+        }
+    }
+    return (luab_pusherr(L, up_call, 1));
+}
+
+/***
+ * Keyed retrieval of a batch of values from the db(3).
+ *
+ * @function get_many
+ *
+ * @param keys              Either an array of (LUA_TSTRING) or an instance
+ *                          of (LUA_TUSERDATA(IOVEC)) holding records,
+ *                          each prefixed by its length as uint32_t.
+ * @param flags             Set to 0.
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          The table holds the value of each key as (LUA_TSTRING) or
+ *          false, if the key was not found. Processing stops at the
+ *          first failing get and the error is returned along with the
+ *          values retrieved so far.
+ *
+ * @usage values [, err, msg ] = db:get_many(keys, flags)
+ */
+static int
+DB_get_many(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    DB *db;
+    DBT *k, v;
+    size_t nk, i;
+    u_int flags;
+    int status, up_call;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m0 = luab_xmod(DB, TYPE, __func__);
+    m1 = luab_xmod(UINT, TYPE, __func__);
+
+    flags = (u_int)luab_checkxinteger(L, 3, m1, luab_env_uint_max);
+
+    if ((db = luab_udata(L, 1, m0, DB *)) == NULL)
+        return (luab_pushnil(L));
+
+    if ((k = luab_db_checkbatch(L, 2, &nk)) == NULL)
+        luab_core_argerror(L, 2, NULL, 0, 0, errno);
+
+    lua_createtable(L, (int)nk, 0);
+
+    for (i = 0, up_call = 0; i < nk; i++) {
+
+        if ((status = (*db->get)(db, &k[i], &v, flags)) == 0)
+            lua_pushlstring(L, v.data, v.size);
+        else if (status > 0)
+            lua_pushboolean(L, 0);
+        else {
+            up_call = errno;
+            break;
+        }
+        lua_rawseti(L, -2, (int)(i + 1));
+    }
+    return (luab_pusherr(L, up_call, 1));
+}
+
+/***
+ * Remove a batch of key/data pairs from the db(3).
+ *
+ * @function del_many
+ *
+ * @param keys              Either an array of (LUA_TSTRING) or an instance
+ *                          of (LUA_TUSERDATA(IOVEC)) holding records,
+ *                          each prefixed by its length as uint32_t.
+ * @param flags             Set to 0.
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          The table holds the status of each del, where 1 denotes
+ *          a key not found. Processing stops at the first failing del,
+ *          whose status is -1, and the error is returned along with
+ *          the table.
+ *
+ * @usage ret [, err, msg ] = db:del_many(keys, flags)
+ */
+static int
+DB_del_many(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    DB *db;
+    DBT *k;
+    size_t nk, i;
+    u_int flags;
+    int status, up_call;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m0 = luab_xmod(DB, TYPE, __func__);
+    m1 = luab_xmod(UINT, TYPE, __func__);
+
+    flags = (u_int)luab_checkxinteger(L, 3, m1, luab_env_uint_max);
+
+    if ((db = luab_udata(L, 1, m0, DB *)) == NULL)
+        return (luab_pushnil(L));
+
+    if ((k = luab_db_checkbatch(L, 2, &nk)) == NULL)
+        luab_core_argerror(L, 2, NULL, 0, 0, errno);
+
+    lua_createtable(L, (int)nk, 0);
+
+    for (i = 0, up_call = 0; i < nk; i++) {
+        status = (*db->del)(db, &k[i], flags);
+
+        lua_pushinteger(L, status);
+        lua_rawseti(L, -2, (int)(i + 1));
+
+        if (status < 0) {
+            up_call = errno;
+            break;
+        }
+    }
+    return (luab_pusherr(L, up_call, 1));
+}
+
 /*
  * Metamethods.
  */
@@ -487,6 +1044,15 @@ static luab_module_table_t db_methods[] = {
     LUAB_FUNC("put",            DB_put),
     LUAB_FUNC("seq",            DB_seq),
     LUAB_FUNC("sync",           DB_sync),
+    LUAB_FUNC("export",         DB_export),
+    LUAB_FUNC("put_many",       DB_put_many),
+    LUAB_FUNC("get_many",       DB_get_many),
+    LUAB_FUNC("del_many",       DB_del_many),
+    LUAB_FUNC("cursor",         DB_cursor),
+    LUAB_FUNC("prefix",         DB_prefix),
+    LUAB_FUNC("cache",          DB_cache),
+    LUAB_FUNC("loader",         DB_loader),
+    LUAB_FUNC("bloom",          DB_bloom),
     LUAB_FUNC("get_table",      DB_get_table),
     LUAB_FUNC("dump",           DB_dump),
     LUAB_FUNC("__gc",           DB_gc),
@@ -506,7 +1072,7 @@ db_create(lua_State *L, void *arg)
 
     if ((dbp = (luab_db_param_t *)arg) != NULL) {
 
-        if ((self = luab_newuserdata(L, m, dbp->dbp_db)) == NULL) {
+        if ((self = luab_newuserdata(L, m, dbp)) == NULL) {
 
             if (dbp->dbp_db != NULL)
                 (void)(*dbp->dbp_db->close)(dbp->dbp_db);
@@ -521,9 +1087,13 @@ static void
 db_init(void *ud, void *arg)
 {
     luab_db_t *self;
+    luab_db_param_t *dbp;
 
-    if ((self = (luab_db_t *)ud) != NULL)
-        self->ud_db = (DB *)arg;
+    if (((self = (luab_db_t *)ud) != NULL) &&
+        ((dbp = (luab_db_param_t *)arg) != NULL)) {
+        self->ud_db = dbp->dbp_db;
+        self->ud_dup = dbp->dbp_dup;
+    }
 }
 
 static void *
@@ -0,0 +1,804 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/queue.h>
+
+#include <db.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+#include "luab_table.h"
+
+#if __BSD_VISIBLE
+extern luab_module_t luab_dbcache_type;
+
+/*
+ * Interface against
+ *
+ *  typedef struct luab_dbcache {
+ *      luab_udata_t    ud_softc;
+ *      DBTYPE          ud_type;
+ *      int             ud_dup;
+ *      struct dbcache_bucket   *ud_hash;
+ *      size_t          ud_nbuckets;
+ *      struct dbcache_lru  ud_lru;
+ *      size_t          ud_budget;
+ *      size_t          ud_bytes;
+ *      size_t          ud_nent;
+ *      u_long          ud_hits;
+ *      u_long          ud_misses;
+ *      u_long          ud_evictions;
+ *  } luab_dbcache_t;
+ *
+ * whereby copies of key/data pairs read from the DB are held in memory
+ * up to ud_budget bytes and released in least recently used order. The
+ * DB is referenced by the uservalue of the cache, operations by put and
+ * del are passed through before the cache is updated.
+ *
+ * Neither DB->put with R_{CURSOR,IAFTER,IBEFORE,SETCURSOR} nor DB->del
+ * on DB_RECNO, where records are renumbered, are mapped onto a single
+ * key, thus the cache is flushed. DB->put on a DB_BTREE opened by R_DUP
+ * adds a duplicate, thus the cached copy of its key is dropped. Any
+ * operation on the DB itself, which bypasses its cache, is not seen.
+ */
+
+typedef struct dbcache_ent {
+    TAILQ_ENTRY(dbcache_ent)    ce_lru;
+    LIST_ENTRY(dbcache_ent)     ce_next;
+    uint32_t        ce_hv;
+    size_t          ce_ksize;
+    size_t          ce_vsize;
+    u_char          ce_data[];  /* key, then data */
+} dbcache_ent_t;
+
+LIST_HEAD(dbcache_bucket, dbcache_ent);
+TAILQ_HEAD(dbcache_lru, dbcache_ent);
+
+typedef struct luab_dbcache {
+    luab_udata_t            ud_softc;
+    DBTYPE                  ud_type;
+    int                     ud_dup;
+    struct dbcache_bucket   *ud_hash;
+    size_t                  ud_nbuckets;
+    struct dbcache_lru      ud_lru;
+    size_t                  ud_budget;
+    size_t                  ud_bytes;
+    size_t                  ud_nent;
+    u_long                  ud_hits;
+    u_long                  ud_misses;
+    u_long                  ud_evictions;
+} luab_dbcache_t;
+
+#define LUAB_DBCACHE_NBUCKETS   64
+
+#define dbcache_entsz(ksize, vsize) \
+    (sizeof(dbcache_ent_t) + (ksize) + (vsize))
+
+/*
+ * Subr.
+ */
+
+static uint32_t
+dbcache_hash(const void *v, size_t len)
+{
+    const u_char *bp;
+    uint32_t hv;
+    size_t i;
+
+    for (bp = v, hv = 2166136261U, i = 0; i < len; i++) {
+        hv ^= bp[i];
+        hv *= 16777619U;
+    }
+    return (hv);
+}
+
+static struct dbcache_bucket *
+dbcache_bucket(luab_dbcache_t *self, uint32_t hv)
+{
+    return (&(self->ud_hash[hv & (self->ud_nbuckets - 1)]));
+}
+
+static dbcache_ent_t *
+dbcache_lookup(luab_dbcache_t *self, const void *k, size_t ksize,
+    uint32_t hv)
+{
+    dbcache_ent_t *ce;
+
+    LIST_FOREACH(ce, dbcache_bucket(self, hv), ce_next) {
+
+        if ((ce->ce_hv == hv) && (ce->ce_ksize == ksize) &&
+            (memcmp(ce->ce_data, k, ksize) == 0))
+            break;
+    }
+    return (ce);
+}
+
+static void
+dbcache_remove(luab_dbcache_t *self, dbcache_ent_t *ce)
+{
+    size_t len;
+
+    len = dbcache_entsz(ce->ce_ksize, ce->ce_vsize);
+
+    LIST_REMOVE(ce, ce_next);
+    TAILQ_REMOVE(&self->ud_lru, ce, ce_lru);
+
+    self->ud_bytes -= len;
+    self->ud_nent--;
+
+    luab_core_free(ce, len);
+}
+
+static void
+dbcache_flush(luab_dbcache_t *self)
+{
+    dbcache_ent_t *ce;
+
+    while ((ce = TAILQ_FIRST(&self->ud_lru)) != NULL)
+        dbcache_remove(self, ce);
+}
+
+static void
+dbcache_evict(luab_dbcache_t *self, size_t len)
+{
+    dbcache_ent_t *ce;
+
+    while ((self->ud_bytes + len > self->ud_budget) &&
+        ((ce = TAILQ_LAST(&self->ud_lru, dbcache_lru)) != NULL)) {
+        dbcache_remove(self, ce);
+        self->ud_evictions++;
+    }
+}
+
+/*
+ * Doubles the amount of buckets, if load factor exceeds 1. Failure is
+ * not fatal, the chains are just getting longer.
+ */
+static void
+dbcache_grow(luab_dbcache_t *self)
+{
+    struct dbcache_bucket *hash;
+    dbcache_ent_t *ce;
+    size_t n;
+
+    if (self->ud_nent < self->ud_nbuckets)
+        return;
+
+    n = self->ud_nbuckets << 1;
+
+    if ((hash = luab_core_alloc(n, sizeof(struct dbcache_bucket))) == NULL)
+        return;
+
+    luab_core_free(self->ud_hash,
+        self->ud_nbuckets * sizeof(struct dbcache_bucket));
+
+    self->ud_hash = hash;
+    self->ud_nbuckets = n;
+
+    TAILQ_FOREACH(ce, &self->ud_lru, ce_lru)
+        LIST_INSERT_HEAD(dbcache_bucket(self, ce->ce_hv), ce, ce_next);
+}
+
+/*
+ * Replaces the entry for key, if any. Records exceeding the budget are
+ * not cached at all.
+ */
+static void
+dbcache_insert(luab_dbcache_t *self, const DBT *k, const DBT *v,
+    uint32_t hv)
+{
+    dbcache_ent_t *ce;
+    size_t len;
+
+    if ((ce = dbcache_lookup(self, k->data, k->size, hv)) != NULL)
+        dbcache_remove(self, ce);
+
+    if ((len = dbcache_entsz(k->size, v->size)) > self->ud_budget)
+        return;
+
+    dbcache_evict(self, len);
+
+    if ((ce = luab_core_allocx(1, len, LUAB_ALLOC_NOZERO)) == NULL)
+        return;
+
+    ce->ce_hv = hv;
+    ce->ce_ksize = k->size;
+    ce->ce_vsize = v->size;
+
+    (void)memmove(ce->ce_data, k->data, k->size);
+    (void)memmove(ce->ce_data + k->size, v->data, v->size);
+
+    LIST_INSERT_HEAD(dbcache_bucket(self, hv), ce, ce_next);
+    TAILQ_INSERT_HEAD(&self->ud_lru, ce, ce_lru);
+
+    self->ud_bytes += len;
+    self->ud_nent++;
+
+    dbcache_grow(self);
+}
+
+static DB *
+dbcache_db(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    DB *db;
+
+    m = luab_xmod(DB, TYPE, __func__);
+
+    lua_getuservalue(L, narg);
+    lua_rawgeti(L, -1, 1);
+
+    db = luab_udata(L, -1, m, DB *);
+
+    lua_pop(L, 2);
+
+    return (db);
+}
+
+static void
+dbcache_checkkey(lua_State *L, int narg, DBT *k)
+{
+    size_t len;
+
+    k->data = (void *)(uintptr_t)luab_checklstring(L, narg,
+        luab_env_buf_max, &len);
+    k->size = len;
+}
+
+static void
+dbcache_fillxtable(lua_State *L, int narg, void *arg)
+{
+    luab_dbcache_t *self;
+
+    if ((self = (luab_dbcache_t *)arg) != NULL) {
+
+        luab_setinteger(L, narg, "type",        self->ud_type);
+        luab_setinteger(L, narg, "budget",      self->ud_budget);
+        luab_setinteger(L, narg, "bytes",       self->ud_bytes);
+        luab_setinteger(L, narg, "nent",        self->ud_nent);
+        luab_setinteger(L, narg, "hits",        self->ud_hits);
+        luab_setinteger(L, narg, "misses",      self->ud_misses);
+        luab_setinteger(L, narg, "evictions",   self->ud_evictions);
+    } else
+        luab_core_err(EX_DATAERR, __func__, EINVAL);
+}
+
+/*
+ * Generator functions.
+ */
+
+/***
+ * Generator function - translate (LUA_TUSERDATA(DBCACHE)) into (LUA_TTABLE).
+ *
+ * @function get_table
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              type        = (LUA_TNUMBER),
+ *              budget      = (LUA_TNUMBER),
+ *              bytes       = (LUA_TNUMBER),
+ *              nent        = (LUA_TNUMBER),
+ *              hits        = (LUA_TNUMBER),
+ *              misses      = (LUA_TNUMBER),
+ *              evictions   = (LUA_TNUMBER),
+ *          }
+ *
+ * @usage t [, err, msg ] = cache:get_table()
+ */
+static int
+DBCACHE_get_table(lua_State *L)
+{
+    luab_module_t *m;
+    luab_xtable_param_t xtp;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DBCACHE, TYPE, __func__);
+
+    xtp.xtp_fill = dbcache_fillxtable;
+    xtp.xtp_arg = luab_todata(L, 1, m, void *);
+    xtp.xtp_new = 1;
+    xtp.xtp_k = NULL;
+
+    return (luab_table_pushxtable(L, -2, &xtp));
+}
+
+/***
+ * Generator function - returns (LUA_TNIL).
+ *
+ * @function dump
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage iovec [, err, msg ] = cache:dump()
+ */
+static int
+DBCACHE_dump(lua_State *L)
+{
+    return (luab_core_dump(L, 1, NULL, 0));
+}
+
+/*
+ * Access functions.
+ */
+
+/***
+ * Set budget in bytes, exceeding entries are evicted.
+ *
+ * @function set_budget
+ *
+ * @param budget            Upper bound for bytes held by cache.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = cache:set_budget(budget)
+ */
+static int
+DBCACHE_set_budget(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dbcache_t *self;
+    size_t x;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(DBCACHE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_dbcache_t *);
+    x = luab_checksize(L, 2);
+
+    self->ud_budget = x;
+    dbcache_evict(self, 0);
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Get budget in bytes.
+ *
+ * @function get_budget
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = cache:get_budget()
+ */
+static int
+DBCACHE_get_budget(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dbcache_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DBCACHE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_dbcache_t *);
+
+    return (luab_pushxinteger(L, self->ud_budget));
+}
+
+/***
+ * Get amount of bytes held by cache.
+ *
+ * @function get_bytes
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = cache:get_bytes()
+ */
+static int
+DBCACHE_get_bytes(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dbcache_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DBCACHE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_dbcache_t *);
+
+    return (luab_pushxinteger(L, self->ud_bytes));
+}
+
+/***
+ * Get counters.
+ *
+ * @function get_stats
+ *
+ * @return (LUA_TNUMBER, LUA_TNUMBER, LUA_TNUMBER)
+ *
+ * @usage hits, misses, evictions = cache:get_stats()
+ */
+static int
+DBCACHE_get_stats(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dbcache_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DBCACHE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_dbcache_t *);
+
+    lua_pushinteger(L, (lua_Integer)self->ud_hits);
+    lua_pushinteger(L, (lua_Integer)self->ud_misses);
+    lua_pushinteger(L, (lua_Integer)self->ud_evictions);
+
+    return (3);
+}
+
+/*
+ * Database access methods.
+ */
+
+/***
+ * Keyed retrieval, either from cache or from the db(3).
+ *
+ * @function get
+ *
+ * @param key               Key, (LUA_TSTRING).
+ *
+ * @return (LUA_T{NIL,STRING} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          Data, or (LUA_TNIL), if key was not found.
+ *
+ * @usage data [, err, msg ] = cache:get(key)
+ */
+static int
+DBCACHE_get(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dbcache_t *self;
+    dbcache_ent_t *ce;
+    DB *db;
+    DBT k, v;
+    uint32_t hv;
+    int status;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(DBCACHE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_dbcache_t *);
+
+    dbcache_checkkey(L, 2, &k);
+    hv = dbcache_hash(k.data, k.size);
+
+    if ((ce = dbcache_lookup(self, k.data, k.size, hv)) != NULL) {
+        TAILQ_REMOVE(&self->ud_lru, ce, ce_lru);
+        TAILQ_INSERT_HEAD(&self->ud_lru, ce, ce_lru);
+
+        self->ud_hits++;
+
+        lua_pushlstring(L, (caddr_t)ce->ce_data + ce->ce_ksize,
+            ce->ce_vsize);
+        return (1);
+    }
+    self->ud_misses++;
+
+    if ((db = dbcache_db(L, 1)) == NULL)
+        return (luab_pushnil(L));
+
+    if ((status = (*db->get)(db, &k, &v, 0)) != 0) {
+
+        if (status > 0) {
+            lua_pushnil(L);
+            return (1);
+        }
+        return (luab_pushnil(L));
+    }
+    lua_pushlstring(L, v.data, v.size);
+
+    dbcache_insert(self, &k, &v, hv);
+
+    return (1);
+}
+
+/***
+ * Store key/data pair in the db(3), then in cache.
+ *
+ * @function put
+ *
+ * @param key               Key, (LUA_TSTRING).
+ * @param data              Data, (LUA_TSTRING).
+ * @param flags             May be set from
+ *
+ *                              bsd.db.R_{CURSOR,I{AFTER,BEFORE},
+ *                                  NOOVERWRITE,SETCURSOR}
+ *
+ *                          as possible value, optional.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage ret [, err, msg ] = cache:put(key, data [, flags ])
+ */
+static int
+DBCACHE_put(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dbcache_t *self;
+    dbcache_ent_t *ce;
+    DB *db;
+    DBT k, v;
+    uint32_t hv;
+    u_int flags;
+    int status;
+
+    (void)luab_core_checkmaxargs(L, 4);
+
+    m = luab_xmod(DBCACHE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_dbcache_t *);
+
+    dbcache_checkkey(L, 2, &k);
+    dbcache_checkkey(L, 3, &v);
+    flags = lua_isnoneornil(L, 4) ? 0 : luab_checkuint(L, 4);
+
+    if ((db = dbcache_db(L, 1)) != NULL) {
+
+        if ((status = (*db->put)(db, &k, &v, flags)) == 0) {
+            hv = dbcache_hash(k.data, k.size);
+
+            if ((flags == 0) && (self->ud_dup != 0)) {
+
+                if ((ce = dbcache_lookup(self, k.data, k.size, hv)) != NULL)
+                    dbcache_remove(self, ce);
+            } else if ((flags == 0) || (flags == R_NOOVERWRITE))
+                dbcache_insert(self, &k, &v, hv);
+            else
+                dbcache_flush(self);
+        }
+    } else
+        status = luab_env_error;
+
+    return (luab_pushxinteger(L, status));
+}
+
+/***
+ * Remove key/data pair from the db(3) and from cache.
+ *
+ * @function del
+ *
+ * @param key               Key, (LUA_TSTRING).
+ * @param flags             May be set
+ *
+ *                              bsd.db.R_CURSOR or 0
+ *
+ *                          as possible value, optional.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage ret [, err, msg ] = cache:del(key [, flags ])
+ */
+static int
+DBCACHE_del(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dbcache_t *self;
+    dbcache_ent_t *ce;
+    DB *db;
+    DBT k;
+    u_int flags;
+    int status;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m = luab_xmod(DBCACHE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_dbcache_t *);
+
+    dbcache_checkkey(L, 2, &k);
+    flags = lua_isnoneornil(L, 3) ? 0 : luab_checkuint(L, 3);
+
+    if ((db = dbcache_db(L, 1)) != NULL) {
+
+        if ((status = (*db->del)(db, &k, flags)) == 0) {
+
+            if ((flags != 0) || (self->ud_type == DB_RECNO))
+                dbcache_flush(self);
+            else if ((ce = dbcache_lookup(self, k.data, k.size,
+                dbcache_hash(k.data, k.size))) != NULL)
+                dbcache_remove(self, ce);
+        }
+    } else
+        status = luab_env_error;
+
+    return (luab_pushxinteger(L, status));
+}
+
+/***
+ * Drop cached copy of key, or all cached copies.
+ *
+ * @function invalidate
+ *
+ * @param key               Key, (LUA_T{NIL,STRING}), optional.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage ret [, err, msg ] = cache:invalidate([ key ])
+ */
+static int
+DBCACHE_invalidate(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dbcache_t *self;
+    dbcache_ent_t *ce;
+    DBT k;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(DBCACHE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_dbcache_t *);
+
+    if (lua_isnoneornil(L, 2) == 0) {
+        dbcache_checkkey(L, 2, &k);
+
+        if ((ce = dbcache_lookup(self, k.data, k.size,
+            dbcache_hash(k.data, k.size))) != NULL)
+            dbcache_remove(self, ce);
+    } else
+        dbcache_flush(self);
+
+    return (luab_pushxinteger(L, luab_env_success));
+}
+
+/*
+ * Metamethods.
+ */
+
+static int
+DBCACHE_gc(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dbcache_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DBCACHE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_dbcache_t *);
+
+    if (self->ud_hash != NULL) {
+        dbcache_flush(self);
+
+        luab_core_free(self->ud_hash,
+            self->ud_nbuckets * sizeof(struct dbcache_bucket));
+        self->ud_hash = NULL;
+    }
+    return (luab_core_gc(L, 1, m));
+}
+
+static int
+DBCACHE_len(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(DBCACHE, TYPE, __func__);
+    return (luab_core_len(L, 2, m));
+}
+
+static int
+DBCACHE_tostring(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(DBCACHE, TYPE, __func__);
+    return (luab_core_tostring(L, 1, m));
+}
+
+/*
+ * Internal interface.
+ */
+
+static luab_module_table_t dbcache_methods[] = {
+    LUAB_FUNC("get",            DBCACHE_get),
+    LUAB_FUNC("put",            DBCACHE_put),
+    LUAB_FUNC("del",            DBCACHE_del),
+    LUAB_FUNC("invalidate",     DBCACHE_invalidate),
+    LUAB_FUNC("set_budget",     DBCACHE_set_budget),
+    LUAB_FUNC("get_budget",     DBCACHE_get_budget),
+    LUAB_FUNC("get_bytes",      DBCACHE_get_bytes),
+    LUAB_FUNC("get_stats",      DBCACHE_get_stats),
+    LUAB_FUNC("get_table",      DBCACHE_get_table),
+    LUAB_FUNC("dump",           DBCACHE_dump),
+    LUAB_FUNC("__gc",           DBCACHE_gc),
+    LUAB_FUNC("__len",          DBCACHE_len),
+    LUAB_FUNC("__tostring",     DBCACHE_tostring),
+    LUAB_MOD_TBL_SENTINEL
+};
+
+static void *
+dbcache_create(lua_State *L, void *arg)
+{
+    luab_module_t *m;
+    luab_dbcache_param_t *dbcp;
+    luab_dbcache_t dc, *self;
+
+    m = luab_xmod(DBCACHE, TYPE, __func__);
+
+    if ((dbcp = (luab_dbcache_param_t *)arg) == NULL) {
+        errno = EINVAL;
+        return (NULL);
+    }
+    (void)memset(&dc, 0, sizeof(dc));
+
+    dc.ud_type = dbcp->dbcp_type;
+    dc.ud_dup = dbcp->dbcp_dup;
+    dc.ud_budget = dbcp->dbcp_budget;
+    dc.ud_nbuckets = LUAB_DBCACHE_NBUCKETS;
+
+    if ((dc.ud_hash = luab_core_alloc(dc.ud_nbuckets,
+        sizeof(struct dbcache_bucket))) == NULL)
+        return (NULL);
+
+    if ((self = luab_newuserdata(L, m, &dc)) != NULL) {
+        lua_createtable(L, 1, 0);
+        lua_pushvalue(L, dbcp->dbcp_narg);
+        lua_rawseti(L, -2, 1);
+        lua_setuservalue(L, -2);
+    } else
+        luab_core_free(dc.ud_hash,
+            dc.ud_nbuckets * sizeof(struct dbcache_bucket));
+
+    return (self);
+}
+
+static void
+dbcache_init(void *ud, void *arg)
+{
+    luab_dbcache_t *self, *dc;
+
+    if (((self = (luab_dbcache_t *)ud) != NULL) &&
+        ((dc = (luab_dbcache_t *)arg) != NULL)) {
+        self->ud_type = dc->ud_type;
+        self->ud_dup = dc->ud_dup;
+        self->ud_hash = dc->ud_hash;
+        self->ud_nbuckets = dc->ud_nbuckets;
+        self->ud_budget = dc->ud_budget;
+
+        TAILQ_INIT(&self->ud_lru);
+    }
+}
+
+static void *
+dbcache_udata(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    m = luab_xmod(DBCACHE, TYPE, __func__);
+    return (luab_todata(L, narg, m, luab_dbcache_t *));
+}
+
+luab_module_t luab_dbcache_type = {
+    .m_id           = LUAB_DBCACHE_TYPE_ID,
+    .m_name         = LUAB_DBCACHE_TYPE,
+    .m_vec          = dbcache_methods,
+    .m_create       = dbcache_create,
+    .m_init         = dbcache_init,
+    .m_get          = dbcache_udata,
+    .m_len          = sizeof(luab_dbcache_t),
+    .m_sz           = sizeof(luab_dbcache_param_t),
+};
+#endif /* __BSD_VISIBLE */
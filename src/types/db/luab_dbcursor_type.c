@@ -0,0 +1,806 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+
+#include <db.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+#include "luab_table.h"
+
+#if __BSD_VISIBLE
+extern luab_module_t luab_dbcursor_type;
+
+/*
+ * Interface against
+ *
+ *  typedef struct luab_dbcursor {
+ *      luab_udata_t    ud_softc;
+ *      DBTYPE          ud_type;
+ *      u_int           ud_flags;
+ *      size_t          ud_card;
+ *      DBT             ud_lower;
+ *      DBT             ud_upper;
+ *      DBT             ud_last;
+ *      size_t          ud_last_max;
+ *      size_t          ud_ndup;
+ *      caddr_t         ud_buf;
+ *      size_t          ud_len;
+ *      size_t          ud_max_len;
+ *      size_t          ud_off;
+ *      size_t          ud_nrec;
+ *  } luab_dbcursor_t;
+ *
+ * whereby up to ud_card key/data pairs are fetched ahead by DB->seq
+ * into ud_buf, each record is prefixed by the length of its key and
+ * its data. The DB is referenced by the uservalue of the cursor.
+ *
+ * On DB_BTREE the cursor repositions itself by R_CURSOR relative to
+ * the last key fetched, thus several cursors may be interleaved on the
+ * same DB. Since a DB_BTREE opened by R_DUP may hold duplicates, ud_ndup
+ * counts the records fetched by the last key, those are skipped exactly. Range scans are bound by [lower, upper) and are available
+ * on DB_BTREE only. Any other access method is scanned sequentially by
+ * the cursor of the DB itself.
+ */
+
+typedef struct luab_dbcursor {
+    luab_udata_t    ud_softc;
+    DBTYPE          ud_type;
+    u_int           ud_flags;
+    size_t          ud_card;
+    DBT             ud_lower;
+    DBT             ud_upper;
+    DBT             ud_last;
+    size_t          ud_last_max;
+    size_t          ud_ndup;
+    caddr_t         ud_buf;
+    size_t          ud_len;
+    size_t          ud_max_len;
+    size_t          ud_off;
+    size_t          ud_nrec;
+} luab_dbcursor_t;
+
+#define DBC_STARTED     0x0001
+#define DBC_EOF         0x0002
+#define DBC_REVERSE     0x0004
+#define DBC_LOWER       0x0008
+#define DBC_UPPER       0x0010
+
+#define LUAB_DBCURSOR_CARD  64
+
+/*
+ * Subr.
+ */
+
+static void
+dbcursor_free(luab_dbcursor_t *self)
+{
+    if (self->ud_lower.data != NULL)
+        luab_core_free(self->ud_lower.data, self->ud_lower.size);
+
+    if (self->ud_upper.data != NULL)
+        luab_core_free(self->ud_upper.data, self->ud_upper.size);
+
+    if (self->ud_last.data != NULL)
+        luab_core_free(self->ud_last.data, self->ud_last_max);
+
+    if (self->ud_buf != NULL)
+        luab_core_free(self->ud_buf, self->ud_max_len);
+
+    (void)memset(&self->ud_lower, 0, sizeof(DBT));
+    (void)memset(&self->ud_upper, 0, sizeof(DBT));
+    (void)memset(&self->ud_last, 0, sizeof(DBT));
+
+    self->ud_last_max = 0;
+    self->ud_ndup = 0;
+    self->ud_buf = NULL;
+    self->ud_len = 0;
+    self->ud_max_len = 0;
+    self->ud_off = 0;
+    self->ud_nrec = 0;
+}
+
+/*
+ * Same order as applied by the default comparison function of btree(3).
+ */
+static int
+dbcursor_cmp(const DBT *a, const DBT *b)
+{
+    size_t len;
+    int cmp;
+
+    len = (a->size < b->size) ? a->size : b->size;
+
+    if (len > 0 && (cmp = memcmp(a->data, b->data, len)) != 0)
+        return (cmp);
+
+    if (a->size < b->size)
+        return (-1);
+
+    return (a->size > b->size);
+}
+
+static int
+dbcursor_copy(DBT *dst, size_t *max_len, const DBT *src)
+{
+    caddr_t bp;
+
+    if (src->size > *max_len) {
+
+        if ((bp = luab_core_realloc(dst->data, src->size,
+            LUAB_ALLOC_NOZERO)) == NULL)
+            return (luab_env_error);
+
+        dst->data = bp;
+        *max_len = src->size;
+    }
+
+    if (src->size > 0)
+        (void)memmove(dst->data, src->data, src->size);
+
+    dst->size = src->size;
+
+    return (0);
+}
+
+static int
+dbcursor_append(luab_dbcursor_t *self, const DBT *k, const DBT *v)
+{
+    size_t hdr[2], len, max_len;
+    caddr_t bp;
+
+    len = sizeof(hdr) + k->size + v->size;
+
+    if ((self->ud_len + len) > self->ud_max_len) {
+
+        if ((max_len = self->ud_max_len) == 0)
+            max_len = luab_env_buf_max;
+
+        while (max_len < (self->ud_len + len))
+            max_len <<= 1;
+
+        if ((bp = luab_core_realloc(self->ud_buf, max_len,
+            LUAB_ALLOC_NOZERO)) == NULL)
+            return (luab_env_error);
+
+        self->ud_buf = bp;
+        self->ud_max_len = max_len;
+    }
+    bp = self->ud_buf + self->ud_len;
+
+    hdr[0] = k->size;
+    hdr[1] = v->size;
+
+    (void)memmove(bp, hdr, sizeof(hdr));
+    bp += sizeof(hdr);
+
+    if (k->size > 0)
+        (void)memmove(bp, k->data, k->size);
+
+    bp += k->size;
+
+    if (v->size > 0)
+        (void)memmove(bp, v->data, v->size);
+
+    self->ud_len += len;
+
+    return (0);
+}
+
+static int
+dbcursor_inrange(luab_dbcursor_t *self, const DBT *k)
+{
+    if (self->ud_flags & DBC_REVERSE) {
+
+        if ((self->ud_flags & DBC_LOWER) &&
+            (dbcursor_cmp(k, &self->ud_lower) < 0))
+            return (0);
+    } else {
+
+        if ((self->ud_flags & DBC_UPPER) &&
+            (dbcursor_cmp(k, &self->ud_upper) >= 0))
+            return (0);
+    }
+    return (1);
+}
+
+/*
+ * Position the cursor of the DB on the first record not yet fetched.
+ */
+static int
+dbcursor_seek(DB *db, luab_dbcursor_t *self, DBT *k, DBT *v)
+{
+    const DBT *bound;
+    size_t i;
+    u_int flags;
+    int status;
+
+    flags = self->ud_flags;
+
+    if (self->ud_type != DB_BTREE) {
+
+        if (flags & DBC_STARTED)
+            status = (*db->seq)(db, k, v,
+                (flags & DBC_REVERSE) ? R_PREV : R_NEXT);
+        else
+            status = (*db->seq)(db, k, v,
+                (flags & DBC_REVERSE) ? R_LAST : R_FIRST);
+
+        return (status);
+    }
+
+    if (flags & DBC_STARTED)
+        bound = &self->ud_last;
+    else if (flags & DBC_REVERSE)
+        bound = (flags & DBC_UPPER) ? &self->ud_upper : NULL;
+    else
+        bound = (flags & DBC_LOWER) ? &self->ud_lower : NULL;
+
+    if (bound == NULL)
+        return ((*db->seq)(db, k, v,
+            (flags & DBC_REVERSE) ? R_LAST : R_FIRST));
+
+    *k = *bound;
+
+    status = (*db->seq)(db, k, v, R_CURSOR);
+
+    if (flags & DBC_REVERSE) {
+
+        /*
+         * R_CURSOR yields the first duplicate of bound, those fetched
+         * before are the last ud_ndup ones, thus advance past them all
+         * and step back from the last one.
+         */
+        if ((flags & DBC_STARTED) && (status == 0) &&
+            (dbcursor_cmp(k, bound) == 0)) {
+
+            while (status == 0 && dbcursor_cmp(k, bound) == 0)
+                status = (*db->seq)(db, k, v, R_NEXT);
+
+            if (status == 0)
+                status = (*db->seq)(db, k, v, R_PREV);
+            else if (status == 1)
+                status = (*db->seq)(db, k, v, R_LAST);
+
+            for (i = 0; status == 0 && i < self->ud_ndup; i++)
+                status = (*db->seq)(db, k, v, R_PREV);
+
+            return (status);
+        }
+
+        if (status == 1)
+            status = (*db->seq)(db, k, v, R_LAST);
+
+        while (status == 0 && dbcursor_cmp(k, bound) >= 0)
+            status = (*db->seq)(db, k, v, R_PREV);
+    } else if (flags & DBC_STARTED) {
+
+        while (status == 0 && dbcursor_cmp(k, bound) < 0)
+            status = (*db->seq)(db, k, v, R_NEXT);
+
+        /* skip duplicates of bound fetched before */
+        for (i = 0; status == 0 && i < self->ud_ndup &&
+            dbcursor_cmp(k, bound) == 0; i++)
+            status = (*db->seq)(db, k, v, R_NEXT);
+    }
+    return (status);
+}
+
+static int
+dbcursor_fill(DB *db, luab_dbcursor_t *self)
+{
+    DBT k, v;
+    u_int step;
+    int status;
+
+    self->ud_len = 0;
+    self->ud_off = 0;
+    self->ud_nrec = 0;
+
+    if (self->ud_flags & DBC_EOF)
+        return (0);
+
+    step = (self->ud_flags & DBC_REVERSE) ? R_PREV : R_NEXT;
+
+    if ((status = dbcursor_seek(db, self, &k, &v)) < 0)
+        return (luab_env_error);
+
+    self->ud_flags |= DBC_STARTED;
+
+    while (status == 0) {
+
+        if (dbcursor_inrange(self, &k) == 0)
+            break;
+
+        if (dbcursor_append(self, &k, &v) != 0)
+            return (luab_env_error);
+
+        if ((self->ud_ndup > 0) &&
+            (dbcursor_cmp(&k, &self->ud_last) == 0))
+            self->ud_ndup++;
+        else {
+            if (dbcursor_copy(&self->ud_last, &self->ud_last_max, &k) != 0)
+                return (luab_env_error);
+
+            self->ud_ndup = 1;
+        }
+
+        if (++self->ud_nrec == self->ud_card)
+            return (0);
+
+        status = (*db->seq)(db, &k, &v, step);
+    }
+
+    if (status < 0)
+        return (luab_env_error);
+
+    self->ud_flags |= DBC_EOF;
+
+    return (0);
+}
+
+static DB *
+dbcursor_db(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    DB *db;
+
+    m = luab_xmod(DB, TYPE, __func__);
+
+    lua_getuservalue(L, narg);
+    lua_rawgeti(L, -1, 1);
+
+    db = luab_udata(L, -1, m, DB *);
+
+    lua_pop(L, 2);
+
+    return (db);
+}
+
+/*
+ * Pushes key and data of the next record, returns 0 when exhausted.
+ */
+static int
+dbcursor_pushnext(lua_State *L, int narg, luab_dbcursor_t *self)
+{
+    size_t hdr[2];
+    caddr_t bp;
+    DB *db;
+
+    if (self->ud_off >= self->ud_len) {
+
+        if ((db = dbcursor_db(L, narg)) == NULL)
+            return (luab_env_error);
+
+        if (dbcursor_fill(db, self) != 0)
+            return (luab_env_error);
+
+        if (self->ud_len == 0)
+            return (0);
+    }
+    bp = self->ud_buf + self->ud_off;
+
+    (void)memmove(hdr, bp, sizeof(hdr));
+    bp += sizeof(hdr);
+
+    lua_pushlstring(L, bp, hdr[0]);
+    bp += hdr[0];
+
+    lua_pushlstring(L, bp, hdr[1]);
+
+    self->ud_off += sizeof(hdr) + hdr[0] + hdr[1];
+
+    return (2);
+}
+
+static void
+dbcursor_fillxtable(lua_State *L, int narg, void *arg)
+{
+    luab_dbcursor_t *self;
+
+    if ((self = (luab_dbcursor_t *)arg) != NULL) {
+
+        luab_setinteger(L, narg, "type",        self->ud_type);
+        luab_setinteger(L, narg, "card",        self->ud_card);
+        luab_setinteger(L, narg, "reverse",
+            (self->ud_flags & DBC_REVERSE) != 0);
+        luab_setinteger(L, narg, "eof",
+            (self->ud_flags & DBC_EOF) != 0 &&
+            (self->ud_off >= self->ud_len));
+
+        if (self->ud_flags & DBC_LOWER)
+            luab_setldata(L, narg, "lower",
+                self->ud_lower.data, self->ud_lower.size);
+
+        if (self->ud_flags & DBC_UPPER)
+            luab_setldata(L, narg, "upper",
+                self->ud_upper.data, self->ud_upper.size);
+    } else
+        luab_core_err(EX_DATAERR, __func__, EINVAL);
+}
+
+/*
+ * Generator functions.
+ */
+
+/***
+ * Generator function - translate (LUA_TUSERDATA(DBCURSOR)) into (LUA_TTABLE).
+ *
+ * @function get_table
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              type        = (LUA_TNUMBER),
+ *              card        = (LUA_TNUMBER),
+ *              reverse     = (LUA_TNUMBER),
+ *              eof         = (LUA_TNUMBER),
+ *              lower       = (LUA_T{NIL,STRING}),
+ *              upper       = (LUA_T{NIL,STRING}),
+ *          }
+ *
+ * @usage t [, err, msg ] = cursor:get_table()
+ */
+static int
+DBCURSOR_get_table(lua_State *L)
+{
+    luab_module_t *m;
+    luab_xtable_param_t xtp;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DBCURSOR, TYPE, __func__);
+
+    xtp.xtp_fill = dbcursor_fillxtable;
+    xtp.xtp_arg = luab_todata(L, 1, m, void *);
+    xtp.xtp_new = 1;
+    xtp.xtp_k = NULL;
+
+    return (luab_table_pushxtable(L, -2, &xtp));
+}
+
+/***
+ * Generator function - returns (LUA_TNIL).
+ *
+ * @function dump
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage iovec [, err, msg ] = cursor:dump()
+ */
+static int
+DBCURSOR_dump(lua_State *L)
+{
+    return (luab_core_dump(L, 1, NULL, 0));
+}
+
+/*
+ * Access functions.
+ */
+
+/***
+ * Fetch next key/data pair.
+ *
+ * @function next
+ *
+ * @return (LUA_T{NIL,STRING}, LUA_T{NIL,STRING} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          (key, data) or (nil) when exhausted or
+ *          (nil, (errno, strerror(errno)))
+ *
+ * @usage key, data [, err, msg ] = cursor:next()
+ */
+static int
+DBCURSOR_next(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dbcursor_t *self;
+    int status;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DBCURSOR, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_dbcursor_t *);
+
+    if ((status = dbcursor_pushnext(L, 1, self)) == 0) {
+        lua_pushnil(L);
+        status = 1;
+    } else if (status < 0)
+        status = luab_pushnil(L);
+
+    return (status);
+}
+
+/***
+ * Rewind the cursor, the next fetch starts at beginning of its range.
+ *
+ * @function reset
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage ret [, err, msg ] = cursor:reset()
+ */
+static int
+DBCURSOR_reset(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dbcursor_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DBCURSOR, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_dbcursor_t *);
+
+    self->ud_flags &= ~(DBC_STARTED|DBC_EOF);
+    self->ud_ndup = 0;
+    self->ud_len = 0;
+    self->ud_off = 0;
+    self->ud_nrec = 0;
+
+    return (luab_pushxinteger(L, 0));
+}
+
+/***
+ * Get number of records fetched ahead.
+ *
+ * @function card
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage card [, err, msg ] = cursor:card()
+ */
+static int
+DBCURSOR_card(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dbcursor_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DBCURSOR, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_dbcursor_t *);
+
+    return (luab_pushxinteger(L, self->ud_card));
+}
+
+/*
+ * Metamethods.
+ */
+
+/*
+ * Iterator, e. g.
+ *
+ *  for k, v in db:cursor(lower, upper) do ... end
+ *
+ * Errors are raised, because (nil) terminates the loop.
+ */
+static int
+DBCURSOR_call(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dbcursor_t *self;
+    int status;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m = luab_xmod(DBCURSOR, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_dbcursor_t *);
+
+    if ((status = dbcursor_pushnext(L, 1, self)) < 0)
+        return (luaL_error(L, "%s: %s", __func__, strerror(errno)));
+
+    if (status == 0) {
+        lua_pushnil(L);
+        status = 1;
+    }
+    return (status);
+}
+
+static int
+DBCURSOR_gc(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dbcursor_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DBCURSOR, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_dbcursor_t *);
+
+    dbcursor_free(self);
+
+    return (luab_core_gc(L, 1, m));
+}
+
+static int
+DBCURSOR_len(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(DBCURSOR, TYPE, __func__);
+    return (luab_core_len(L, 2, m));
+}
+
+static int
+DBCURSOR_tostring(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(DBCURSOR, TYPE, __func__);
+    return (luab_core_tostring(L, 1, m));
+}
+
+/*
+ * Internal interface.
+ */
+
+static luab_module_table_t dbcursor_methods[] = {
+    LUAB_FUNC("next",           DBCURSOR_next),
+    LUAB_FUNC("reset",          DBCURSOR_reset),
+    LUAB_FUNC("card",           DBCURSOR_card),
+    LUAB_FUNC("get_table",      DBCURSOR_get_table),
+    LUAB_FUNC("dump",           DBCURSOR_dump),
+    LUAB_FUNC("__call",         DBCURSOR_call),
+    LUAB_FUNC("__gc",           DBCURSOR_gc),
+    LUAB_FUNC("__len",          DBCURSOR_len),
+    LUAB_FUNC("__tostring",     DBCURSOR_tostring),
+    LUAB_MOD_TBL_SENTINEL
+};
+
+static void *
+dbcursor_create(lua_State *L, void *arg)
+{
+    luab_module_t *m;
+    luab_dbcursor_param_t *dcp;
+    luab_dbcursor_t dc, *self;
+    u_char *bp;
+    size_t len;
+
+    m = luab_xmod(DBCURSOR, TYPE, __func__);
+
+    if ((dcp = (luab_dbcursor_param_t *)arg) == NULL) {
+        errno = EINVAL;
+        return (NULL);
+    }
+
+    if ((dcp->dcp_type != DB_BTREE) &&
+        (dcp->dcp_lower.data != NULL || dcp->dcp_upper.data != NULL)) {
+        errno = EINVAL;
+        return (NULL);
+    }
+    (void)memset(&dc, 0, sizeof(dc));
+
+    dc.ud_type = dcp->dcp_type;
+    dc.ud_card = (dcp->dcp_card > 0) ? dcp->dcp_card : LUAB_DBCURSOR_CARD;
+
+    if (dcp->dcp_reverse != 0)
+        dc.ud_flags |= DBC_REVERSE;
+
+    if (dcp->dcp_lower.data != NULL) {
+
+        if ((len = dcp->dcp_lower.size) > 0) {
+
+            if ((dc.ud_lower.data = luab_core_alloc(len,
+                sizeof(char))) == NULL)
+                goto bad;
+
+            (void)memmove(dc.ud_lower.data, dcp->dcp_lower.data, len);
+            dc.ud_lower.size = len;
+        }
+        dc.ud_flags |= DBC_LOWER;
+
+        /*
+         * The upper bound of a prefix is its successor, that is the
+         * prefix with trailing 0xff stripped and its last byte
+         * incremented. There is none, if the prefix consists of 0xff.
+         */
+        if (dcp->dcp_prefix != 0) {
+            bp = dcp->dcp_lower.data;
+
+            while (len > 0 && bp[len - 1] == 0xff)
+                len--;
+
+            if (len > 0) {
+
+                if ((dc.ud_upper.data = luab_core_alloc(len,
+                    sizeof(char))) == NULL)
+                    goto bad;
+
+                (void)memmove(dc.ud_upper.data, bp, len);
+                ((u_char *)dc.ud_upper.data)[len - 1]++;
+
+                dc.ud_upper.size = len;
+                dc.ud_flags |= DBC_UPPER;
+            }
+        }
+    }
+
+    if (dcp->dcp_prefix == 0 && dcp->dcp_upper.data != NULL) {
+
+        if ((len = dcp->dcp_upper.size) > 0) {
+
+            if ((dc.ud_upper.data = luab_core_alloc(len,
+                sizeof(char))) == NULL)
+                goto bad;
+
+            (void)memmove(dc.ud_upper.data, dcp->dcp_upper.data, len);
+            dc.ud_upper.size = len;
+        }
+        dc.ud_flags |= DBC_UPPER;
+    }
+
+    if ((self = luab_newuserdata(L, m, &dc)) != NULL) {
+        lua_createtable(L, 1, 0);
+        lua_pushvalue(L, dcp->dcp_narg);
+        lua_rawseti(L, -2, 1);
+        lua_setuservalue(L, -2);
+        return (self);
+    }
+bad:
+    dbcursor_free(&dc);
+    return (NULL);
+}
+
+static void
+dbcursor_init(void *ud, void *arg)
+{
+    luab_dbcursor_t *self, *dc;
+
+    if (((self = (luab_dbcursor_t *)ud) != NULL) &&
+        ((dc = (luab_dbcursor_t *)arg) != NULL)) {
+        self->ud_type = dc->ud_type;
+        self->ud_flags = dc->ud_flags;
+        self->ud_card = dc->ud_card;
+        self->ud_lower = dc->ud_lower;
+        self->ud_upper = dc->ud_upper;
+    }
+}
+
+static void *
+dbcursor_udata(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    m = luab_xmod(DBCURSOR, TYPE, __func__);
+    return (luab_todata(L, narg, m, luab_dbcursor_t *));
+}
+
+luab_module_t luab_dbcursor_type = {
+    .m_id           = LUAB_DBCURSOR_TYPE_ID,
+    .m_name         = LUAB_DBCURSOR_TYPE,
+    .m_vec          = dbcursor_methods,
+    .m_create       = dbcursor_create,
+    .m_init         = dbcursor_init,
+    .m_get          = dbcursor_udata,
+    .m_len          = sizeof(luab_dbcursor_t),
+    .m_sz           = sizeof(DBT),
+};
+#endif /* __BSD_VISIBLE */
@@ -0,0 +1,912 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+
+#include <db.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+#include "luab_table.h"
+
+#if __BSD_VISIBLE
+extern luab_module_t luab_dbloader_type;
+
+/*
+ * Interface against
+ *
+ *  typedef struct luab_dbloader {
+ *      luab_udata_t    ud_softc;
+ *      size_t          ud_budget;
+ *      caddr_t         ud_buf;
+ *      size_t          ud_len;
+ *      size_t          ud_size;
+ *      size_t          *ud_idx;
+ *      size_t          ud_nrec;
+ *      size_t          ud_nidx;
+ *      dbloader_run_t  *ud_runs;
+ *      size_t          ud_nruns;
+ *      size_t          ud_nput;
+ *  } luab_dbloader_t;
+ *
+ * whereby key/data pairs are appended to ud_buf, each record prefixed
+ * by the size of its key and its data. Once ud_budget is exceeded, the
+ * records are sorted and spilled as run into a file created by tmpfile(3).
+ * Once DBLOADER_FANIN runs of the same level were spilled, those are
+ * merged into one run of the next level, thus the number of open files
+ * grows by the logarithm of the number of spilled records only. On
+ * finish, the runs and the records in memory are merged by a binary
+ * heap and stored in ascending order of their keys into the DB_BTREE,
+ * which is referenced by the uservalue of the loader.
+ *
+ * Keys are ordered as by the default comparison function of btree(3).
+ * Records with equal keys are stored in the order they were added, thus
+ * the last one wins, unless R_DUP was set by BTREEINFO.
+ */
+
+typedef struct dbloader_hdr {
+    uint32_t        dh_ksize;
+    uint32_t        dh_vsize;
+} dbloader_hdr_t;
+
+typedef struct dbloader_run {
+    FILE            *dr_fp;
+    size_t          dr_level;   /* number of merges */
+} dbloader_run_t;
+
+typedef struct dbloader_src {
+    FILE            *ds_fp;     /* NULL, if records are in memory */
+    caddr_t         ds_rec;     /* current record, NULL on EOF */
+    caddr_t         ds_buf;
+    size_t          ds_size;
+    caddr_t         *ds_vec;
+    size_t          ds_card;
+    size_t          ds_off;
+} dbloader_src_t;
+
+typedef struct luab_dbloader {
+    luab_udata_t    ud_softc;
+    size_t          ud_budget;
+    caddr_t         ud_buf;
+    size_t          ud_len;
+    size_t          ud_size;
+    size_t          *ud_idx;
+    size_t          ud_nrec;
+    size_t          ud_nidx;
+    dbloader_run_t  *ud_runs;
+    size_t          ud_nruns;
+    size_t          ud_nput;
+} luab_dbloader_t;
+
+#define DBLOADER_BUFSIZE    (64 * 1024)
+#define DBLOADER_FANIN      8
+
+#define dbloader_recsz(bp) \
+    (sizeof(dbloader_hdr_t) + ((dbloader_hdr_t *)(bp))->dh_ksize + \
+        ((dbloader_hdr_t *)(bp))->dh_vsize)
+
+/*
+ * Subr.
+ */
+
+static int
+dbloader_keycmp(caddr_t x, caddr_t y)
+{
+    dbloader_hdr_t hx, hy;
+    size_t len;
+    int status;
+
+    (void)memmove(&hx, x, sizeof(hx));
+    (void)memmove(&hy, y, sizeof(hy));
+
+    len = (hx.dh_ksize < hy.dh_ksize) ? hx.dh_ksize : hy.dh_ksize;
+
+    if ((status = memcmp(x + sizeof(hx), y + sizeof(hy), len)) == 0)
+        status = (hx.dh_ksize > hy.dh_ksize) - (hx.dh_ksize < hy.dh_ksize);
+
+    return (status);
+}
+
+/*
+ * Records are ordered by their address, if keys are equal. Those
+ * were appended in that order to ud_buf, thus sorting is stable.
+ */
+static int
+dbloader_cmp(const void *a, const void *b)
+{
+    caddr_t x, y;
+    int status;
+
+    x = *(caddr_t const *)a;
+    y = *(caddr_t const *)b;
+
+    if ((status = dbloader_keycmp(x, y)) == 0)
+        status = (x > y) - (x < y);
+
+    return (status);
+}
+
+static caddr_t *
+dbloader_sort(luab_dbloader_t *self)
+{
+    caddr_t *vec;
+    size_t i;
+
+    if ((vec = luab_core_alloc(self->ud_nrec, sizeof(caddr_t))) != NULL) {
+
+        for (i = 0; i < self->ud_nrec; i++)
+            vec[i] = self->ud_buf + self->ud_idx[i];
+
+        qsort(vec, self->ud_nrec, sizeof(caddr_t), dbloader_cmp);
+    }
+    return (vec);
+}
+
+static void
+dbloader_reset(luab_dbloader_t *self)
+{
+    self->ud_len = 0;
+    self->ud_nrec = 0;
+}
+
+static void
+dbloader_free(luab_dbloader_t *self)
+{
+    size_t i;
+
+    if (self->ud_runs != NULL) {
+
+        for (i = 0; i < self->ud_nruns; i++)
+            (void)fclose(self->ud_runs[i].dr_fp);
+
+        luab_core_free(self->ud_runs,
+            self->ud_nruns * sizeof(dbloader_run_t));
+
+        self->ud_runs = NULL;
+        self->ud_nruns = 0;
+    }
+
+    if (self->ud_idx != NULL) {
+        luab_core_free(self->ud_idx, self->ud_nidx * sizeof(size_t));
+        self->ud_idx = NULL;
+        self->ud_nidx = 0;
+    }
+
+    if (self->ud_buf != NULL) {
+        luab_core_free(self->ud_buf, self->ud_size);
+        self->ud_buf = NULL;
+        self->ud_size = 0;
+    }
+    dbloader_reset(self);
+}
+
+/*
+ * Advances source onto its next record.
+ */
+static int
+dbloader_next(dbloader_src_t *src)
+{
+    dbloader_hdr_t hdr;
+    size_t len;
+    caddr_t bp;
+
+    if (src->ds_fp == NULL) {
+
+        if (src->ds_off < src->ds_card)
+            src->ds_rec = src->ds_vec[src->ds_off++];
+        else
+            src->ds_rec = NULL;
+
+        return (luab_env_success);
+    }
+
+    if (fread(&hdr, sizeof(hdr), 1, src->ds_fp) != 1) {
+        src->ds_rec = NULL;
+        return (ferror(src->ds_fp) ? luab_env_error : luab_env_success);
+    }
+    len = sizeof(hdr) + hdr.dh_ksize + hdr.dh_vsize;
+
+    if (len > src->ds_size) {
+
+        if ((bp = luab_core_realloc(src->ds_buf, len,
+            LUAB_ALLOC_NOZERO)) == NULL)
+            return (luab_env_error);
+
+        src->ds_buf = bp;
+        src->ds_size = len;
+    }
+    (void)memmove(src->ds_buf, &hdr, sizeof(hdr));
+
+    if ((len > sizeof(hdr)) && (fread(src->ds_buf + sizeof(hdr),
+        len - sizeof(hdr), 1, src->ds_fp) != 1)) {
+        errno = EIO;
+        return (luab_env_error);
+    }
+    src->ds_rec = src->ds_buf;
+
+    return (luab_env_success);
+}
+
+/*
+ * Sources are kept by a binary heap, ordered by their current record
+ * and by their age, if keys are equal.
+ */
+static int
+dbloader_srccmp(dbloader_src_t *src, size_t i, size_t j)
+{
+    int status;
+
+    if ((status = dbloader_keycmp(src[i].ds_rec, src[j].ds_rec)) == 0)
+        status = (i > j) - (i < j);
+
+    return (status);
+}
+
+static void
+dbloader_sift(dbloader_src_t *src, size_t *heap, size_t card, size_t i)
+{
+    size_t j, x;
+
+    for (x = heap[i]; (j = 2 * i + 1) < card; i = j) {
+
+        if (j + 1 < card && dbloader_srccmp(src, heap[j + 1], heap[j]) < 0)
+            j++;
+
+        if (dbloader_srccmp(src, heap[j], x) >= 0)
+            break;
+
+        heap[i] = heap[j];
+    }
+    heap[i] = x;
+}
+
+/*
+ * Merges n sources, ordered by age, either into db or as run into fp.
+ * On equal keys the older record is stored first. Runs are rewound,
+ * thus a failed merge may be repeated.
+ */
+static ssize_t
+dbloader_kmerge(dbloader_src_t *src, size_t n, DB *db, FILE *fp)
+{
+    dbloader_hdr_t hdr;
+    size_t *heap, card, i;
+    ssize_t count;
+    DBT k, v;
+
+    if ((heap = luab_core_alloc(n, sizeof(size_t))) == NULL)
+        return (luab_env_error);
+
+    for (i = 0, card = 0, count = 0; i < n; i++) {
+
+        if ((src[i].ds_fp != NULL &&
+            fseeko(src[i].ds_fp, 0, SEEK_SET) != 0) ||
+            dbloader_next(&src[i]) != 0) {
+            count = luab_env_error;
+            break;
+        }
+
+        if (src[i].ds_rec != NULL)
+            heap[card++] = i;
+    }
+
+    for (i = card / 2; count == 0 && i-- > 0; )
+        dbloader_sift(src, heap, card, i);
+
+    while (count >= 0 && card > 0) {
+        i = heap[0];
+
+        if (db != NULL) {
+            (void)memmove(&hdr, src[i].ds_rec, sizeof(hdr));
+
+            k.data = src[i].ds_rec + sizeof(hdr);
+            k.size = hdr.dh_ksize;
+            v.data = (caddr_t)k.data + k.size;
+            v.size = hdr.dh_vsize;
+
+            if ((*db->put)(db, &k, &v, 0) != 0) {
+                count = luab_env_error;
+                break;
+            }
+        } else if (fwrite(src[i].ds_rec, dbloader_recsz(src[i].ds_rec),
+            1, fp) != 1) {
+            count = luab_env_error;
+            break;
+        }
+        count++;
+
+        if (dbloader_next(&src[i]) != 0) {
+            count = luab_env_error;
+            break;
+        }
+
+        if (src[i].ds_rec == NULL)
+            heap[0] = heap[--card];
+
+        if (card > 0)
+            dbloader_sift(src, heap, card, 0);
+    }
+    luab_core_free(heap, n * sizeof(size_t));
+
+    for (i = 0; i < n; i++) {
+
+        if (src[i].ds_buf != NULL)
+            luab_core_free(src[i].ds_buf, src[i].ds_size);
+
+        src[i].ds_buf = NULL;
+        src[i].ds_size = 0;
+    }
+    return (count);
+}
+
+/*
+ * Merges the youngest DBLOADER_FANIN runs into one, while those are
+ * of the same level. Levels do not increase by age, thus it suffices
+ * to compare the levels of the first and of the last of those.
+ */
+static int
+dbloader_compact(luab_dbloader_t *self)
+{
+    dbloader_src_t src[DBLOADER_FANIN];
+    dbloader_run_t *runs;
+    FILE *fp;
+    size_t i;
+    int status;
+
+    for (status = 0; self->ud_nruns >= DBLOADER_FANIN; ) {
+        runs = self->ud_runs + self->ud_nruns - DBLOADER_FANIN;
+
+        if (runs[0].dr_level != runs[DBLOADER_FANIN - 1].dr_level)
+            break;
+
+        if ((fp = tmpfile()) == NULL) {
+            status = luab_env_error;
+            break;
+        }
+        (void)memset(src, 0, sizeof(src));
+
+        for (i = 0; i < DBLOADER_FANIN; i++)
+            src[i].ds_fp = runs[i].dr_fp;
+
+        if (dbloader_kmerge(src, DBLOADER_FANIN, NULL, fp) < 0 ||
+            fflush(fp) != 0) {
+            (void)fclose(fp);
+            status = luab_env_error;
+            break;
+        }
+
+        for (i = 0; i < DBLOADER_FANIN; i++)
+            (void)fclose(runs[i].dr_fp);
+
+        runs[0].dr_fp = fp;
+        runs[0].dr_level++;
+
+        self->ud_nruns -= DBLOADER_FANIN - 1;
+    }
+    return (status);
+}
+
+/*
+ * Sorts records held in memory and writes them as run into a
+ * temporary file. The run is kept, even if its compaction fails.
+ */
+static int
+dbloader_spill(luab_dbloader_t *self)
+{
+    dbloader_run_t *runs;
+    caddr_t *vec;
+    FILE *fp;
+    size_t i;
+    int status;
+
+    if ((runs = luab_core_realloc(self->ud_runs,
+        (self->ud_nruns + 1) * sizeof(dbloader_run_t), 0)) == NULL)
+        return (luab_env_error);
+
+    self->ud_runs = runs;
+
+    if ((vec = dbloader_sort(self)) == NULL)
+        return (luab_env_error);
+
+    if ((fp = tmpfile()) != NULL) {
+
+        for (i = 0, status = 0; i < self->ud_nrec; i++) {
+
+            if (fwrite(vec[i], dbloader_recsz(vec[i]), 1, fp) != 1) {
+                status = luab_env_error;
+                break;
+            }
+        }
+
+        if (status == 0 && fflush(fp) == 0) {
+            runs[self->ud_nruns].dr_fp = fp;
+            runs[self->ud_nruns].dr_level = 0;
+            self->ud_nruns++;
+            dbloader_reset(self);
+        } else {
+            (void)fclose(fp);
+            status = luab_env_error;
+        }
+    } else
+        status = luab_env_error;
+
+    luab_core_free(vec, self->ud_nrec * sizeof(caddr_t));
+
+    if (status == 0)
+        status = dbloader_compact(self);
+
+    return (status);
+}
+
+static int
+dbloader_append(luab_dbloader_t *self, const DBT *k, const DBT *v)
+{
+    dbloader_hdr_t hdr;
+    size_t len, n;
+    caddr_t bp;
+    size_t *idx;
+
+    if ((k->size > UINT32_MAX) || (v->size > UINT32_MAX)) {
+        errno = ERANGE;
+        return (luab_env_error);
+    }
+    len = sizeof(hdr) + k->size + v->size;
+
+    if ((self->ud_nrec > 0) &&
+        (self->ud_len + len + self->ud_nrec * sizeof(size_t) >
+        self->ud_budget)) {
+
+        if (dbloader_spill(self) != 0)
+            return (luab_env_error);
+    }
+
+    if (self->ud_len + len > self->ud_size) {
+
+        for (n = (self->ud_size > 0) ? self->ud_size : DBLOADER_BUFSIZE;
+            n < self->ud_len + len; n <<= 1)
+            ;
+
+        if ((bp = luab_core_realloc(self->ud_buf, n,
+            LUAB_ALLOC_NOZERO)) == NULL)
+            return (luab_env_error);
+
+        self->ud_buf = bp;
+        self->ud_size = n;
+    }
+
+    if (self->ud_nrec == self->ud_nidx) {
+        n = (self->ud_nidx > 0) ? (self->ud_nidx << 1) : 1024;
+
+        if ((idx = luab_core_realloc(self->ud_idx, n * sizeof(size_t),
+            LUAB_ALLOC_NOZERO)) == NULL)
+            return (luab_env_error);
+
+        self->ud_idx = idx;
+        self->ud_nidx = n;
+    }
+    bp = self->ud_buf + self->ud_len;
+
+    hdr.dh_ksize = (uint32_t)k->size;
+    hdr.dh_vsize = (uint32_t)v->size;
+
+    (void)memmove(bp, &hdr, sizeof(hdr));
+    (void)memmove(bp + sizeof(hdr), k->data, k->size);
+    (void)memmove(bp + sizeof(hdr) + k->size, v->data, v->size);
+
+    self->ud_idx[self->ud_nrec++] = self->ud_len;
+    self->ud_len += len;
+
+    return (luab_env_success);
+}
+
+/*
+ * Merges runs and records in memory into db, the latter are the most
+ * recent ones.
+ */
+static ssize_t
+dbloader_merge(luab_dbloader_t *self, DB *db)
+{
+    dbloader_src_t *src;
+    caddr_t *vec;
+    size_t i, n;
+    ssize_t count;
+
+    if ((vec = dbloader_sort(self)) == NULL && self->ud_nrec > 0)
+        return (luab_env_error);
+
+    n = self->ud_nruns + 1;
+
+    if ((src = luab_core_alloc(n, sizeof(dbloader_src_t))) == NULL) {
+
+        if (vec != NULL)
+            luab_core_free(vec, self->ud_nrec * sizeof(caddr_t));
+
+        return (luab_env_error);
+    }
+
+    for (i = 0; i < self->ud_nruns; i++)
+        src[i].ds_fp = self->ud_runs[i].dr_fp;
+
+    src[i].ds_vec = vec;
+    src[i].ds_card = self->ud_nrec;
+
+    count = dbloader_kmerge(src, n, db, NULL);
+
+    luab_core_free(src, n * sizeof(dbloader_src_t));
+
+    if (vec != NULL)
+        luab_core_free(vec, self->ud_nrec * sizeof(caddr_t));
+
+    return (count);
+}
+
+static DB *
+dbloader_db(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    DB *db;
+
+    m = luab_xmod(DB, TYPE, __func__);
+
+    lua_getuservalue(L, narg);
+    lua_rawgeti(L, -1, 1);
+
+    db = luab_udata(L, -1, m, DB *);
+
+    lua_pop(L, 2);
+
+    return (db);
+}
+
+static void
+dbloader_fillxtable(lua_State *L, int narg, void *arg)
+{
+    luab_dbloader_t *self;
+
+    if ((self = (luab_dbloader_t *)arg) != NULL) {
+
+        luab_setinteger(L, narg, "budget",      self->ud_budget);
+        luab_setinteger(L, narg, "len",         self->ud_len);
+        luab_setinteger(L, narg, "nrec",        self->ud_nrec);
+        luab_setinteger(L, narg, "nruns",       self->ud_nruns);
+        luab_setinteger(L, narg, "nput",        self->ud_nput);
+    } else
+        luab_core_err(EX_DATAERR, __func__, EINVAL);
+}
+
+/*
+ * Generator functions.
+ */
+
+/***
+ * Generator function - translate (LUA_TUSERDATA(DBLOADER)) into (LUA_TTABLE).
+ *
+ * @function get_table
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              budget      = (LUA_TNUMBER),
+ *              len         = (LUA_TNUMBER),
+ *              nrec        = (LUA_TNUMBER),
+ *              nruns       = (LUA_TNUMBER),
+ *              nput        = (LUA_TNUMBER),
+ *          }
+ *
+ * @usage t [, err, msg ] = loader:get_table()
+ */
+static int
+DBLOADER_get_table(lua_State *L)
+{
+    luab_module_t *m;
+    luab_xtable_param_t xtp;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DBLOADER, TYPE, __func__);
+
+    xtp.xtp_fill = dbloader_fillxtable;
+    xtp.xtp_arg = luab_todata(L, 1, m, void *);
+    xtp.xtp_new = 1;
+    xtp.xtp_k = NULL;
+
+    return (luab_table_pushxtable(L, -2, &xtp));
+}
+
+/***
+ * Generator function - returns (LUA_TNIL).
+ *
+ * @function dump
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage iovec [, err, msg ] = loader:dump()
+ */
+static int
+DBLOADER_dump(lua_State *L)
+{
+    return (luab_core_dump(L, 1, NULL, 0));
+}
+
+/*
+ * Access functions.
+ */
+
+/***
+ * Get number of records held in memory, spilled runs are not counted.
+ *
+ * @function get_nrec
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = loader:get_nrec()
+ */
+static int
+DBLOADER_get_nrec(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dbloader_t *self;
+    size_t x;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DBLOADER, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_dbloader_t *);
+    x = self->ud_nrec;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/*
+ * Service primitives.
+ */
+
+/***
+ * Add a batch of key/data pairs.
+ *
+ * @function add
+ *
+ * @param keys              Either an array of (LUA_TSTRING) or an instance
+ *                          of (LUA_TUSERDATA(IOVEC)) holding records,
+ *                          each prefixed by its length as uint32_t.
+ * @param values            Values, passed as keys and with same cardinality.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          Number of pairs added. If a pair cannot be added, the number
+ *          of pairs added so far is returned along with the error, those
+ *          remain added.
+ *
+ * @usage n [, err, msg ] = loader:add(keys, values)
+ */
+static int
+DBLOADER_add(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dbloader_t *self;
+    DBT *k, *v;
+    size_t nk, nv, i;
+    int up_call;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m = luab_xmod(DBLOADER, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_dbloader_t *);
+
+    if ((k = luab_db_checkbatch(L, 2, &nk)) == NULL)
+        luab_core_argerror(L, 2, NULL, 0, 0, errno);
+
+    if ((v = luab_db_checkbatch(L, 3, &nv)) == NULL || nv != nk)
+        luab_core_argerror(L, 3, NULL, 0, 0, (v == NULL) ? errno : ERANGE);
+
+    for (i = 0; i < nk; i++) {
+
+        if (dbloader_append(self, &k[i], &v[i]) != 0)
+            break;
+    }
+    up_call = (i < nk) ? errno : 0;
+
+    lua_pushinteger(L, (lua_Integer)i);
+
+    return (luab_pusherr(L, up_call, 1));
+}
+
+/***
+ * Store added key/data pairs in ascending order of their keys.
+ *
+ * @function finish
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          Number of records stored. On failure, the added pairs are
+ *          kept, thus finish may be called again, whereby records stored
+ *          before are stored again, or the pairs are discarded by clear.
+ *
+ * @usage n [, err, msg ] = loader:finish()
+ */
+static int
+DBLOADER_finish(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dbloader_t *self;
+    DB *db;
+    ssize_t count;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DBLOADER, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_dbloader_t *);
+
+    if ((db = dbloader_db(L, 1)) != NULL) {
+
+        if ((count = dbloader_merge(self, db)) >= 0) {
+            self->ud_nput += (size_t)count;
+            dbloader_free(self);
+        }
+    } else
+        count = luab_env_error;
+
+    return (luab_pushxinteger(L, count));
+}
+
+/***
+ * Discard added key/data pairs.
+ *
+ * @function clear
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage ret [, err, msg ] = loader:clear()
+ */
+static int
+DBLOADER_clear(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dbloader_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DBLOADER, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_dbloader_t *);
+
+    dbloader_free(self);
+
+    return (luab_pushxinteger(L, luab_env_success));
+}
+
+/*
+ * Metamethods.
+ */
+
+static int
+DBLOADER_gc(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dbloader_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DBLOADER, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_dbloader_t *);
+
+    dbloader_free(self);
+
+    return (luab_core_gc(L, 1, m));
+}
+
+static int
+DBLOADER_len(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(DBLOADER, TYPE, __func__);
+    return (luab_core_len(L, 2, m));
+}
+
+static int
+DBLOADER_tostring(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(DBLOADER, TYPE, __func__);
+    return (luab_core_tostring(L, 1, m));
+}
+
+/*
+ * Internal interface.
+ */
+
+static luab_module_table_t dbloader_methods[] = {
+    LUAB_FUNC("add",            DBLOADER_add),
+    LUAB_FUNC("finish",         DBLOADER_finish),
+    LUAB_FUNC("clear",          DBLOADER_clear),
+    LUAB_FUNC("get_nrec",       DBLOADER_get_nrec),
+    LUAB_FUNC("get_table",      DBLOADER_get_table),
+    LUAB_FUNC("dump",           DBLOADER_dump),
+    LUAB_FUNC("__gc",           DBLOADER_gc),
+    LUAB_FUNC("__len",          DBLOADER_len),
+    LUAB_FUNC("__tostring",     DBLOADER_tostring),
+    LUAB_MOD_TBL_SENTINEL
+};
+
+static void *
+dbloader_create(lua_State *L, void *arg)
+{
+    luab_module_t *m;
+    luab_dbloader_param_t *dlp;
+    luab_dbloader_t *self;
+
+    m = luab_xmod(DBLOADER, TYPE, __func__);
+
+    if ((dlp = (luab_dbloader_param_t *)arg) == NULL) {
+        errno = EINVAL;
+        return (NULL);
+    }
+
+    if ((self = luab_newuserdata(L, m, dlp)) != NULL) {
+        lua_createtable(L, 1, 0);
+        lua_pushvalue(L, dlp->dlp_narg);
+        lua_rawseti(L, -2, 1);
+        lua_setuservalue(L, -2);
+    }
+    return (self);
+}
+
+static void
+dbloader_init(void *ud, void *arg)
+{
+    luab_dbloader_t *self;
+    luab_dbloader_param_t *dlp;
+
+    if (((self = (luab_dbloader_t *)ud) != NULL) &&
+        ((dlp = (luab_dbloader_param_t *)arg) != NULL))
+        self->ud_budget = dlp->dlp_budget;
+}
+
+static void *
+dbloader_udata(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    m = luab_xmod(DBLOADER, TYPE, __func__);
+    return (luab_todata(L, narg, m, luab_dbloader_t *));
+}
+
+luab_module_t luab_dbloader_type = {
+    .m_id           = LUAB_DBLOADER_TYPE_ID,
+    .m_name         = LUAB_DBLOADER_TYPE,
+    .m_vec          = dbloader_methods,
+    .m_create       = dbloader_create,
+    .m_init         = dbloader_init,
+    .m_get          = dbloader_udata,
+    .m_len          = sizeof(luab_dbloader_t),
+    .m_sz           = sizeof(luab_dbloader_param_t),
+};
+#endif /* __BSD_VISIBLE */
@@ -0,0 +1,587 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <db.h>
+#include <string.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+#include "luab_table.h"
+
+#if __BSD_VISIBLE
+extern luab_module_t luab_hashinfo_type;
+
+/*
+ * Interface against
+ *
+ *  typedef struct {
+ *      u_int   bsize;
+ *      u_int   ffactor;
+ *      u_int   nelem;
+ *      u_int   cachesize;
+ *      uint32_t    (*hash)(const void *, size_t);
+ *      int     lorder;
+ *  } HASHINFO;
+ */
+
+typedef struct luab_hashinfo {
+    luab_udata_t    ud_softc;
+    HASHINFO        ud_info;
+} luab_hashinfo_t;
+
+/*
+ * The callout hash is not mapped, because it is not called with any
+ * context, where a lua_State might be retrieved from. It is NULL, thus
+ * the default of hash(3) is used.
+ */
+
+/*
+ * Subr.
+ */
+
+static void
+hashinfo_fillxtable(lua_State *L, int narg, void *arg)
+{
+    HASHINFO *info;
+
+    if ((info = (HASHINFO *)arg) != NULL) {
+
+        luab_setinteger(L, narg, "bsize",      info->bsize);
+        luab_setinteger(L, narg, "ffactor",    info->ffactor);
+        luab_setinteger(L, narg, "nelem",      info->nelem);
+        luab_setinteger(L, narg, "cachesize",  info->cachesize);
+        luab_setinteger(L, narg, "lorder",     info->lorder);
+    } else
+        luab_core_err(EX_DATAERR, __func__, EINVAL);
+}
+
+/*
+ * Generator functions.
+ */
+
+/***
+ * Generator function - translate (LUA_TUSERDATA(HASHINFO)) into (LUA_TTABLE).
+ *
+ * @function get_table
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              bsize        = (LUA_TNUMBER),
+ *              ffactor      = (LUA_TNUMBER),
+ *              nelem        = (LUA_TNUMBER),
+ *              cachesize    = (LUA_TNUMBER),
+ *              lorder       = (LUA_TNUMBER),
+ *          }
+ *
+ * @usage t [, err, msg ] = hashinfo:get_table()
+ */
+static int
+HASHINFO_get_table(lua_State *L)
+{
+    luab_module_t *m;
+    luab_xtable_param_t xtp;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(HASHINFO, TYPE, __func__);
+
+    xtp.xtp_fill = hashinfo_fillxtable;
+    xtp.xtp_arg = luab_xdata(L, 1, m);
+    xtp.xtp_new = 1;
+    xtp.xtp_k = NULL;
+
+    return (luab_table_pushxtable(L, -2, &xtp));
+}
+
+/***
+ * Generator function - translate hashinfo{} into (LUA_TUSERDATA(IOVEC)).
+ *
+ * @function dump
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage iovec [, err, msg ] = hashinfo:dump()
+ */
+static int
+HASHINFO_dump(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(HASHINFO, TYPE, __func__);
+    return (luab_core_dump(L, 1, m, m->m_sz));
+}
+
+/*
+ * Access functions.
+ */
+
+/***
+ * Set bucket size in bytes.
+ *
+ * @function set_bsize
+ *
+ * @param arg               Specifies bsize.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = hashinfo:set_bsize(arg)
+ */
+static int
+HASHINFO_set_bsize(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    HASHINFO *info;
+    u_int x;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(HASHINFO, TYPE, __func__);
+    m1 = luab_xmod(UINT, TYPE, __func__);
+
+    info = luab_udata(L, 1, m0, HASHINFO *);
+    x = (u_int)luab_checkxinteger(L, 2, m1, luab_env_uint_max);
+
+    info->bsize = x;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Get bucket size in bytes.
+ *
+ * @function get_bsize
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = hashinfo:get_bsize()
+ */
+static int
+HASHINFO_get_bsize(lua_State *L)
+{
+    luab_module_t *m;
+    HASHINFO *info;
+    u_int x;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(HASHINFO, TYPE, __func__);
+    info = luab_udata(L, 1, m, HASHINFO *);
+    x = info->bsize;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Set desired density within hash table.
+ *
+ * @function set_ffactor
+ *
+ * @param arg               Specifies ffactor.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = hashinfo:set_ffactor(arg)
+ */
+static int
+HASHINFO_set_ffactor(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    HASHINFO *info;
+    u_int x;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(HASHINFO, TYPE, __func__);
+    m1 = luab_xmod(UINT, TYPE, __func__);
+
+    info = luab_udata(L, 1, m0, HASHINFO *);
+    x = (u_int)luab_checkxinteger(L, 2, m1, luab_env_uint_max);
+
+    info->ffactor = x;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Get desired density within hash table.
+ *
+ * @function get_ffactor
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = hashinfo:get_ffactor()
+ */
+static int
+HASHINFO_get_ffactor(lua_State *L)
+{
+    luab_module_t *m;
+    HASHINFO *info;
+    u_int x;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(HASHINFO, TYPE, __func__);
+    info = luab_udata(L, 1, m, HASHINFO *);
+    x = info->ffactor;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Set estimated final size of hash table.
+ *
+ * @function set_nelem
+ *
+ * @param arg               Specifies nelem.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = hashinfo:set_nelem(arg)
+ */
+static int
+HASHINFO_set_nelem(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    HASHINFO *info;
+    u_int x;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(HASHINFO, TYPE, __func__);
+    m1 = luab_xmod(UINT, TYPE, __func__);
+
+    info = luab_udata(L, 1, m0, HASHINFO *);
+    x = (u_int)luab_checkxinteger(L, 2, m1, luab_env_uint_max);
+
+    info->nelem = x;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Get estimated final size of hash table.
+ *
+ * @function get_nelem
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = hashinfo:get_nelem()
+ */
+static int
+HASHINFO_get_nelem(lua_State *L)
+{
+    luab_module_t *m;
+    HASHINFO *info;
+    u_int x;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(HASHINFO, TYPE, __func__);
+    info = luab_udata(L, 1, m, HASHINFO *);
+    x = info->nelem;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Set maximum size of memory cache in bytes.
+ *
+ * @function set_cachesize
+ *
+ * @param arg               Specifies cachesize.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = hashinfo:set_cachesize(arg)
+ */
+static int
+HASHINFO_set_cachesize(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    HASHINFO *info;
+    u_int x;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(HASHINFO, TYPE, __func__);
+    m1 = luab_xmod(UINT, TYPE, __func__);
+
+    info = luab_udata(L, 1, m0, HASHINFO *);
+    x = (u_int)luab_checkxinteger(L, 2, m1, luab_env_uint_max);
+
+    info->cachesize = x;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Get maximum size of memory cache in bytes.
+ *
+ * @function get_cachesize
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = hashinfo:get_cachesize()
+ */
+static int
+HASHINFO_get_cachesize(lua_State *L)
+{
+    luab_module_t *m;
+    HASHINFO *info;
+    u_int x;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(HASHINFO, TYPE, __func__);
+    info = luab_udata(L, 1, m, HASHINFO *);
+    x = info->cachesize;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Set byte order.
+ *
+ * @function set_lorder
+ *
+ * @param arg               Specifies lorder.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = hashinfo:set_lorder(arg)
+ */
+static int
+HASHINFO_set_lorder(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    HASHINFO *info;
+    int x;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(HASHINFO, TYPE, __func__);
+    m1 = luab_xmod(INT, TYPE, __func__);
+
+    info = luab_udata(L, 1, m0, HASHINFO *);
+    x = (int)luab_checkxinteger(L, 2, m1, luab_env_int_max);
+
+    info->lorder = x;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Get byte order.
+ *
+ * @function get_lorder
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = hashinfo:get_lorder()
+ */
+static int
+HASHINFO_get_lorder(lua_State *L)
+{
+    luab_module_t *m;
+    HASHINFO *info;
+    int x;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(HASHINFO, TYPE, __func__);
+    info = luab_udata(L, 1, m, HASHINFO *);
+    x = info->lorder;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/*
+ * Metamethods.
+ */
+
+static int
+HASHINFO_gc(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(HASHINFO, TYPE, __func__);
+    return (luab_core_gc(L, 1, m));
+}
+
+static int
+HASHINFO_len(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(HASHINFO, TYPE, __func__);
+    return (luab_core_len(L, 2, m));
+}
+
+static int
+HASHINFO_tostring(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(HASHINFO, TYPE, __func__);
+    return (luab_core_tostring(L, 1, m));
+}
+
+/*
+ * Internal interface.
+ */
+
+static luab_module_table_t hashinfo_methods[] = {
+    LUAB_FUNC("set_bsize",        HASHINFO_set_bsize),
+    LUAB_FUNC("set_ffactor",      HASHINFO_set_ffactor),
+    LUAB_FUNC("set_nelem",        HASHINFO_set_nelem),
+    LUAB_FUNC("set_cachesize",    HASHINFO_set_cachesize),
+    LUAB_FUNC("set_lorder",       HASHINFO_set_lorder),
+    LUAB_FUNC("get_table",        HASHINFO_get_table),
+    LUAB_FUNC("get_bsize",        HASHINFO_get_bsize),
+    LUAB_FUNC("get_ffactor",      HASHINFO_get_ffactor),
+    LUAB_FUNC("get_nelem",        HASHINFO_get_nelem),
+    LUAB_FUNC("get_cachesize",    HASHINFO_get_cachesize),
+    LUAB_FUNC("get_lorder",       HASHINFO_get_lorder),
+    LUAB_FUNC("dump",             HASHINFO_dump),
+    LUAB_FUNC("__gc",             HASHINFO_gc),
+    LUAB_FUNC("__len",            HASHINFO_len),
+    LUAB_FUNC("__tostring",       HASHINFO_tostring),
+    LUAB_MOD_TBL_SENTINEL
+};
+
+static void *
+hashinfo_create(lua_State *L, void *arg)
+{
+    luab_module_t *m;
+    m = luab_xmod(HASHINFO, TYPE, __func__);
+    return (luab_newuserdata(L, m, arg));
+}
+
+static void
+hashinfo_init(void *ud, void *arg)
+{
+    luab_module_t *m;
+    m = luab_xmod(HASHINFO, TYPE, __func__);
+    luab_udata_init(m, ud, arg);
+}
+
+static void *
+hashinfo_udata(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    m = luab_xmod(HASHINFO, TYPE, __func__);
+    return (luab_checkludata(L, narg, m, m->m_sz));
+}
+
+static luab_table_t *
+hashinfo_checktable(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    luab_table_t *tbl;
+    HASHINFO *x, *y;
+    size_t i, j;
+
+    m = luab_xmod(HASHINFO, TYPE, __func__);
+
+    if ((tbl = luab_table_newvectornil(L, narg, m)) != NULL) {
+
+        if (((x = (HASHINFO *)tbl->tbl_vec) != NULL) &&
+            (tbl->tbl_card > 0)) {
+            luab_table_init(L, 0);
+
+            for (i = 0, j = tbl->tbl_card; i < j; i++) {
+
+                if (lua_next(L, narg) != 0) {
+
+                    if ((lua_isnumber(L, -2) != 0) &&
+                        (lua_isuserdata(L, -1) != 0)) {
+                        y = luab_udata(L, -1, m, HASHINFO *);
+                        (void)memmove(&(x[i]), y, m->m_sz);
+                    } else
+                        luab_core_err(EX_DATAERR, __func__, EINVAL);
+                } else {
+                    errno = ENOENT;
+                    break;
+                }
+                lua_pop(L, 1);
+            }
+        } else
+            errno = ERANGE;
+    }
+    return (tbl);
+}
+
+static void
+hashinfo_pushtable(lua_State *L, int narg, luab_table_t *tbl, int new, int clr)
+{
+    luab_module_t *m;
+    HASHINFO *x;
+    size_t i, j, k;
+
+    m = luab_xmod(HASHINFO, TYPE, __func__);
+
+    if (tbl != NULL) {
+
+        if (((x = (HASHINFO *)tbl->tbl_vec) != NULL) &&
+            (tbl->tbl_card > 0)) {
+            luab_table_init(L, new);
+
+            for (i = 0, j = tbl->tbl_card, k = 1; i < j; i++, k++)
+                luab_rawsetxdata(L, narg, m, k, &(x[i]));
+
+            errno = ENOENT;
+        } else
+            errno = ERANGE;
+
+        if (clr != 0)
+            luab_table_free(tbl);
+    } else
+        errno = ERANGE;
+}
+
+static luab_table_t *
+hashinfo_alloctable(void *vec, size_t card)
+{
+    luab_module_t *m;
+    m = luab_xmod(HASHINFO, TYPE, __func__);
+    return (luab_table_create(m, vec, card));
+}
+
+luab_module_t luab_hashinfo_type = {
+    .m_id           = LUAB_HASHINFO_TYPE_ID,
+    .m_name         = LUAB_HASHINFO_TYPE,
+    .m_vec          = hashinfo_methods,
+    .m_create       = hashinfo_create,
+    .m_init         = hashinfo_init,
+    .m_get          = hashinfo_udata,
+    .m_get_tbl      = hashinfo_checktable,
+    .m_set_tbl      = hashinfo_pushtable,
+    .m_alloc_tbl    = hashinfo_alloctable,
+    .m_len          = sizeof(luab_hashinfo_t),
+    .m_sz           = sizeof(HASHINFO),
+};
+#endif /* __BSD_VISIBLE */
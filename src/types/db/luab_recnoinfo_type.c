@@ -0,0 +1,648 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <db.h>
+#include <string.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+#include "luab_table.h"
+
+#if __BSD_VISIBLE
+extern luab_module_t luab_recnoinfo_type;
+
+/*
+ * Interface against
+ *
+ *  typedef struct {
+ *      u_long  flags;
+ *      u_int   cachesize;
+ *      u_int   psize;
+ *      int     lorder;
+ *      size_t  reclen;
+ *      u_char  bval;
+ *      char    *bfname;
+ *  } RECNOINFO;
+ */
+
+typedef struct luab_recnoinfo {
+    luab_udata_t    ud_softc;
+    RECNOINFO       ud_info;
+} luab_recnoinfo_t;
+
+/*
+ * The attribute bfname is not mapped, because its storage is not owned
+ * by an instance of (LUA_TUSERDATA(RECNOINFO)). It is NULL, thus the
+ * underlying btree(3) is held in memory.
+ */
+
+/*
+ * Subr.
+ */
+
+static void
+recnoinfo_fillxtable(lua_State *L, int narg, void *arg)
+{
+    RECNOINFO *info;
+
+    if ((info = (RECNOINFO *)arg) != NULL) {
+
+        luab_setinteger(L, narg, "flags",      info->flags);
+        luab_setinteger(L, narg, "cachesize",  info->cachesize);
+        luab_setinteger(L, narg, "psize",      info->psize);
+        luab_setinteger(L, narg, "lorder",     info->lorder);
+        luab_setinteger(L, narg, "reclen",     info->reclen);
+        luab_setinteger(L, narg, "bval",       info->bval);
+    } else
+        luab_core_err(EX_DATAERR, __func__, EINVAL);
+}
+
+/*
+ * Generator functions.
+ */
+
+/***
+ * Generator function - translate (LUA_TUSERDATA(RECNOINFO)) into (LUA_TTABLE).
+ *
+ * @function get_table
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              flags        = (LUA_TNUMBER),
+ *              cachesize    = (LUA_TNUMBER),
+ *              psize        = (LUA_TNUMBER),
+ *              lorder       = (LUA_TNUMBER),
+ *              reclen       = (LUA_TNUMBER),
+ *              bval         = (LUA_TNUMBER),
+ *          }
+ *
+ * @usage t [, err, msg ] = recnoinfo:get_table()
+ */
+static int
+RECNOINFO_get_table(lua_State *L)
+{
+    luab_module_t *m;
+    luab_xtable_param_t xtp;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(RECNOINFO, TYPE, __func__);
+
+    xtp.xtp_fill = recnoinfo_fillxtable;
+    xtp.xtp_arg = luab_xdata(L, 1, m);
+    xtp.xtp_new = 1;
+    xtp.xtp_k = NULL;
+
+    return (luab_table_pushxtable(L, -2, &xtp));
+}
+
+/***
+ * Generator function - translate recnoinfo{} into (LUA_TUSERDATA(IOVEC)).
+ *
+ * @function dump
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage iovec [, err, msg ] = recnoinfo:dump()
+ */
+static int
+RECNOINFO_dump(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(RECNOINFO, TYPE, __func__);
+    return (luab_core_dump(L, 1, m, m->m_sz));
+}
+
+/*
+ * Access functions.
+ */
+
+/***
+ * Set flags, e. g. bsd.db.R_FIXEDLEN.
+ *
+ * @function set_flags
+ *
+ * @param arg               Specifies flags.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = recnoinfo:set_flags(arg)
+ */
+static int
+RECNOINFO_set_flags(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    RECNOINFO *info;
+    u_long x;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(RECNOINFO, TYPE, __func__);
+    m1 = luab_xmod(ULONG, TYPE, __func__);
+
+    info = luab_udata(L, 1, m0, RECNOINFO *);
+    x = (u_long)luab_checkxinteger(L, 2, m1, luab_env_ulong_max);
+
+    info->flags = x;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Get flags, e. g. bsd.db.R_FIXEDLEN.
+ *
+ * @function get_flags
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = recnoinfo:get_flags()
+ */
+static int
+RECNOINFO_get_flags(lua_State *L)
+{
+    luab_module_t *m;
+    RECNOINFO *info;
+    u_long x;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(RECNOINFO, TYPE, __func__);
+    info = luab_udata(L, 1, m, RECNOINFO *);
+    x = info->flags;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Set maximum size of memory cache in bytes.
+ *
+ * @function set_cachesize
+ *
+ * @param arg               Specifies cachesize.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = recnoinfo:set_cachesize(arg)
+ */
+static int
+RECNOINFO_set_cachesize(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    RECNOINFO *info;
+    u_int x;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(RECNOINFO, TYPE, __func__);
+    m1 = luab_xmod(UINT, TYPE, __func__);
+
+    info = luab_udata(L, 1, m0, RECNOINFO *);
+    x = (u_int)luab_checkxinteger(L, 2, m1, luab_env_uint_max);
+
+    info->cachesize = x;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Get maximum size of memory cache in bytes.
+ *
+ * @function get_cachesize
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = recnoinfo:get_cachesize()
+ */
+static int
+RECNOINFO_get_cachesize(lua_State *L)
+{
+    luab_module_t *m;
+    RECNOINFO *info;
+    u_int x;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(RECNOINFO, TYPE, __func__);
+    info = luab_udata(L, 1, m, RECNOINFO *);
+    x = info->cachesize;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Set page size of underlying btree(3) in bytes.
+ *
+ * @function set_psize
+ *
+ * @param arg               Specifies psize.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = recnoinfo:set_psize(arg)
+ */
+static int
+RECNOINFO_set_psize(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    RECNOINFO *info;
+    u_int x;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(RECNOINFO, TYPE, __func__);
+    m1 = luab_xmod(UINT, TYPE, __func__);
+
+    info = luab_udata(L, 1, m0, RECNOINFO *);
+    x = (u_int)luab_checkxinteger(L, 2, m1, luab_env_uint_max);
+
+    info->psize = x;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Get page size of underlying btree(3) in bytes.
+ *
+ * @function get_psize
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = recnoinfo:get_psize()
+ */
+static int
+RECNOINFO_get_psize(lua_State *L)
+{
+    luab_module_t *m;
+    RECNOINFO *info;
+    u_int x;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(RECNOINFO, TYPE, __func__);
+    info = luab_udata(L, 1, m, RECNOINFO *);
+    x = info->psize;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Set byte order.
+ *
+ * @function set_lorder
+ *
+ * @param arg               Specifies lorder.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = recnoinfo:set_lorder(arg)
+ */
+static int
+RECNOINFO_set_lorder(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    RECNOINFO *info;
+    int x;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(RECNOINFO, TYPE, __func__);
+    m1 = luab_xmod(INT, TYPE, __func__);
+
+    info = luab_udata(L, 1, m0, RECNOINFO *);
+    x = (int)luab_checkxinteger(L, 2, m1, luab_env_int_max);
+
+    info->lorder = x;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Get byte order.
+ *
+ * @function get_lorder
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = recnoinfo:get_lorder()
+ */
+static int
+RECNOINFO_get_lorder(lua_State *L)
+{
+    luab_module_t *m;
+    RECNOINFO *info;
+    int x;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(RECNOINFO, TYPE, __func__);
+    info = luab_udata(L, 1, m, RECNOINFO *);
+    x = info->lorder;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Set length of fixed-length records.
+ *
+ * @function set_reclen
+ *
+ * @param arg               Specifies reclen.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = recnoinfo:set_reclen(arg)
+ */
+static int
+RECNOINFO_set_reclen(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    RECNOINFO *info;
+    size_t x;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(RECNOINFO, TYPE, __func__);
+    m1 = luab_xmod(SIZE, TYPE, __func__);
+
+    info = luab_udata(L, 1, m0, RECNOINFO *);
+    x = (size_t)luab_checklxinteger(L, 2, m1, 0);
+
+    info->reclen = x;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Get length of fixed-length records.
+ *
+ * @function get_reclen
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = recnoinfo:get_reclen()
+ */
+static int
+RECNOINFO_get_reclen(lua_State *L)
+{
+    luab_module_t *m;
+    RECNOINFO *info;
+    size_t x;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(RECNOINFO, TYPE, __func__);
+    info = luab_udata(L, 1, m, RECNOINFO *);
+    x = info->reclen;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Set delimiting byte of variable-length records.
+ *
+ * @function set_bval
+ *
+ * @param arg               Specifies bval.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = recnoinfo:set_bval(arg)
+ */
+static int
+RECNOINFO_set_bval(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    RECNOINFO *info;
+    u_char x;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(RECNOINFO, TYPE, __func__);
+    m1 = luab_xmod(UCHAR, TYPE, __func__);
+
+    info = luab_udata(L, 1, m0, RECNOINFO *);
+    x = (u_char)luab_checkxinteger(L, 2, m1, luab_env_uchar_max);
+
+    info->bval = x;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/***
+ * Get delimiting byte of variable-length records.
+ *
+ * @function get_bval
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = recnoinfo:get_bval()
+ */
+static int
+RECNOINFO_get_bval(lua_State *L)
+{
+    luab_module_t *m;
+    RECNOINFO *info;
+    u_char x;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(RECNOINFO, TYPE, __func__);
+    info = luab_udata(L, 1, m, RECNOINFO *);
+    x = info->bval;
+
+    return (luab_pushxinteger(L, x));
+}
+
+/*
+ * Metamethods.
+ */
+
+static int
+RECNOINFO_gc(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(RECNOINFO, TYPE, __func__);
+    return (luab_core_gc(L, 1, m));
+}
+
+static int
+RECNOINFO_len(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(RECNOINFO, TYPE, __func__);
+    return (luab_core_len(L, 2, m));
+}
+
+static int
+RECNOINFO_tostring(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(RECNOINFO, TYPE, __func__);
+    return (luab_core_tostring(L, 1, m));
+}
+
+/*
+ * Internal interface.
+ */
+
+static luab_module_table_t recnoinfo_methods[] = {
+    LUAB_FUNC("set_flags",        RECNOINFO_set_flags),
+    LUAB_FUNC("set_cachesize",    RECNOINFO_set_cachesize),
+    LUAB_FUNC("set_psize",        RECNOINFO_set_psize),
+    LUAB_FUNC("set_lorder",       RECNOINFO_set_lorder),
+    LUAB_FUNC("set_reclen",       RECNOINFO_set_reclen),
+    LUAB_FUNC("set_bval",         RECNOINFO_set_bval),
+    LUAB_FUNC("get_table",        RECNOINFO_get_table),
+    LUAB_FUNC("get_flags",        RECNOINFO_get_flags),
+    LUAB_FUNC("get_cachesize",    RECNOINFO_get_cachesize),
+    LUAB_FUNC("get_psize",        RECNOINFO_get_psize),
+    LUAB_FUNC("get_lorder",       RECNOINFO_get_lorder),
+    LUAB_FUNC("get_reclen",       RECNOINFO_get_reclen),
+    LUAB_FUNC("get_bval",         RECNOINFO_get_bval),
+    LUAB_FUNC("dump",             RECNOINFO_dump),
+    LUAB_FUNC("__gc",             RECNOINFO_gc),
+    LUAB_FUNC("__len",            RECNOINFO_len),
+    LUAB_FUNC("__tostring",       RECNOINFO_tostring),
+    LUAB_MOD_TBL_SENTINEL
+};
+
+static void *
+recnoinfo_create(lua_State *L, void *arg)
+{
+    luab_module_t *m;
+    m = luab_xmod(RECNOINFO, TYPE, __func__);
+    return (luab_newuserdata(L, m, arg));
+}
+
+static void
+recnoinfo_init(void *ud, void *arg)
+{
+    luab_module_t *m;
+    m = luab_xmod(RECNOINFO, TYPE, __func__);
+    luab_udata_init(m, ud, arg);
+}
+
+static void *
+recnoinfo_udata(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    m = luab_xmod(RECNOINFO, TYPE, __func__);
+    return (luab_checkludata(L, narg, m, m->m_sz));
+}
+
+static luab_table_t *
+recnoinfo_checktable(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    luab_table_t *tbl;
+    RECNOINFO *x, *y;
+    size_t i, j;
+
+    m = luab_xmod(RECNOINFO, TYPE, __func__);
+
+    if ((tbl = luab_table_newvectornil(L, narg, m)) != NULL) {
+
+        if (((x = (RECNOINFO *)tbl->tbl_vec) != NULL) &&
+            (tbl->tbl_card > 0)) {
+            luab_table_init(L, 0);
+
+            for (i = 0, j = tbl->tbl_card; i < j; i++) {
+
+                if (lua_next(L, narg) != 0) {
+
+                    if ((lua_isnumber(L, -2) != 0) &&
+                        (lua_isuserdata(L, -1) != 0)) {
+                        y = luab_udata(L, -1, m, RECNOINFO *);
+                        (void)memmove(&(x[i]), y, m->m_sz);
+                    } else
+                        luab_core_err(EX_DATAERR, __func__, EINVAL);
+                } else {
+                    errno = ENOENT;
+                    break;
+                }
+                lua_pop(L, 1);
+            }
+        } else
+            errno = ERANGE;
+    }
+    return (tbl);
+}
+
+static void
+recnoinfo_pushtable(lua_State *L, int narg, luab_table_t *tbl, int new, int clr)
+{
+    luab_module_t *m;
+    RECNOINFO *x;
+    size_t i, j, k;
+
+    m = luab_xmod(RECNOINFO, TYPE, __func__);
+
+    if (tbl != NULL) {
+
+        if (((x = (RECNOINFO *)tbl->tbl_vec) != NULL) &&
+            (tbl->tbl_card > 0)) {
+            luab_table_init(L, new);
+
+            for (i = 0, j = tbl->tbl_card, k = 1; i < j; i++, k++)
+                luab_rawsetxdata(L, narg, m, k, &(x[i]));
+
+            errno = ENOENT;
+        } else
+            errno = ERANGE;
+
+        if (clr != 0)
+            luab_table_free(tbl);
+    } else
+        errno = ERANGE;
+}
+
+static luab_table_t *
+recnoinfo_alloctable(void *vec, size_t card)
+{
+    luab_module_t *m;
+    m = luab_xmod(RECNOINFO, TYPE, __func__);
+    return (luab_table_create(m, vec, card));
+}
+
+luab_module_t luab_recnoinfo_type = {
+    .m_id           = LUAB_RECNOINFO_TYPE_ID,
+    .m_name         = LUAB_RECNOINFO_TYPE,
+    .m_vec          = recnoinfo_methods,
+    .m_create       = recnoinfo_create,
+    .m_init         = recnoinfo_init,
+    .m_get          = recnoinfo_udata,
+    .m_get_tbl      = recnoinfo_checktable,
+    .m_set_tbl      = recnoinfo_pushtable,
+    .m_alloc_tbl    = recnoinfo_alloctable,
+    .m_len          = sizeof(luab_recnoinfo_t),
+    .m_sz           = sizeof(RECNOINFO),
+};
+#endif /* __BSD_VISIBLE */
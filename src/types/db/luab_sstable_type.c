@@ -0,0 +1,957 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <db.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+#include "luab_table.h"
+
+#if __BSD_VISIBLE
+extern luab_module_t luab_sstable_type;
+
+/*
+ * Interface against
+ *
+ *  typedef struct luab_sstable {
+ *      luab_udata_t    ud_softc;
+ *      caddr_t         ud_base;
+ *      size_t          ud_len;
+ *      u_int           ud_flags;
+ *      u_int           ud_interval;
+ *      size_t          ud_nrec;
+ *      size_t          ud_nindex;
+ *      size_t          ud_index;
+ *      caddr_t         ud_key;
+ *      size_t          ud_keymax;
+ *  } luab_sstable_t;
+ *
+ * whereby ud_base maps an immutable file, written by db:export(), by
+ * mmap(2). The mapping is held by an instance of (LUA_TUSERDATA(IOVEC)),
+ * which is referenced by the uservalue of the table.
+ *
+ * The file starts with a header, followed by records in ascending order
+ * of their keys and an index. Records are grouped into blocks of
+ * sh_interval records, each record is prefixed by
+ *
+ *      uint32_t    sr_shared;      bytes shared with previous key
+ *      uint32_t    sr_unshared;    bytes following
+ *      uint32_t    sr_vsize;       size of data, following the key
+ *
+ * in host byte order, whereby sr_shared is 0 on the first record of
+ * each block or without LUAB_SSTABLE_PREFIX. The index holds the offset
+ * of each block as uint64_t, thus a key is located by binary search
+ * over the first keys of the blocks and a scan over a single block.
+ */
+
+#define LUAB_SSTABLE_MAGIC      0x4c535354U
+#define LUAB_SSTABLE_VERSION    1
+
+typedef struct sstable_hdr {
+    uint32_t        sh_magic;
+    uint16_t        sh_version;
+    uint16_t        sh_flags;
+    uint32_t        sh_interval;
+    uint32_t        sh_pad;
+    uint64_t        sh_nrec;
+    uint64_t        sh_nindex;
+    uint64_t        sh_index;
+} sstable_hdr_t;
+
+typedef struct sstable_rec {
+    uint32_t        sr_shared;
+    uint32_t        sr_unshared;
+    uint32_t        sr_vsize;
+} sstable_rec_t;
+
+typedef struct luab_sstable_param {
+    int             stp_narg;
+    caddr_t         stp_base;
+    size_t          stp_len;
+    sstable_hdr_t   stp_hdr;
+} luab_sstable_param_t;
+
+typedef struct luab_sstable {
+    luab_udata_t    ud_softc;
+    caddr_t         ud_base;
+    size_t          ud_len;
+    u_int           ud_flags;
+    u_int           ud_interval;
+    size_t          ud_nrec;
+    size_t          ud_nindex;
+    size_t          ud_index;
+    caddr_t         ud_key;
+    size_t          ud_keymax;
+} luab_sstable_t;
+
+/*
+ * Subr.
+ */
+
+static int
+sstable_keycmp(const void *x, size_t xlen, const void *y, size_t ylen)
+{
+    int status;
+
+    if ((status = memcmp(x, y, (xlen < ylen) ? xlen : ylen)) == 0)
+        status = (xlen > ylen) - (xlen < ylen);
+
+    return (status);
+}
+
+static int
+sstable_reserve(luab_sstable_t *self, size_t len)
+{
+    caddr_t bp;
+    size_t n;
+
+    if (len > self->ud_keymax) {
+
+        for (n = (self->ud_keymax > 0) ? self->ud_keymax : 256;
+            n < len; n <<= 1)
+            ;
+
+        if ((bp = luab_core_realloc(self->ud_key, n,
+            LUAB_ALLOC_NOZERO)) == NULL)
+            return (luab_env_error);
+
+        self->ud_key = bp;
+        self->ud_keymax = n;
+    }
+    return (luab_env_success);
+}
+
+/*
+ * Decodes record at off, its key is composed in ud_key from the key of
+ * the previous record, whose length is passed by klen. Returns offset
+ * of next record, or 0 on malformed input.
+ */
+static size_t
+sstable_decode(luab_sstable_t *self, size_t off, size_t *klen,
+    sstable_rec_t *rec)
+{
+    size_t len;
+
+    if ((off > self->ud_index) ||
+        ((self->ud_index - off) < sizeof(*rec)))
+        goto bad;
+
+    (void)memmove(rec, self->ud_base + off, sizeof(*rec));
+
+    if (rec->sr_shared > *klen)
+        goto bad;
+
+    len = (size_t)rec->sr_unshared + rec->sr_vsize;
+
+    if ((self->ud_index - off - sizeof(*rec)) < len)
+        goto bad;
+
+    if (sstable_reserve(self, (size_t)rec->sr_shared +
+        rec->sr_unshared) != 0)
+        return (0);
+
+    (void)memmove(self->ud_key + rec->sr_shared,
+        self->ud_base + off + sizeof(*rec), rec->sr_unshared);
+
+    *klen = (size_t)rec->sr_shared + rec->sr_unshared;
+
+    return (off + sizeof(*rec) + len);
+bad:
+    errno = EFTYPE;
+    return (0);
+}
+
+static size_t
+sstable_block(luab_sstable_t *self, size_t i)
+{
+    uint64_t off;
+
+    (void)memmove(&off, self->ud_base + self->ud_index +
+        i * sizeof(off), sizeof(off));
+
+    return ((size_t)off);
+}
+
+/*
+ * Returns offset of the last block, whose first key is less than k, or
+ * offset of the first block, if there is none. Returns 0 on malformed
+ * input. Since keys are stored in full at the beginning of each block,
+ * the search takes place over the mapped region without decoding.
+ */
+static size_t
+sstable_search(luab_sstable_t *self, const void *k, size_t ksize)
+{
+    sstable_rec_t r;
+    size_t lo, hi, mid, off;
+
+    for (lo = 0, hi = self->ud_nindex; lo < hi; ) {
+        mid = lo + ((hi - lo) >> 1);
+        off = sstable_block(self, mid);
+
+        if ((off > self->ud_index) ||
+            ((self->ud_index - off) < sizeof(r))) {
+            errno = EFTYPE;
+            return (0);
+        }
+        (void)memmove(&r, self->ud_base + off, sizeof(r));
+
+        if (((self->ud_index - off - sizeof(r)) < r.sr_unshared) ||
+            (r.sr_shared != 0)) {
+            errno = EFTYPE;
+            return (0);
+        }
+
+        if (sstable_keycmp(self->ud_base + off + sizeof(r),
+            r.sr_unshared, k, ksize) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return ((lo > 0) ? sstable_block(self, lo - 1) : sizeof(sstable_hdr_t));
+}
+
+/*
+ * Positions onto first record, whose key is not less than k. Its key is
+ * left in ud_key. Returns its offset, ud_index if there is none, or 0 on
+ * malformed input.
+ */
+static size_t
+sstable_seek(luab_sstable_t *self, const void *k, size_t ksize,
+    size_t *klen, sstable_rec_t *rec)
+{
+    size_t off, next;
+
+    if ((off = sstable_search(self, k, ksize)) == 0)
+        return (0);
+
+    *klen = 0;
+
+    while (off < self->ud_index) {
+
+        if ((next = sstable_decode(self, off, klen, rec)) == 0)
+            return (0);
+
+        if (sstable_keycmp(self->ud_key, *klen, k, ksize) >= 0)
+            break;
+
+        off = next;
+    }
+    return (off);
+}
+
+/*
+ * Pushes data of record at off either by (LUA_TSTRING) or without
+ * copying by (LUA_TUSERDATA(SLICE)) over the mapped region.
+ */
+static int
+sstable_pushdata(lua_State *L, int narg, luab_sstable_t *self, size_t off,
+    sstable_rec_t *rec, int slice)
+{
+    luab_module_t *m0, *m1;
+    luab_slice_param_t slp;
+    size_t voff;
+
+    voff = off + sizeof(*rec) + rec->sr_unshared;
+
+    if (slice == 0) {
+        lua_pushlstring(L, self->ud_base + voff, rec->sr_vsize);
+        return (1);
+    }
+    m0 = luab_xmod(IOVEC, TYPE, __func__);
+    m1 = luab_xmod(SLICE, TYPE, __func__);
+
+    lua_getuservalue(L, narg);
+    lua_rawgeti(L, -1, 1);
+
+    slp.slp_narg = lua_gettop(L);
+    slp.slp_buf = luab_udata(L, -1, m0, luab_iovec_t *);
+    slp.slp_off = voff;
+    slp.slp_len = rec->sr_vsize;
+
+    if (m1->m_create(L, &slp) == NULL) {
+        lua_pop(L, 2);
+        return (luab_env_error);
+    }
+    lua_replace(L, -3);
+    lua_pop(L, 1);
+
+    return (1);
+}
+
+/*
+ * Iterator, position, key of previous record and bounds are held by its
+ * upvalues. Iteration starts at the beginning of a block, thus records
+ * below the lower bound are skipped, before the lower bound is released.
+ */
+static int
+sstable_range(lua_State *L)
+{
+    luab_module_t *m;
+    luab_sstable_t *self;
+    sstable_rec_t rec;
+    const char *dp;
+    size_t off, next, klen, len;
+
+    m = luab_xmod(SSTABLE, TYPE, __func__);
+    self = luab_todata(L, lua_upvalueindex(1), m, luab_sstable_t *);
+
+    off = (size_t)lua_tointeger(L, lua_upvalueindex(2));
+    dp = lua_tolstring(L, lua_upvalueindex(3), &klen);
+
+    if (sstable_reserve(self, klen) != 0)
+        return (luaL_error(L, "%s: %s", __func__, strerror(errno)));
+
+    if (klen > 0)
+        (void)memmove(self->ud_key, dp, klen);
+
+    for (;;) {
+
+        if (off >= self->ud_index)
+            return (0);
+
+        if ((next = sstable_decode(self, off, &klen, &rec)) == 0)
+            return (luaL_error(L, "%s: %s", __func__, strerror(errno)));
+
+        if (lua_isnil(L, lua_upvalueindex(6)) != 0)
+            break;
+
+        dp = lua_tolstring(L, lua_upvalueindex(6), &len);
+
+        if (sstable_keycmp(self->ud_key, klen, dp, len) >= 0) {
+            lua_pushnil(L);
+            lua_replace(L, lua_upvalueindex(6));
+            break;
+        }
+        off = next;
+    }
+
+    if (lua_isnil(L, lua_upvalueindex(4)) == 0) {
+        dp = lua_tolstring(L, lua_upvalueindex(4), &len);
+
+        if (sstable_keycmp(self->ud_key, klen, dp, len) >= 0) {
+            lua_pushinteger(L, (lua_Integer)self->ud_index);
+            lua_replace(L, lua_upvalueindex(2));
+            return (0);
+        }
+    }
+    lua_pushlstring(L, self->ud_key, klen);
+    lua_pushvalue(L, -1);
+    lua_replace(L, lua_upvalueindex(3));
+
+    lua_pushinteger(L, (lua_Integer)next);
+    lua_replace(L, lua_upvalueindex(2));
+
+    if (sstable_pushdata(L, lua_upvalueindex(1), self, off, &rec,
+        lua_toboolean(L, lua_upvalueindex(5))) < 0)
+        return (luaL_error(L, "%s: %s", __func__, strerror(errno)));
+
+    return (2);
+}
+
+static void
+sstable_fillxtable(lua_State *L, int narg, void *arg)
+{
+    luab_sstable_t *self;
+
+    if ((self = (luab_sstable_t *)arg) != NULL) {
+
+        luab_setinteger(L, narg, "len",         self->ud_len);
+        luab_setinteger(L, narg, "flags",       self->ud_flags);
+        luab_setinteger(L, narg, "interval",    self->ud_interval);
+        luab_setinteger(L, narg, "nrec",        self->ud_nrec);
+        luab_setinteger(L, narg, "nindex",      self->ud_nindex);
+    } else
+        luab_core_err(EX_DATAERR, __func__, EINVAL);
+}
+
+/*
+ * Generator functions.
+ */
+
+/***
+ * Generator function - translate (LUA_TUSERDATA(SSTABLE)) into (LUA_TTABLE).
+ *
+ * @function get_table
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              len         = (LUA_TNUMBER),
+ *              flags       = (LUA_TNUMBER),
+ *              interval    = (LUA_TNUMBER),
+ *              nrec        = (LUA_TNUMBER),
+ *              nindex      = (LUA_TNUMBER),
+ *          }
+ *
+ * @usage t [, err, msg ] = sstable:get_table()
+ */
+static int
+SSTABLE_get_table(lua_State *L)
+{
+    luab_module_t *m;
+    luab_xtable_param_t xtp;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(SSTABLE, TYPE, __func__);
+
+    xtp.xtp_fill = sstable_fillxtable;
+    xtp.xtp_arg = luab_todata(L, 1, m, void *);
+    xtp.xtp_new = 1;
+    xtp.xtp_k = NULL;
+
+    return (luab_table_pushxtable(L, -2, &xtp));
+}
+
+/***
+ * Generator function - returns (LUA_TNIL).
+ *
+ * @function dump
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage iovec [, err, msg ] = sstable:dump()
+ */
+static int
+SSTABLE_dump(lua_State *L)
+{
+    return (luab_core_dump(L, 1, NULL, 0));
+}
+
+/***
+ * Generator function - iterate over key/data pairs in ascending order.
+ *
+ * @function range
+ *
+ * @param lower             Lower bound, inclusive, (LUA_T{NIL,STRING}).
+ * @param upper             Upper bound, exclusive, (LUA_T{NIL,STRING}).
+ * @param slice             Data is returned by (LUA_TUSERDATA(SLICE)),
+ *                          (LUA_T{NIL,BOOLEAN}).
+ *
+ * @return (LUA_TFUNCTION)
+ *
+ *          An error is raised, if the lower bound cannot be located
+ *          within a malformed file.
+ *
+ * @usage for k, v in sstable:range([ lower [, upper [, slice ]]]) do
+ *          ...
+ *      end
+ */
+static int
+SSTABLE_range(lua_State *L)
+{
+    luab_module_t *m;
+    luab_sstable_t *self;
+    const char *dp;
+    size_t len, off;
+
+    (void)luab_core_checkmaxargs(L, 4);
+
+    m = luab_xmod(SSTABLE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_sstable_t *);
+
+    if (lua_isnoneornil(L, 2) == 0) {
+        dp = luab_checklstring(L, 2, luab_env_buf_max, &len);
+
+        if ((off = sstable_search(self, dp, len)) == 0)
+            return (luaL_error(L, "%s: %s", __func__, strerror(errno)));
+    } else
+        off = sizeof(sstable_hdr_t);
+
+    if (lua_isnoneornil(L, 3) == 0)
+        (void)luab_checklstring(L, 3, luab_env_buf_max, NULL);
+
+    lua_pushvalue(L, 1);
+    lua_pushinteger(L, (lua_Integer)off);
+    lua_pushliteral(L, "");
+    lua_pushvalue(L, 3);
+    lua_pushboolean(L, lua_toboolean(L, 4));
+    lua_pushvalue(L, 2);
+    lua_pushcclosure(L, sstable_range, 6);
+
+    return (1);
+}
+
+/*
+ * Access functions, immutable properties.
+ */
+
+/***
+ * Get number of records.
+ *
+ * @function card
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = sstable:card()
+ */
+static int
+SSTABLE_card(lua_State *L)
+{
+    luab_module_t *m;
+    luab_sstable_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(SSTABLE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_sstable_t *);
+
+    return (luab_pushxinteger(L, self->ud_nrec));
+}
+
+/*
+ * Service primitives.
+ */
+
+/***
+ * Keyed retrieval.
+ *
+ * @function get
+ *
+ * @param key               Key, (LUA_TSTRING).
+ * @param slice             Data is returned by (LUA_TUSERDATA(SLICE)),
+ *                          (LUA_T{NIL,BOOLEAN}).
+ *
+ * @return (LUA_T{NIL,STRING,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          Data, or (LUA_TNIL), if key was not found.
+ *
+ * @usage data [, err, msg ] = sstable:get(key [, slice ])
+ */
+static int
+SSTABLE_get(lua_State *L)
+{
+    luab_module_t *m;
+    luab_sstable_t *self;
+    sstable_rec_t rec;
+    const char *dp;
+    size_t len, klen, off;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m = luab_xmod(SSTABLE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_sstable_t *);
+    dp = luab_checklstring(L, 2, luab_env_buf_max, &len);
+
+    if ((off = sstable_seek(self, dp, len, &klen, &rec)) == 0)
+        return (luab_pushnil(L));
+
+    if ((off >= self->ud_index) ||
+        (sstable_keycmp(self->ud_key, klen, dp, len) != 0)) {
+        lua_pushnil(L);
+        return (1);
+    }
+
+    if (sstable_pushdata(L, 1, self, off, &rec, lua_toboolean(L, 3)) < 0)
+        return (luab_pushnil(L));
+
+    return (1);
+}
+
+/*
+ * Metamethods.
+ */
+
+static int
+SSTABLE_gc(lua_State *L)
+{
+    luab_module_t *m;
+    luab_sstable_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(SSTABLE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_sstable_t *);
+
+    if (self->ud_key != NULL) {
+        luab_core_free(self->ud_key, self->ud_keymax);
+        self->ud_key = NULL;
+        self->ud_keymax = 0;
+    }
+    return (luab_core_gc(L, 1, m));
+}
+
+static int
+SSTABLE_len(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(SSTABLE, TYPE, __func__);
+    return (luab_core_len(L, 2, m));
+}
+
+static int
+SSTABLE_tostring(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(SSTABLE, TYPE, __func__);
+    return (luab_core_tostring(L, 1, m));
+}
+
+/*
+ * Internal interface.
+ */
+
+static luab_module_table_t sstable_methods[] = {
+    LUAB_FUNC("get",            SSTABLE_get),
+    LUAB_FUNC("range",          SSTABLE_range),
+    LUAB_FUNC("card",           SSTABLE_card),
+    LUAB_FUNC("get_table",      SSTABLE_get_table),
+    LUAB_FUNC("dump",           SSTABLE_dump),
+    LUAB_FUNC("__gc",           SSTABLE_gc),
+    LUAB_FUNC("__len",          SSTABLE_len),
+    LUAB_FUNC("__tostring",     SSTABLE_tostring),
+    LUAB_MOD_TBL_SENTINEL
+};
+
+static void *
+sstable_create(lua_State *L, void *arg)
+{
+    luab_module_t *m;
+    luab_sstable_param_t *stp;
+    luab_sstable_t *self;
+
+    m = luab_xmod(SSTABLE, TYPE, __func__);
+
+    if ((stp = (luab_sstable_param_t *)arg) == NULL) {
+        errno = EINVAL;
+        return (NULL);
+    }
+
+    if ((self = luab_newuserdata(L, m, stp)) != NULL) {
+        lua_createtable(L, 1, 0);
+        lua_pushvalue(L, stp->stp_narg);
+        lua_rawseti(L, -2, 1);
+        lua_setuservalue(L, -2);
+    }
+    return (self);
+}
+
+static void
+sstable_init(void *ud, void *arg)
+{
+    luab_sstable_t *self;
+    luab_sstable_param_t *stp;
+
+    if (((self = (luab_sstable_t *)ud) != NULL) &&
+        ((stp = (luab_sstable_param_t *)arg) != NULL)) {
+        self->ud_base = stp->stp_base;
+        self->ud_len = stp->stp_len;
+        self->ud_flags = stp->stp_hdr.sh_flags;
+        self->ud_interval = stp->stp_hdr.sh_interval;
+        self->ud_nrec = (size_t)stp->stp_hdr.sh_nrec;
+        self->ud_nindex = (size_t)stp->stp_hdr.sh_nindex;
+        self->ud_index = (size_t)stp->stp_hdr.sh_index;
+    }
+}
+
+static void *
+sstable_udata(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    m = luab_xmod(SSTABLE, TYPE, __func__);
+    return (luab_todata(L, narg, m, luab_sstable_t *));
+}
+
+luab_module_t luab_sstable_type = {
+    .m_id           = LUAB_SSTABLE_TYPE_ID,
+    .m_name         = LUAB_SSTABLE_TYPE,
+    .m_vec          = sstable_methods,
+    .m_create       = sstable_create,
+    .m_init         = sstable_init,
+    .m_get          = sstable_udata,
+    .m_len          = sizeof(luab_sstable_t),
+    .m_sz           = sizeof(luab_sstable_param_t),
+};
+
+/*
+ * Interface against db:export() and bsd.db.create_sstable().
+ */
+
+static int
+sstable_write(FILE *fp, const void *v, size_t len)
+{
+    if (len > 0 && fwrite(v, len, 1, fp) != 1)
+        return (luab_env_error);
+
+    return (luab_env_success);
+}
+
+/*
+ * Writes key/data pairs of a DB_BTREE, as returned by DB->seq, into
+ * a temporary file, which replaces path by rename(2) on completion. Its
+ * mode is set as by open(2), since mkstemp(3) creates it by 0600.
+ */
+ssize_t
+luab_sstable_export(DB *db, const char *path, u_int interval, u_int flags)
+{
+    sstable_hdr_t hdr;
+    sstable_rec_t rec;
+    char tmp[MAXPATHLEN];
+    caddr_t prev, bp;
+    size_t plen, pmax, shared, n;
+    uint64_t *idx, off;
+    size_t nidx, idxmax;
+    ssize_t count;
+    FILE *fp;
+    DBT k, v;
+    mode_t mask;
+    int fd, status, up_call;
+
+    if ((db == NULL) || (db->type != DB_BTREE) || (interval == 0)) {
+        errno = EINVAL;
+        return (luab_env_error);
+    }
+
+    if (snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path) >=
+        (int)sizeof(tmp)) {
+        errno = ENAMETOOLONG;
+        return (luab_env_error);
+    }
+
+    if ((fd = mkstemp(tmp)) < 0)
+        return (luab_env_error);
+
+    mask = umask(0);
+    (void)umask(mask);
+
+    if ((fchmod(fd, DEFFILEMODE & ~mask) != 0) ||
+        ((fp = fdopen(fd, "w")) == NULL)) {
+        up_call = errno;
+        (void)close(fd);
+        (void)unlink(tmp);
+        errno = up_call;
+        return (luab_env_error);
+    }
+    (void)memset(&hdr, 0, sizeof(hdr));
+
+    prev = NULL;
+    plen = pmax = 0;
+    idx = NULL;
+    nidx = idxmax = 0;
+    count = 0;
+
+    if (sstable_write(fp, &hdr, sizeof(hdr)) != 0)
+        goto bad;
+
+    off = sizeof(hdr);
+
+    for (status = (*db->seq)(db, &k, &v, R_FIRST); status == 0;
+        status = (*db->seq)(db, &k, &v, R_NEXT)) {
+
+        if ((k.size > UINT32_MAX) || (v.size > UINT32_MAX)) {
+            errno = ERANGE;
+            goto bad;
+        }
+
+        if ((count % interval) == 0) {
+
+            if (nidx == idxmax) {
+                n = (idxmax > 0) ? (idxmax << 1) : 64;
+
+                if ((bp = luab_core_realloc(idx, n * sizeof(uint64_t),
+                    LUAB_ALLOC_NOZERO)) == NULL)
+                    goto bad;
+
+                idx = (uint64_t *)bp;
+                idxmax = n;
+            }
+            idx[nidx++] = off;
+            shared = 0;
+        } else if ((flags & LUAB_SSTABLE_PREFIX) != 0) {
+            n = (plen < k.size) ? plen : k.size;
+
+            for (shared = 0; shared < n; shared++) {
+
+                if (prev[shared] != ((caddr_t)k.data)[shared])
+                    break;
+            }
+        } else
+            shared = 0;
+
+        rec.sr_shared = (uint32_t)shared;
+        rec.sr_unshared = (uint32_t)(k.size - shared);
+        rec.sr_vsize = (uint32_t)v.size;
+
+        if ((sstable_write(fp, &rec, sizeof(rec)) != 0) ||
+            (sstable_write(fp, (caddr_t)k.data + shared,
+                rec.sr_unshared) != 0) ||
+            (sstable_write(fp, v.data, v.size) != 0))
+            goto bad;
+
+        off += sizeof(rec) + rec.sr_unshared + rec.sr_vsize;
+
+        if ((flags & LUAB_SSTABLE_PREFIX) != 0) {
+
+            if (k.size > pmax) {
+
+                if ((bp = luab_core_realloc(prev, k.size,
+                    LUAB_ALLOC_NOZERO)) == NULL)
+                    goto bad;
+
+                prev = bp;
+                pmax = k.size;
+            }
+            (void)memmove(prev, k.data, k.size);
+            plen = k.size;
+        }
+        count++;
+    }
+
+    if (status < 0)
+        goto bad;
+
+    if (sstable_write(fp, idx, nidx * sizeof(uint64_t)) != 0)
+        goto bad;
+
+    hdr.sh_magic = LUAB_SSTABLE_MAGIC;
+    hdr.sh_version = LUAB_SSTABLE_VERSION;
+    hdr.sh_flags = (uint16_t)(flags & LUAB_SSTABLE_PREFIX);
+    hdr.sh_interval = interval;
+    hdr.sh_nrec = (uint64_t)count;
+    hdr.sh_nindex = (uint64_t)nidx;
+    hdr.sh_index = off;
+
+    if ((fseeko(fp, 0, SEEK_SET) != 0) ||
+        (sstable_write(fp, &hdr, sizeof(hdr)) != 0) ||
+        (fflush(fp) != 0) ||
+        (fsync(fileno(fp)) != 0))
+        goto bad;
+
+    if (fclose(fp) != 0) {
+        fp = NULL;
+        goto bad;
+    }
+    fp = NULL;
+
+    if (rename(tmp, path) != 0)
+        goto bad;
+
+    luab_core_free(idx, idxmax * sizeof(uint64_t));
+    luab_core_free(prev, pmax);
+
+    return (count);
+bad:
+    up_call = errno;
+
+    if (fp != NULL)
+        (void)fclose(fp);
+
+    (void)unlink(tmp);
+
+    if (idx != NULL)
+        luab_core_free(idx, idxmax * sizeof(uint64_t));
+
+    if (prev != NULL)
+        luab_core_free(prev, pmax);
+
+    errno = up_call;
+    return (luab_env_error);
+}
+
+/*
+ * Maps file at path by mmap(2) and pushes an instance of
+ * (LUA_TUSERDATA(SSTABLE)) onto the stack.
+ */
+int
+luab_sstable_pushfile(lua_State *L, const char *path)
+{
+    luab_sstable_param_t stp;
+    struct stat sb;
+    caddr_t bp;
+    size_t len;
+    int fd, up_call;
+
+    if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+        return (luab_pushnil(L));
+
+    if (fstat(fd, &sb) != 0) {
+        up_call = errno;
+        (void)close(fd);
+        errno = up_call;
+        return (luab_pushnil(L));
+    }
+
+    if ((sb.st_size < (off_t)sizeof(sstable_hdr_t)) ||
+        ((uintmax_t)sb.st_size > SIZE_MAX)) {
+        (void)close(fd);
+        errno = EFTYPE;
+        return (luab_pushnil(L));
+    }
+    len = (size_t)sb.st_size;
+
+    bp = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+    up_call = errno;
+    (void)close(fd);
+
+    if (bp == MAP_FAILED) {
+        errno = up_call;
+        return (luab_pushnil(L));
+    }
+    (void)memmove(&stp.stp_hdr, bp, sizeof(stp.stp_hdr));
+
+    if ((stp.stp_hdr.sh_magic != LUAB_SSTABLE_MAGIC) ||
+        (stp.stp_hdr.sh_version != LUAB_SSTABLE_VERSION) ||
+        (stp.stp_hdr.sh_index < sizeof(sstable_hdr_t)) ||
+        (stp.stp_hdr.sh_index > len) ||
+        (stp.stp_hdr.sh_nindex >
+            (len - stp.stp_hdr.sh_index) / sizeof(uint64_t))) {
+        (void)munmap(bp, len);
+        errno = EFTYPE;
+        return (luab_pushnil(L));
+    }
+
+    /* the mapping is released, when its IOVEC is collected */
+    if (luab_iovec_pushmdata(L, bp, len, IOV_RDONLY) != 1) {
+        (void)munmap(bp, len);
+        return (luab_pushnil(L));
+    }
+    stp.stp_narg = lua_gettop(L);
+    stp.stp_base = bp;
+    stp.stp_len = len;
+
+    if (sstable_create(L, &stp) == NULL) {
+        lua_pop(L, 1);
+        return (luab_pushnil(L));
+    }
+    lua_remove(L, stp.stp_narg);
+
+    return (1);
+}
+#endif /* __BSD_VISIBLE */
@@ -0,0 +1,585 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+#include "luab_table.h"
+
+extern luab_module_t luab_dirbuf_type;
+
+/*
+ * Interface against
+ *
+ *  typedef struct luab_dirbuf {
+ *      luab_udata_t    ud_softc;
+ *      caddr_t         ud_buf;
+ *      size_t          ud_size;
+ *      size_t          ud_len;
+ *      size_t          ud_off;
+ *      off_t           ud_base;
+ *  } luab_dirbuf_t;
+ *
+ * whereby ud_buf is filled by getdents(2) or getdirentries(2). Records
+ * are decoded in place from ud_off, thus no (LUA_TUSERDATA(DIRENT)) is
+ * created per entry.
+ */
+
+/*
+ * Subr.
+ */
+
+static struct dirent *
+dirbuf_next(luab_dirbuf_t *self)
+{
+    struct dirent *dp;
+
+    while (self->ud_off < self->ud_len) {
+        dp = (struct dirent *)(self->ud_buf + self->ud_off);
+
+        if (dp->d_reclen == 0) {
+            self->ud_off = self->ud_len;
+            break;
+        }
+        self->ud_off += dp->d_reclen;
+
+        if (dp->d_fileno != 0)
+            return (dp);
+    }
+    return (NULL);
+}
+
+static int
+dirbuf_pushdirent(lua_State *L, struct dirent *dp)
+{
+    if (dp != NULL) {
+        lua_pushlstring(L, dp->d_name, dp->d_namlen);
+        lua_pushinteger(L, (lua_Integer)dp->d_type);
+        lua_pushinteger(L, (lua_Integer)dp->d_fileno);
+        return (3);
+    }
+    lua_pushnil(L);
+    return (1);
+}
+
+static int
+dirbuf_fillio(lua_State *L, int dirent)
+{
+    luab_module_t *m;
+    luab_dirbuf_t *self;
+    int fd;
+    size_t nbytes;
+    ssize_t count;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m = luab_xmod(DIRBUF, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_dirbuf_t *);
+    fd = luab_checkint(L, 2);
+    nbytes = lua_isnoneornil(L, 3) ? 0 : luab_checksize(L, 3);
+
+    count = luab_dirbuf_fill(self, fd, nbytes,
+        (dirent != 0) ? NULL : &(self->ud_base));
+
+    return (luab_pushxinteger(L, count));
+}
+
+/*
+ * Iterator, refills from fd by its upvalues.
+ */
+static int
+dirbuf_entries(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dirbuf_t *self;
+    struct dirent *dp;
+    int fd;
+
+    m = luab_xmod(DIRBUF, TYPE, __func__);
+    self = luab_udata(L, lua_upvalueindex(1), m, luab_dirbuf_t *);
+    fd = (int)lua_tointeger(L, lua_upvalueindex(2));
+
+    while ((dp = dirbuf_next(self)) == NULL) {
+
+        switch (luab_dirbuf_fill(self, fd, 0, NULL)) {
+        case -1:
+            return (luaL_error(L, "%s: %s", __func__, strerror(errno)));
+        case 0:
+            lua_pushnil(L);
+            return (1);
+        default:
+            break;
+        }
+    }
+    return (dirbuf_pushdirent(L, dp));
+}
+
+static void
+dirbuf_fillxtable(lua_State *L, int narg, void *arg)
+{
+    luab_dirbuf_t *self;
+
+    if ((self = (luab_dirbuf_t *)arg) != NULL) {
+
+        luab_setinteger(L, narg, "size",    self->ud_size);
+        luab_setinteger(L, narg, "len",     self->ud_len);
+        luab_setinteger(L, narg, "off",     self->ud_off);
+        luab_setinteger(L, narg, "base",    self->ud_base);
+    } else
+        luab_core_err(EX_DATAERR, __func__, EINVAL);
+}
+
+/*
+ * Generator functions.
+ */
+
+/***
+ * Generator function - translate (LUA_TUSERDATA(DIRBUF)) into (LUA_TTABLE).
+ *
+ * @function get_table
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              size    = (LUA_TNUMBER),
+ *              len     = (LUA_TNUMBER),
+ *              off     = (LUA_TNUMBER),
+ *              base    = (LUA_TNUMBER),
+ *          }
+ *
+ * @usage t [, err, msg ] = dirbuf:get_table()
+ */
+static int
+DIRBUF_get_table(lua_State *L)
+{
+    luab_module_t *m;
+    luab_xtable_param_t xtp;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DIRBUF, TYPE, __func__);
+
+    xtp.xtp_fill = dirbuf_fillxtable;
+    xtp.xtp_arg = luab_todata(L, 1, m, void *);
+    xtp.xtp_new = 1;
+    xtp.xtp_k = NULL;
+
+    return (luab_table_pushxtable(L, -2, &xtp));
+}
+
+/***
+ * Generator function - returns (LUA_TNIL).
+ *
+ * @function dump
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage iovec [, err, msg ] = dirbuf:dump()
+ */
+static int
+DIRBUF_dump(lua_State *L)
+{
+    return (luab_core_dump(L, 1, NULL, 0));
+}
+
+/***
+ * Generator function - iterate over entries of a directory.
+ *
+ * @function entries
+ *
+ * @param fd                Open file descriptor of directory, the buffer
+ *                          is refilled by getdents(2) when exhausted.
+ *
+ * @return (LUA_TFUNCTION)
+ *
+ * @usage for name, type, fileno in dirbuf:entries(fd) do ... end
+ */
+static int
+DIRBUF_entries(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dirbuf_t *self;
+    int fd;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(DIRBUF, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_dirbuf_t *);
+    fd = luab_checkint(L, 2);
+
+    self->ud_len = 0;
+    self->ud_off = 0;
+
+    lua_pushvalue(L, 1);
+    lua_pushinteger(L, fd);
+    lua_pushcclosure(L, dirbuf_entries, 2);
+
+    return (1);
+}
+
+/*
+ * Access functions, immutable properties.
+ */
+
+/***
+ * Get capacity.
+ *
+ * @function get_size
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage nbytes [, err, msg ] = dirbuf:get_size()
+ */
+static int
+DIRBUF_get_size(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dirbuf_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DIRBUF, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_dirbuf_t *);
+
+    return (luab_pushxinteger(L, self->ud_size));
+}
+
+/*
+ * Access functions.
+ */
+
+/***
+ * Get amount of bytes filled by last call of getdents or getdirentries.
+ *
+ * @function get_len
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage nbytes [, err, msg ] = dirbuf:get_len()
+ */
+static int
+DIRBUF_get_len(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dirbuf_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DIRBUF, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_dirbuf_t *);
+
+    return (luab_pushxinteger(L, self->ud_len));
+}
+
+/***
+ * Get position of block read by last call of getdirentries.
+ *
+ * @function get_base
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage base [, err, msg ] = dirbuf:get_base()
+ */
+static int
+DIRBUF_get_base(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dirbuf_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DIRBUF, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_dirbuf_t *);
+
+    return (luab_pushxinteger(L, self->ud_base));
+}
+
+/***
+ * getdents(2) - fill buffer with directory entries
+ *
+ * @function getdents
+ *
+ * @param fd                Open file descriptor of directory.
+ * @param nbytes            Amount of bytes, optional, capacity by default.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage count [, err, msg ] = dirbuf:getdents(fd [, nbytes ])
+ */
+static int
+DIRBUF_getdents(lua_State *L)
+{
+    return (dirbuf_fillio(L, 1));
+}
+
+/***
+ * getdirentries(2) - fill buffer with directory entries
+ *
+ * @function getdirentries
+ *
+ * @param fd                Open file descriptor of directory.
+ * @param nbytes            Amount of bytes, optional, capacity by default.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          The position of the block read is kept, see get_base.
+ *
+ * @usage count [, err, msg ] = dirbuf:getdirentries(fd [, nbytes ])
+ */
+static int
+DIRBUF_getdirentries(lua_State *L)
+{
+    return (dirbuf_fillio(L, 0));
+}
+
+/***
+ * Decode next entry from buffer.
+ *
+ * @function next
+ *
+ * @return (LUA_T{NIL,STRING}, LUA_TNUMBER, LUA_TNUMBER)
+ *
+ *          Name, type and file serial number, (nil) if exhausted.
+ *
+ * @usage name, type, fileno = dirbuf:next()
+ */
+static int
+DIRBUF_next(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dirbuf_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DIRBUF, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_dirbuf_t *);
+
+    return (dirbuf_pushdirent(L, dirbuf_next(self)));
+}
+
+/***
+ * Restart decoding at first entry in buffer.
+ *
+ * @function rewind
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage ret [, err, msg ] = dirbuf:rewind()
+ */
+static int
+DIRBUF_rewind(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dirbuf_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DIRBUF, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_dirbuf_t *);
+
+    self->ud_off = 0;
+
+    return (luab_pushxinteger(L, luab_env_success));
+}
+
+/*
+ * Metamethods.
+ */
+
+/*
+ * Iterator over buffered entries, e. g.
+ *
+ *  for name, type, fileno in dirbuf do ... end
+ */
+static int
+DIRBUF_call(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dirbuf_t *self;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m = luab_xmod(DIRBUF, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_dirbuf_t *);
+
+    return (dirbuf_pushdirent(L, dirbuf_next(self)));
+}
+
+static int
+DIRBUF_gc(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dirbuf_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DIRBUF, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_dirbuf_t *);
+
+    if (self->ud_buf != NULL) {
+        luab_core_free(self->ud_buf, self->ud_size);
+        self->ud_buf = NULL;
+    }
+    return (luab_core_gc(L, 1, m));
+}
+
+static int
+DIRBUF_len(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(DIRBUF, TYPE, __func__);
+    return (luab_core_len(L, 2, m));
+}
+
+static int
+DIRBUF_tostring(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(DIRBUF, TYPE, __func__);
+    return (luab_core_tostring(L, 1, m));
+}
+
+/*
+ * Internal interface.
+ */
+
+static luab_module_table_t dirbuf_methods[] = {
+    LUAB_FUNC("get_size",       DIRBUF_get_size),
+    LUAB_FUNC("get_len",        DIRBUF_get_len),
+    LUAB_FUNC("get_base",       DIRBUF_get_base),
+    LUAB_FUNC("getdents",       DIRBUF_getdents),
+    LUAB_FUNC("getdirentries",  DIRBUF_getdirentries),
+    LUAB_FUNC("next",           DIRBUF_next),
+    LUAB_FUNC("rewind",         DIRBUF_rewind),
+    LUAB_FUNC("entries",        DIRBUF_entries),
+    LUAB_FUNC("get_table",      DIRBUF_get_table),
+    LUAB_FUNC("dump",           DIRBUF_dump),
+    LUAB_FUNC("__call",         DIRBUF_call),
+    LUAB_FUNC("__gc",           DIRBUF_gc),
+    LUAB_FUNC("__len",          DIRBUF_len),
+    LUAB_FUNC("__tostring",     DIRBUF_tostring),
+    LUAB_MOD_TBL_SENTINEL
+};
+
+static void *
+dirbuf_create(lua_State *L, void *arg)
+{
+    luab_module_t *m;
+    luab_dirbuf_t db, *self;
+    size_t size;
+
+    m = luab_xmod(DIRBUF, TYPE, __func__);
+
+    if ((arg == NULL) ||
+        ((size = *(size_t *)arg) < DIRBLKSIZ)) {
+        errno = EINVAL;
+        return (NULL);
+    }
+    (void)memset(&db, 0, sizeof(db));
+
+    if ((db.ud_buf = luab_core_allocx(size, sizeof(char),
+        LUAB_ALLOC_NOZERO)) == NULL)
+        return (NULL);
+
+    db.ud_size = size;
+
+    if ((self = luab_newuserdata(L, m, &db)) == NULL)
+        luab_core_free(db.ud_buf, size);
+
+    return (self);
+}
+
+static void
+dirbuf_init(void *ud, void *arg)
+{
+    luab_dirbuf_t *self, *db;
+
+    if (((self = (luab_dirbuf_t *)ud) != NULL) &&
+        ((db = (luab_dirbuf_t *)arg) != NULL)) {
+        self->ud_buf = db->ud_buf;
+        self->ud_size = db->ud_size;
+    }
+}
+
+static void *
+dirbuf_udata(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    m = luab_xmod(DIRBUF, TYPE, __func__);
+    return (luab_todata(L, narg, m, luab_dirbuf_t *));
+}
+
+/*
+ * Service primitives.
+ */
+
+ssize_t
+luab_dirbuf_fill(luab_dirbuf_t *self, int fd, size_t nbytes, off_t *basep)
+{
+    ssize_t count;
+
+    if (self == NULL || self->ud_buf == NULL) {
+        errno = EINVAL;
+        return (luab_env_error);
+    }
+
+    if (nbytes == 0)
+        nbytes = self->ud_size;
+    else if (nbytes > self->ud_size) {
+        errno = ERANGE;
+        return (luab_env_error);
+    }
+
+    if (basep != NULL)
+        count = getdirentries(fd, self->ud_buf, nbytes, basep);
+    else
+        count = getdents(fd, self->ud_buf, nbytes);
+
+    self->ud_len = (count > 0) ? (size_t)count : 0;
+    self->ud_off = 0;
+
+    return (count);
+}
+
+luab_module_t luab_dirbuf_type = {
+    .m_id           = LUAB_DIRBUF_TYPE_ID,
+    .m_name         = LUAB_DIRBUF_TYPE,
+    .m_vec          = dirbuf_methods,
+    .m_create       = dirbuf_create,
+    .m_init         = dirbuf_init,
+    .m_get          = dirbuf_udata,
+    .m_len          = sizeof(luab_dirbuf_t),
+    .m_sz           = sizeof(size_t),
+};
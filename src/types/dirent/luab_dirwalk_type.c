@@ -0,0 +1,663 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+#include "luab_table.h"
+
+extern luab_module_t luab_dirwalk_type;
+
+/*
+ * Interface against
+ *
+ *  typedef struct luab_dirwalk {
+ *      luab_udata_t            ud_softc;
+ *      luab_dirwalk_level_t    *ud_stack;
+ *      size_t                  ud_nstack;
+ *      size_t                  ud_depth;
+ *      size_t                  ud_maxdepth;
+ *      size_t                  ud_bufsize;
+ *      u_int                   ud_flags;
+ *      size_t                  ud_nerr;
+ *      int                     ud_busy;
+ *      char                    ud_path[PATH_MAX];
+ *  } luab_dirwalk_t;
+ *
+ * whereby ud_stack[0 .. ud_depth - 1] refers open directories from root
+ * to the current one. Each level owns a buffer filled by getdents(2),
+ * buffers are kept by unused levels for reuse. Entries are visited in
+ * pre-order, the root itself is not reported.
+ *
+ * While the prune callback runs, ud_busy is set and re-entrant calls
+ * of next or close fail with EBUSY, thus the level being visited stays
+ * valid.
+ */
+
+typedef struct luab_dirwalk_level {
+    int         dl_fd;
+    size_t      dl_pathlen;
+    size_t      dl_len;
+    size_t      dl_off;
+    char        *dl_buf;
+} luab_dirwalk_level_t;
+
+typedef struct luab_dirwalk {
+    luab_udata_t            ud_softc;
+    luab_dirwalk_level_t    *ud_stack;
+    size_t                  ud_nstack;
+    size_t                  ud_depth;
+    size_t                  ud_maxdepth;
+    size_t                  ud_bufsize;
+    u_int                   ud_flags;
+    size_t                  ud_nerr;
+    int                     ud_busy;
+    char                    ud_path[PATH_MAX];
+} luab_dirwalk_t;
+
+typedef struct luab_dirwalk_ent {
+    size_t      de_pathlen;
+    size_t      de_depth;
+    ino_t       de_ino;
+    u_int       de_type;
+    off_t       de_size;
+    time_t      de_mtime;
+} luab_dirwalk_ent_t;
+
+#define LUAB_DIRWALK_NSTACK     16
+#define LUAB_DIRWALK_CARD       1024
+
+/*
+ * Subr.
+ */
+
+/*
+ * Opens directory name relative to fd and makes it current.
+ */
+static int
+dirwalk_push(luab_dirwalk_t *self, int fd, const char *name, size_t pathlen)
+{
+    luab_dirwalk_level_t *dl;
+    size_t nstack;
+    int dfd;
+
+    if (self->ud_depth == self->ud_nstack) {
+        nstack = self->ud_nstack << 1;
+
+        if ((dl = luab_core_realloc(self->ud_stack,
+            nstack * sizeof(luab_dirwalk_level_t), 0)) == NULL)
+            return (luab_env_error);
+
+        (void)memset(dl + self->ud_nstack, 0,
+            self->ud_nstack * sizeof(luab_dirwalk_level_t));
+
+        self->ud_stack = dl;
+        self->ud_nstack = nstack;
+    }
+    dl = &(self->ud_stack[self->ud_depth]);
+
+    if (dl->dl_buf == NULL &&
+        (dl->dl_buf = luab_core_allocx(self->ud_bufsize, sizeof(char),
+        LUAB_ALLOC_NOZERO)) == NULL)
+        return (luab_env_error);
+
+    if ((dfd = openat(fd, name,
+        O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC)) < 0)
+        return (luab_env_error);
+
+    dl->dl_fd = dfd;
+    dl->dl_pathlen = pathlen;
+    dl->dl_len = 0;
+    dl->dl_off = 0;
+
+    self->ud_depth++;
+
+    return (luab_env_success);
+}
+
+static void
+dirwalk_pop(luab_dirwalk_t *self)
+{
+    luab_dirwalk_level_t *dl;
+
+    if (self->ud_depth > 0) {
+        dl = &(self->ud_stack[--self->ud_depth]);
+
+        if (dl->dl_fd >= 0)
+            (void)close(dl->dl_fd);
+
+        dl->dl_fd = -1;
+    }
+}
+
+static void
+dirwalk_close(luab_dirwalk_t *self)
+{
+    while (self->ud_depth > 0)
+        dirwalk_pop(self);
+}
+
+static void
+dirwalk_free(luab_dirwalk_t *self)
+{
+    size_t i;
+
+    dirwalk_close(self);
+
+    if (self->ud_stack != NULL) {
+
+        for (i = 0; i < self->ud_nstack; i++) {
+            if (self->ud_stack[i].dl_buf != NULL)
+                luab_core_free(self->ud_stack[i].dl_buf, self->ud_bufsize);
+        }
+        luab_core_free(self->ud_stack,
+            self->ud_nstack * sizeof(luab_dirwalk_level_t));
+    }
+    self->ud_stack = NULL;
+    self->ud_nstack = 0;
+}
+
+static int
+dirwalk_prune(lua_State *L, int narg, luab_dirwalk_t *self,
+    luab_dirwalk_ent_t *de)
+{
+    int status;
+
+    lua_pushvalue(L, narg);
+    lua_pushlstring(L, self->ud_path, de->de_pathlen);
+    lua_pushinteger(L, (lua_Integer)de->de_depth);
+
+    self->ud_busy = 1;
+    status = lua_pcall(L, 2, 1, 0);
+    self->ud_busy = 0;
+
+    if (status != LUA_OK)
+        return (lua_error(L));
+
+    status = lua_toboolean(L, -1);
+    lua_pop(L, 1);
+
+    return (status);
+}
+
+/*
+ * Visits next entry, its path is held by ud_path. Returns 0, if
+ * traversal has completed.
+ */
+static int
+dirwalk_next(lua_State *L, int narg, luab_dirwalk_t *self,
+    luab_dirwalk_ent_t *de)
+{
+    luab_dirwalk_level_t *dl;
+    struct dirent *dp;
+    struct stat sb;
+    size_t pathlen;
+    ssize_t n;
+
+    while (self->ud_depth > 0) {
+        dl = &(self->ud_stack[self->ud_depth - 1]);
+
+        if (dl->dl_off >= dl->dl_len) {
+
+            if ((n = getdents(dl->dl_fd, dl->dl_buf, self->ud_bufsize)) > 0) {
+                dl->dl_len = (size_t)n;
+                dl->dl_off = 0;
+            } else {
+                if (n < 0)
+                    self->ud_nerr++;
+
+                dirwalk_pop(self);
+            }
+            continue;
+        }
+        dp = (struct dirent *)(dl->dl_buf + dl->dl_off);
+        dl->dl_off += dp->d_reclen;
+
+        if (dp->d_fileno == 0)
+            continue;
+
+        if (dp->d_name[0] == '.' && (dp->d_name[1] == '\0' ||
+            (dp->d_name[1] == '.' && dp->d_name[2] == '\0')))
+            continue;
+
+        if ((pathlen = dl->dl_pathlen + 1 + dp->d_namlen) >= PATH_MAX) {
+            self->ud_nerr++;
+            continue;
+        }
+        self->ud_path[dl->dl_pathlen] = '/';
+        (void)memmove(self->ud_path + dl->dl_pathlen + 1, dp->d_name,
+            dp->d_namlen);
+        self->ud_path[pathlen] = '\0';
+
+        de->de_pathlen = pathlen;
+        de->de_depth = self->ud_depth;
+        de->de_ino = dp->d_fileno;
+        de->de_type = dp->d_type;
+        de->de_size = 0;
+        de->de_mtime = 0;
+
+        if (((self->ud_flags & LUAB_DIRWALK_STAT) != 0) ||
+            (de->de_type == DT_UNKNOWN)) {
+
+            if (fstatat(dl->dl_fd, dp->d_name, &sb,
+                AT_SYMLINK_NOFOLLOW) == 0) {
+                de->de_type = IFTODT(sb.st_mode);
+                de->de_size = sb.st_size;
+                de->de_mtime = sb.st_mtim.tv_sec;
+            } else
+                self->ud_nerr++;
+        }
+
+        if ((de->de_type == DT_DIR) &&
+            ((self->ud_maxdepth == 0) ||
+            (de->de_depth < self->ud_maxdepth))) {
+
+            if ((narg == 0) || (dirwalk_prune(L, narg, self, de) == 0)) {
+
+                if (dirwalk_push(self, dl->dl_fd, dp->d_name, pathlen) != 0)
+                    self->ud_nerr++;
+            }
+        }
+        return (1);
+    }
+    return (0);
+}
+
+static void
+dirwalk_fillxtable(lua_State *L, int narg, void *arg)
+{
+    luab_dirwalk_t *self;
+
+    if ((self = (luab_dirwalk_t *)arg) != NULL) {
+
+        luab_setinteger(L, narg, "depth",       self->ud_depth);
+        luab_setinteger(L, narg, "maxdepth",    self->ud_maxdepth);
+        luab_setinteger(L, narg, "bufsize",     self->ud_bufsize);
+        luab_setinteger(L, narg, "flags",       self->ud_flags);
+        luab_setinteger(L, narg, "nerr",        self->ud_nerr);
+    } else
+        luab_core_err(EX_DATAERR, __func__, EINVAL);
+}
+
+/*
+ * Generator functions.
+ */
+
+/***
+ * Generator function - translate (LUA_TUSERDATA(DIRWALK)) into (LUA_TTABLE).
+ *
+ * @function get_table
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              depth       = (LUA_TNUMBER),
+ *              maxdepth    = (LUA_TNUMBER),
+ *              bufsize     = (LUA_TNUMBER),
+ *              flags       = (LUA_TNUMBER),
+ *              nerr        = (LUA_TNUMBER),
+ *          }
+ *
+ *          whereby nerr counts entries skipped due to failures.
+ *
+ * @usage t [, err, msg ] = dirwalk:get_table()
+ */
+static int
+DIRWALK_get_table(lua_State *L)
+{
+    luab_module_t *m;
+    luab_xtable_param_t xtp;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DIRWALK, TYPE, __func__);
+
+    xtp.xtp_fill = dirwalk_fillxtable;
+    xtp.xtp_arg = luab_todata(L, 1, m, void *);
+    xtp.xtp_new = 1;
+    xtp.xtp_k = NULL;
+
+    return (luab_table_pushxtable(L, -2, &xtp));
+}
+
+/***
+ * Generator function - returns (LUA_TNIL).
+ *
+ * @function dump
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage iovec [, err, msg ] = dirwalk:dump()
+ */
+static int
+DIRWALK_dump(lua_State *L)
+{
+    return (luab_core_dump(L, 1, NULL, 0));
+}
+
+/*
+ * Access functions.
+ */
+
+/***
+ * Fetch next batch of entries.
+ *
+ * @function next
+ *
+ * @param card              Maximum number of entries, optional,
+ *                          bounded by INT_MAX.
+ * @param prune             Callback, optional, invoked as prune(path, depth)
+ *                          for each directory, descent is skipped, if
+ *                          true is returned.
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              n       = (LUA_TNUMBER),
+ *              path    = { (LUA_TSTRING) ... },
+ *              type    = { (LUA_TNUMBER) ... },
+ *              ino     = { (LUA_TNUMBER) ... },
+ *              depth   = { (LUA_TNUMBER) ... },
+ *              size    = { (LUA_TNUMBER) ... },
+ *              mtime   = { (LUA_TNUMBER) ... },
+ *          }
+ *
+ *          by columns, whereby size and mtime are set by DIRWALK_STAT
+ *          only. Types are denoted by bsd.sys.dirent.DT_*. If traversal
+ *          has completed, (nil) is returned. EBUSY is returned, if
+ *          called by the prune callback.
+ *
+ * @usage t [, err, msg ] = dirwalk:next([ card [, prune ]])
+ */
+static int
+DIRWALK_next(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dirwalk_t *self;
+    luab_dirwalk_ent_t de;
+    size_t card, k;
+    int narg, ncol, st, t;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m = luab_xmod(DIRWALK, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_dirwalk_t *);
+    card = lua_isnoneornil(L, 2) ? LUAB_DIRWALK_CARD : luab_checksize(L, 2);
+
+    if (card > (size_t)luab_env_int_max)
+        luab_core_argerror(L, 2, NULL, 0, 0, ERANGE);
+
+    if (lua_isnoneornil(L, 3))
+        narg = 0;
+    else {
+        luaL_checktype(L, 3, LUA_TFUNCTION);
+        narg = 3;
+    }
+    if (self->ud_busy != 0) {
+        errno = EBUSY;
+        return (luab_pushnil(L));
+    }
+    st = ((self->ud_flags & LUAB_DIRWALK_STAT) != 0);
+    ncol = st ? 6 : 4;
+
+    if (self->ud_depth == 0 || card == 0) {
+        lua_pushnil(L);
+        return (1);
+    }
+    lua_settop(L, 3);
+
+    lua_createtable(L, 0, ncol + 1);
+    t = lua_gettop(L);
+
+    /* card bounds the batch, not the preallocation */
+    for (k = 0; k < (size_t)ncol; k++)
+        lua_createtable(L, (int)MIN(card, LUAB_DIRWALK_CARD), 0);
+
+    for (k = 0; k < card; k++) {
+
+        if (dirwalk_next(L, narg, self, &de) == 0)
+            break;
+
+        lua_pushlstring(L, self->ud_path, de.de_pathlen);
+        lua_rawseti(L, t + 1, (int)(k + 1));
+        lua_pushinteger(L, (lua_Integer)de.de_type);
+        lua_rawseti(L, t + 2, (int)(k + 1));
+        lua_pushinteger(L, (lua_Integer)de.de_ino);
+        lua_rawseti(L, t + 3, (int)(k + 1));
+        lua_pushinteger(L, (lua_Integer)de.de_depth);
+        lua_rawseti(L, t + 4, (int)(k + 1));
+
+        if (st != 0) {
+            lua_pushinteger(L, (lua_Integer)de.de_size);
+            lua_rawseti(L, t + 5, (int)(k + 1));
+            lua_pushinteger(L, (lua_Integer)de.de_mtime);
+            lua_rawseti(L, t + 6, (int)(k + 1));
+        }
+    }
+
+    if (k == 0) {
+        lua_settop(L, 3);
+        lua_pushnil(L);
+        return (1);
+    }
+
+    if (st != 0) {
+        lua_setfield(L, t, "mtime");
+        lua_setfield(L, t, "size");
+    }
+    lua_setfield(L, t, "depth");
+    lua_setfield(L, t, "ino");
+    lua_setfield(L, t, "type");
+    lua_setfield(L, t, "path");
+
+    luab_setinteger(L, t, "n", (lua_Integer)k);
+
+    return (1);
+}
+
+/***
+ * Close each open directory, traversal completes.
+ *
+ * @function close
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          EBUSY is returned, if called by the prune callback.
+ *
+ * @usage ret [, err, msg ] = dirwalk:close()
+ */
+static int
+DIRWALK_close(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dirwalk_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DIRWALK, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_dirwalk_t *);
+
+    if (self->ud_busy != 0) {
+        errno = EBUSY;
+        return (luab_pushxinteger(L, luab_env_error));
+    }
+    dirwalk_close(self);
+
+    return (luab_pushxinteger(L, luab_env_success));
+}
+
+/*
+ * Metamethods.
+ */
+
+static int
+DIRWALK_gc(lua_State *L)
+{
+    luab_module_t *m;
+    luab_dirwalk_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(DIRWALK, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_dirwalk_t *);
+
+    dirwalk_free(self);
+
+    return (luab_core_gc(L, 1, m));
+}
+
+static int
+DIRWALK_len(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(DIRWALK, TYPE, __func__);
+    return (luab_core_len(L, 2, m));
+}
+
+static int
+DIRWALK_tostring(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(DIRWALK, TYPE, __func__);
+    return (luab_core_tostring(L, 1, m));
+}
+
+/*
+ * Internal interface.
+ */
+
+static luab_module_table_t dirwalk_methods[] = {
+    LUAB_FUNC("next",           DIRWALK_next),
+    LUAB_FUNC("close",          DIRWALK_close),
+    LUAB_FUNC("get_table",      DIRWALK_get_table),
+    LUAB_FUNC("dump",           DIRWALK_dump),
+    LUAB_FUNC("__gc",           DIRWALK_gc),
+    LUAB_FUNC("__len",          DIRWALK_len),
+    LUAB_FUNC("__tostring",     DIRWALK_tostring),
+    LUAB_MOD_TBL_SENTINEL
+};
+
+static void *
+dirwalk_create(lua_State *L, void *arg)
+{
+    luab_module_t *m;
+    luab_dirwalk_param_t *dwp;
+    luab_dirwalk_t *dw, *self;
+    size_t len;
+
+    m = luab_xmod(DIRWALK, TYPE, __func__);
+
+    if (((dwp = (luab_dirwalk_param_t *)arg) == NULL) ||
+        (dwp->dwp_path == NULL) ||
+        ((len = strlen(dwp->dwp_path)) == 0) ||
+        (len >= PATH_MAX) ||
+        (dwp->dwp_bufsize < DIRBLKSIZ)) {
+        errno = EINVAL;
+        return (NULL);
+    }
+
+    if ((dw = luab_core_alloc(1, sizeof(luab_dirwalk_t))) == NULL)
+        return (NULL);
+
+    dw->ud_maxdepth = dwp->dwp_maxdepth;
+    dw->ud_bufsize = dwp->dwp_bufsize;
+    dw->ud_flags = dwp->dwp_flags;
+    dw->ud_nstack = LUAB_DIRWALK_NSTACK;
+
+    while (len > 1 && dwp->dwp_path[len - 1] == '/')
+        len--;
+
+    (void)memmove(dw->ud_path, dwp->dwp_path, len);
+
+    if (len == 1 && dw->ud_path[0] == '/')
+        len = 0;
+
+    if ((dw->ud_stack = luab_core_alloc(dw->ud_nstack,
+        sizeof(luab_dirwalk_level_t))) == NULL)
+        goto bad;
+
+    if (dirwalk_push(dw, AT_FDCWD, dwp->dwp_path, len) != 0)
+        goto bad;
+
+    if ((self = luab_newuserdata(L, m, dw)) != NULL) {
+        luab_core_free(dw, sizeof(luab_dirwalk_t));
+        return (self);
+    }
+bad:
+    dirwalk_free(dw);
+    luab_core_free(dw, sizeof(luab_dirwalk_t));
+    return (NULL);
+}
+
+static void
+dirwalk_init(void *ud, void *arg)
+{
+    luab_dirwalk_t *self, *dw;
+
+    if (((self = (luab_dirwalk_t *)ud) != NULL) &&
+        ((dw = (luab_dirwalk_t *)arg) != NULL)) {
+        self->ud_stack = dw->ud_stack;
+        self->ud_nstack = dw->ud_nstack;
+        self->ud_depth = dw->ud_depth;
+        self->ud_maxdepth = dw->ud_maxdepth;
+        self->ud_bufsize = dw->ud_bufsize;
+        self->ud_flags = dw->ud_flags;
+        (void)memmove(self->ud_path, dw->ud_path, sizeof(self->ud_path));
+    }
+}
+
+static void *
+dirwalk_udata(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    m = luab_xmod(DIRWALK, TYPE, __func__);
+    return (luab_todata(L, narg, m, luab_dirwalk_t *));
+}
+
+luab_module_t luab_dirwalk_type = {
+    .m_id           = LUAB_DIRWALK_TYPE_ID,
+    .m_name         = LUAB_DIRWALK_TYPE,
+    .m_vec          = dirwalk_methods,
+    .m_create       = dirwalk_create,
+    .m_init         = dirwalk_init,
+    .m_get          = dirwalk_udata,
+    .m_len          = sizeof(luab_dirwalk_t),
+    .m_sz           = sizeof(luab_dirwalk_param_t),
+};
@@ -281,7 +281,7 @@ GROUP_gc(lua_State *L)
     grp = luab_udata(L, 1, m, struct group *);
 
     luab_core_freestr(grp->gr_name);
-    luab_core_freestr(grp->gr_passwd);
+    luab_core_freestrx(grp->gr_passwd, LUAB_ALLOC_SCRUB);
 
     if ((vec = grp->gr_mem) != NULL) {
         for (n = 0; vec[n] != NULL; n++)    /* XXX */
@@ -333,12 +333,43 @@ group_create(lua_State *L, void *arg)
     return (luab_newuserdata(L, m, arg));
 }
 
+/*
+ * Strings are copied, since those returned by getgr{ent,gid,nam}(3) are
+ * owned by libc and overwritten by subsequent calls.
+ */
 static void
 group_init(void *ud, void *arg)
 {
     luab_module_t *m;
+    struct group *grp;
+    caddr_t *src, *dst;
+    size_t n;
+
     m = luab_xmod(GROUP, TYPE, __func__);
     luab_udata_init(m, ud, arg);
+
+    if ((ud != NULL) && (arg != NULL)) {
+        grp = &(((luab_group_t *)ud)->ud_grp);
+
+        grp->gr_name = luab_core_allocstring(grp->gr_name, NULL);
+        grp->gr_passwd = luab_core_allocstring(grp->gr_passwd, NULL);
+
+        if ((src = grp->gr_mem) != NULL) {
+
+            for (n = 0; src[n] != NULL; n++)
+                ;
+
+            if ((dst = luab_core_alloc(n + 1, sizeof(caddr_t))) != NULL) {
+
+                for (n = 0; src[n] != NULL; n++) {
+
+                    if ((dst[n] = luab_core_allocstring(src[n], NULL)) == NULL)
+                        break;
+                }
+            }
+            grp->gr_mem = dst;
+        }
+    }
 }
 
 static void *
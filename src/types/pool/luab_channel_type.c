@@ -0,0 +1,494 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+#include "luab_table.h"
+
+extern luab_module_t luab_channel_type;
+
+/*
+ * Interface against
+ *
+ *  typedef struct luab_channel_udata {
+ *      luab_udata_t    ud_softc;
+ *      luab_channel_t  *ud_ch;
+ *  } luab_channel_udata_t;
+ *
+ * whereby ud_ch is reference counted, thus an instance passed as argument
+ * to pool:submit refers the same channel within the lua_State of the
+ * worker.
+ */
+
+/*
+ * Subr.
+ */
+
+static void
+channel_fillxtable(lua_State *L, int narg, void *arg)
+{
+    luab_channel_udata_t *self;
+
+    if ((self = (luab_channel_udata_t *)arg) != NULL) {
+
+        luab_setinteger(L, narg, "card",    self->ud_ch->ch_card);
+        luab_setinteger(L, narg, "len",     luab_channel_len(self->ud_ch));
+        luab_setinteger(L, narg, "closed",  atomic_load(&self->ud_ch->ch_closed));
+    } else
+        luab_core_err(EX_DATAERR, __func__, EINVAL);
+}
+
+/*
+ * Generator functions.
+ */
+
+/***
+ * Generator function - translate (LUA_TUSERDATA(CHANNEL)) into (LUA_TTABLE).
+ *
+ * @function get_table
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              card        = (LUA_TNUMBER),
+ *              len         = (LUA_TNUMBER),
+ *              closed      = (LUA_TNUMBER),
+ *          }
+ *
+ * @usage t [, err, msg ] = channel:get_table()
+ */
+static int
+CHANNEL_get_table(lua_State *L)
+{
+    luab_module_t *m;
+    luab_xtable_param_t xtp;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(CHANNEL, TYPE, __func__);
+
+    xtp.xtp_fill = channel_fillxtable;
+    xtp.xtp_arg = luab_todata(L, 1, m, void *);
+    xtp.xtp_new = 1;
+    xtp.xtp_k = NULL;
+
+    return (luab_table_pushxtable(L, -2, &xtp));
+}
+
+/***
+ * Generator function - returns (LUA_TNIL).
+ *
+ * @function dump
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage iovec [, err, msg ] = channel:dump()
+ */
+static int
+CHANNEL_dump(lua_State *L)
+{
+    return (luab_core_dump(L, 1, NULL, 0));
+}
+
+/*
+ * Access functions.
+ */
+
+/***
+ * Get capacity of the channel.
+ *
+ * @function card
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage card [, err, msg ] = channel:card()
+ */
+static int
+CHANNEL_card(lua_State *L)
+{
+    luab_module_t *m;
+    luab_channel_udata_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(CHANNEL, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_channel_udata_t *);
+
+    return (luab_pushxinteger(L, self->ud_ch->ch_card));
+}
+
+/***
+ * Get number of queued messages, approximately.
+ *
+ * @function nmsg
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage nmsg [, err, msg ] = channel:nmsg()
+ */
+static int
+CHANNEL_nmsg(lua_State *L)
+{
+    luab_module_t *m;
+    luab_channel_udata_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(CHANNEL, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_channel_udata_t *);
+
+    return (luab_pushxinteger(L, luab_channel_len(self->ud_ch)));
+}
+
+/*
+ * Service primitives.
+ */
+
+/***
+ * Move the buffer of (LUA_TUSERDATA(IOVEC)) into the channel, sleeps
+ * while the channel is full.
+ *
+ * @function send
+ *
+ * @param buf               Instance of (LUA_TUSERDATA(IOVEC)), it is
+ *                          empty on success.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage ret [, err, msg ] = channel:send(buf)
+ */
+static int
+CHANNEL_send(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    luab_channel_udata_t *self;
+    luab_iovec_t *buf;
+    int status;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(CHANNEL, TYPE, __func__);
+    m1 = luab_xmod(IOVEC, TYPE, __func__);
+
+    self = luab_todata(L, 1, m0, luab_channel_udata_t *);
+    buf = luab_udata(L, 2, m1, luab_iovec_t *);
+
+    status = luab_channel_sendiovec(L, self->ud_ch, buf, 1, NULL);
+    return (luab_pushxinteger(L, status));
+}
+
+/***
+ * Move the buffer of (LUA_TUSERDATA(IOVEC)) into the channel, without
+ * blocking.
+ *
+ * @function try_send
+ *
+ * @param buf               Instance of (LUA_TUSERDATA(IOVEC)), it is
+ *                          empty on success.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          EAGAIN is returned, if the channel is full.
+ *
+ * @usage ret [, err, msg ] = channel:try_send(buf)
+ */
+static int
+CHANNEL_try_send(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    luab_channel_udata_t *self;
+    luab_iovec_t *buf;
+    int status;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(CHANNEL, TYPE, __func__);
+    m1 = luab_xmod(IOVEC, TYPE, __func__);
+
+    self = luab_todata(L, 1, m0, luab_channel_udata_t *);
+    buf = luab_udata(L, 2, m1, luab_iovec_t *);
+
+    status = luab_channel_sendiovec(L, self->ud_ch, buf, 0, NULL);
+    return (luab_pushxinteger(L, status));
+}
+
+/***
+ * Move the buffer of (LUA_TUSERDATA(IOVEC)) into the channel, sleeps
+ * at most timeout while the channel is full.
+ *
+ * @function timedsend
+ *
+ * @param buf               Instance of (LUA_TUSERDATA(IOVEC)), it is
+ *                          empty on success.
+ * @param timeout           Relative timeout, (LUA_TUSERDATA(TIMESPEC)).
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage ret [, err, msg ] = channel:timedsend(buf, timeout)
+ */
+static int
+CHANNEL_timedsend(lua_State *L)
+{
+    luab_module_t *m0, *m1, *m2;
+    luab_channel_udata_t *self;
+    luab_iovec_t *buf;
+    struct timespec *timeout;
+    int status;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m0 = luab_xmod(CHANNEL, TYPE, __func__);
+    m1 = luab_xmod(IOVEC, TYPE, __func__);
+    m2 = luab_xmod(TIMESPEC, TYPE, __func__);
+
+    self = luab_todata(L, 1, m0, luab_channel_udata_t *);
+    buf = luab_udata(L, 2, m1, luab_iovec_t *);
+    timeout = luab_udata(L, 3, m2, struct timespec *);
+
+    status = luab_channel_sendiovec(L, self->ud_ch, buf, 1, timeout);
+    return (luab_pushxinteger(L, status));
+}
+
+/***
+ * Receive a buffer, sleeps while the channel is empty.
+ *
+ * @function recv
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          EPIPE is returned, if the channel was closed and is empty.
+ *
+ * @usage buf [, err, msg ] = channel:recv()
+ */
+static int
+CHANNEL_recv(lua_State *L)
+{
+    luab_module_t *m;
+    luab_channel_udata_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(CHANNEL, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_channel_udata_t *);
+
+    return (luab_channel_pushiovec(L, self->ud_ch, 1, NULL));
+}
+
+/***
+ * Receive a buffer, without blocking.
+ *
+ * @function try_recv
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          EAGAIN is returned, if the channel is empty.
+ *
+ * @usage buf [, err, msg ] = channel:try_recv()
+ */
+static int
+CHANNEL_try_recv(lua_State *L)
+{
+    luab_module_t *m;
+    luab_channel_udata_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(CHANNEL, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_channel_udata_t *);
+
+    return (luab_channel_pushiovec(L, self->ud_ch, 0, NULL));
+}
+
+/***
+ * Receive a buffer, sleeps at most timeout while the channel is empty.
+ *
+ * @function timedrecv
+ *
+ * @param timeout           Relative timeout, (LUA_TUSERDATA(TIMESPEC)).
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          ETIMEDOUT is returned, if no buffer was received in time.
+ *
+ * @usage buf [, err, msg ] = channel:timedrecv(timeout)
+ */
+static int
+CHANNEL_timedrecv(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    luab_channel_udata_t *self;
+    struct timespec *timeout;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(CHANNEL, TYPE, __func__);
+    m1 = luab_xmod(TIMESPEC, TYPE, __func__);
+
+    self = luab_todata(L, 1, m0, luab_channel_udata_t *);
+    timeout = luab_udata(L, 2, m1, struct timespec *);
+
+    return (luab_channel_pushiovec(L, self->ud_ch, 1, timeout));
+}
+
+/***
+ * Close the channel, sleeping senders and receivers are woken up.
+ *
+ * @function close
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage ret [, err, msg ] = channel:close()
+ */
+static int
+CHANNEL_close(lua_State *L)
+{
+    luab_module_t *m;
+    luab_channel_udata_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(CHANNEL, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_channel_udata_t *);
+
+    luab_channel_close(self->ud_ch);
+    return (luab_pushxinteger(L, luab_env_success));
+}
+
+/*
+ * Metamethods.
+ */
+
+static int
+CHANNEL_gc(lua_State *L)
+{
+    luab_module_t *m;
+    luab_channel_udata_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(CHANNEL, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_channel_udata_t *);
+
+    if (self->ud_ch != NULL) {
+        luab_channel_rele(self->ud_ch);
+        self->ud_ch = NULL;
+    }
+    return (luab_core_gc(L, 1, m));
+}
+
+static int
+CHANNEL_len(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(CHANNEL, TYPE, __func__);
+    return (luab_core_len(L, 2, m));
+}
+
+static int
+CHANNEL_tostring(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(CHANNEL, TYPE, __func__);
+    return (luab_core_tostring(L, 1, m));
+}
+
+/*
+ * Internal interface.
+ */
+
+static luab_module_table_t channel_methods[] = {
+    LUAB_FUNC("card",           CHANNEL_card),
+    LUAB_FUNC("nmsg",           CHANNEL_nmsg),
+    LUAB_FUNC("send",           CHANNEL_send),
+    LUAB_FUNC("try_send",       CHANNEL_try_send),
+    LUAB_FUNC("timedsend",      CHANNEL_timedsend),
+    LUAB_FUNC("recv",           CHANNEL_recv),
+    LUAB_FUNC("try_recv",       CHANNEL_try_recv),
+    LUAB_FUNC("timedrecv",      CHANNEL_timedrecv),
+    LUAB_FUNC("close",          CHANNEL_close),
+    LUAB_FUNC("get_table",      CHANNEL_get_table),
+    LUAB_FUNC("dump",           CHANNEL_dump),
+    LUAB_FUNC("__gc",           CHANNEL_gc),
+    LUAB_FUNC("__len",          CHANNEL_len),
+    LUAB_FUNC("__tostring",     CHANNEL_tostring),
+    LUAB_MOD_TBL_SENTINEL
+};
+
+static void *
+channel_create(lua_State *L, void *arg)
+{
+    luab_module_t *m;
+    luab_channel_udata_t *self;
+
+    m = luab_xmod(CHANNEL, TYPE, __func__);
+
+    if (arg != NULL)
+        self = luab_newuserdata(L, m, arg);
+    else {
+        errno = EINVAL;
+        self = NULL;
+    }
+    return (self);
+}
+
+static void
+channel_init(void *ud, void *arg)
+{
+    luab_channel_udata_t *self;
+
+    if ((self = (luab_channel_udata_t *)ud) != NULL) {
+        self->ud_ch = (luab_channel_t *)arg;
+        luab_channel_hold(self->ud_ch);
+    }
+}
+
+static void *
+channel_udata(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    m = luab_xmod(CHANNEL, TYPE, __func__);
+    return (luab_todata(L, narg, m, luab_channel_udata_t *));
+}
+
+luab_module_t luab_channel_type = {
+    .m_id           = LUAB_CHANNEL_TYPE_ID,
+    .m_name         = LUAB_CHANNEL_TYPE,
+    .m_vec          = channel_methods,
+    .m_create       = channel_create,
+    .m_init         = channel_init,
+    .m_get          = channel_udata,
+    .m_len          = sizeof(luab_channel_udata_t),
+    .m_sz           = sizeof(luab_channel_t),
+};
@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+#include "luab_table.h"
+
+extern luab_module_t luab_future_type;
+
+/*
+ * Interface against
+ *
+ *  typedef struct luab_future {
+ *      luab_udata_t        ud_softc;
+ *      luab_pool_job_t     *ud_job;
+ *  } luab_future_t;
+ *
+ * whereby ud_job refers a job submitted by pool:submit. The job is
+ * shared with the worker executing it and released by the last one.
+ */
+
+typedef struct luab_future {
+    luab_udata_t        ud_softc;
+    luab_pool_job_t     *ud_job;
+} luab_future_t;
+
+/*
+ * Subr.
+ */
+
+static void
+future_fillxtable(lua_State *L, int narg, void *arg)
+{
+    luab_future_t *self;
+
+    if ((self = (luab_future_t *)arg) != NULL) {
+
+        luab_setinteger(L, narg, "done",    luab_pool_isdone(self->ud_job));
+        luab_setinteger(L, narg, "nargs",   self->ud_job->pj_nargs);
+    } else
+        luab_core_err(EX_DATAERR, __func__, EINVAL);
+}
+
+/*
+ * Generator functions.
+ */
+
+/***
+ * Generator function - translate (LUA_TUSERDATA(FUTURE)) into (LUA_TTABLE).
+ *
+ * @function get_table
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              done        = (LUA_TNUMBER),
+ *              nargs       = (LUA_TNUMBER),
+ *          }
+ *
+ * @usage t [, err, msg ] = future:get_table()
+ */
+static int
+FUTURE_get_table(lua_State *L)
+{
+    luab_module_t *m;
+    luab_xtable_param_t xtp;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(FUTURE, TYPE, __func__);
+
+    xtp.xtp_fill = future_fillxtable;
+    xtp.xtp_arg = luab_todata(L, 1, m, void *);
+    xtp.xtp_new = 1;
+    xtp.xtp_k = NULL;
+
+    return (luab_table_pushxtable(L, -2, &xtp));
+}
+
+/***
+ * Generator function - returns (LUA_TNIL).
+ *
+ * @function dump
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage iovec [, err, msg ] = future:dump()
+ */
+static int
+FUTURE_dump(lua_State *L)
+{
+    return (luab_core_dump(L, 1, NULL, 0));
+}
+
+/*
+ * Access functions.
+ */
+
+/***
+ * Test, if the job was completed.
+ *
+ * @function done
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage done [, err, msg ] = future:done()
+ */
+static int
+FUTURE_done(lua_State *L)
+{
+    luab_module_t *m;
+    luab_future_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(FUTURE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_future_t *);
+
+    return (luab_pushxinteger(L, luab_pool_isdone(self->ud_job)));
+}
+
+/***
+ * Wait for completion of the job and fetch its results.
+ *
+ * @function get
+ *
+ * @return (LUA_TBOOLEAN, ...)
+ *
+ *          Similar to pcall, either true and the values returned by
+ *          the chunk or false and the error message.
+ *
+ * @usage ok, ... = future:get()
+ */
+static int
+FUTURE_get(lua_State *L)
+{
+    luab_module_t *m;
+    luab_future_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(FUTURE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_future_t *);
+
+    return (luab_pool_pushresult(L, self->ud_job, 1));
+}
+
+/***
+ * Fetch results of the job, without blocking.
+ *
+ * @function poll
+ *
+ * @return (LUA_T{NIL,BOOLEAN}, ...)
+ *
+ *          As future:get, but (LUA_TNIL) and EAGAIN are returned, if the
+ *          job is still pending.
+ *
+ * @usage ok, ... = future:poll()
+ */
+static int
+FUTURE_poll(lua_State *L)
+{
+    luab_module_t *m;
+    luab_future_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(FUTURE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_future_t *);
+
+    return (luab_pool_pushresult(L, self->ud_job, 0));
+}
+
+/*
+ * Metamethods.
+ */
+
+static int
+FUTURE_gc(lua_State *L)
+{
+    luab_module_t *m;
+    luab_future_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(FUTURE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_future_t *);
+
+    if (self->ud_job != NULL) {
+        luab_pool_rele(self->ud_job);
+        self->ud_job = NULL;
+    }
+    return (luab_core_gc(L, 1, m));
+}
+
+static int
+FUTURE_len(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(FUTURE, TYPE, __func__);
+    return (luab_core_len(L, 2, m));
+}
+
+static int
+FUTURE_tostring(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(FUTURE, TYPE, __func__);
+    return (luab_core_tostring(L, 1, m));
+}
+
+/*
+ * Internal interface.
+ */
+
+static luab_module_table_t future_methods[] = {
+    LUAB_FUNC("done",           FUTURE_done),
+    LUAB_FUNC("get",            FUTURE_get),
+    LUAB_FUNC("poll",           FUTURE_poll),
+    LUAB_FUNC("get_table",      FUTURE_get_table),
+    LUAB_FUNC("dump",           FUTURE_dump),
+    LUAB_FUNC("__gc",           FUTURE_gc),
+    LUAB_FUNC("__len",          FUTURE_len),
+    LUAB_FUNC("__tostring",     FUTURE_tostring),
+    LUAB_MOD_TBL_SENTINEL
+};
+
+static void *
+future_create(lua_State *L, void *arg)
+{
+    luab_module_t *m;
+    luab_future_t *self;
+
+    m = luab_xmod(FUTURE, TYPE, __func__);
+
+    if (arg != NULL) {
+
+        if ((self = luab_newuserdata(L, m, arg)) == NULL)
+            luab_pool_rele((luab_pool_job_t *)arg);
+    } else {
+        errno = EINVAL;
+        self = NULL;
+    }
+    return (self);
+}
+
+static void
+future_init(void *ud, void *arg)
+{
+    luab_future_t *self;
+
+    if ((self = (luab_future_t *)ud) != NULL)
+        self->ud_job = (luab_pool_job_t *)arg;
+}
+
+static void *
+future_udata(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    m = luab_xmod(FUTURE, TYPE, __func__);
+    return (luab_todata(L, narg, m, luab_future_t *));
+}
+
+luab_module_t luab_future_type = {
+    .m_id           = LUAB_FUTURE_TYPE_ID,
+    .m_name         = LUAB_FUTURE_TYPE,
+    .m_vec          = future_methods,
+    .m_create       = future_create,
+    .m_init         = future_init,
+    .m_get          = future_udata,
+    .m_len          = sizeof(luab_future_t),
+    .m_sz           = sizeof(luab_pool_job_t),
+};
@@ -0,0 +1,392 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+#include "luab_table.h"
+
+extern luab_module_t luab_pool_type;
+
+/*
+ * Interface against
+ *
+ *  typedef struct luab_pool_udata {
+ *      luab_udata_t    ud_softc;
+ *      luab_pool_t     *ud_pool;
+ *  } luab_pool_udata_t;
+ *
+ * whereby ud_pool refers a fixed set of OS threads, each executes jobs
+ * within a lua_State of its own. The pool is shut down by close or when
+ * its instance is collected, pending jobs are completed before.
+ */
+
+typedef struct luab_pool_udata {
+    luab_udata_t    ud_softc;
+    luab_pool_t     *ud_pool;
+} luab_pool_udata_t;
+
+/*
+ * Subr.
+ */
+
+static void
+pool_fillxtable(lua_State *L, int narg, void *arg)
+{
+    luab_pool_udata_t *self;
+    luab_pool_t *pool;
+
+    if ((self = (luab_pool_udata_t *)arg) != NULL) {
+
+        if ((pool = self->ud_pool) != NULL) {
+            (void)pthread_mutex_lock(&pool->pl_mtx);
+
+            luab_setinteger(L, narg, "card",        pool->pl_card);
+            luab_setinteger(L, narg, "nthr",        pool->pl_nthr);
+            luab_setinteger(L, narg, "npending",    pool->pl_npending);
+
+            (void)pthread_mutex_unlock(&pool->pl_mtx);
+        }
+    } else
+        luab_core_err(EX_DATAERR, __func__, EINVAL);
+}
+
+/*
+ * Generator functions.
+ */
+
+/***
+ * Generator function - translate (LUA_TUSERDATA(POOL)) into (LUA_TTABLE).
+ *
+ * @function get_table
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              card        = (LUA_TNUMBER),
+ *              nthr        = (LUA_TNUMBER),
+ *              npending    = (LUA_TNUMBER),
+ *          }
+ *
+ * @usage t [, err, msg ] = pool:get_table()
+ */
+static int
+POOL_get_table(lua_State *L)
+{
+    luab_module_t *m;
+    luab_xtable_param_t xtp;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(POOL, TYPE, __func__);
+
+    xtp.xtp_fill = pool_fillxtable;
+    xtp.xtp_arg = luab_todata(L, 1, m, void *);
+    xtp.xtp_new = 1;
+    xtp.xtp_k = NULL;
+
+    return (luab_table_pushxtable(L, -2, &xtp));
+}
+
+/***
+ * Generator function - returns (LUA_TNIL).
+ *
+ * @function dump
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage iovec [, err, msg ] = pool:dump()
+ */
+static int
+POOL_dump(lua_State *L)
+{
+    return (luab_core_dump(L, 1, NULL, 0));
+}
+
+/*
+ * Access functions, immutable properties.
+ */
+
+/***
+ * Get number of worker threads.
+ *
+ * @function card
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage card [, err, msg ] = pool:card()
+ */
+static int
+POOL_card(lua_State *L)
+{
+    luab_module_t *m;
+    luab_pool_udata_t *self;
+    int card;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(POOL, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_pool_udata_t *);
+
+    if (self->ud_pool != NULL)
+        card = self->ud_pool->pl_nthr;
+    else {
+        errno = ENXIO;
+        card = luab_env_error;
+    }
+    return (luab_pushxinteger(L, card));
+}
+
+/***
+ * Get number of jobs, not yet dispatched.
+ *
+ * @function pending
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage npending [, err, msg ] = pool:pending()
+ */
+static int
+POOL_pending(lua_State *L)
+{
+    luab_module_t *m;
+    luab_pool_udata_t *self;
+    luab_pool_t *pool;
+    int npending;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(POOL, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_pool_udata_t *);
+
+    if ((pool = self->ud_pool) != NULL) {
+        (void)pthread_mutex_lock(&pool->pl_mtx);
+        npending = pool->pl_npending;
+        (void)pthread_mutex_unlock(&pool->pl_mtx);
+    } else {
+        errno = ENXIO;
+        npending = luab_env_error;
+    }
+    return (luab_pushxinteger(L, npending));
+}
+
+/*
+ * Service primitives.
+ */
+
+/***
+ * Submit a job.
+ *
+ * @function submit
+ *
+ * @param chunk             Either (LUA_TFUNCTION), it is dumped by
+ *                          lua_dump(3) and thus its upvalues are lost,
+ *                          or (LUA_TSTRING), source code or precompiled.
+ * @param ...               Arguments, values of type nil, boolean, number,
+ *                          string, (LUA_TUSERDATA(CHANNEL)) or tables
+ *                          over these.
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          The instance of (LUA_TUSERDATA(FUTURE)) yields the results.
+ *
+ * @usage future [, err, msg ] = pool:submit(chunk, ...)
+ */
+static int
+POOL_submit(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    luab_pool_udata_t *self;
+    luab_pool_job_t *job;
+
+    m0 = luab_xmod(POOL, TYPE, __func__);
+    m1 = luab_xmod(FUTURE, TYPE, __func__);
+
+    self = luab_todata(L, 1, m0, luab_pool_udata_t *);
+
+    if ((job = luab_pool_submit(L, self->ud_pool, 2)) != NULL)
+        return (luab_pushxdata(L, m1, job));
+
+    return (luab_pushnil(L));
+}
+
+/***
+ * Shut down the pool, pending jobs are completed before.
+ *
+ * @function close
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage ret [, err, msg ] = pool:close()
+ */
+static int
+POOL_close(lua_State *L)
+{
+    luab_module_t *m;
+    luab_pool_udata_t *self;
+    int status;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(POOL, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_pool_udata_t *);
+
+    if (self->ud_pool != NULL) {
+        luab_pool_free(self->ud_pool);
+        self->ud_pool = NULL;
+        status = 0;
+    } else {
+        errno = ENXIO;
+        status = luab_env_error;
+    }
+    return (luab_pushxinteger(L, status));
+}
+
+/*
+ * Metamethods.
+ */
+
+static int
+POOL_gc(lua_State *L)
+{
+    luab_module_t *m;
+    luab_pool_udata_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(POOL, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_pool_udata_t *);
+
+    if (self->ud_pool != NULL) {
+        luab_pool_free(self->ud_pool);
+        self->ud_pool = NULL;
+    }
+    return (luab_core_gc(L, 1, m));
+}
+
+static int
+POOL_len(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(POOL, TYPE, __func__);
+    return (luab_core_len(L, 2, m));
+}
+
+static int
+POOL_tostring(lua_State *L)
+{
+    luab_module_t *m;
+    luab_pool_udata_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(POOL, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_pool_udata_t *);
+
+    if (self->ud_pool != NULL)
+        lua_pushfstring(L, "pool (%d)", self->ud_pool->pl_nthr);
+    else
+        lua_pushliteral(L, "pool (closed)");
+
+    return (1);
+}
+
+/*
+ * Internal interface.
+ */
+
+static luab_module_table_t pool_methods[] = {
+    LUAB_FUNC("card",           POOL_card),
+    LUAB_FUNC("pending",        POOL_pending),
+    LUAB_FUNC("submit",         POOL_submit),
+    LUAB_FUNC("close",          POOL_close),
+    LUAB_FUNC("get_table",      POOL_get_table),
+    LUAB_FUNC("dump",           POOL_dump),
+    LUAB_FUNC("__gc",           POOL_gc),
+    LUAB_FUNC("__len",          POOL_len),
+    LUAB_FUNC("__tostring",     POOL_tostring),
+    LUAB_MOD_TBL_SENTINEL
+};
+
+static void *
+pool_create(lua_State *L, void *arg)
+{
+    luab_module_t *m;
+    luab_pool_t *pool;
+    luab_pool_udata_t *self;
+
+    m = luab_xmod(POOL, TYPE, __func__);
+
+    if (arg != NULL) {
+
+        if ((pool = luab_pool_alloc(*(int *)arg)) != NULL) {
+
+            if ((self = luab_newuserdata(L, m, pool)) == NULL)
+                luab_pool_free(pool);
+        } else
+            self = NULL;
+    } else {
+        errno = EINVAL;
+        self = NULL;
+    }
+    return (self);
+}
+
+static void
+pool_init(void *ud, void *arg)
+{
+    luab_pool_udata_t *self;
+
+    if ((self = (luab_pool_udata_t *)ud) != NULL)
+        self->ud_pool = (luab_pool_t *)arg;
+}
+
+static void *
+pool_udata(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    m = luab_xmod(POOL, TYPE, __func__);
+    return (luab_todata(L, narg, m, luab_pool_udata_t *));
+}
+
+luab_module_t luab_pool_type = {
+    .m_id           = LUAB_POOL_TYPE_ID,
+    .m_name         = LUAB_POOL_TYPE,
+    .m_vec          = pool_methods,
+    .m_create       = pool_create,
+    .m_init         = pool_init,
+    .m_get          = pool_udata,
+    .m_len          = sizeof(luab_pool_udata_t),
+    .m_sz           = sizeof(int),
+};
@@ -443,7 +443,7 @@ PASSWD_gc(lua_State *L)
     pwd = luab_udata(L, 1, m, struct passwd *);
 
     luab_core_freestr(pwd->pw_name);
-    luab_core_freestr(pwd->pw_passwd);
+    luab_core_freestrx(pwd->pw_passwd, LUAB_ALLOC_SCRUB);
     luab_core_freestr(pwd->pw_class);
     luab_core_freestr(pwd->pw_gecos);
     luab_core_freestr(pwd->pw_dir);
@@ -500,12 +500,29 @@ passwd_create(lua_State *L, void *arg)
     return (luab_newuserdata(L, m, arg));
 }
 
+/*
+ * Strings are copied, since those returned by getpw{ent,nam,uid}(3) are
+ * owned by libc and overwritten by subsequent calls.
+ */
 static void
 passwd_init(void *ud, void *arg)
 {
     luab_module_t *m;
+    struct passwd *pwd;
+
     m = luab_xmod(PASSWD, TYPE, __func__);
     luab_udata_init(m, ud, arg);
+
+    if ((ud != NULL) && (arg != NULL)) {
+        pwd = &(((luab_passwd_t *)ud)->ud_pwd);
+
+        pwd->pw_name = luab_core_allocstring(pwd->pw_name, NULL);
+        pwd->pw_passwd = luab_core_allocstring(pwd->pw_passwd, NULL);
+        pwd->pw_class = luab_core_allocstring(pwd->pw_class, NULL);
+        pwd->pw_gecos = luab_core_allocstring(pwd->pw_gecos, NULL);
+        pwd->pw_dir = luab_core_allocstring(pwd->pw_dir, NULL);
+        pwd->pw_shell = luab_core_allocstring(pwd->pw_shell, NULL);
+    }
 }
 
 static void *
@@ -51,6 +51,10 @@ extern luab_module_t luab_regex_type;
 typedef struct luab_regex {
     luab_udata_t    ud_softc;
     regex_t         ud_re;
+    regmatch_t      *ud_pmatch;
+    size_t          ud_nmatch;
+    caddr_t         ud_cap;
+    size_t          ud_caplen;
 } luab_regex_t;
 
 /*
@@ -76,6 +80,238 @@ regex_fillxtable(lua_State *L, int narg, void *arg)
         luab_core_err(EX_DATAERR, __func__, EINVAL);
 }
 
+/*
+ * By regexec(3) over [so, eo) of dp with REG_STARTEND. The vector ud_pmatch
+ * is kept with its instance and grown, if re_nsub was changed by regcomp(3).
+ */
+static int
+regex_exec(luab_regex_t *self, const char *dp, size_t so, size_t eo,
+    int eflags)
+{
+    regmatch_t *pmatch;
+    size_t nmatch;
+
+    nmatch = self->ud_re.re_nsub + 1;
+
+    if (self->ud_nmatch < nmatch) {
+
+        if ((pmatch = luab_core_realloc(self->ud_pmatch,
+            nmatch * sizeof(regmatch_t), LUAB_ALLOC_NOZERO)) == NULL)
+            return (REG_ESPACE);
+
+        self->ud_pmatch = pmatch;
+        self->ud_nmatch = nmatch;
+    } else
+        pmatch = self->ud_pmatch;
+
+    pmatch[0].rm_so = (regoff_t)so;
+    pmatch[0].rm_eo = (regoff_t)eo;
+
+    return (regexec(&(self->ud_re), dp, nmatch, pmatch,
+        eflags | REG_STARTEND));
+}
+
+/*
+ * Subject is either (LUA_TSTRING) or (LUA_TUSERDATA(IOVEC)). The latter
+ * is matched in place, its region is pinned by luab_iovec_hold() until
+ * regex_leave() is called. Nothing may raise in between, since IOV_LOCK
+ * were never dropped otherwise.
+ */
+static const char *
+regex_enter(lua_State *L, int narg, luab_iovec_t **bufp, size_t *lenp,
+    const char *fname)
+{
+    luab_iovec_t *buf;
+    const char *dp;
+
+    if ((buf = luab_isiovec(L, narg)) != NULL) {
+
+        if (luab_iovec_istxbuf(buf) == 0) {
+            errno = ERANGE;
+            buf = NULL;
+            dp = NULL;
+        } else if (luab_iovec_hold(L, buf, fname) != 0) {
+            buf = NULL;
+            dp = NULL;
+        } else if ((dp = buf->iov.iov_base) != NULL)
+            *lenp = buf->iov.iov_len;
+        else {
+            luab_iovec_rele(L, buf, fname);
+            errno = ERANGE;
+            buf = NULL;
+        }
+    } else
+        dp = luab_checklstring(L, narg, luab_env_buf_max, lenp);
+
+    *bufp = buf;
+    return (dp);
+}
+
+static void
+regex_leave(lua_State *L, luab_iovec_t *buf, const char *fname)
+{
+    if (buf != NULL)
+        luab_iovec_rele(L, buf, fname);
+}
+
+/*
+ * Whole match of an IOVEC is copied into ud_cap while held, thus its
+ * captures are pushed by regex_pushcaptures() after regex_leave(). The
+ * offset of the copy is returned by sop.
+ */
+static const char *
+regex_copyout(luab_regex_t *self, luab_iovec_t *buf, const char *dp,
+    size_t *sop)
+{
+    regmatch_t *pmatch;
+    caddr_t bp;
+    size_t len;
+
+    pmatch = self->ud_pmatch;
+
+    if (buf == NULL) {
+        *sop = 0;
+        return (dp);
+    }
+    *sop = (size_t)pmatch[0].rm_so;
+
+    if ((len = (size_t)(pmatch[0].rm_eo - pmatch[0].rm_so)) == 0)
+        return ("");
+
+    if (self->ud_caplen < len) {
+
+        if ((bp = luab_core_realloc(self->ud_cap, len,
+            LUAB_ALLOC_NOZERO)) == NULL)
+            return (NULL);
+
+        self->ud_cap = bp;
+        self->ud_caplen = len;
+    } else
+        bp = self->ud_cap;
+
+    (void)memmove(bp, dp + pmatch[0].rm_so, len);
+    return (bp);
+}
+
+/*
+ * Translates init, starting at 1 or counted from end, if negative.
+ */
+static size_t
+regex_init_off(lua_Integer init, size_t len)
+{
+    if (init < 0)
+        init = (lua_Integer)len + init + 1;
+
+    return ((init < 1) ? 0 : (size_t)(init - 1));
+}
+
+/*
+ * Either whole match, or captured substrings, if any. Offsets are
+ * relative to so, see regex_copyout().
+ */
+static int
+regex_pushcaptures(lua_State *L, const char *dp, size_t so,
+    regmatch_t *pmatch, size_t nmatch)
+{
+    size_t i;
+
+    if (nmatch == 1) {
+        lua_pushlstring(L, dp + (pmatch[0].rm_so - so),
+            (size_t)(pmatch[0].rm_eo - pmatch[0].rm_so));
+        return (1);
+    }
+
+    for (i = 1; i < nmatch; i++) {
+
+        if (pmatch[i].rm_so < 0)
+            lua_pushnil(L);
+        else
+            lua_pushlstring(L, dp + (pmatch[i].rm_so - so),
+                (size_t)(pmatch[i].rm_eo - pmatch[i].rm_so));
+    }
+    return ((int)(nmatch - 1));
+}
+
+static int
+regex_pushstatus(lua_State *L, int status)
+{
+    if (status == REG_NOMATCH) {
+        lua_pushnil(L);
+        return (1);
+    }
+    errno = (status == REG_ESPACE) ? ENOMEM : EINVAL;
+    return (luab_pushnil(L));
+}
+
+/*
+ * Iterator, position of next match is held by its upvalues.
+ */
+static int
+regex_gmatch(lua_State *L)
+{
+    luab_module_t *m;
+    luab_regex_t *self;
+    luab_iovec_t *buf;
+    const char *dp;
+    size_t len, off, so;
+    lua_Integer pos;
+    int eflags, status, n;
+
+    m = luab_xmod(REGEX, TYPE, __func__);
+    self = luab_todata(L, lua_upvalueindex(1), m, luab_regex_t *);
+    pos = lua_tointeger(L, lua_upvalueindex(3));
+    eflags = (int)lua_tointeger(L, lua_upvalueindex(4));
+
+    if (pos < 0)
+        return (0);
+
+    luaL_checkstack(L, (int)self->ud_re.re_nsub + 1, NULL);
+
+    if ((dp = regex_enter(L, lua_upvalueindex(2), &buf, &len,
+        __func__)) == NULL)
+        return (luaL_error(L, "%s: %s", __func__, strerror(errno)));
+
+    if ((off = (size_t)pos) <= len) {
+
+        if (off > 0)
+            eflags |= REG_NOTBOL;
+
+        if ((status = regex_exec(self, dp, off, len, eflags)) == 0) {
+
+            if ((dp = regex_copyout(self, buf, dp, &so)) != NULL) {
+                off = (size_t)self->ud_pmatch[0].rm_eo;
+
+                if (self->ud_pmatch[0].rm_so == self->ud_pmatch[0].rm_eo)
+                    off++;
+
+                pos = (lua_Integer)off;
+            } else {
+                status = REG_ESPACE;
+                pos = -1;
+            }
+        } else
+            pos = -1;
+    } else {
+        status = REG_NOMATCH;
+        pos = -1;
+    }
+    regex_leave(L, buf, __func__);
+
+    lua_pushinteger(L, pos);
+    lua_replace(L, lua_upvalueindex(3));
+
+    if (status == 0)
+        n = regex_pushcaptures(L, dp, so, self->ud_pmatch,
+            self->ud_re.re_nsub + 1);
+    else if (status == REG_NOMATCH)
+        n = 0;
+    else {
+        errno = (status == REG_ESPACE) ? ENOMEM : EINVAL;
+        return (luaL_error(L, "%s: %s", __func__, strerror(errno)));
+    }
+    return (n);
+}
+
 /*
  * Generator functions.
  */
@@ -131,6 +367,52 @@ REGEX_dump(lua_State *L)
     return (luab_core_dump(L, 1, m, m->m_sz));
 }
 
+/***
+ * Generator function - iterate over successive matches.
+ *
+ * @function gmatch
+ *
+ * @param subject           Either (LUA_TSTRING) or (LUA_TUSERDATA(IOVEC)),
+ *                          the latter is matched in place, EBUSY
+ *                          is raised, if it is held e. g. by aio(4).
+ * @param eflags            Values are constructed over
+ *
+ *                              bsd.regex.REG_{
+ *                                  NOTBOL,
+ *                                  NOTEOL
+ *                              }
+ *
+ *                          by inclusive OR, optional.
+ *
+ * @return (LUA_TFUNCTION)
+ *
+ * @usage for s [, ... ] in regex:gmatch(subject [, eflags ]) do ... end
+ */
+static int
+REGEX_gmatch(lua_State *L)
+{
+    luab_module_t *m;
+    int eflags;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m = luab_xmod(REGEX, TYPE, __func__);
+    (void)luab_todata(L, 1, m, luab_regex_t *);
+
+    if (luab_isiovec(L, 2) == NULL)
+        (void)luab_checklstring(L, 2, luab_env_buf_max, NULL);
+
+    eflags = lua_isnoneornil(L, 3) ? 0 : luab_checkint(L, 3);
+
+    lua_pushvalue(L, 1);
+    lua_pushvalue(L, 2);
+    lua_pushinteger(L, 0);
+    lua_pushinteger(L, eflags);
+    lua_pushcclosure(L, regex_gmatch, 4);
+
+    return (1);
+}
+
 /*
  * Access functions, immutable properties.
  */
@@ -235,6 +517,168 @@ REGEX_re_g(lua_State *L)
     return (luab_pushfstring(L, "(%p)", dp));
 }
 
+/*
+ * Service primitives.
+ */
+
+/***
+ * Match subject against compiled regular-expression.
+ *
+ * @function match
+ *
+ * @param subject           Either (LUA_TSTRING) or (LUA_TUSERDATA(IOVEC)),
+ *                          the latter is matched in place, EBUSY
+ *                          is returned, if it is held e. g. by aio(4).
+ * @param init              Position where matching starts, optional.
+ * @param eflags            Values are constructed over
+ *
+ *                              bsd.regex.REG_{
+ *                                  NOTBOL,
+ *                                  NOTEOL
+ *                              }
+ *
+ *                          by inclusive OR, optional.
+ *
+ * @return (LUA_T{NIL,STRING} [, LUA_T{NIL,STRING}, ... ])
+ *
+ *          Captured substrings, or whole match, if there are none.
+ *
+ * @usage s [, ... ] = regex:match(subject [, init [, eflags ]])
+ */
+static int
+REGEX_match(lua_State *L)
+{
+    luab_module_t *m;
+    luab_regex_t *self;
+    lua_Integer init;
+    int eflags, status;
+    luab_iovec_t *buf;
+    const char *dp;
+    size_t len, off, so;
+
+    (void)luab_core_checkmaxargs(L, 4);
+
+    m = luab_xmod(REGEX, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_regex_t *);
+    init = luaL_optinteger(L, 3, 1);
+    eflags = lua_isnoneornil(L, 4) ? 0 : luab_checkint(L, 4);
+
+    luaL_checkstack(L, (int)self->ud_re.re_nsub + 1, NULL);
+
+    if ((dp = regex_enter(L, 2, &buf, &len, __func__)) == NULL)
+        return (luab_pushnil(L));
+
+    if ((off = regex_init_off(init, len)) <= len) {
+
+        if ((status = regex_exec(self, dp, off, len, eflags)) == 0 &&
+            (dp = regex_copyout(self, buf, dp, &so)) == NULL)
+            status = REG_ESPACE;
+    } else
+        status = REG_NOMATCH;
+
+    regex_leave(L, buf, __func__);
+
+    if (status == 0)
+        status = regex_pushcaptures(L, dp, so, self->ud_pmatch,
+            self->ud_re.re_nsub + 1);
+    else
+        status = regex_pushstatus(L, status);
+
+    return (status);
+}
+
+/***
+ * Find all non-overlapping matches.
+ *
+ * @function find_all
+ *
+ * @param subject           Either (LUA_TSTRING) or (LUA_TUSERDATA(IOVEC)),
+ *                          the latter is matched in place, EBUSY
+ *                          is returned, if it is held e. g. by aio(4).
+ * @param init              Position where matching starts, optional.
+ * @param eflags            Values are constructed over
+ *
+ *                              bsd.regex.REG_{
+ *                                  NOTBOL,
+ *                                  NOTEOL
+ *                              }
+ *
+ *                          by inclusive OR, optional.
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              start1, end1,
+ *              start2, end2,
+ *                  ...
+ *              startN, endN
+ *          }
+ *
+ *          Positions are inclusive and start at 1, as by string.find.
+ *
+ * @usage t [, err, msg ] = regex:find_all(subject [, init [, eflags ]])
+ */
+static int
+REGEX_find_all(lua_State *L)
+{
+    luab_module_t *m;
+    luab_regex_t *self;
+    lua_Integer init, k;
+    int eflags, status;
+    luab_iovec_t *buf;
+    const char *dp;
+    size_t len, off;
+    regmatch_t *pmatch;
+
+    (void)luab_core_checkmaxargs(L, 4);
+
+    m = luab_xmod(REGEX, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_regex_t *);
+    init = luaL_optinteger(L, 3, 1);
+    eflags = lua_isnoneornil(L, 4) ? 0 : luab_checkint(L, 4);
+
+    lua_newtable(L);
+
+    /* subject is held by each match, but not while its bounds are set */
+    for (off = 0, k = 1; ; k += 2) {
+
+        if ((dp = regex_enter(L, 2, &buf, &len, __func__)) == NULL)
+            return (luab_pushnil(L));
+
+        if (k == 1)
+            off = regex_init_off(init, len);
+
+        if (off <= len)
+            status = regex_exec(self, dp, off, len, eflags);
+        else
+            status = REG_NOMATCH;
+
+        regex_leave(L, buf, __func__);
+
+        if (status != 0)
+            break;
+
+        pmatch = self->ud_pmatch;
+
+        lua_pushinteger(L, (lua_Integer)pmatch[0].rm_so + 1);
+        lua_rawseti(L, -2, k);
+        lua_pushinteger(L, (lua_Integer)pmatch[0].rm_eo);
+        lua_rawseti(L, -2, k + 1);
+
+        off = (size_t)pmatch[0].rm_eo;
+
+        if (pmatch[0].rm_so == pmatch[0].rm_eo)
+            off++;
+
+        eflags |= REG_NOTBOL;
+    }
+
+    if (status != REG_NOMATCH)
+        return (regex_pushstatus(L, status));
+
+    return (1);
+}
+
 /*
  * Meta-methods.
  */
@@ -243,7 +687,23 @@ static int
 REGEX_gc(lua_State *L)
 {
     luab_module_t *m;
+    luab_regex_t *self;
+
     m = luab_xmod(REGEX, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_regex_t *);
+
+    if (self->ud_pmatch != NULL) {
+        luab_core_free(self->ud_pmatch,
+            self->ud_nmatch * sizeof(regmatch_t));
+        self->ud_pmatch = NULL;
+        self->ud_nmatch = 0;
+    }
+
+    if (self->ud_cap != NULL) {
+        luab_core_free(self->ud_cap, self->ud_caplen);
+        self->ud_cap = NULL;
+        self->ud_caplen = 0;
+    }
     return (luab_core_gc(L, 1, m));
 }
 
@@ -272,6 +732,9 @@ static luab_module_table_t regex_methods[] = {
     LUAB_FUNC("re_nsub",        REGEX_re_nsub),
     LUAB_FUNC("re_endp",        REGEX_re_endp),
     LUAB_FUNC("re_g",           REGEX_re_g),
+    LUAB_FUNC("match",          REGEX_match),
+    LUAB_FUNC("gmatch",         REGEX_gmatch),
+    LUAB_FUNC("find_all",       REGEX_find_all),
     LUAB_FUNC("get_table",      REGEX_get_table),
     LUAB_FUNC("dump",           REGEX_dump),
     LUAB_FUNC("__gc",           REGEX_gc),
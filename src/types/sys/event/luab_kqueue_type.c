@@ -0,0 +1,748 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/event.h>
+#include <sys/time.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+#include "luab_table.h"
+
+#if __BSD_VISIBLE
+extern luab_module_t luab_kqueue_type;
+
+/*
+ * Interface against kqueue(2), by
+ *
+ *  typedef struct luab_kqueue {
+ *      luab_udata_t    ud_softc;
+ *      int             ud_kq;
+ *      int             ud_card;
+ *      int             ud_nchanges;
+ *      int             ud_nevents;
+ *      struct kevent   *ud_changelist;
+ *      struct kevent   *ud_eventlist;
+ *  } luab_kqueue_t;
+ *
+ * whereby both vectors are allocated once with capacity ud_card. Changes
+ * are queued by set_event and submitted by the next call of wait, ready
+ * events are stored in ud_eventlist and accessed by index, thus a batch
+ * is delivered without producing any garbage.
+ */
+
+typedef struct luab_kqueue {
+    luab_udata_t    ud_softc;
+    int             ud_kq;
+    int             ud_card;
+    int             ud_nchanges;
+    int             ud_nevents;
+    struct kevent   *ud_changelist;
+    struct kevent   *ud_eventlist;
+} luab_kqueue_t;
+
+/*
+ * Subr.
+ */
+
+static void
+kqueue_free(luab_kqueue_t *self)
+{
+    size_t sz;
+
+    if (self != NULL) {
+        sz = sizeof(struct kevent);
+
+        if (self->ud_changelist != NULL) {
+            luab_core_free(self->ud_changelist, self->ud_card * sz);
+            self->ud_changelist = NULL;
+        }
+
+        if (self->ud_eventlist != NULL) {
+            luab_core_free(self->ud_eventlist, self->ud_card * sz);
+            self->ud_eventlist = NULL;
+        }
+        self->ud_nchanges = 0;
+        self->ud_nevents = 0;
+        self->ud_card = 0;
+    } else
+        errno = EINVAL;
+}
+
+static int
+kqueue_close(luab_kqueue_t *self)
+{
+    int status;
+
+    if (self != NULL) {
+
+        if (self->ud_kq >= 0) {
+
+            if ((status = close(self->ud_kq)) == 0)
+                self->ud_kq = -1;
+        } else {
+            errno = EBADF;
+            status = luab_env_error;
+        }
+        kqueue_free(self);
+    } else {
+        errno = EINVAL;
+        status = luab_env_error;
+    }
+    return (status);
+}
+
+static struct kevent *
+kqueue_checkevent(lua_State *L, int narg, luab_kqueue_t *self)
+{
+    luab_module_t *m;
+    int idx;
+
+    m = luab_xmod(INT, TYPE, __func__);
+    idx = (int)luab_checkxinteger(L, narg, m, luab_env_int_max);
+
+    if ((self->ud_eventlist != NULL) &&
+        (idx > 0) &&
+        (idx <= self->ud_nevents))
+        return (&(self->ud_eventlist[idx - 1]));
+
+    errno = ERANGE;
+    return (NULL);
+}
+
+static void
+kqueue_fillxtable(lua_State *L, int narg, void *arg)
+{
+    luab_kqueue_t *self;
+
+    if ((self = (luab_kqueue_t *)arg) != NULL) {
+
+        luab_setinteger(L, narg, "kq",          self->ud_kq);
+        luab_setinteger(L, narg, "card",        self->ud_card);
+        luab_setinteger(L, narg, "nchanges",    self->ud_nchanges);
+        luab_setinteger(L, narg, "nevents",     self->ud_nevents);
+    } else
+        luab_core_err(EX_DATAERR, __func__, EINVAL);
+}
+
+/*
+ * Generator functions.
+ */
+
+/***
+ * Generator function - translate (LUA_TUSERDATA(KQUEUE)) into (LUA_TTABLE).
+ *
+ * @function get_table
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              kq          = (LUA_TNUMBER),
+ *              card        = (LUA_TNUMBER),
+ *              nchanges    = (LUA_TNUMBER),
+ *              nevents     = (LUA_TNUMBER),
+ *          }
+ *
+ * @usage t [, err, msg ] = kqueue:get_table()
+ */
+static int
+KQUEUE_get_table(lua_State *L)
+{
+    luab_module_t *m;
+    luab_xtable_param_t xtp;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(KQUEUE, TYPE, __func__);
+
+    xtp.xtp_fill = kqueue_fillxtable;
+    xtp.xtp_arg = luab_todata(L, 1, m, void *);
+    xtp.xtp_new = 1;
+    xtp.xtp_k = NULL;
+
+    return (luab_table_pushxtable(L, -2, &xtp));
+}
+
+/***
+ * Generator function - returns (LUA_TNIL).
+ *
+ * @function dump
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage iovec [, err, msg ] = kqueue:dump()
+ */
+static int
+KQUEUE_dump(lua_State *L)
+{
+    return (luab_core_dump(L, 1, NULL, 0));
+}
+
+/*
+ * Access functions, immutable properties.
+ */
+
+/***
+ * Get file descriptor of the kqueue(2).
+ *
+ * @function fd
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage fd [, err, msg ] = kqueue:fd()
+ */
+static int
+KQUEUE_fd(lua_State *L)
+{
+    luab_module_t *m;
+    luab_kqueue_t *self;
+    int fd;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(KQUEUE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_kqueue_t *);
+
+    if ((fd = self->ud_kq) < 0) {
+        errno = EBADF;
+        fd = luab_env_error;
+    }
+    return (luab_pushxinteger(L, fd));
+}
+
+/***
+ * Get capacity of changelist and eventlist.
+ *
+ * @function card
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage card [, err, msg ] = kqueue:card()
+ */
+static int
+KQUEUE_card(lua_State *L)
+{
+    luab_module_t *m;
+    luab_kqueue_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(KQUEUE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_kqueue_t *);
+
+    return (luab_pushxinteger(L, self->ud_card));
+}
+
+/***
+ * Get number of events returned by recent call of wait.
+ *
+ * @function nevents
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage nevents [, err, msg ] = kqueue:nevents()
+ */
+static int
+KQUEUE_nevents(lua_State *L)
+{
+    luab_module_t *m;
+    luab_kqueue_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(KQUEUE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_kqueue_t *);
+
+    return (luab_pushxinteger(L, self->ud_nevents));
+}
+
+/*
+ * Access functions, ready events.
+ */
+
+/***
+ * Get identifier of n-th ready event.
+ *
+ * @function get_ident
+ *
+ * @param idx               Index, starts by 1.
+ *
+ * @return (LUA_T{NIL,NUMBER} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage ident [, err, msg ] = kqueue:get_ident(idx)
+ */
+static int
+KQUEUE_get_ident(lua_State *L)
+{
+    luab_module_t *m;
+    luab_kqueue_t *self;
+    struct kevent *kev;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(KQUEUE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_kqueue_t *);
+
+    if ((kev = kqueue_checkevent(L, 2, self)) != NULL)
+        return (luab_pushxinteger(L, kev->ident));
+
+    return (luab_pushnil(L));
+}
+
+/***
+ * Get filter of n-th ready event.
+ *
+ * @function get_filter
+ *
+ * @param idx               Index, starts by 1.
+ *
+ * @return (LUA_T{NIL,NUMBER} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage filter [, err, msg ] = kqueue:get_filter(idx)
+ */
+static int
+KQUEUE_get_filter(lua_State *L)
+{
+    luab_module_t *m;
+    luab_kqueue_t *self;
+    struct kevent *kev;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(KQUEUE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_kqueue_t *);
+
+    if ((kev = kqueue_checkevent(L, 2, self)) != NULL)
+        return (luab_pushxinteger(L, kev->filter));
+
+    return (luab_pushnil(L));
+}
+
+/***
+ * Get flags of n-th ready event.
+ *
+ * @function get_flags
+ *
+ * @param idx               Index, starts by 1.
+ *
+ * @return (LUA_T{NIL,NUMBER} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage flags [, err, msg ] = kqueue:get_flags(idx)
+ */
+static int
+KQUEUE_get_flags(lua_State *L)
+{
+    luab_module_t *m;
+    luab_kqueue_t *self;
+    struct kevent *kev;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(KQUEUE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_kqueue_t *);
+
+    if ((kev = kqueue_checkevent(L, 2, self)) != NULL)
+        return (luab_pushxinteger(L, kev->flags));
+
+    return (luab_pushnil(L));
+}
+
+/***
+ * Get filter-specific flags of n-th ready event.
+ *
+ * @function get_fflags
+ *
+ * @param idx               Index, starts by 1.
+ *
+ * @return (LUA_T{NIL,NUMBER} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage fflags [, err, msg ] = kqueue:get_fflags(idx)
+ */
+static int
+KQUEUE_get_fflags(lua_State *L)
+{
+    luab_module_t *m;
+    luab_kqueue_t *self;
+    struct kevent *kev;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(KQUEUE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_kqueue_t *);
+
+    if ((kev = kqueue_checkevent(L, 2, self)) != NULL)
+        return (luab_pushxinteger(L, kev->fflags));
+
+    return (luab_pushnil(L));
+}
+
+/***
+ * Get filter-specific data of n-th ready event, e. g. the
+ * amount of bytes ready for rx by EVFILT_READ.
+ *
+ * @function get_data
+ *
+ * @param idx               Index, starts by 1.
+ *
+ * @return (LUA_T{NIL,NUMBER} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage data [, err, msg ] = kqueue:get_data(idx)
+ */
+static int
+KQUEUE_get_data(lua_State *L)
+{
+    luab_module_t *m;
+    luab_kqueue_t *self;
+    struct kevent *kev;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(KQUEUE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_kqueue_t *);
+
+    if ((kev = kqueue_checkevent(L, 2, self)) != NULL)
+        return (luab_pushxinteger(L, kev->data));
+
+    return (luab_pushnil(L));
+}
+
+/*
+ * Event notification.
+ */
+
+/***
+ * Queue a change, those are submitted by next call of wait.
+ *
+ * If the changelist is exhausted, pending changes are flushed by kevent(2).
+ *
+ * @function set_event
+ *
+ * @param ident             Identifier, e. g. file descriptor, signal number
+ *                          or an arbitrary value for EVFILT_TIMER.
+ * @param filter            Filter, over
+ *
+ *                              bsd.sys.event.EVFILT_{READ,WRITE,AIO,VNODE,
+ *                                  PROC,SIGNAL,TIMER,PROCDESC,FS,LIO,USER,
+ *                                  SENDFILE,EMPTY}
+ *
+ * @param flags             Actions, over
+ *
+ *                              bsd.sys.event.EV_{ADD,DELETE,ENABLE,DISABLE,
+ *                                  ONESHOT,CLEAR,RECEIPT,DISPATCH}
+ *
+ *                          may combined by inclusive or.
+ * @param fflags            Filter-specific flags, optional.
+ * @param data              Filter-specific data, optional, e. g. the
+ *                          period in ms by EVFILT_TIMER.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage nchanges [, err, msg ] = kqueue:set_event(ident, filter, flags [, fflags [, data ]])
+ */
+static int
+KQUEUE_set_event(lua_State *L)
+{
+    luab_module_t *m0, *m1, *m2, *m3, *m4;
+    luab_kqueue_t *self;
+    int narg;
+    uintptr_t ident;
+    short filter;
+    u_short flags;
+    u_int fflags;
+    int64_t data;
+    struct kevent *kev;
+    int status;
+
+    narg = luab_core_checkmaxargs(L, 6);
+
+    m0 = luab_xmod(KQUEUE, TYPE, __func__);
+    m1 = luab_xmod(UINTPTR, TYPE, __func__);
+    m2 = luab_xmod(SHORT, TYPE, __func__);
+    m3 = luab_xmod(USHRT, TYPE, __func__);
+    m4 = luab_xmod(UINT, TYPE, __func__);
+
+    self = luab_todata(L, 1, m0, luab_kqueue_t *);
+    ident = (uintptr_t)luab_checklxinteger(L, 2, m1, 1);
+    filter = (short)luab_checkxinteger(L, 3, m2, luab_env_ushrt_max);
+    flags = (u_short)luab_checkxinteger(L, 4, m3, luab_env_ushrt_max);
+    fflags = (narg > 4) ?
+        (u_int)luab_checkxinteger(L, 5, m4, luab_env_uint_max) : 0;
+    data = (narg > 5) ? (int64_t)luab_checkinteger(L, 6, luab_env_llong_max) : 0;
+
+    if ((self->ud_kq >= 0) &&
+        (self->ud_changelist != NULL)) {
+
+        if (self->ud_nchanges == self->ud_card) {
+
+            if (kevent(self->ud_kq, self->ud_changelist,
+                self->ud_nchanges, NULL, 0, NULL) == 0)
+                self->ud_nchanges = 0;
+        }
+
+        if (self->ud_nchanges < self->ud_card) {
+            kev = &(self->ud_changelist[self->ud_nchanges]);
+            EV_SET(kev, ident, filter, flags, fflags, data, NULL);
+            status = ++(self->ud_nchanges);
+        } else
+            status = luab_env_error;
+    } else {
+        errno = EBADF;
+        status = luab_env_error;
+    }
+    return (luab_pushxinteger(L, status));
+}
+
+/***
+ * Submit queued changes and wait for events, see kevent(2).
+ *
+ * The call blocks without holding any lock, thus other threads are not
+ * affected. If kevent(2) fails, queued changes are retained and passed
+ * again by the next call. Ready events are accessed by get_{ident,filter,flags,fflags,
+ * data}, e. g. by passing get_ident(idx) to iovec:{read,recv,write,send}.
+ *
+ * @function wait
+ *
+ * @param timeout           Instance of (LUA_TUSERDATA(TIMESPEC)) or
+ *                          (LUA_TNIL) for blocking infinitely.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage nevents [, err, msg ] = kqueue:wait([ timeout ])
+ */
+static int
+KQUEUE_wait(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    luab_kqueue_t *self;
+    struct timespec *timeout;
+    int nchanges;
+    int status;
+
+    m0 = luab_xmod(KQUEUE, TYPE, __func__);
+    m1 = luab_xmod(TIMESPEC, TYPE, __func__);
+
+    if (luab_core_checkmaxargs(L, 2) > 1)
+        timeout = luab_udataisnil(L, 2, m1, struct timespec *);
+    else
+        timeout = NULL;
+
+    self = luab_todata(L, 1, m0, luab_kqueue_t *);
+
+    if ((self->ud_kq >= 0) &&
+        (self->ud_eventlist != NULL)) {
+        nchanges = self->ud_nchanges;
+
+        self->ud_nevents = 0;
+
+        /* queued changes are retained, until accepted by kevent(2) */
+        if ((status = kevent(self->ud_kq, self->ud_changelist, nchanges,
+            self->ud_eventlist, self->ud_card, timeout)) >= 0) {
+            self->ud_nchanges = 0;
+            self->ud_nevents = status;
+        }
+    } else {
+        errno = EBADF;
+        status = luab_env_error;
+    }
+    return (luab_pushxinteger(L, status));
+}
+
+/***
+ * Close the kqueue(2) and release its vectors.
+ *
+ * @function close
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage ret [, err, msg ] = kqueue:close()
+ */
+static int
+KQUEUE_close(lua_State *L)
+{
+    luab_module_t *m;
+    luab_kqueue_t *self;
+    int status;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(KQUEUE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_kqueue_t *);
+    status = kqueue_close(self);
+
+    return (luab_pushxinteger(L, status));
+}
+
+/*
+ * Metamethods.
+ */
+
+static int
+KQUEUE_gc(lua_State *L)
+{
+    luab_module_t *m;
+    luab_kqueue_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(KQUEUE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_kqueue_t *);
+
+    if (self->ud_kq >= 0)
+        (void)kqueue_close(self);
+    else
+        kqueue_free(self);
+
+    return (luab_core_gc(L, 1, m));
+}
+
+static int
+KQUEUE_len(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(KQUEUE, TYPE, __func__);
+    return (luab_core_len(L, 2, m));
+}
+
+static int
+KQUEUE_tostring(lua_State *L)
+{
+    luab_module_t *m;
+    luab_kqueue_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(KQUEUE, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_kqueue_t *);
+
+    if (self->ud_kq >= 0)
+        lua_pushfstring(L, "kqueue (%d)", self->ud_kq);
+    else
+        lua_pushliteral(L, "kqueue (closed)");
+
+    return (1);
+}
+
+/*
+ * Internal interface.
+ */
+
+static luab_module_table_t kqueue_methods[] = {
+    LUAB_FUNC("fd",             KQUEUE_fd),
+    LUAB_FUNC("card",           KQUEUE_card),
+    LUAB_FUNC("nevents",        KQUEUE_nevents),
+    LUAB_FUNC("set_event",      KQUEUE_set_event),
+    LUAB_FUNC("wait",           KQUEUE_wait),
+    LUAB_FUNC("get_ident",      KQUEUE_get_ident),
+    LUAB_FUNC("get_filter",     KQUEUE_get_filter),
+    LUAB_FUNC("get_flags",      KQUEUE_get_flags),
+    LUAB_FUNC("get_fflags",     KQUEUE_get_fflags),
+    LUAB_FUNC("get_data",       KQUEUE_get_data),
+    LUAB_FUNC("close",          KQUEUE_close),
+    LUAB_FUNC("get_table",      KQUEUE_get_table),
+    LUAB_FUNC("dump",           KQUEUE_dump),
+    LUAB_FUNC("__gc",           KQUEUE_gc),
+    LUAB_FUNC("__len",          KQUEUE_len),
+    LUAB_FUNC("__tostring",     KQUEUE_tostring),
+    LUAB_MOD_TBL_SENTINEL
+};
+
+static void *
+kqueue_create(lua_State *L, void *arg)
+{
+    luab_module_t *m;
+    luab_kqueue_t kq, *self;
+    size_t sz;
+
+    m = luab_xmod(KQUEUE, TYPE, __func__);
+
+    if (arg != NULL) {
+        (void)memset_s(&kq, sizeof(kq), 0, sizeof(kq));
+
+        sz = sizeof(struct kevent);
+
+        kq.ud_card = *(int *)arg;
+        kq.ud_changelist = luab_core_alloc(kq.ud_card, sz);
+        kq.ud_eventlist = luab_core_alloc(kq.ud_card, sz);
+
+        if ((kq.ud_changelist != NULL) &&
+            (kq.ud_eventlist != NULL) &&
+            ((kq.ud_kq = kqueue()) >= 0)) {
+
+            if ((self = luab_newuserdata(L, m, &kq)) == NULL)
+                (void)kqueue_close(&kq);
+        } else {
+            kq.ud_kq = -1;
+            kqueue_free(&kq);
+            self = NULL;
+        }
+    } else {
+        errno = EINVAL;
+        self = NULL;
+    }
+    return (self);
+}
+
+static void
+kqueue_init(void *ud, void *arg)
+{
+    luab_kqueue_t *self, *kq;
+
+    if (((self = (luab_kqueue_t *)ud) != NULL) &&
+        ((kq = (luab_kqueue_t *)arg) != NULL)) {
+        self->ud_kq = kq->ud_kq;
+        self->ud_card = kq->ud_card;
+        self->ud_changelist = kq->ud_changelist;
+        self->ud_eventlist = kq->ud_eventlist;
+    }
+}
+
+static void *
+kqueue_udata(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    m = luab_xmod(KQUEUE, TYPE, __func__);
+    return (luab_todata(L, narg, m, luab_kqueue_t *));
+}
+
+luab_module_t luab_kqueue_type = {
+    .m_id           = LUAB_KQUEUE_TYPE_ID,
+    .m_name         = LUAB_KQUEUE_TYPE,
+    .m_vec          = kqueue_methods,
+    .m_create       = kqueue_create,
+    .m_init         = kqueue_init,
+    .m_get          = kqueue_udata,
+    .m_len          = sizeof(luab_kqueue_t),
+    .m_sz           = sizeof(int),
+};
+#endif /* __BSD_VISIBLE */
@@ -274,13 +274,10 @@ static int
 SIGVEC_gc(lua_State *L)
 {
     luab_module_t *m;
-    struct sigvec *sv;
 
     (void)luab_core_checkmaxargs(L, 1);
 
     m = luab_xmod(SIGVEC, TYPE, __func__);
-    sv = luab_udata(L, 1, m, struct sigvec *);
-    (void)luab_core_free(sv->sv_handler, sv->sv_mask);
     return (luab_core_gc(L, 1, m));
 }
 
@@ -0,0 +1,616 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+#include "luab_table.h"
+
+#if __BSD_VISIBLE
+extern luab_module_t luab_mmsgbatch_type;
+
+/*
+ * Interface against
+ *
+ *  typedef struct luab_mmsgbatch {
+ *      luab_udata_t            ud_softc;
+ *      size_t                  ud_card;
+ *      size_t                  ud_buflen;
+ *      struct mmsghdr          *ud_vec;
+ *      struct iovec            *ud_iov;
+ *      struct sockaddr_storage *ud_addr;
+ *      caddr_t                 ud_buf;
+ *  } luab_mmsgbatch_t;
+ *
+ * whereby slots are accessed by index in [1, card]. The vectors are
+ * allocated once, recvmmsg(2) and sendmmsg(2) operate on them without
+ * any translation.
+ */
+
+/*
+ * Subr.
+ */
+
+static void
+mmsgbatch_free(luab_mmsgbatch_t *self)
+{
+    if (self->ud_buf != NULL)
+        luab_core_free(self->ud_buf, self->ud_card * self->ud_buflen);
+
+    if (self->ud_addr != NULL)
+        luab_core_free(self->ud_addr,
+            self->ud_card * sizeof(struct sockaddr_storage));
+
+    if (self->ud_iov != NULL)
+        luab_core_free(self->ud_iov, self->ud_card * sizeof(struct iovec));
+
+    if (self->ud_vec != NULL)
+        luab_core_free(self->ud_vec, self->ud_card * sizeof(struct mmsghdr));
+
+    self->ud_buf = NULL;
+    self->ud_addr = NULL;
+    self->ud_iov = NULL;
+    self->ud_vec = NULL;
+    self->ud_card = 0;
+}
+
+static size_t
+mmsgbatch_checkslot(lua_State *L, int narg, luab_mmsgbatch_t *self)
+{
+    luab_module_t *m;
+    size_t idx;
+
+    m = luab_xmod(SIZE, TYPE, __func__);
+    idx = (size_t)luab_checklxinteger(L, narg, m, 0);
+
+    if (idx < 1 || idx > self->ud_card)
+        luab_core_argerror(L, narg, NULL, 0, 0, ERANGE);
+
+    return (idx - 1);
+}
+
+static void
+mmsgbatch_fillxtable(lua_State *L, int narg, void *arg)
+{
+    luab_mmsgbatch_t *self;
+
+    if ((self = (luab_mmsgbatch_t *)arg) != NULL) {
+
+        luab_setinteger(L, narg, "card",        self->ud_card);
+        luab_setinteger(L, narg, "buflen",      self->ud_buflen);
+    } else
+        luab_core_err(EX_DATAERR, __func__, EINVAL);
+}
+
+/*
+ * Generator functions.
+ */
+
+/***
+ * Generator function - translate (LUA_TUSERDATA(MMSGBATCH)) into (LUA_TTABLE).
+ *
+ * @function get_table
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              card        = (LUA_TNUMBER),
+ *              buflen      = (LUA_TNUMBER),
+ *          }
+ *
+ * @usage t [, err, msg ] = mmsgbatch:get_table()
+ */
+static int
+MMSGBATCH_get_table(lua_State *L)
+{
+    luab_module_t *m;
+    luab_xtable_param_t xtp;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(MMSGBATCH, TYPE, __func__);
+
+    xtp.xtp_fill = mmsgbatch_fillxtable;
+    xtp.xtp_arg = luab_todata(L, 1, m, void *);
+    xtp.xtp_new = 1;
+    xtp.xtp_k = NULL;
+
+    return (luab_table_pushxtable(L, -2, &xtp));
+}
+
+/***
+ * Generator function - returns (LUA_TNIL).
+ *
+ * @function dump
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage iovec [, err, msg ] = mmsgbatch:dump()
+ */
+static int
+MMSGBATCH_dump(lua_State *L)
+{
+    return (luab_core_dump(L, 1, NULL, 0));
+}
+
+/*
+ * Access functions, immutable properties.
+ */
+
+/***
+ * Get number of slots.
+ *
+ * @function card
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage card [, err, msg ] = mmsgbatch:card()
+ */
+static int
+MMSGBATCH_card(lua_State *L)
+{
+    luab_module_t *m;
+    luab_mmsgbatch_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(MMSGBATCH, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_mmsgbatch_t *);
+
+    return (luab_pushxinteger(L, self->ud_card));
+}
+
+/***
+ * Get capacity of each slot.
+ *
+ * @function buflen
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage buflen [, err, msg ] = mmsgbatch:buflen()
+ */
+static int
+MMSGBATCH_buflen(lua_State *L)
+{
+    luab_module_t *m;
+    luab_mmsgbatch_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(MMSGBATCH, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_mmsgbatch_t *);
+
+    return (luab_pushxinteger(L, self->ud_buflen));
+}
+
+/*
+ * Access functions.
+ */
+
+/***
+ * Copy data into a slot, its length is set accordingly.
+ *
+ * @function set_data
+ *
+ * @param idx               Index of the slot.
+ * @param data              Instance of (LUA_TSTRING), at most buflen bytes.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage len [, err, msg ] = mmsgbatch:set_data(idx, data)
+ */
+static int
+MMSGBATCH_set_data(lua_State *L)
+{
+    luab_module_t *m;
+    luab_mmsgbatch_t *self;
+    const char *dp;
+    size_t i, len;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m = luab_xmod(MMSGBATCH, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_mmsgbatch_t *);
+
+    i = mmsgbatch_checkslot(L, 2, self);
+    dp = luaL_checklstring(L, 3, &len);
+
+    if (len <= self->ud_buflen) {
+        (void)memmove(self->ud_iov[i].iov_base, dp, len);
+        self->ud_iov[i].iov_len = len;
+        self->ud_vec[i].msg_len = len;
+    } else {
+        errno = EMSGSIZE;
+        return (luab_pushxinteger(L, luab_env_error));
+    }
+    return (luab_pushxinteger(L, len));
+}
+
+/***
+ * Get data of a slot, i. e. msg_len bytes as received, sent or set by
+ * set_{data,len}.
+ *
+ * @function get_data
+ *
+ * @param idx               Index of the slot.
+ *
+ * @return (LUA_T{NIL,STRING} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage data [, err, msg ] = mmsgbatch:get_data(idx)
+ */
+static int
+MMSGBATCH_get_data(lua_State *L)
+{
+    luab_module_t *m;
+    luab_mmsgbatch_t *self;
+    size_t i, len;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(MMSGBATCH, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_mmsgbatch_t *);
+
+    i = mmsgbatch_checkslot(L, 2, self);
+
+    if ((len = self->ud_vec[i].msg_len) > self->ud_buflen)
+        len = self->ud_buflen;
+
+    lua_pushlstring(L, self->ud_iov[i].iov_base, len);
+    return (1);
+}
+
+/***
+ * Set length of the data, about to be sent from a slot.
+ *
+ * @function set_len
+ *
+ * @param idx               Index of the slot.
+ * @param len               Length, at most buflen.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage len [, err, msg ] = mmsgbatch:set_len(idx, len)
+ */
+static int
+MMSGBATCH_set_len(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    luab_mmsgbatch_t *self;
+    size_t i, len;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m0 = luab_xmod(MMSGBATCH, TYPE, __func__);
+    m1 = luab_xmod(SIZE, TYPE, __func__);
+
+    self = luab_todata(L, 1, m0, luab_mmsgbatch_t *);
+    i = mmsgbatch_checkslot(L, 2, self);
+    len = (size_t)luab_checklxinteger(L, 3, m1, 0);
+
+    if (len <= self->ud_buflen) {
+        self->ud_iov[i].iov_len = len;
+        self->ud_vec[i].msg_len = len;
+    } else {
+        errno = EMSGSIZE;
+        return (luab_pushxinteger(L, luab_env_error));
+    }
+    return (luab_pushxinteger(L, len));
+}
+
+/***
+ * Get number of bytes received or sent by the slot, or about to be sent,
+ * as set by set_{data,len}.
+ *
+ * @function get_len
+ *
+ * @param idx               Index of the slot.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage len [, err, msg ] = mmsgbatch:get_len(idx)
+ */
+static int
+MMSGBATCH_get_len(lua_State *L)
+{
+    luab_module_t *m;
+    luab_mmsgbatch_t *self;
+    size_t i;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(MMSGBATCH, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_mmsgbatch_t *);
+
+    i = mmsgbatch_checkslot(L, 2, self);
+
+    return (luab_pushxinteger(L, self->ud_vec[i].msg_len));
+}
+
+/***
+ * Get flags of the message received by the slot.
+ *
+ * @function get_flags
+ *
+ * @param idx               Index of the slot.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage flags [, err, msg ] = mmsgbatch:get_flags(idx)
+ */
+static int
+MMSGBATCH_get_flags(lua_State *L)
+{
+    luab_module_t *m;
+    luab_mmsgbatch_t *self;
+    size_t i;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(MMSGBATCH, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_mmsgbatch_t *);
+
+    i = mmsgbatch_checkslot(L, 2, self);
+
+    return (luab_pushxinteger(L, self->ud_vec[i].msg_hdr.msg_flags));
+}
+
+/***
+ * Set destination address of a slot.
+ *
+ * @function set_addr
+ *
+ * @param idx               Index of the slot.
+ * @param sockaddr          Instance of (LUA_TUSERDATA(SOCKADDR)) or nil,
+ *                          if the socket(9) is connected.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage namelen [, err, msg ] = mmsgbatch:set_addr(idx, sockaddr)
+ */
+static int
+MMSGBATCH_set_addr(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    luab_mmsgbatch_t *self;
+    struct sockaddr *sa;
+    struct msghdr *msg;
+    size_t i;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m0 = luab_xmod(MMSGBATCH, TYPE, __func__);
+    m1 = luab_xmod(SOCKADDR, TYPE, __func__);
+
+    self = luab_todata(L, 1, m0, luab_mmsgbatch_t *);
+    i = mmsgbatch_checkslot(L, 2, self);
+    sa = luab_udataisnil(L, 3, m1, struct sockaddr *);
+
+    msg = &(self->ud_vec[i].msg_hdr);
+
+    if (sa != NULL) {
+
+        if (sa->sa_len > sizeof(struct sockaddr_storage)) {
+            errno = EINVAL;
+            return (luab_pushxinteger(L, luab_env_error));
+        }
+        (void)memmove(&(self->ud_addr[i]), sa, sa->sa_len);
+        msg->msg_name = &(self->ud_addr[i]);
+        msg->msg_namelen = sa->sa_len;
+    } else {
+        msg->msg_name = NULL;
+        msg->msg_namelen = 0;
+    }
+    return (luab_pushxinteger(L, msg->msg_namelen));
+}
+
+/***
+ * Get address of the peer, a slot received from.
+ *
+ * @function get_addr
+ *
+ * @param idx               Index of the slot.
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage sockaddr [, err, msg ] = mmsgbatch:get_addr(idx)
+ */
+static int
+MMSGBATCH_get_addr(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    luab_mmsgbatch_t *self;
+    struct msghdr *msg;
+    size_t i;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m0 = luab_xmod(MMSGBATCH, TYPE, __func__);
+    m1 = luab_xmod(SOCKADDR, TYPE, __func__);
+
+    self = luab_todata(L, 1, m0, luab_mmsgbatch_t *);
+    i = mmsgbatch_checkslot(L, 2, self);
+
+    msg = &(self->ud_vec[i].msg_hdr);
+
+    if (msg->msg_name == NULL || msg->msg_namelen == 0) {
+        errno = EADDRNOTAVAIL;
+        return (luab_pushnil(L));
+    }
+    return (luab_pushxdata(L, m1, msg->msg_name));
+}
+
+/*
+ * Metamethods.
+ */
+
+static int
+MMSGBATCH_gc(lua_State *L)
+{
+    luab_module_t *m;
+    luab_mmsgbatch_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(MMSGBATCH, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_mmsgbatch_t *);
+
+    mmsgbatch_free(self);
+
+    return (luab_core_gc(L, 1, m));
+}
+
+static int
+MMSGBATCH_len(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(MMSGBATCH, TYPE, __func__);
+    return (luab_core_len(L, 2, m));
+}
+
+static int
+MMSGBATCH_tostring(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(MMSGBATCH, TYPE, __func__);
+    return (luab_core_tostring(L, 1, m));
+}
+
+/*
+ * Internal interface.
+ */
+
+static luab_module_table_t mmsgbatch_methods[] = {
+    LUAB_FUNC("card",           MMSGBATCH_card),
+    LUAB_FUNC("buflen",         MMSGBATCH_buflen),
+    LUAB_FUNC("set_data",       MMSGBATCH_set_data),
+    LUAB_FUNC("set_len",        MMSGBATCH_set_len),
+    LUAB_FUNC("set_addr",       MMSGBATCH_set_addr),
+    LUAB_FUNC("get_data",       MMSGBATCH_get_data),
+    LUAB_FUNC("get_len",        MMSGBATCH_get_len),
+    LUAB_FUNC("get_flags",      MMSGBATCH_get_flags),
+    LUAB_FUNC("get_addr",       MMSGBATCH_get_addr),
+    LUAB_FUNC("get_table",      MMSGBATCH_get_table),
+    LUAB_FUNC("dump",           MMSGBATCH_dump),
+    LUAB_FUNC("__gc",           MMSGBATCH_gc),
+    LUAB_FUNC("__len",          MMSGBATCH_len),
+    LUAB_FUNC("__tostring",     MMSGBATCH_tostring),
+    LUAB_MOD_TBL_SENTINEL
+};
+
+static void *
+mmsgbatch_create(lua_State *L, void *arg)
+{
+    luab_module_t *m;
+    luab_mmsgbatch_param_t *mbp;
+    luab_mmsgbatch_t mb, *self;
+    struct msghdr *msg;
+    size_t i;
+
+    m = luab_xmod(MMSGBATCH, TYPE, __func__);
+
+    if ((mbp = (luab_mmsgbatch_param_t *)arg) != NULL) {
+        (void)memset_s(&mb, sizeof(mb), 0, sizeof(mb));
+
+        mb.ud_card = mbp->mbp_card;
+        mb.ud_buflen = mbp->mbp_buflen;
+
+        mb.ud_vec = luab_core_alloc(mb.ud_card, sizeof(struct mmsghdr));
+        mb.ud_iov = luab_core_alloc(mb.ud_card, sizeof(struct iovec));
+        mb.ud_addr = luab_core_alloc(mb.ud_card,
+            sizeof(struct sockaddr_storage));
+        mb.ud_buf = luab_core_alloc(mb.ud_card, mb.ud_buflen);
+
+        if ((mb.ud_vec != NULL) &&
+            (mb.ud_iov != NULL) &&
+            (mb.ud_addr != NULL) &&
+            (mb.ud_buf != NULL)) {
+
+            for (i = 0; i < mb.ud_card; i++) {
+                mb.ud_iov[i].iov_base = mb.ud_buf + (i * mb.ud_buflen);
+                mb.ud_iov[i].iov_len = mb.ud_buflen;
+
+                msg = &(mb.ud_vec[i].msg_hdr);
+                msg->msg_iov = &(mb.ud_iov[i]);
+                msg->msg_iovlen = 1;
+            }
+
+            if ((self = luab_newuserdata(L, m, &mb)) == NULL)
+                mmsgbatch_free(&mb);
+        } else {
+            mmsgbatch_free(&mb);
+            self = NULL;
+        }
+    } else {
+        errno = EINVAL;
+        self = NULL;
+    }
+    return (self);
+}
+
+static void
+mmsgbatch_init(void *ud, void *arg)
+{
+    luab_mmsgbatch_t *self, *mb;
+
+    if (((self = (luab_mmsgbatch_t *)ud) != NULL) &&
+        ((mb = (luab_mmsgbatch_t *)arg) != NULL)) {
+        self->ud_card = mb->ud_card;
+        self->ud_buflen = mb->ud_buflen;
+        self->ud_vec = mb->ud_vec;
+        self->ud_iov = mb->ud_iov;
+        self->ud_addr = mb->ud_addr;
+        self->ud_buf = mb->ud_buf;
+    }
+}
+
+static void *
+mmsgbatch_udata(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    m = luab_xmod(MMSGBATCH, TYPE, __func__);
+    return (luab_todata(L, narg, m, luab_mmsgbatch_t *));
+}
+
+luab_module_t luab_mmsgbatch_type = {
+    .m_id           = LUAB_MMSGBATCH_TYPE_ID,
+    .m_name         = LUAB_MMSGBATCH_TYPE,
+    .m_vec          = mmsgbatch_methods,
+    .m_create       = mmsgbatch_create,
+    .m_init         = mmsgbatch_init,
+    .m_get          = mmsgbatch_udata,
+    .m_len          = sizeof(luab_mmsgbatch_t),
+    .m_sz           = sizeof(struct mmsghdr),
+};
+#endif /* __BSD_VISIBLE */
@@ -0,0 +1,681 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+#include "luab_table.h"
+
+extern luab_module_t luab_iovec_array_type;
+
+/*
+ * Interface against
+ *
+ *  typedef struct luab_iovec_array {
+ *      luab_udata_t    ud_softc;
+ *      struct iovec    *ud_vec;
+ *      luab_iovec_t    **ud_buf;
+ *      size_t          ud_card;
+ *      size_t          ud_cnt;
+ *  } luab_iovec_array_t;
+ *
+ * whereby ud_buf[0 .. ud_cnt - 1] refers (LUA_TUSERDATA(IOVEC)) kept by
+ * the uservalue at indices 1 .. ud_cnt. The regions are mapped in place
+ * on ud_vec, when {p}{read,write}v(2) is called.
+ */
+
+typedef struct luab_iovec_array {
+    luab_udata_t    ud_softc;
+    struct iovec    *ud_vec;
+    luab_iovec_t    **ud_buf;
+    size_t          ud_card;
+    size_t          ud_cnt;
+} luab_iovec_array_t;
+
+#define IOVA_READV      0x00
+#define IOVA_WRITEV     0x01
+#define IOVA_PREADV     0x02
+#define IOVA_PWRITEV    0x03
+
+#define iovec_array_isrx(op) \
+    (((op) & IOVA_WRITEV) == 0)
+
+/*
+ * Subr.
+ */
+
+static void
+iovec_array_free(luab_iovec_array_t *self)
+{
+    if (self->ud_vec != NULL)
+        luab_core_free(self->ud_vec, self->ud_card * sizeof(struct iovec));
+
+    if (self->ud_buf != NULL)
+        luab_core_free(self->ud_buf, self->ud_card * sizeof(luab_iovec_t *));
+
+    self->ud_vec = NULL;
+    self->ud_buf = NULL;
+    self->ud_cnt = 0;
+}
+
+/*
+ * Locks each buffer by IOV_LOCK and maps its region on ud_vec, thus
+ * a buffer may not be referred twice. Received data is bound by the
+ * capacity, transmitted data by the length of each buffer.
+ */
+static int
+iovec_array_hold(lua_State *L, luab_iovec_array_t *self, int op)
+{
+    luab_iovec_t *buf;
+    size_t i, k;
+    int status;
+
+    status = luab_env_success;
+
+    luab_thread_mtx_lock(L, __func__);
+
+    for (i = 0; i < self->ud_cnt; i++) {
+        buf = self->ud_buf[i];
+
+        if (iovec_array_isrx(op) ?
+            (luab_iovec_isrxbuf(buf) == 0) : (luab_iovec_istxbuf(buf) == 0)) {
+            errno = ERANGE;
+            status = luab_env_error;
+            break;
+        }
+
+        if ((buf->iov_flags & IOV_LOCK) != 0) {
+            errno = EBUSY;
+            status = luab_env_error;
+            break;
+        }
+        buf->iov_flags |= IOV_LOCK;
+
+        self->ud_vec[i].iov_base = buf->iov.iov_base;
+        self->ud_vec[i].iov_len = iovec_array_isrx(op) ?
+            buf->iov_max_len : buf->iov.iov_len;
+    }
+
+    if (status != 0) {
+        for (k = 0; k < i; k++)
+            self->ud_buf[k]->iov_flags &= ~IOV_LOCK;
+    }
+    luab_thread_mtx_unlock(L, __func__);
+
+    return (status);
+}
+
+/*
+ * Releases each buffer, received data is distributed in order.
+ */
+static void
+iovec_array_rele(lua_State *L, luab_iovec_array_t *self, int op,
+    ssize_t count)
+{
+    luab_iovec_t *buf;
+    size_t i, len;
+
+    luab_thread_mtx_lock(L, __func__);
+
+    for (i = 0; i < self->ud_cnt; i++) {
+        buf = self->ud_buf[i];
+
+        if (iovec_array_isrx(op) && count >= 0) {
+            len = self->ud_vec[i].iov_len;
+
+            if ((size_t)count < len)
+                len = (size_t)count;
+
+            buf->iov.iov_len = len;
+            count -= len;
+        }
+        buf->iov_flags &= ~IOV_LOCK;
+    }
+    luab_thread_mtx_unlock(L, __func__);
+}
+
+static int
+iovec_array_io(lua_State *L, int op)
+{
+    luab_module_t *m;
+    luab_iovec_array_t *self;
+    struct iovec *iov;
+    int fd, iovcnt;
+    off_t offset;
+    ssize_t count;
+
+    m = luab_xmod(IOVEC_ARRAY, TYPE, __func__);
+
+    if (op == IOVA_PREADV || op == IOVA_PWRITEV) {
+        (void)luab_core_checkmaxargs(L, 3);
+        offset = luab_checkoff(L, 3);
+    } else {
+        (void)luab_core_checkmaxargs(L, 2);
+        offset = 0;
+    }
+    self = luab_udata(L, 1, m, luab_iovec_array_t *);
+    fd = luab_checkint(L, 2);
+
+    iov = self->ud_vec;
+    iovcnt = (int)self->ud_cnt;
+
+    if (iovec_array_hold(L, self, op) != 0)
+        return (luab_pushxinteger(L, luab_env_error));
+
+    switch (op) {
+    case IOVA_READV:
+        count = readv(fd, iov, iovcnt);
+        break;
+    case IOVA_WRITEV:
+        count = writev(fd, iov, iovcnt);
+        break;
+#if __BSD_VISIBLE
+    case IOVA_PREADV:
+        count = preadv(fd, iov, iovcnt, offset);
+        break;
+    case IOVA_PWRITEV:
+        count = pwritev(fd, iov, iovcnt, offset);
+        break;
+#endif
+    default:
+        errno = EINVAL;
+        count = luab_env_error;
+        break;
+    }
+    iovec_array_rele(L, self, op, count);
+
+    return (luab_pushxinteger(L, count));
+}
+
+static void
+iovec_array_fillxtable(lua_State *L, int narg, void *arg)
+{
+    luab_iovec_array_t *self;
+
+    if ((self = (luab_iovec_array_t *)arg) != NULL) {
+
+        luab_setinteger(L, narg, "card",    self->ud_card);
+        luab_setinteger(L, narg, "cnt",     self->ud_cnt);
+    } else
+        luab_core_err(EX_DATAERR, __func__, EINVAL);
+}
+
+/*
+ * Generator functions.
+ */
+
+/***
+ * Generator function - translate (LUA_TUSERDATA(IOVEC_ARRAY)) into (LUA_TTABLE).
+ *
+ * @function get_table
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              card    = (LUA_TNUMBER),
+ *              cnt     = (LUA_TNUMBER),
+ *          }
+ *
+ * @usage t [, err, msg ] = iovec_array:get_table()
+ */
+static int
+IOVEC_ARRAY_get_table(lua_State *L)
+{
+    luab_module_t *m;
+    luab_xtable_param_t xtp;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(IOVEC_ARRAY, TYPE, __func__);
+
+    xtp.xtp_fill = iovec_array_fillxtable;
+    xtp.xtp_arg = luab_todata(L, 1, m, void *);
+    xtp.xtp_new = 1;
+    xtp.xtp_k = NULL;
+
+    return (luab_table_pushxtable(L, -2, &xtp));
+}
+
+/***
+ * Generator function - returns (LUA_TNIL).
+ *
+ * @function dump
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage iovec [, err, msg ] = iovec_array:dump()
+ */
+static int
+IOVEC_ARRAY_dump(lua_State *L)
+{
+    return (luab_core_dump(L, 1, NULL, 0));
+}
+
+/*
+ * Access functions, immutable properties.
+ */
+
+/***
+ * Get capacity.
+ *
+ * @function card
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage card [, err, msg ] = iovec_array:card()
+ */
+static int
+IOVEC_ARRAY_card(lua_State *L)
+{
+    luab_module_t *m;
+    luab_iovec_array_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(IOVEC_ARRAY, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_iovec_array_t *);
+
+    return (luab_pushxinteger(L, self->ud_card));
+}
+
+/*
+ * Access functions.
+ */
+
+/***
+ * Get number of referred buffers.
+ *
+ * @function get_cnt
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage cnt [, err, msg ] = iovec_array:get_cnt()
+ */
+static int
+IOVEC_ARRAY_get_cnt(lua_State *L)
+{
+    luab_module_t *m;
+    luab_iovec_array_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(IOVEC_ARRAY, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_iovec_array_t *);
+
+    return (luab_pushxinteger(L, self->ud_cnt));
+}
+
+/***
+ * Refer (LUA_TUSERDATA(IOVEC)) at index i, without copying.
+ *
+ * @function set
+ *
+ * @param i                 Index, 1 .. get_cnt() + 1, the latter appends.
+ * @param buf               Instance of (LUA_TUSERDATA(IOVEC)).
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage cnt [, err, msg ] = iovec_array:set(i, buf)
+ */
+static int
+IOVEC_ARRAY_set(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    luab_iovec_array_t *self;
+    luab_iovec_t *buf;
+    size_t i;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m0 = luab_xmod(IOVEC_ARRAY, TYPE, __func__);
+    m1 = luab_xmod(IOVEC, TYPE, __func__);
+
+    self = luab_udata(L, 1, m0, luab_iovec_array_t *);
+    i = luab_checksize(L, 2);
+    buf = luab_udata(L, 3, m1, luab_iovec_t *);
+
+    if (i < 1 || i > (self->ud_cnt + 1) || i > self->ud_card) {
+        errno = ERANGE;
+        return (luab_pushxinteger(L, luab_env_error));
+    }
+    lua_getuservalue(L, 1);
+    lua_pushvalue(L, 3);
+    lua_rawseti(L, -2, (int)i);
+    lua_pop(L, 1);
+
+    self->ud_buf[i - 1] = buf;
+
+    if (i > self->ud_cnt)
+        self->ud_cnt = i;
+
+    return (luab_pushxinteger(L, self->ud_cnt));
+}
+
+/***
+ * Append (LUA_TUSERDATA(IOVEC)), without copying.
+ *
+ * @function append
+ *
+ * @param buf               Instance of (LUA_TUSERDATA(IOVEC)).
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage cnt [, err, msg ] = iovec_array:append(buf)
+ */
+static int
+IOVEC_ARRAY_append(lua_State *L)
+{
+    luab_module_t *m;
+    luab_iovec_array_t *self;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(IOVEC_ARRAY, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_iovec_array_t *);
+
+    lua_pushinteger(L, (lua_Integer)self->ud_cnt + 1);
+    lua_insert(L, 2);
+
+    return (IOVEC_ARRAY_set(L));
+}
+
+/***
+ * Get (LUA_TUSERDATA(IOVEC)) at index i.
+ *
+ * @function get
+ *
+ * @param i                 Index, 1 .. get_cnt().
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage buf [, err, msg ] = iovec_array:get(i)
+ */
+static int
+IOVEC_ARRAY_get(lua_State *L)
+{
+    luab_module_t *m;
+    luab_iovec_array_t *self;
+    size_t i;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(IOVEC_ARRAY, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_iovec_array_t *);
+    i = luab_checksize(L, 2);
+
+    if (i < 1 || i > self->ud_cnt) {
+        errno = ERANGE;
+        return (luab_pushnil(L));
+    }
+    lua_getuservalue(L, 1);
+    lua_rawgeti(L, -1, (int)i);
+
+    return (1);
+}
+
+/***
+ * Drop references on each (LUA_TUSERDATA(IOVEC)).
+ *
+ * @function clear
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage ret [, err, msg ] = iovec_array:clear()
+ */
+static int
+IOVEC_ARRAY_clear(lua_State *L)
+{
+    luab_module_t *m;
+    luab_iovec_array_t *self;
+    size_t i;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(IOVEC_ARRAY, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_iovec_array_t *);
+
+    lua_getuservalue(L, 1);
+
+    for (i = 1; i <= self->ud_cnt; i++) {
+        lua_pushnil(L);
+        lua_rawseti(L, -2, (int)i);
+        self->ud_buf[i - 1] = NULL;
+    }
+    lua_pop(L, 1);
+
+    self->ud_cnt = 0;
+
+    return (luab_pushxinteger(L, luab_env_success));
+}
+
+/***
+ * readv(2) - read input into referred buffers
+ *
+ * @function readv
+ *
+ * @param fd                Open file descriptor.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          Received data is distributed in order, the length of each
+ *          buffer is updated.
+ *
+ * @usage count [, err, msg ] = iovec_array:readv(fd)
+ */
+static int
+IOVEC_ARRAY_readv(lua_State *L)
+{
+    return (iovec_array_io(L, IOVA_READV));
+}
+
+/***
+ * writev(2) - write output from referred buffers
+ *
+ * @function writev
+ *
+ * @param fd                Open file descriptor.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage count [, err, msg ] = iovec_array:writev(fd)
+ */
+static int
+IOVEC_ARRAY_writev(lua_State *L)
+{
+    return (iovec_array_io(L, IOVA_WRITEV));
+}
+
+/***
+ * preadv(2) - read input into referred buffers at offset
+ *
+ * @function preadv
+ *
+ * @param fd                Open file descriptor.
+ * @param offset            Offset.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage count [, err, msg ] = iovec_array:preadv(fd, offset)
+ */
+static int
+IOVEC_ARRAY_preadv(lua_State *L)
+{
+    return (iovec_array_io(L, IOVA_PREADV));
+}
+
+/***
+ * pwritev(2) - write output from referred buffers at offset
+ *
+ * @function pwritev
+ *
+ * @param fd                Open file descriptor.
+ * @param offset            Offset.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage count [, err, msg ] = iovec_array:pwritev(fd, offset)
+ */
+static int
+IOVEC_ARRAY_pwritev(lua_State *L)
+{
+    return (iovec_array_io(L, IOVA_PWRITEV));
+}
+
+/*
+ * Metamethods.
+ */
+
+static int
+IOVEC_ARRAY_gc(lua_State *L)
+{
+    luab_module_t *m;
+    luab_iovec_array_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(IOVEC_ARRAY, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_iovec_array_t *);
+
+    iovec_array_free(self);
+
+    return (luab_core_gc(L, 1, m));
+}
+
+static int
+IOVEC_ARRAY_len(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(IOVEC_ARRAY, TYPE, __func__);
+    return (luab_core_len(L, 2, m));
+}
+
+static int
+IOVEC_ARRAY_tostring(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(IOVEC_ARRAY, TYPE, __func__);
+    return (luab_core_tostring(L, 1, m));
+}
+
+/*
+ * Internal interface.
+ */
+
+static luab_module_table_t iovec_array_methods[] = {
+    LUAB_FUNC("card",           IOVEC_ARRAY_card),
+    LUAB_FUNC("get_cnt",        IOVEC_ARRAY_get_cnt),
+    LUAB_FUNC("set",            IOVEC_ARRAY_set),
+    LUAB_FUNC("get",            IOVEC_ARRAY_get),
+    LUAB_FUNC("append",         IOVEC_ARRAY_append),
+    LUAB_FUNC("clear",          IOVEC_ARRAY_clear),
+    LUAB_FUNC("readv",          IOVEC_ARRAY_readv),
+    LUAB_FUNC("writev",         IOVEC_ARRAY_writev),
+    LUAB_FUNC("preadv",         IOVEC_ARRAY_preadv),
+    LUAB_FUNC("pwritev",        IOVEC_ARRAY_pwritev),
+    LUAB_FUNC("get_table",      IOVEC_ARRAY_get_table),
+    LUAB_FUNC("dump",           IOVEC_ARRAY_dump),
+    LUAB_FUNC("__gc",           IOVEC_ARRAY_gc),
+    LUAB_FUNC("__len",          IOVEC_ARRAY_len),
+    LUAB_FUNC("__tostring",     IOVEC_ARRAY_tostring),
+    LUAB_MOD_TBL_SENTINEL
+};
+
+static void *
+iovec_array_create(lua_State *L, void *arg)
+{
+    luab_module_t *m;
+    luab_iovec_array_t iova, *self;
+    size_t card;
+
+    m = luab_xmod(IOVEC_ARRAY, TYPE, __func__);
+
+    if ((arg == NULL) ||
+        ((card = *(size_t *)arg) < 1) ||
+        (card > IOV_MAX)) {
+        errno = EINVAL;
+        return (NULL);
+    }
+    (void)memset(&iova, 0, sizeof(iova));
+
+    iova.ud_card = card;
+
+    if (((iova.ud_vec = luab_core_alloc(card,
+        sizeof(struct iovec))) == NULL) ||
+        ((iova.ud_buf = luab_core_alloc(card,
+        sizeof(luab_iovec_t *))) == NULL))
+        goto bad;
+
+    if ((self = luab_newuserdata(L, m, &iova)) != NULL) {
+        lua_createtable(L, (int)card, 0);
+        lua_setuservalue(L, -2);
+        return (self);
+    }
+bad:
+    iovec_array_free(&iova);
+    return (NULL);
+}
+
+static void
+iovec_array_init(void *ud, void *arg)
+{
+    luab_iovec_array_t *self, *iova;
+
+    if (((self = (luab_iovec_array_t *)ud) != NULL) &&
+        ((iova = (luab_iovec_array_t *)arg) != NULL)) {
+        self->ud_vec = iova->ud_vec;
+        self->ud_buf = iova->ud_buf;
+        self->ud_card = iova->ud_card;
+    }
+}
+
+static void *
+iovec_array_udata(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    m = luab_xmod(IOVEC_ARRAY, TYPE, __func__);
+    return (luab_todata(L, narg, m, luab_iovec_array_t *));
+}
+
+luab_module_t luab_iovec_array_type = {
+    .m_id           = LUAB_IOVEC_ARRAY_TYPE_ID,
+    .m_name         = LUAB_IOVEC_ARRAY_TYPE,
+    .m_vec          = iovec_array_methods,
+    .m_create       = iovec_array_create,
+    .m_init         = iovec_array_init,
+    .m_get          = iovec_array_udata,
+    .m_len          = sizeof(luab_iovec_array_t),
+    .m_sz           = sizeof(size_t),
+};
@@ -24,6 +24,7 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <sys/mman.h>
 #include <sys/uio.h>
 
 #include <stdlib.h>
@@ -146,6 +147,63 @@ IOVEC_clone(lua_State *L)
     return (status);
 }
 
+/***
+ * Generator function, creates (LUA_TUSERDATA(SLICE)) referring bytes
+ * in [i, j] without copying, indices are translated as string.sub does.
+ *
+ * @function slice
+ *
+ * @param i                 Index of first byte, optional.
+ * @param j                 Index of last byte, optional.
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage slice [, err, msg ] = iovec:slice([ i [, j ]])
+ */
+static int
+IOVEC_slice(lua_State *L)
+{
+    luab_module_t *m0, *m1;
+    luab_iovec_t *self;
+    luab_slice_param_t slp;
+    lua_Integer i, j, len;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m0 = luab_xmod(IOVEC, TYPE, __func__);
+    m1 = luab_xmod(SLICE, TYPE, __func__);
+
+    self = luab_udata(L, 1, m0, luab_iovec_t *);
+
+    i = luaL_optinteger(L, 2, 1);
+    j = luaL_optinteger(L, 3, -1);
+
+    luab_thread_mtx_lock(L, __func__);
+    len = (lua_Integer)self->iov.iov_len;
+    luab_thread_mtx_unlock(L, __func__);
+
+    if (i < 0)
+        i = len + i + 1;
+    if (j < 0)
+        j = len + j + 1;
+    if (i < 1)
+        i = 1;
+    if (j > len)
+        j = len;
+
+    slp.slp_narg = 1;
+    slp.slp_buf = self;
+
+    if (i > j) {
+        slp.slp_off = 0;
+        slp.slp_len = 0;
+    } else {
+        slp.slp_off = (size_t)(i - 1);
+        slp.slp_len = (size_t)(j - i + 1);
+    }
+    return (luab_pushxdata(L, m1, &slp));
+}
+
 /***
  * Generator function - returns (LUA_TNIL).
  *
@@ -231,9 +289,13 @@ IOVEC_set_len(lua_State *L)
 
         luab_thread_mtx_lock(L, __func__);;
 
-        iov->iov_len = nbytes;
-        len = nbytes;
-
+        if ((self->iov_flags & IOV_LOCK) == 0) {
+            iov->iov_len = nbytes;
+            len = nbytes;
+        } else {
+            errno = EBUSY;
+            len = luab_env_error;
+        }
         luab_thread_mtx_unlock(L, __func__);;
     } else {
         errno = ERANGE;
@@ -300,7 +362,16 @@ IOVEC_clear(lua_State *L)
 
     luab_thread_mtx_lock(L, __func__);;
 
-    if (self->iov_flags & IOV_BUFF)
+    if (self->iov_flags & IOV_LOCK) {
+        errno = EBUSY;
+        status = luab_env_error;
+    } else if (self->iov_flags & IOV_RDONLY) {
+        errno = EACCES;
+        status = luab_env_error;
+    } else if (self->iov_flags & IOV_MMAP) {
+        errno = EINVAL;
+        status = luab_env_error;
+    } else if (self->iov_flags & IOV_BUFF)
         status = luab_iov_clear(iov);
     else {
         errno = ERANGE;
@@ -402,7 +473,13 @@ IOVEC_resize(lua_State *L)
 
     luab_thread_mtx_lock(L, __func__);;
 
-    if (self->iov_flags & IOV_BUFF) {
+    if (self->iov_flags & IOV_LOCK) {
+        errno = EBUSY;
+        status = luab_env_error;
+    } else if (self->iov_flags & IOV_MMAP) {
+        errno = EINVAL;
+        status = luab_env_error;
+    } else if (self->iov_flags & IOV_BUFF) {
 
         if ((status = luab_iov_realloc(iov, len)) == 0) {
 
@@ -565,21 +642,44 @@ IOVEC_gc(lua_State *L)
 {
     luab_module_t *m;
     luab_iovec_t *self;
+    struct iovec iov;
     caddr_t dp;
     size_t len;
+    u_int flags;
+    int status;
 
     (void)luab_core_checkmaxargs(L, 1);
 
     m = luab_xmod(IOVEC, TYPE, __func__);
     self = luab_udata(L, 1, m, luab_iovec_t *);
 
-    if (((dp = self->iov.iov_base) != NULL) &&
-        (self->iov_flags & IOV_BUFF)) {
-        len = self->iov_max_len;
+    luab_thread_mtx_lock(L, __func__);
+
+    iov = self->iov;
+    len = self->iov_max_len;
+    flags = self->iov_flags;
+
+    if (flags & IOV_LOCK) {
+        /* luab_thread_mtx is not recursive, see luab_udata_xremove() */
+        status = luab_core_xgc(L, 1, m);
+
+        /* still held, e. g. by aio(4), released by luab_iovec_rele() */
+        self->iov = iov;
+        self->iov_max_len = len;
+        self->iov_flags = flags | IOV_ORPHAN;
+    }
+    luab_thread_mtx_unlock(L, __func__);
 
-        (void)memset_s(dp, len, 0, len);
+    if (flags & IOV_LOCK)
+        return (status);
 
-        free(dp);
+    if (((dp = iov.iov_base) != NULL) &&
+        (flags & IOV_BUFF)) {
+
+        if ((flags & IOV_MMAP) == 0)
+            luab_core_freex(dp, len, LUAB_ALLOC_SCRUB);
+        else
+            (void)munmap(dp, len);
     } else
         dp = NULL;
 
@@ -613,6 +713,7 @@ static luab_module_table_t iovec_methods[] = {
     LUAB_FUNC("max_len",        IOVEC_max_len),
     LUAB_FUNC("clear",          IOVEC_clear),
     LUAB_FUNC("clone",          IOVEC_clone),
+    LUAB_FUNC("slice",          IOVEC_slice),
     LUAB_FUNC("copy_in",        IOVEC_copy_in),
     LUAB_FUNC("copy_out",       IOVEC_copy_out),
     LUAB_FUNC("resize",         IOVEC_resize),
@@ -638,7 +739,13 @@ iovec_create(lua_State *L, void *arg)
     m = luab_xmod(IOVEC, TYPE, __func__);
 
     if ((iop = (luab_iovec_param_t *)arg) != NULL) {
-        if ((max_len = iop->iop_iov.iov_len) > 1) {
+        if (iop->iop_flags & (IOV_BUFF|IOV_MMAP)) {
+            /* adopt region, e. g. mapped or received over (LUA_TUSERDATA(CHANNEL)) */
+            if (iop->iop_iov.iov_base != NULL)
+                iop->iop_flags |= IOV_BUFF;
+            else
+                iop->iop_flags = IOV_PROXY;
+        } else if ((max_len = iop->iop_iov.iov_len) > 1) {
 
             if (luab_iov_alloc(&iop->iop_iov, max_len) != 0)
                 iop->iop_flags = IOV_PROXY;
@@ -671,14 +778,15 @@ iovec_init(void *ud, void *arg)
         self->iov.iov_base = iop->iop_iov.iov_base;
         self->iov_max_len = iop->iop_iov.iov_len;
 
-        if (((max_len = self->iov_max_len) > 1) &&
+        if (((max_len = self->iov_max_len) > 0) &&
             ((dst = self->iov.iov_base) != NULL)) {
 
             if (((src = iop->iop_data.iov_base) != NULL) &&
                 ((len = iop->iop_data.iov_len) <= max_len)) {
                 (void)memmove(dst, src, len);
                 self->iov.iov_len = len;
-            }
+            } else if ((len = iop->iop_data.iov_len) <= max_len)
+                self->iov.iov_len = len;
         }
         self->iov_flags = iop->iop_flags;
     }
@@ -0,0 +1,913 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+#include "luab_table.h"
+
+extern luab_module_t luab_ringbuf_type;
+
+/*
+ * Interface against
+ *
+ *  typedef struct luab_ringbuf {
+ *      luab_udata_t    ud_softc;
+ *      struct iovec    ud_iov;
+ *      size_t          ud_max_len;
+ *      size_t          ud_head;
+ *      size_t          ud_len;
+ *  } luab_ringbuf_t;
+ *
+ * whereby ud_len bytes starting at ud_head are held by the region ud_iov,
+ * modulo its iov_len. The region grows by doubling, bound by ud_max_len.
+ */
+
+typedef struct luab_ringbuf {
+    luab_udata_t    ud_softc;
+    struct iovec    ud_iov;
+    size_t          ud_max_len;
+    size_t          ud_head;
+    size_t          ud_len;
+} luab_ringbuf_t;
+
+#define LUAB_RINGBUF_FRAME_WIDTH    4
+
+/*
+ * Subr.
+ */
+
+/*
+ * Returns pointer on byte at offset k relative to ud_head and the
+ * number of bytes contiguously stored from there.
+ */
+static u_char *
+ringbuf_seg(luab_ringbuf_t *self, size_t k, size_t *n)
+{
+    u_char *bp;
+    size_t size, off;
+
+    bp = self->ud_iov.iov_base;
+    size = self->ud_iov.iov_len;
+    off = (self->ud_head + k) % size;
+
+    *n = size - off;
+
+    if (*n > (self->ud_len - k))
+        *n = self->ud_len - k;
+
+    return (bp + off);
+}
+
+static void
+ringbuf_copyout(luab_ringbuf_t *self, size_t k, void *v, size_t len)
+{
+    u_char *dp, *bp;
+    size_t n;
+
+    for (dp = v; len > 0; dp += n, k += n, len -= n) {
+        bp = ringbuf_seg(self, k, &n);
+
+        if (n > len)
+            n = len;
+
+        (void)memmove(dp, bp, n);
+    }
+}
+
+static int
+ringbuf_match(luab_ringbuf_t *self, size_t k, const u_char *dp, size_t len)
+{
+    u_char *bp;
+    size_t n;
+
+    for (; len > 0; dp += n, k += n, len -= n) {
+        bp = ringbuf_seg(self, k, &n);
+
+        if (n > len)
+            n = len;
+
+        if (memcmp(bp, dp, n) != 0)
+            return (0);
+    }
+    return (1);
+}
+
+/*
+ * Returns offset of first occurence of dp at or after init, or -1.
+ */
+static ssize_t
+ringbuf_find(luab_ringbuf_t *self, size_t init, const u_char *dp,
+    size_t len)
+{
+    u_char *bp, *hit;
+    size_t k, n;
+
+    if (len == 0)
+        return ((init <= self->ud_len) ? (ssize_t)init : -1);
+
+    for (k = init; (k + len) <= self->ud_len; ) {
+        bp = ringbuf_seg(self, k, &n);
+
+        if ((hit = memchr(bp, dp[0], n)) == NULL) {
+            k += n;
+            continue;
+        }
+        k += (size_t)(hit - bp);
+
+        if ((k + len) > self->ud_len)
+            break;
+
+        if (ringbuf_match(self, k, dp, len) != 0)
+            return ((ssize_t)k);
+
+        k++;
+    }
+    return (-1);
+}
+
+static void
+ringbuf_consume(luab_ringbuf_t *self, size_t n)
+{
+    if (n < self->ud_len) {
+        self->ud_head = (self->ud_head + n) % self->ud_iov.iov_len;
+        self->ud_len -= n;
+    } else {
+        self->ud_head = 0;
+        self->ud_len = 0;
+    }
+}
+
+/*
+ * Ensures, at least n bytes may be appended. On growth, bytes stored
+ * before the wrap point are moved towards the end of the region.
+ */
+static int
+ringbuf_reserve(luab_ringbuf_t *self, size_t n)
+{
+    caddr_t bp;
+    size_t size, len, seg;
+
+    size = self->ud_iov.iov_len;
+
+    if (n <= (size - self->ud_len))
+        return (luab_env_success);
+
+    if (n > (self->ud_max_len - self->ud_len)) {
+        errno = ENOBUFS;
+        return (luab_env_error);
+    }
+    len = self->ud_len + n;
+
+    while (size < len && size <= (self->ud_max_len >> 1))
+        size <<= 1;
+
+    if (size < len)
+        size = self->ud_max_len;
+
+    seg = self->ud_iov.iov_len - self->ud_head;
+
+    if (luab_iov_realloc(&self->ud_iov, size) != 0)
+        return (luab_env_error);
+
+    if (self->ud_len > seg) {
+        bp = self->ud_iov.iov_base;
+        (void)memmove(bp + size - seg, bp + self->ud_head, seg);
+        self->ud_head = size - seg;
+    }
+    return (luab_env_success);
+}
+
+/*
+ * Maps free (UIO_READ) or held (UIO_WRITE) bytes on iov[2].
+ */
+static int
+ringbuf_iov(luab_ringbuf_t *self, struct iovec *iov, size_t len, int rw)
+{
+    u_char *bp;
+    size_t size, off, n;
+    int iovcnt;
+
+    bp = self->ud_iov.iov_base;
+    size = self->ud_iov.iov_len;
+
+    if (rw == UIO_READ) {
+        off = (self->ud_head + self->ud_len) % size;
+        n = size - self->ud_len;
+    } else {
+        off = self->ud_head;
+        n = self->ud_len;
+    }
+
+    if (len > n)
+        len = n;
+
+    for (iovcnt = 0; len > 0; iovcnt++) {
+        n = size - off;
+
+        if (n > len)
+            n = len;
+
+        iov[iovcnt].iov_base = bp + off;
+        iov[iovcnt].iov_len = n;
+
+        off = 0;
+        len -= n;
+    }
+    return (iovcnt);
+}
+
+/*
+ * Pushes n bytes at offset k as (LUA_TSTRING).
+ */
+static void
+ringbuf_pushldata(lua_State *L, luab_ringbuf_t *self, size_t k, size_t len)
+{
+    u_char *bp;
+    size_t n;
+
+    if (len > 0) {
+        bp = ringbuf_seg(self, k, &n);
+
+        if (n < len) {
+            lua_pushlstring(L, (caddr_t)bp, n);
+            bp = ringbuf_seg(self, k + n, &n);
+            lua_pushlstring(L, (caddr_t)bp, len - n);
+            lua_concat(L, 2);
+        } else
+            lua_pushlstring(L, (caddr_t)bp, len);
+    } else
+        lua_pushliteral(L, "");
+}
+
+static void
+ringbuf_fillxtable(lua_State *L, int narg, void *arg)
+{
+    luab_ringbuf_t *self;
+
+    if ((self = (luab_ringbuf_t *)arg) != NULL) {
+
+        luab_setinteger(L, narg, "len",         self->ud_len);
+        luab_setinteger(L, narg, "size",        self->ud_iov.iov_len);
+        luab_setinteger(L, narg, "max_len",     self->ud_max_len);
+    } else
+        luab_core_err(EX_DATAERR, __func__, EINVAL);
+}
+
+/*
+ * Generator functions.
+ */
+
+/***
+ * Generator function - translate (LUA_TUSERDATA(RINGBUF)) into (LUA_TTABLE).
+ *
+ * @function get_table
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              len     = (LUA_TNUMBER),
+ *              size    = (LUA_TNUMBER),
+ *              max_len = (LUA_TNUMBER),
+ *          }
+ *
+ * @usage t [, err, msg ] = ringbuf:get_table()
+ */
+static int
+RINGBUF_get_table(lua_State *L)
+{
+    luab_module_t *m;
+    luab_xtable_param_t xtp;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(RINGBUF, TYPE, __func__);
+
+    xtp.xtp_fill = ringbuf_fillxtable;
+    xtp.xtp_arg = luab_todata(L, 1, m, void *);
+    xtp.xtp_new = 1;
+    xtp.xtp_k = NULL;
+
+    return (luab_table_pushxtable(L, -2, &xtp));
+}
+
+/***
+ * Generator function - returns (LUA_TNIL).
+ *
+ * @function dump
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage iovec [, err, msg ] = ringbuf:dump()
+ */
+static int
+RINGBUF_dump(lua_State *L)
+{
+    return (luab_core_dump(L, 1, NULL, 0));
+}
+
+/*
+ * Access functions, immutable properties.
+ */
+
+/***
+ * Get upper bound of capacity.
+ *
+ * @function max_len
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage nbytes [, err, msg ] = ringbuf:max_len()
+ */
+static int
+RINGBUF_max_len(lua_State *L)
+{
+    luab_module_t *m;
+    luab_ringbuf_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(RINGBUF, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_ringbuf_t *);
+
+    return (luab_pushxinteger(L, self->ud_max_len));
+}
+
+/*
+ * Access functions.
+ */
+
+/***
+ * Get amount of buffered data.
+ *
+ * @function get_len
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage nbytes [, err, msg ] = ringbuf:get_len()
+ */
+static int
+RINGBUF_get_len(lua_State *L)
+{
+    luab_module_t *m;
+    luab_ringbuf_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(RINGBUF, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_ringbuf_t *);
+
+    return (luab_pushxinteger(L, self->ud_len));
+}
+
+/***
+ * Get current capacity.
+ *
+ * @function get_size
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage nbytes [, err, msg ] = ringbuf:get_size()
+ */
+static int
+RINGBUF_get_size(lua_State *L)
+{
+    luab_module_t *m;
+    luab_ringbuf_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(RINGBUF, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_ringbuf_t *);
+
+    return (luab_pushxinteger(L, self->ud_iov.iov_len));
+}
+
+/***
+ * Discard buffered data.
+ *
+ * @function clear
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage ret [, err, msg ] = ringbuf:clear()
+ */
+static int
+RINGBUF_clear(lua_State *L)
+{
+    luab_module_t *m;
+    luab_ringbuf_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(RINGBUF, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_ringbuf_t *);
+
+    ringbuf_consume(self, self->ud_len);
+
+    return (luab_pushxinteger(L, luab_env_success));
+}
+
+/***
+ * Append data.
+ *
+ * @function append
+ *
+ * @param data              Data, (LUA_TSTRING).
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage nbytes [, err, msg ] = ringbuf:append(data)
+ */
+static int
+RINGBUF_append(lua_State *L)
+{
+    luab_module_t *m;
+    luab_ringbuf_t *self;
+    const char *dp;
+    struct iovec iov[2];
+    size_t len, k;
+    int iovcnt, i;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(RINGBUF, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_ringbuf_t *);
+    dp = luaL_checklstring(L, 2, &len);
+
+    if (ringbuf_reserve(self, len) != 0)
+        return (luab_pushxinteger(L, luab_env_error));
+
+    iovcnt = ringbuf_iov(self, iov, len, UIO_READ);
+
+    for (i = 0, k = 0; i < iovcnt; k += iov[i].iov_len, i++)
+        (void)memmove(iov[i].iov_base, dp + k, iov[i].iov_len);
+
+    self->ud_len += len;
+
+    return (luab_pushxinteger(L, len));
+}
+
+/***
+ * Copy data without consuming it.
+ *
+ * @function peek
+ *
+ * @param nbytes            Amount of bytes, optional.
+ *
+ * @return (LUA_T{NIL,STRING} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage data [, err, msg ] = ringbuf:peek([ nbytes ])
+ */
+static int
+RINGBUF_peek(lua_State *L)
+{
+    luab_module_t *m;
+    luab_ringbuf_t *self;
+    size_t len;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(RINGBUF, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_ringbuf_t *);
+    len = lua_isnoneornil(L, 2) ? self->ud_len : luab_checksize(L, 2);
+
+    if (len > self->ud_len)
+        len = self->ud_len;
+
+    ringbuf_pushldata(L, self, 0, len);
+    return (1);
+}
+
+/***
+ * Discard data.
+ *
+ * @function consume
+ *
+ * @param nbytes            Amount of bytes.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage nbytes [, err, msg ] = ringbuf:consume(nbytes)
+ */
+static int
+RINGBUF_consume(lua_State *L)
+{
+    luab_module_t *m;
+    luab_ringbuf_t *self;
+    size_t len;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(RINGBUF, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_ringbuf_t *);
+    len = luab_checksize(L, 2);
+
+    if (len > self->ud_len)
+        len = self->ud_len;
+
+    ringbuf_consume(self, len);
+
+    return (luab_pushxinteger(L, len));
+}
+
+/***
+ * Find first occurence of a delimiter.
+ *
+ * @function find
+ *
+ * @param delim             Delimiter, plain, (LUA_TSTRING).
+ * @param init              Index where search starts, optional.
+ *
+ * @return (LUA_T{NIL,NUMBER} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          Index of first byte of delimiter, (nil) if not found.
+ *
+ * @usage i [, err, msg ] = ringbuf:find(delim [, init ])
+ */
+static int
+RINGBUF_find(lua_State *L)
+{
+    luab_module_t *m;
+    luab_ringbuf_t *self;
+    const char *dp;
+    size_t len, init;
+    ssize_t k;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m = luab_xmod(RINGBUF, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_ringbuf_t *);
+    dp = luaL_checklstring(L, 2, &len);
+    init = lua_isnoneornil(L, 3) ? 1 : luab_checksize(L, 3);
+
+    if (init < 1)
+        luab_core_argerror(L, 3, NULL, 0, 0, ERANGE);
+
+    if ((k = ringbuf_find(self, init - 1, (const u_char *)dp, len)) < 0) {
+        lua_pushnil(L);
+        return (1);
+    }
+    return (luab_pushxinteger(L, k + 1));
+}
+
+/***
+ * Extract a line.
+ *
+ * @function get_line
+ *
+ * @param delim             Delimiter, (LUA_TSTRING), "\n" by default.
+ *
+ * @return (LUA_T{NIL,STRING} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          Line without delimiter, (nil) if incomplete. The line and its
+ *          delimiter are consumed.
+ *
+ * @usage line [, err, msg ] = ringbuf:get_line([ delim ])
+ */
+static int
+RINGBUF_get_line(lua_State *L)
+{
+    luab_module_t *m;
+    luab_ringbuf_t *self;
+    const char *dp;
+    size_t len;
+    ssize_t k;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(RINGBUF, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_ringbuf_t *);
+
+    if (lua_isnoneornil(L, 2)) {
+        dp = "\n";
+        len = 1;
+    } else {
+        dp = luaL_checklstring(L, 2, &len);
+
+        if (len == 0)
+            luab_core_argerror(L, 2, NULL, 0, 0, EINVAL);
+    }
+
+    if ((k = ringbuf_find(self, 0, (const u_char *)dp, len)) < 0) {
+        lua_pushnil(L);
+        return (1);
+    }
+    ringbuf_pushldata(L, self, 0, (size_t)k);
+    ringbuf_consume(self, (size_t)k + len);
+
+    return (1);
+}
+
+/***
+ * Extract a length-prefixed frame.
+ *
+ * @function get_frame
+ *
+ * @param width             Size of length field, 1, 2 or 4 bytes, optional.
+ * @param le                Length field is little endian, if true.
+ *
+ * @return (LUA_T{NIL,STRING} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          Payload, (nil) if incomplete. The frame is consumed. A frame
+ *          exceeding max_len is reported as EMSGSIZE.
+ *
+ * @usage payload [, err, msg ] = ringbuf:get_frame([ width [, le ]])
+ */
+static int
+RINGBUF_get_frame(lua_State *L)
+{
+    luab_module_t *m;
+    luab_ringbuf_t *self;
+    u_char hdr[sizeof(uint32_t)];
+    size_t width, len, k;
+    int le;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m = luab_xmod(RINGBUF, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_ringbuf_t *);
+    width = lua_isnoneornil(L, 2) ? LUAB_RINGBUF_FRAME_WIDTH :
+        luab_checksize(L, 2);
+    le = lua_toboolean(L, 3);
+
+    switch (width) {
+    case sizeof(uint8_t):
+    case sizeof(uint16_t):
+    case sizeof(uint32_t):
+        break;
+    default:
+        luab_core_argerror(L, 2, NULL, 0, 0, EINVAL);
+        break;
+    }
+
+    if (self->ud_len < width) {
+        lua_pushnil(L);
+        return (1);
+    }
+    ringbuf_copyout(self, 0, hdr, width);
+
+    for (len = 0, k = 0; k < width; k++) {
+
+        if (le != 0)
+            len |= ((size_t)hdr[k] << (8 * k));
+        else
+            len = (len << 8) | hdr[k];
+    }
+
+    if (len > (self->ud_max_len - width)) {
+        errno = EMSGSIZE;
+        return (luab_pushnil(L));
+    }
+
+    if (self->ud_len < (width + len)) {
+        lua_pushnil(L);
+        return (1);
+    }
+    ringbuf_pushldata(L, self, width, len);
+    ringbuf_consume(self, width + len);
+
+    return (1);
+}
+
+/***
+ * Read from file descriptor by readv(2), across the wrap point.
+ *
+ * @function read_from
+ *
+ * @param fd                Open file descriptor.
+ * @param nbytes            Amount of bytes, optional.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          Amount of bytes read, 0 on EOF. The buffer grows, if full.
+ *
+ * @usage count [, err, msg ] = ringbuf:read_from(fd [, nbytes ])
+ */
+static int
+RINGBUF_read_from(lua_State *L)
+{
+    luab_module_t *m;
+    luab_ringbuf_t *self;
+    struct iovec iov[2];
+    size_t len;
+    ssize_t count;
+    int fd, iovcnt;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m = luab_xmod(RINGBUF, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_ringbuf_t *);
+    fd = luab_checkint(L, 2);
+    len = lua_isnoneornil(L, 3) ? 0 : luab_checksize(L, 3);
+
+    if (len == 0) {
+
+        if (self->ud_len == self->ud_iov.iov_len &&
+            ringbuf_reserve(self, 1) != 0)
+            return (luab_pushxinteger(L, luab_env_error));
+
+        len = self->ud_iov.iov_len - self->ud_len;
+    } else if (ringbuf_reserve(self, len) != 0)
+        return (luab_pushxinteger(L, luab_env_error));
+
+    iovcnt = ringbuf_iov(self, iov, len, UIO_READ);
+
+    if ((count = readv(fd, iov, iovcnt)) > 0)
+        self->ud_len += (size_t)count;
+
+    return (luab_pushxinteger(L, count));
+}
+
+/***
+ * Write to file descriptor by writev(2), across the wrap point.
+ *
+ * @function write_to
+ *
+ * @param fd                Open file descriptor.
+ * @param nbytes            Amount of bytes, optional.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          Amount of bytes written and consumed.
+ *
+ * @usage count [, err, msg ] = ringbuf:write_to(fd [, nbytes ])
+ */
+static int
+RINGBUF_write_to(lua_State *L)
+{
+    luab_module_t *m;
+    luab_ringbuf_t *self;
+    struct iovec iov[2];
+    size_t len;
+    ssize_t count;
+    int fd, iovcnt;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m = luab_xmod(RINGBUF, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_ringbuf_t *);
+    fd = luab_checkint(L, 2);
+    len = lua_isnoneornil(L, 3) ? self->ud_len : luab_checksize(L, 3);
+
+    if ((iovcnt = ringbuf_iov(self, iov, len, UIO_WRITE)) == 0)
+        return (luab_pushxinteger(L, 0));
+
+    if ((count = writev(fd, iov, iovcnt)) > 0)
+        ringbuf_consume(self, (size_t)count);
+
+    return (luab_pushxinteger(L, count));
+}
+
+/*
+ * Metamethods.
+ */
+
+static int
+RINGBUF_gc(lua_State *L)
+{
+    luab_module_t *m;
+    luab_ringbuf_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(RINGBUF, TYPE, __func__);
+    self = luab_todata(L, 1, m, luab_ringbuf_t *);
+
+    (void)luab_iov_free(&self->ud_iov);
+
+    return (luab_core_gc(L, 1, m));
+}
+
+static int
+RINGBUF_len(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(RINGBUF, TYPE, __func__);
+    return (luab_core_len(L, 2, m));
+}
+
+static int
+RINGBUF_tostring(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(RINGBUF, TYPE, __func__);
+    return (luab_core_tostring(L, 1, m));
+}
+
+/*
+ * Internal interface.
+ */
+
+static luab_module_table_t ringbuf_methods[] = {
+    LUAB_FUNC("max_len",        RINGBUF_max_len),
+    LUAB_FUNC("get_len",        RINGBUF_get_len),
+    LUAB_FUNC("get_size",       RINGBUF_get_size),
+    LUAB_FUNC("clear",          RINGBUF_clear),
+    LUAB_FUNC("append",         RINGBUF_append),
+    LUAB_FUNC("peek",           RINGBUF_peek),
+    LUAB_FUNC("consume",        RINGBUF_consume),
+    LUAB_FUNC("find",           RINGBUF_find),
+    LUAB_FUNC("get_line",       RINGBUF_get_line),
+    LUAB_FUNC("get_frame",      RINGBUF_get_frame),
+    LUAB_FUNC("read_from",      RINGBUF_read_from),
+    LUAB_FUNC("write_to",       RINGBUF_write_to),
+    LUAB_FUNC("get_table",      RINGBUF_get_table),
+    LUAB_FUNC("dump",           RINGBUF_dump),
+    LUAB_FUNC("__gc",           RINGBUF_gc),
+    LUAB_FUNC("__len",          RINGBUF_len),
+    LUAB_FUNC("__tostring",     RINGBUF_tostring),
+    LUAB_MOD_TBL_SENTINEL
+};
+
+static void *
+ringbuf_create(lua_State *L, void *arg)
+{
+    luab_module_t *m;
+    luab_ringbuf_param_t *rbp;
+    luab_ringbuf_t rb, *self;
+
+    m = luab_xmod(RINGBUF, TYPE, __func__);
+
+    if (((rbp = (luab_ringbuf_param_t *)arg) == NULL) ||
+        (rbp->rbp_size > rbp->rbp_max_len)) {
+        errno = EINVAL;
+        return (NULL);
+    }
+    (void)memset(&rb, 0, sizeof(rb));
+
+    if (luab_iov_alloc(&rb.ud_iov, rbp->rbp_size) != 0)
+        return (NULL);
+
+    rb.ud_max_len = rbp->rbp_max_len;
+
+    if ((self = luab_newuserdata(L, m, &rb)) == NULL)
+        (void)luab_iov_free(&rb.ud_iov);
+
+    return (self);
+}
+
+static void
+ringbuf_init(void *ud, void *arg)
+{
+    luab_ringbuf_t *self, *rb;
+
+    if (((self = (luab_ringbuf_t *)ud) != NULL) &&
+        ((rb = (luab_ringbuf_t *)arg) != NULL)) {
+        self->ud_iov = rb->ud_iov;
+        self->ud_max_len = rb->ud_max_len;
+    }
+}
+
+static void *
+ringbuf_udata(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    m = luab_xmod(RINGBUF, TYPE, __func__);
+    return (luab_todata(L, narg, m, luab_ringbuf_t *));
+}
+
+luab_module_t luab_ringbuf_type = {
+    .m_id           = LUAB_RINGBUF_TYPE_ID,
+    .m_name         = LUAB_RINGBUF_TYPE,
+    .m_vec          = ringbuf_methods,
+    .m_create       = ringbuf_create,
+    .m_init         = ringbuf_init,
+    .m_get          = ringbuf_udata,
+    .m_len          = sizeof(luab_ringbuf_t),
+    .m_sz           = sizeof(luab_ringbuf_param_t),
+};
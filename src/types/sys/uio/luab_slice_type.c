@@ -0,0 +1,851 @@
+/*
+ * Copyright (c) 2020, 2021 Henning Matyschok
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "luabsd.h"
+#include "luab_udata.h"
+#include "luab_table.h"
+
+extern luab_module_t luab_slice_type;
+
+/*
+ * Interface against
+ *
+ *  typedef struct luab_slice {
+ *      luab_udata_t    ud_softc;
+ *      luab_iovec_t    *ud_buf;
+ *      size_t          ud_off;
+ *      size_t          ud_len;
+ *  } luab_slice_t;
+ *
+ * whereby ud_buf refers the (LUA_TUSERDATA(IOVEC)), which is kept by the
+ * uservalue of the slice. Bytes are accessed in place, thus a Lua string
+ * is created by get_string only. The region is validated on each access,
+ * since ud_buf may be resized or cleared meanwhile.
+ */
+
+typedef struct luab_slice {
+    luab_udata_t    ud_softc;
+    luab_iovec_t    *ud_buf;
+    size_t          ud_off;
+    size_t          ud_len;
+} luab_slice_t;
+
+#define LUAB_SLICE_FNV_BASIS    0x811c9dc5U
+#define LUAB_SLICE_FNV_PRIME    0x01000193U
+
+/*
+ * Subr.
+ */
+
+/*
+ * Must be called with luab_thread_mtx held.
+ */
+static caddr_t
+slice_base(luab_slice_t *self)
+{
+    struct iovec *iov;
+    caddr_t bp;
+
+    iov = &(self->ud_buf->iov);
+
+    if ((bp = iov->iov_base) == NULL) {
+        errno = ENXIO;
+        return (NULL);
+    }
+
+    if ((self->ud_off > iov->iov_len) ||
+        (self->ud_len > (iov->iov_len - self->ud_off))) {
+        errno = ERANGE;
+        return (NULL);
+    }
+    return (bp + self->ud_off);
+}
+
+/*
+ * Translates [i, j] as string.sub does, into offset and length.
+ */
+static void
+slice_checkrange(lua_State *L, int narg, size_t len, size_t *off, size_t *n)
+{
+    lua_Integer i, j;
+
+    i = luaL_optinteger(L, narg, 1);
+    j = luaL_optinteger(L, narg + 1, -1);
+
+    if (i < 0)
+        i = ((lua_Integer)len + i + 1);
+    if (j < 0)
+        j = ((lua_Integer)len + j + 1);
+
+    if (i < 1)
+        i = 1;
+    if (j > (lua_Integer)len)
+        j = (lua_Integer)len;
+
+    if (i > j) {
+        *off = 0;
+        *n = 0;
+    } else {
+        *off = (size_t)(i - 1);
+        *n = (size_t)(j - i + 1);
+    }
+}
+
+static size_t
+slice_checkindex(lua_State *L, int narg, luab_slice_t *self, size_t width)
+{
+    lua_Integer i;
+
+    i = luaL_checkinteger(L, narg);
+
+    if (i < 1 || (size_t)i > self->ud_len ||
+        width > (self->ud_len - (size_t)(i - 1)))
+        luab_core_argerror(L, narg, NULL, 0, 0, ERANGE);
+
+    return ((size_t)(i - 1));
+}
+
+static uint64_t
+slice_decode(const u_char *bp, size_t width, int be)
+{
+    uint64_t x;
+    size_t k;
+
+    for (x = 0, k = 0; k < width; k++) {
+
+        if (be != 0)
+            x = (x << 8) | bp[k];
+        else
+            x |= ((uint64_t)bp[k] << (8 * k));
+    }
+    return (x);
+}
+
+/*
+ * Operand of find or cmp, either (LUA_TSTRING) or (LUA_TUSERDATA(SLICE)).
+ */
+static luab_slice_t *
+slice_checkoperand(lua_State *L, int narg, const char **dp, size_t *len)
+{
+    luab_module_t *m;
+    luab_slice_t *x;
+
+    m = luab_xmod(SLICE, TYPE, __func__);
+
+    if ((x = luab_isdata(L, narg, m, luab_slice_t *)) != NULL) {
+        *dp = NULL;
+        *len = x->ud_len;
+    } else
+        *dp = luaL_checklstring(L, narg, len);
+
+    return (x);
+}
+
+static int
+slice_cmp(const char *a, size_t alen, const char *b, size_t blen)
+{
+    size_t len;
+    int cmp;
+
+    len = (alen < blen) ? alen : blen;
+
+    if (len > 0 && (cmp = memcmp(a, b, len)) != 0)
+        return ((cmp < 0) ? -1 : 1);
+
+    if (alen < blen)
+        return (-1);
+
+    return (alen > blen);
+}
+
+/*
+ * Compares slice at narg with its operand at narg + 1.
+ */
+static int
+slice_compare(lua_State *L, int narg, int *cmp)
+{
+    luab_module_t *m;
+    luab_slice_t *self, *x;
+    const char *a, *b;
+    size_t alen, blen;
+    int status;
+
+    m = luab_xmod(SLICE, TYPE, __func__);
+
+    self = luab_udata(L, narg, m, luab_slice_t *);
+    x = slice_checkoperand(L, narg + 1, &b, &blen);
+    alen = self->ud_len;
+
+    luab_thread_mtx_lock(L, __func__);
+
+    if (((a = slice_base(self)) != NULL) &&
+        ((x == NULL) || ((b = slice_base(x)) != NULL))) {
+        *cmp = slice_cmp(a, alen, b, blen);
+        status = 0;
+    } else
+        status = luab_env_error;
+
+    luab_thread_mtx_unlock(L, __func__);
+
+    return (status);
+}
+
+static void
+slice_fillxtable(lua_State *L, int narg, void *arg)
+{
+    luab_slice_t *self;
+
+    if ((self = (luab_slice_t *)arg) != NULL) {
+
+        luab_setinteger(L, narg, "off",     self->ud_off);
+        luab_setinteger(L, narg, "len",     self->ud_len);
+    } else
+        luab_core_err(EX_DATAERR, __func__, EINVAL);
+}
+
+/*
+ * Generator functions.
+ */
+
+/***
+ * Generator function - translate (LUA_TUSERDATA(SLICE)) into (LUA_TTABLE).
+ *
+ * @function get_table
+ *
+ * @return (LUA_T{NIL,TABLE} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          t = {
+ *              off     = (LUA_TNUMBER),
+ *              len     = (LUA_TNUMBER),
+ *          }
+ *
+ * @usage t [, err, msg ] = slice:get_table()
+ */
+static int
+SLICE_get_table(lua_State *L)
+{
+    luab_module_t *m;
+    luab_xtable_param_t xtp;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(SLICE, TYPE, __func__);
+
+    xtp.xtp_fill = slice_fillxtable;
+    xtp.xtp_arg = luab_todata(L, 1, m, void *);
+    xtp.xtp_new = 1;
+    xtp.xtp_k = NULL;
+
+    return (luab_table_pushxtable(L, -2, &xtp));
+}
+
+/***
+ * Generator function - returns (LUA_TNIL).
+ *
+ * @function dump
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage iovec [, err, msg ] = slice:dump()
+ */
+static int
+SLICE_dump(lua_State *L)
+{
+    return (luab_core_dump(L, 1, NULL, 0));
+}
+
+/***
+ * Generator function - create a (LUA_TUSERDATA(SLICE)) on a subrange.
+ *
+ * @function sub
+ *
+ * @param i                 Index of first byte, as string.sub(3) does.
+ * @param j                 Index of last byte, optional.
+ *
+ * @return (LUA_T{NIL,USERDATA} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage slice [, err, msg ] = slice:sub(i [, j ])
+ */
+static int
+SLICE_sub(lua_State *L)
+{
+    luab_module_t *m;
+    luab_slice_t *self;
+    luab_slice_param_t slp;
+    size_t off, len;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m = luab_xmod(SLICE, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_slice_t *);
+
+    slice_checkrange(L, 2, self->ud_len, &off, &len);
+
+    lua_getuservalue(L, 1);
+    lua_rawgeti(L, -1, 1);
+
+    slp.slp_narg = lua_gettop(L);
+    slp.slp_buf = self->ud_buf;
+    slp.slp_off = self->ud_off + off;
+    slp.slp_len = len;
+
+    if (m->m_create(L, &slp) == NULL)
+        return (luab_pushnil(L));
+
+    return (1);
+}
+
+/*
+ * Access functions.
+ */
+
+/***
+ * Get offset of slice relative to iov_base.
+ *
+ * @function get_off
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage off [, err, msg ] = slice:get_off()
+ */
+static int
+SLICE_get_off(lua_State *L)
+{
+    luab_module_t *m;
+    luab_slice_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(SLICE, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_slice_t *);
+
+    return (luab_pushxinteger(L, self->ud_off));
+}
+
+/***
+ * Get length of slice.
+ *
+ * @function get_len
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage len [, err, msg ] = slice:get_len()
+ */
+static int
+SLICE_get_len(lua_State *L)
+{
+    luab_module_t *m;
+    luab_slice_t *self;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(SLICE, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_slice_t *);
+
+    return (luab_pushxinteger(L, self->ud_len));
+}
+
+/***
+ * Copy slice into a Lua string.
+ *
+ * @function get_string
+ *
+ * @return (LUA_T{NIL,STRING} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage str [, err, msg ] = slice:get_string()
+ */
+static int
+SLICE_get_string(lua_State *L)
+{
+    luab_module_t *m;
+    luab_slice_t *self;
+    caddr_t bp;
+    int status;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(SLICE, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_slice_t *);
+
+    luab_thread_mtx_lock(L, __func__);
+
+    if ((bp = slice_base(self)) != NULL) {
+        lua_pushlstring(L, bp, self->ud_len);
+        status = 1;
+    } else
+        status = luab_env_error;
+
+    luab_thread_mtx_unlock(L, __func__);
+
+    if (status < 0)
+        status = luab_pushnil(L);
+
+    return (status);
+}
+
+/***
+ * Get value of byte at index i.
+ *
+ * @function byte
+ *
+ * @param i                 Index, starting at 1.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage x [, err, msg ] = slice:byte(i)
+ */
+static int
+SLICE_byte(lua_State *L)
+{
+    luab_module_t *m;
+    luab_slice_t *self;
+    size_t off;
+    caddr_t bp;
+    lua_Integer x;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(SLICE, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_slice_t *);
+    off = slice_checkindex(L, 2, self, sizeof(u_char));
+
+    luab_thread_mtx_lock(L, __func__);
+
+    if ((bp = slice_base(self)) != NULL)
+        x = ((u_char *)bp)[off];
+    else
+        x = luab_env_error;
+
+    luab_thread_mtx_unlock(L, __func__);
+
+    return (luab_pushxinteger(L, x));
+}
+
+static int
+slice_pushuint(lua_State *L, size_t width, int be)
+{
+    luab_module_t *m;
+    luab_slice_t *self;
+    size_t off;
+    caddr_t bp;
+    uint64_t x;
+    int status;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    m = luab_xmod(SLICE, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_slice_t *);
+    off = slice_checkindex(L, 2, self, width);
+
+    luab_thread_mtx_lock(L, __func__);
+
+    if ((bp = slice_base(self)) != NULL) {
+        x = slice_decode((u_char *)bp + off, width, be);
+        status = 0;
+    } else {
+        x = 0;
+        status = luab_env_error;
+    }
+    luab_thread_mtx_unlock(L, __func__);
+
+    if (status != 0)
+        return (luab_pushnil(L));
+
+    /* not by lua_Integer, values above INT64_MAX would wrap */
+    lua_pushnumber(L, (lua_Number)x);
+
+    return (1);
+}
+
+/***
+ * Decode unsigned integer at index i, little or big endian.
+ *
+ * @function get_u16le
+ *
+ * @param i                 Index of first byte, starting at 1.
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          Same applies to get_u16be, get_u32{le,be} and get_u64{le,be},
+ *          whereby values above 2^53 are rounded to the nearest value
+ *          representable by (LUA_TNUMBER), but never wrap into negative.
+ *
+ * @usage x [, err, msg ] = slice:get_u16le(i)
+ */
+static int
+SLICE_get_u16le(lua_State *L)
+{
+    return (slice_pushuint(L, sizeof(uint16_t), 0));
+}
+
+static int
+SLICE_get_u16be(lua_State *L)
+{
+    return (slice_pushuint(L, sizeof(uint16_t), 1));
+}
+
+static int
+SLICE_get_u32le(lua_State *L)
+{
+    return (slice_pushuint(L, sizeof(uint32_t), 0));
+}
+
+static int
+SLICE_get_u32be(lua_State *L)
+{
+    return (slice_pushuint(L, sizeof(uint32_t), 1));
+}
+
+static int
+SLICE_get_u64le(lua_State *L)
+{
+    return (slice_pushuint(L, sizeof(uint64_t), 0));
+}
+
+static int
+SLICE_get_u64be(lua_State *L)
+{
+    return (slice_pushuint(L, sizeof(uint64_t), 1));
+}
+
+/***
+ * Find first occurence of a byte sequence.
+ *
+ * @function find
+ *
+ * @param x                 Pattern, plain, by (LUA_T{STRING,USERDATA(SLICE)}).
+ * @param init              Index where search starts, optional. As by
+ *                          string.find, a negative index counts from
+ *                          the end of the slice.
+ *
+ * @return (LUA_T{NIL,NUMBER}, LUA_T{NIL,NUMBER} [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          (i, j) denotes the match, (nil) if not found.
+ *
+ * @usage i, j [, err, msg ] = slice:find(x [, init ])
+ */
+static int
+SLICE_find(lua_State *L)
+{
+    luab_module_t *m;
+    luab_slice_t *self, *x;
+    const char *dp;
+    caddr_t bp, hit;
+    size_t len, init;
+    lua_Integer pos;
+    int status;
+
+    (void)luab_core_checkmaxargs(L, 3);
+
+    m = luab_xmod(SLICE, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_slice_t *);
+    x = slice_checkoperand(L, 2, &dp, &len);
+    pos = luaL_optinteger(L, 3, 1);
+
+    if (pos < 0) {
+        if ((size_t)-pos > self->ud_len)
+            pos = 1;
+        else
+            pos += (lua_Integer)self->ud_len + 1;
+    } else if (pos == 0)
+        pos = 1;
+
+    if ((size_t)pos > (self->ud_len + 1)) {
+        lua_pushnil(L);
+        return (1);
+    }
+    init = (size_t)pos - 1;
+    hit = NULL;
+
+    luab_thread_mtx_lock(L, __func__);
+
+    if (((bp = slice_base(self)) != NULL) &&
+        ((x == NULL) || ((dp = slice_base(x)) != NULL))) {
+
+        if (len == 0)
+            hit = bp + init;
+        else if (len <= (self->ud_len - init))
+            hit = memmem(bp + init, self->ud_len - init, dp, len);
+
+        status = 0;
+    } else
+        status = luab_env_error;
+
+    luab_thread_mtx_unlock(L, __func__);
+
+    if (status != 0)
+        return (luab_pushnil(L));
+
+    if (hit == NULL) {
+        lua_pushnil(L);
+        return (1);
+    }
+    lua_pushinteger(L, (hit - bp) + 1);
+    lua_pushinteger(L, (hit - bp) + (lua_Integer)len);
+
+    return (2);
+}
+
+/***
+ * Compare lexicographically, as memcmp(3) does.
+ *
+ * @function cmp
+ *
+ * @param x                 Operand, by (LUA_T{STRING,USERDATA(SLICE)}).
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ *          -1, 0 or 1.
+ *
+ * @usage ret [, err, msg ] = slice:cmp(x)
+ */
+static int
+SLICE_cmp(lua_State *L)
+{
+    int cmp;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    if (slice_compare(L, 1, &cmp) != 0)
+        return (luab_pushnil(L));
+
+    return (luab_pushxinteger(L, cmp));
+}
+
+/***
+ * Compute FNV-1a hash over slice.
+ *
+ * @function hash
+ *
+ * @return (LUA_TNUMBER [, LUA_T{NIL,NUMBER}, LUA_T{NIL,STRING} ])
+ *
+ * @usage h [, err, msg ] = slice:hash()
+ */
+static int
+SLICE_hash(lua_State *L)
+{
+    luab_module_t *m;
+    luab_slice_t *self;
+    u_char *bp;
+    uint32_t h;
+    size_t k;
+    int status;
+
+    (void)luab_core_checkmaxargs(L, 1);
+
+    m = luab_xmod(SLICE, TYPE, __func__);
+    self = luab_udata(L, 1, m, luab_slice_t *);
+
+    h = LUAB_SLICE_FNV_BASIS;
+
+    luab_thread_mtx_lock(L, __func__);
+
+    if ((bp = (u_char *)slice_base(self)) != NULL) {
+
+        for (k = 0; k < self->ud_len; k++) {
+            h ^= bp[k];
+            h *= LUAB_SLICE_FNV_PRIME;
+        }
+        status = 0;
+    } else
+        status = luab_env_error;
+
+    luab_thread_mtx_unlock(L, __func__);
+
+    if (status != 0)
+        return (luab_pushnil(L));
+
+    return (luab_pushxinteger(L, h));
+}
+
+/*
+ * Metamethods.
+ */
+
+static int
+SLICE_eq(lua_State *L)
+{
+    int cmp;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    if (slice_compare(L, 1, &cmp) != 0)
+        return (luaL_error(L, "%s: %s", __func__, strerror(errno)));
+
+    lua_pushboolean(L, cmp == 0);
+    return (1);
+}
+
+static int
+SLICE_lt(lua_State *L)
+{
+    int cmp;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    if (slice_compare(L, 1, &cmp) != 0)
+        return (luaL_error(L, "%s: %s", __func__, strerror(errno)));
+
+    lua_pushboolean(L, cmp < 0);
+    return (1);
+}
+
+static int
+SLICE_le(lua_State *L)
+{
+    int cmp;
+
+    (void)luab_core_checkmaxargs(L, 2);
+
+    if (slice_compare(L, 1, &cmp) != 0)
+        return (luaL_error(L, "%s: %s", __func__, strerror(errno)));
+
+    lua_pushboolean(L, cmp <= 0);
+    return (1);
+}
+
+static int
+SLICE_gc(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(SLICE, TYPE, __func__);
+    return (luab_core_gc(L, 1, m));
+}
+
+static int
+SLICE_len(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(SLICE, TYPE, __func__);
+    return (luab_core_len(L, 2, m));
+}
+
+static int
+SLICE_tostring(lua_State *L)
+{
+    luab_module_t *m;
+    m = luab_xmod(SLICE, TYPE, __func__);
+    return (luab_core_tostring(L, 1, m));
+}
+
+/*
+ * Internal interface.
+ */
+
+static luab_module_table_t slice_methods[] = {
+    LUAB_FUNC("get_off",        SLICE_get_off),
+    LUAB_FUNC("get_len",        SLICE_get_len),
+    LUAB_FUNC("get_string",     SLICE_get_string),
+    LUAB_FUNC("get_u16le",      SLICE_get_u16le),
+    LUAB_FUNC("get_u16be",      SLICE_get_u16be),
+    LUAB_FUNC("get_u32le",      SLICE_get_u32le),
+    LUAB_FUNC("get_u32be",      SLICE_get_u32be),
+    LUAB_FUNC("get_u64le",      SLICE_get_u64le),
+    LUAB_FUNC("get_u64be",      SLICE_get_u64be),
+    LUAB_FUNC("byte",           SLICE_byte),
+    LUAB_FUNC("find",           SLICE_find),
+    LUAB_FUNC("cmp",            SLICE_cmp),
+    LUAB_FUNC("hash",           SLICE_hash),
+    LUAB_FUNC("sub",            SLICE_sub),
+    LUAB_FUNC("get_table",      SLICE_get_table),
+    LUAB_FUNC("dump",           SLICE_dump),
+    LUAB_FUNC("__eq",           SLICE_eq),
+    LUAB_FUNC("__lt",           SLICE_lt),
+    LUAB_FUNC("__le",           SLICE_le),
+    LUAB_FUNC("__gc",           SLICE_gc),
+    LUAB_FUNC("__len",          SLICE_len),
+    LUAB_FUNC("__tostring",     SLICE_tostring),
+    LUAB_MOD_TBL_SENTINEL
+};
+
+static void *
+slice_create(lua_State *L, void *arg)
+{
+    luab_module_t *m;
+    luab_slice_param_t *slp;
+    luab_slice_t *self;
+
+    m = luab_xmod(SLICE, TYPE, __func__);
+
+    if ((slp = (luab_slice_param_t *)arg) != NULL &&
+        slp->slp_buf != NULL) {
+
+        if ((self = luab_newuserdata(L, m, slp)) != NULL) {
+            lua_createtable(L, 1, 0);
+            lua_pushvalue(L, slp->slp_narg);
+            lua_rawseti(L, -2, 1);
+            lua_setuservalue(L, -2);
+        }
+    } else {
+        errno = EINVAL;
+        self = NULL;
+    }
+    return (self);
+}
+
+static void
+slice_init(void *ud, void *arg)
+{
+    luab_slice_t *self;
+    luab_slice_param_t *slp;
+
+    if (((self = (luab_slice_t *)ud) != NULL) &&
+        ((slp = (luab_slice_param_t *)arg) != NULL)) {
+        self->ud_buf = slp->slp_buf;
+        self->ud_off = slp->slp_off;
+        self->ud_len = slp->slp_len;
+    }
+}
+
+static void *
+slice_udata(lua_State *L, int narg)
+{
+    luab_module_t *m;
+    m = luab_xmod(SLICE, TYPE, __func__);
+    return (luab_todata(L, narg, m, luab_slice_t *));
+}
+
+luab_module_t luab_slice_type = {
+    .m_id           = LUAB_SLICE_TYPE_ID,
+    .m_name         = LUAB_SLICE_TYPE,
+    .m_vec          = slice_methods,
+    .m_create       = slice_create,
+    .m_init         = slice_init,
+    .m_get          = slice_udata,
+    .m_len          = sizeof(luab_slice_t),
+    .m_sz           = sizeof(luab_slice_param_t),
+};